@@ -4,7 +4,7 @@
 #ifndef OUROBOROS_AST_H
 #define OUROBOROS_AST_H
 
-#include "ouroboros/token.h" // Include Token definitions for literals and lexemes
+#include "token.h" // Include Token definitions for literals and lexemes
 #include <stdlib.h> // For size_t
 #include <stdbool.h> // For bool type
 
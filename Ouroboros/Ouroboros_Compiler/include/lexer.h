@@ -5,7 +5,8 @@
 #define OUROBOROS_LEXER_H
 
 #include <stdio.h>    // For FILE*
-#include "ouroboros/token.h" // For Token and TokenType definitions
+#include <stdbool.h>  // For bool
+#include "token.h" // For Token and TokenType definitions
 
 // The Lexer structure holds the state of the lexer.
 typedef struct {
@@ -13,11 +14,40 @@ typedef struct {
     int source_length;       // Total length of the source code
     int current_pos;         // Current reading position in the source code
     int start_pos;           // Starting position of the current token being scanned
+    int start_line;          // Line and column where the current token starts
+    int start_column;
     int current_line;        // Current line number
     int current_column;      // Current column number
     const char* source_name; // Name of the source file being lexed
 } Lexer;
 
+// A token scanned by lexer_scan_all(). Its lexeme is not copied: it is the
+// `length` bytes at `offset` in the source code.
+typedef struct {
+    TokenType type;
+    int offset;                // Start of the lexeme in the source code
+    int length;                // Length of the lexeme in bytes
+    int line;                  // Line number where the token starts
+    int column;                // Column number where the token starts
+    LiteralValue literal;      // string_val points into the TokenBuffer's string arena
+    const char* error_message; // For ERROR_TOKEN; a static string, not owned
+} TokenSpan;
+
+typedef struct StringArenaBlock StringArenaBlock;
+
+// Every token of a source, in one contiguous array, with the payloads of its
+// string literals in a side arena. Tokenizing costs a few allocations for the
+// whole file instead of several per token.
+typedef struct {
+    const char* source_code;    // The lexed source; spans index into it, so it must outlive the buffer
+    const char* source_name;
+    TokenSpan* tokens;          // Ends with an EOF_TOKEN
+    size_t count;
+    size_t capacity;
+    StringArenaBlock* strings;  // String literal payloads, NUL-terminated
+    size_t error_count;         // ERROR_TOKENs among the tokens
+} TokenBuffer;
+
 // Function to initialize a new Lexer instance.
 // @param source_code The entire source code string to lex. This string should persist
 //                    for the lifetime of the lexer.
@@ -31,6 +61,19 @@ Lexer* lexer_init(const char* source_code, const char* source_name);
 // @return A dynamically allocated Token pointer, or NULL if an unrecoverable error occurs.
 Token* lexer_scan_token(Lexer* lexer);
 
+// Scans the rest of the source into `buffer`, up to and including EOF_TOKEN.
+// Lexical errors become ERROR_TOKENs and scanning goes on past them, so one
+// pass reports all of them.
+// Responsibility: Caller must release the buffer with token_buffer_free().
+// @param lexer A pointer to the Lexer instance.
+// @param buffer The TokenBuffer to fill; any previous contents are discarded without being freed.
+// @return true if the source had no lexical errors.
+bool lexer_scan_all(Lexer* lexer, TokenBuffer* buffer);
+
+// Frees the tokens and string payloads of a TokenBuffer, leaving it empty.
+// Does NOT free the source code the tokens refer to.
+void token_buffer_free(TokenBuffer* buffer);
+
 // Function to free the memory associated with a Lexer instance.
 // Note: This does NOT free the source_code string, as it is assumed to be owned externally.
 // @param lexer A pointer to the Lexer instance to free.
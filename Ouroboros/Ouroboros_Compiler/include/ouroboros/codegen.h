@@ -3,21 +3,60 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Forward declarations
 typedef struct ASTNode ASTNode;
-typedef struct ProgramNode ProgramNode;
-typedef struct ExpressionNode ExpressionNode;
+
+// The C type an Ouroboros value is given in the generated code.
+// Numeric kinds are ordered by rank, for binary numeric promotion.
+typedef enum {
+    CG_TYPE_UNKNOWN,
+    CG_TYPE_VOID,
+    CG_TYPE_BOOLEAN,
+    CG_TYPE_CHAR,
+    CG_TYPE_SHORT,
+    CG_TYPE_INT,
+    CG_TYPE_LONG,
+    CG_TYPE_FLOAT,
+    CG_TYPE_DOUBLE,
+    CG_TYPE_STRING
+} CodegenType;
+
+// A variable in scope, or a top-level function, as the generator sees it
+typedef struct {
+    const char* name;
+    CodegenType type;       // A function's return type
+    const void* declaration; // FunctionDeclarationNode* for functions
+} CodegenSymbol;
 
 // CodeGenerator structure
 typedef struct {
     FILE* output_file;
-    // Add other fields as needed
+    int indent;                 // Nesting depth of the C being written
+    int error_count;            // Constructs the C backend could not translate
+    CodegenSymbol* variables;   // Globals, then locals innermost last
+    size_t variable_count;
+    size_t variable_capacity;
+    CodegenSymbol* functions;   // Every top-level function, so calls may precede declarations
+    size_t function_count;
+    CodegenType return_type;    // Of the function being generated
+    size_t function_scope;      // First variable of that function: its parameters, then its locals
+    size_t loop_scope;          // First variable declared inside the innermost loop
 } CodeGenerator;
 
 // Public API
+
+// Writes C to `output_file`: the program's globals and functions, a small
+// runtime for strings and printing, and a `main` that initializes the
+// globals and calls the program's `main`. Strings are freed when the
+// statement that made them or the variable that owns them ends (see the
+// runtime's comment in the output). Compile the result with
+// `cc -O2 -fwrapv` (integers wrap as they do in Ouroboros) and link -lm.
 CodeGenerator* codegen_init(FILE* output_file);
+// False if any part of the program could not be translated; each such part
+// was reported on stderr.
 bool codegen_generate(CodeGenerator* codegen, ASTNode* ast_root);
 void codegen_free(CodeGenerator* codegen);
 
-#endif // OUROBOROS_CODEGEN_H 
\ No newline at end of file
+#endif // OUROBOROS_CODEGEN_H
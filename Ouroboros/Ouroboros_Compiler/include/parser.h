@@ -4,7 +4,7 @@
 #ifndef OUROBOROS_PARSER_H
 #define OUROBOROS_PARSER_H
 
-#include "ouroboros/token.h" // For Token and TokenType definitions
+#include "token.h" // For Token and TokenType definitions
 #include <stdlib.h> // For size_t
 
 // Forward declaration for ASTNode (full definition will be in ast.h later)
@@ -1,22 +1,173 @@
 // codegen.c
-// This file will contain the code generation logic for the Ouroboros compiler.
-// It will take the Abstract Syntax Tree (AST) as input and produce
-// executable code (e.g., bytecode, assembly, or C for a C backend).
-
-#include "../include/codegen.h"
-#include "../include/ast.h"
-#include "../include/token.h"
-#include "../include/common.h" // For error reporting, common utilities
+// The C backend of the Ouroboros compiler. It takes the Abstract Syntax Tree
+// (AST) and writes a C translation unit that a C compiler turns into a
+// native executable, so programs run ahead-of-time compiled instead of
+// interpreted.
+//
+// Values keep their declared types: int, long, short, char, float, double
+// and boolean become the C types of the same width, String becomes a
+// `const char*`. Identifiers are prefixed with `o_` so they cannot clash with
+// C keywords or the runtime. Classes, arrays, exceptions and ref/out
+// parameters are not translated yet; they are reported as errors.
+
+#include "ouroboros/codegen.h"
+#include "ast.h"
+#include "token.h"
+#include "common.h" // For ouro_malloc, ouro_realloc, compiler name and version
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 // --- Internal Helper Function Declarations ---
-// (These will be populated as codegen develops)
-static void generate_code_for_node(CodeGenerator* codegen, ASTNode* node);
 static void generate_code_for_program(CodeGenerator* codegen, ProgramNode* program_node);
-static void generate_code_for_expression(CodeGenerator* codegen, ExpressionNode* expr_node);
-// ... more specific generation functions for different AST node types ...
+static void generate_function(CodeGenerator* codegen, FunctionDeclarationNode* function);
+static void generate_statement(CodeGenerator* codegen, ASTNode* stmt);
+static void generate_expression(CodeGenerator* codegen, ASTNode* expr);
+static CodegenType type_of(CodeGenerator* codegen, ASTNode* expr);
+
+// Everything the generated code relies on besides the C library. Integer
+// division goes through ouro_idiv so dividing by zero stops the program
+// with a message instead of being undefined. The comment on Strings is
+// written into the generated file too, for whoever reads it.
+static const char* RUNTIME =
+    "#include <math.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <stdint.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "typedef const char* ouro_string;\n"
+    "\n"
+    "static inline void ouro_fail(const char* message) {\n"
+    "    fflush(stdout);\n"
+    "    fprintf(stderr, \"Runtime error: %s\\n\", message);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n"
+    "\n"
+    "static inline long long ouro_idiv(long long a, long long b) {\n"
+    "    if (b == 0) ouro_fail(\"division by zero\");\n"
+    "    return b == -1 ? (long long)(0ULL - (unsigned long long)a) : a / b;\n"
+    "}\n"
+    "\n"
+    "static inline long long ouro_imod(long long a, long long b) {\n"
+    "    if (b == 0) ouro_fail(\"division by zero\");\n"
+    "    return b == -1 ? 0 : a % b;\n"
+    "}\n"
+    "\n"
+    "// Strings. One that a statement computes (a concatenation, a conversion,\n"
+    "// a String returned by a call) is a temporary: it is recorded in\n"
+    "// ouro_temps and freed when the statement ends, or when a condition has\n"
+    "// been tested. Variables own their Strings. Assigning one adopts the\n"
+    "// temporary or copies the value, and frees the old value with the\n"
+    "// statement's temporaries, since the statement may still read it. A\n"
+    "// variable's String is freed when the variable goes out of scope, so a\n"
+    "// loop like `s = s + i` holds only what its variables hold.\n"
+    "// Temporaries stay until the statement that made them ends, so a deep\n"
+    "// recursion holds those of every statement still waiting on a call, and\n"
+    "// global initializers keep theirs until the program exits.\n"
+    "static ouro_string* ouro_temps;\n"
+    "static size_t ouro_temp_count;\n"
+    "static size_t ouro_temp_capacity;\n"
+    "\n"
+    "static inline ouro_string ouro_temp(ouro_string s) {\n"
+    "    if (ouro_temp_count == ouro_temp_capacity) {\n"
+    "        ouro_temp_capacity = ouro_temp_capacity ? ouro_temp_capacity * 2 : 64;\n"
+    "        ouro_temps = realloc(ouro_temps, ouro_temp_capacity * sizeof *ouro_temps);\n"
+    "        if (!ouro_temps) ouro_fail(\"out of memory\");\n"
+    "    }\n"
+    "    ouro_temps[ouro_temp_count++] = s;\n"
+    "    return s;\n"
+    "}\n"
+    "\n"
+    "// Frees the temporaries made since `mark`\n"
+    "static inline void ouro_temp_release(size_t mark) {\n"
+    "    while (ouro_temp_count > mark) free((void*)ouro_temps[--ouro_temp_count]);\n"
+    "}\n"
+    "\n"
+    "static inline bool ouro_released(size_t mark, bool condition) {\n"
+    "    ouro_temp_release(mark);\n"
+    "    return condition;\n"
+    "}\n"
+    "\n"
+    "// A String for a variable to own: `s` itself if it is one of the last\n"
+    "// temporaries made, which then no longer frees it, or else a copy\n"
+    "static inline ouro_string ouro_own(ouro_string s) {\n"
+    "    if (!s) return NULL;\n"
+    "    for (size_t i = ouro_temp_count, seen = 0; i-- > 0 && seen < 16; ++seen) {\n"
+    "        if (ouro_temps[i] == s) {\n"
+    "            ouro_temps[i] = NULL;\n"
+    "            return s;\n"
+    "        }\n"
+    "    }\n"
+    "    size_t length = strlen(s) + 1;\n"
+    "    char* copy = malloc(length);\n"
+    "    if (!copy) ouro_fail(\"out of memory\");\n"
+    "    return memcpy(copy, s, length);\n"
+    "}\n"
+    "\n"
+    "static inline ouro_string ouro_assign(ouro_string* variable, ouro_string s) {\n"
+    "    ouro_string old = *variable;\n"
+    "    *variable = ouro_own(s);\n"
+    "    if (old) ouro_temp(old);\n"
+    "    return *variable;\n"
+    "}\n"
+    "\n"
+    "static inline void ouro_free(ouro_string s) { free((void*)s); }\n"
+    "\n"
+    "static inline ouro_string ouro_concat(ouro_string a, ouro_string b) {\n"
+    "    if (!a) a = \"null\";\n"
+    "    if (!b) b = \"null\";\n"
+    "    size_t la = strlen(a), lb = strlen(b);\n"
+    "    char* s = malloc(la + lb + 1);\n"
+    "    if (!s) ouro_fail(\"out of memory\");\n"
+    "    memcpy(s, a, la);\n"
+    "    memcpy(s + la, b, lb + 1);\n"
+    "    return ouro_temp(s);\n"
+    "}\n"
+    "\n"
+    "static inline ouro_string ouro_from_long(long long v) {\n"
+    "    char buf[32];\n"
+    "    snprintf(buf, sizeof buf, \"%lld\", v);\n"
+    "    return ouro_concat(buf, \"\");\n"
+    "}\n"
+    "\n"
+    "// The shortest form that reads back as the same double\n"
+    "static inline void ouro_format_double(char buf[40], double v) {\n"
+    "    for (int digits = 1; digits <= 17; ++digits) {\n"
+    "        snprintf(buf, 40, \"%.*g\", digits, v);\n"
+    "        if (strtod(buf, NULL) == v) break;\n"
+    "    }\n"
+    "    if (isfinite(v) && !strpbrk(buf, \".e\")) strcat(buf, \".0\");\n"
+    "}\n"
+    "\n"
+    "static inline ouro_string ouro_from_double(double v) {\n"
+    "    char buf[40];\n"
+    "    ouro_format_double(buf, v);\n"
+    "    return ouro_concat(buf, \"\");\n"
+    "}\n"
+    "\n"
+    "static inline ouro_string ouro_from_char(char c) {\n"
+    "    char buf[2] = {c, 0};\n"
+    "    return ouro_concat(buf, \"\");\n"
+    "}\n"
+    "\n"
+    "static inline ouro_string ouro_from_bool(bool v) { return v ? \"true\" : \"false\"; }\n"
+    "\n"
+    "static inline bool ouro_string_equals(ouro_string a, ouro_string b) {\n"
+    "    return a == b || (a && b && strcmp(a, b) == 0);\n"
+    "}\n"
+    "\n"
+    "static inline void ouro_print(ouro_string s) { fputs(s ? s : \"null\", stdout); }\n"
+    "static inline void ouro_print_long(long long v) { printf(\"%lld\", v); }\n"
+    "static inline void ouro_print_double(double v) {\n"
+    "    char buf[40];\n"
+    "    ouro_format_double(buf, v);\n"
+    "    fputs(buf, stdout);\n"
+    "}\n"
+    "static inline void ouro_print_char(char c) { putchar(c); }\n"
+    "static inline void ouro_print_bool(bool v) { fputs(v ? \"true\" : \"false\", stdout); }\n";
 
 
 // --- Public API Implementations ---
@@ -28,18 +179,18 @@ static void generate_code_for_expression(CodeGenerator* codegen, ExpressionNode*
  */
 CodeGenerator* codegen_init(FILE* output_file) {
     CodeGenerator* codegen = (CodeGenerator*)ouro_malloc(sizeof(CodeGenerator));
+    memset(codegen, 0, sizeof(CodeGenerator));
     codegen->output_file = output_file;
-    // Initialize any internal state, symbol tables, register allocators etc.
-    // For now, it's minimal.
+    codegen->return_type = CG_TYPE_VOID;
     return codegen;
 }
 
 /**
- * Generates code from the given Abstract Syntax Tree.
+ * Generates C from the given Abstract Syntax Tree.
  * This is the main entry point for the code generation phase.
  * @param codegen A pointer to the CodeGenerator instance.
  * @param ast_root The root of the AST (a ProgramNode).
- * @return True if code generation was successful, false otherwise.
+ * @return True if the whole program was translated, false otherwise.
  */
 bool codegen_generate(CodeGenerator* codegen, ASTNode* ast_root) {
     if (codegen == NULL || ast_root == NULL) {
@@ -52,15 +203,17 @@ bool codegen_generate(CodeGenerator* codegen, ASTNode* ast_root) {
     }
 
     printf("--- Starting Code Generation ---\n");
-    // This is a placeholder. Real code generation would traverse the AST
-    // and emit target-specific instructions.
     fprintf(codegen->output_file, "// Generated by %s Compiler (v%s)\n",
             OUROBOROS_COMPILER_NAME, OUROBOROS_COMPILER_VERSION);
-    fprintf(codegen->output_file, "// Source AST Node Type: %s\n\n",
-            ast_node_type_to_string(ast_root->base_type));
+    fprintf(codegen->output_file, "// Build with: cc -O2 -fwrapv <this file> -lm\n\n");
+    fputs(RUNTIME, codegen->output_file);
 
     generate_code_for_program(codegen, (ProgramNode*)ast_root);
 
+    if (codegen->error_count > 0) {
+        fprintf(stderr, "Code generation failed with %d error(s).\n", codegen->error_count);
+        return false;
+    }
     printf("--- Code Generation Complete ---\n");
     return true;
 }
@@ -72,7 +225,8 @@ bool codegen_generate(CodeGenerator* codegen, ASTNode* ast_root) {
  */
 void codegen_free(CodeGenerator* codegen) {
     if (codegen) {
-        // Clean up any internal data structures used by the code generator
+        free(codegen->variables);
+        free(codegen->functions);
         free(codegen);
     }
 }
@@ -80,205 +234,1144 @@ void codegen_free(CodeGenerator* codegen) {
 
 // --- Internal Helper Function Implementations ---
 
-static void generate_code_for_node(CodeGenerator* codegen, ASTNode* node) {
-    if (node == NULL) return;
+/**
+ * Reports a construct the backend cannot translate, and counts it.
+ * Generation goes on so every such construct is reported in one run.
+ */
+static void codegen_error(CodeGenerator* codegen, ASTNode* node, const char* message) {
+    Token* token = node ? node->token : NULL;
+    if (token) {
+        fprintf(stderr, "Code generation error at %s:%d:%d: %s\n",
+                token->source_name ? token->source_name : "UnknownSource", token->line, token->column, message);
+    } else {
+        fprintf(stderr, "Code generation error: %s\n", message);
+    }
+    codegen->error_count++;
+}
+
+static void emit(CodeGenerator* codegen, const char* text) {
+    fputs(text, codegen->output_file);
+}
+
+static void emit_indent(CodeGenerator* codegen) {
+    for (int i = 0; i < codegen->indent; ++i) {
+        fputs("    ", codegen->output_file);
+    }
+}
+
+static void emit_name(CodeGenerator* codegen, const char* name) {
+    fprintf(codegen->output_file, "o_%s", name);
+}
+
+// Statements, expressions and declarations all begin with their kind after
+// the ASTNode base, so any of them can be read through one of its structs.
+static StatementType statement_type(ASTNode* node) { return ((BlockStatementNode*)node)->stmt_type; }
+static ExpressionType expression_type(ASTNode* node) { return ((BinaryExpressionNode*)node)->expr_type; }
+static DeclarationType declaration_type(ASTNode* node) { return ((FunctionDeclarationNode*)node)->decl_type; }
+
+// --- Types ---
+
+static bool is_numeric(CodegenType type) {
+    return type >= CG_TYPE_CHAR && type <= CG_TYPE_DOUBLE;
+}
+
+static bool is_integral(CodegenType type) {
+    return type >= CG_TYPE_CHAR && type <= CG_TYPE_LONG;
+}
+
+/**
+ * Maps a type reference to the generator's types. Class and array types
+ * have no C translation yet and map to CG_TYPE_UNKNOWN.
+ */
+static CodegenType type_from_reference(TypeReferenceNode* type) {
+    if (type == NULL || type->name == NULL) return CG_TYPE_UNKNOWN;
+    const char* name = type->name;
+    if (strcmp(name, "void") == 0) return CG_TYPE_VOID;
+    if (strcmp(name, "boolean") == 0 || strcmp(name, "bool") == 0) return CG_TYPE_BOOLEAN;
+    if (strcmp(name, "char") == 0) return CG_TYPE_CHAR;
+    if (strcmp(name, "short") == 0) return CG_TYPE_SHORT;
+    if (strcmp(name, "int") == 0) return CG_TYPE_INT;
+    if (strcmp(name, "long") == 0) return CG_TYPE_LONG;
+    if (strcmp(name, "float") == 0) return CG_TYPE_FLOAT;
+    if (strcmp(name, "double") == 0) return CG_TYPE_DOUBLE;
+    if (strcmp(name, "String") == 0 || strcmp(name, "string") == 0) return CG_TYPE_STRING;
+    return CG_TYPE_UNKNOWN;
+}
+
+static const char* c_type(CodegenType type) {
+    switch (type) {
+        case CG_TYPE_VOID: return "void";
+        case CG_TYPE_BOOLEAN: return "bool";
+        case CG_TYPE_CHAR: return "char";
+        case CG_TYPE_SHORT: return "int16_t";
+        case CG_TYPE_INT: return "int32_t";
+        case CG_TYPE_LONG: return "int64_t";
+        case CG_TYPE_FLOAT: return "float";
+        case CG_TYPE_DOUBLE: return "double";
+        case CG_TYPE_STRING: return "ouro_string";
+        default: return "void*";
+    }
+}
+
+// What a variable declared without an initializer starts as
+static const char* zero_value(CodegenType type) {
+    switch (type) {
+        case CG_TYPE_BOOLEAN: return "false";
+        case CG_TYPE_STRING: return "NULL";
+        case CG_TYPE_FLOAT: case CG_TYPE_DOUBLE: return "0.0";
+        default: return "0";
+    }
+}
+
+// --- Symbols ---
+
+static void declare_variable(CodeGenerator* codegen, const char* name, CodegenType type) {
+    if (codegen->variable_count == codegen->variable_capacity) {
+        codegen->variable_capacity = codegen->variable_capacity ? codegen->variable_capacity * 2 : 32;
+        codegen->variables = (CodegenSymbol*)ouro_realloc(codegen->variables,
+                                                          codegen->variable_capacity * sizeof(CodegenSymbol));
+    }
+    codegen->variables[codegen->variable_count++] = (CodegenSymbol){name, type, NULL};
+}
+
+// Innermost first, so a local shadows a global
+static CodegenSymbol* find_variable(CodeGenerator* codegen, const char* name) {
+    for (size_t i = codegen->variable_count; i-- > 0;) {
+        if (strcmp(codegen->variables[i].name, name) == 0) return &codegen->variables[i];
+    }
+    return NULL;
+}
+
+static CodegenSymbol* find_function(CodeGenerator* codegen, const char* name) {
+    for (size_t i = 0; i < codegen->function_count; ++i) {
+        if (strcmp(codegen->functions[i].name, name) == 0) return &codegen->functions[i];
+    }
+    return NULL;
+}
+
+static bool is_print(const char* name) {
+    return strcmp(name, "print") == 0 || strcmp(name, "println") == 0;
+}
+
+// --- Expression typing ---
+
+/**
+ * The type of an expression's value, following Java's binary numeric
+ * promotion: arithmetic is done in at least int, and `+` with a String
+ * operand concatenates. CG_TYPE_UNKNOWN for what cannot be translated.
+ */
+static CodegenType type_of(CodeGenerator* codegen, ASTNode* expr) {
+    if (expr == NULL) return CG_TYPE_UNKNOWN;
+    if (expr->base_type == NODE_LITERAL) {
+        switch (((LiteralNode*)expr)->literal_type) {
+            case INTEGER_LITERAL: {
+                long long v = ((LiteralNode*)expr)->value.integer_val;
+                return v >= INT32_MIN && v <= INT32_MAX ? CG_TYPE_INT : CG_TYPE_LONG;
+            }
+            case FLOATING_POINT_LITERAL: return CG_TYPE_DOUBLE;
+            case STRING_LITERAL: case NULL_LITERAL: return CG_TYPE_STRING;
+            case CHARACTER_LITERAL: return CG_TYPE_CHAR;
+            case BOOLEAN_LITERAL: return CG_TYPE_BOOLEAN;
+            default: return CG_TYPE_UNKNOWN;
+        }
+    }
+    if (expr->base_type == NODE_IDENTIFIER) {
+        CodegenSymbol* symbol = find_variable(codegen, ((IdentifierNode*)expr)->name);
+        return symbol ? symbol->type : CG_TYPE_UNKNOWN;
+    }
+    if (expr->base_type != NODE_EXPRESSION) return CG_TYPE_UNKNOWN;
+
+    switch (expression_type(expr)) {
+        case EXPR_BINARY: {
+            BinaryExpressionNode* binary = (BinaryExpressionNode*)expr;
+            CodegenType left = type_of(codegen, binary->left);
+            CodegenType right = type_of(codegen, binary->right);
+            switch (binary->operator->type) {
+                case EQ: case NE: case LT: case GT: case LE: case GE: case AND: case OR:
+                    return CG_TYPE_BOOLEAN;
+                case PLUS:
+                    if (left == CG_TYPE_STRING || right == CG_TYPE_STRING) return CG_TYPE_STRING;
+                    // Fall through
+                case MINUS: case MULTIPLY: case DIVIDE: case MODULO:
+                case BIT_AND: case BIT_OR: case BIT_XOR:
+                    if (left == CG_TYPE_BOOLEAN && right == CG_TYPE_BOOLEAN) return CG_TYPE_BOOLEAN; // & | ^ on booleans
+                    if (!is_numeric(left) || !is_numeric(right)) return CG_TYPE_UNKNOWN;
+                    {
+                        CodegenType wider = left > right ? left : right;
+                        return wider < CG_TYPE_INT ? CG_TYPE_INT : wider;
+                    }
+                case LEFT_SHIFT: case RIGHT_SHIFT: case UNSIGNED_RIGHT_SHIFT:
+                    if (!is_integral(left)) return CG_TYPE_UNKNOWN;
+                    return left < CG_TYPE_INT ? CG_TYPE_INT : left;
+                default:
+                    return CG_TYPE_UNKNOWN;
+            }
+        }
+        case EXPR_UNARY: {
+            UnaryExpressionNode* unary = (UnaryExpressionNode*)expr;
+            CodegenType operand = type_of(codegen, unary->operand);
+            switch (unary->operator->type) {
+                case NOT: return CG_TYPE_BOOLEAN;
+                case INCREMENT: case DECREMENT: return operand;
+                default: return is_numeric(operand) && operand < CG_TYPE_INT ? CG_TYPE_INT : operand;
+            }
+        }
+        case EXPR_ASSIGNMENT:
+            return type_of(codegen, ((AssignmentExpressionNode*)expr)->target);
+        case EXPR_CALL: {
+            CallExpressionNode* call = (CallExpressionNode*)expr;
+            if (call->callee == NULL || call->callee->base_type != NODE_IDENTIFIER) return CG_TYPE_UNKNOWN;
+            const char* name = ((IdentifierNode*)call->callee)->name;
+            CodegenSymbol* function = find_function(codegen, name);
+            if (function) return function->type;
+            return is_print(name) ? CG_TYPE_VOID : CG_TYPE_UNKNOWN;
+        }
+        case EXPR_CAST:
+            return type_from_reference(((CastExpressionNode*)expr)->target_type);
+        case EXPR_TERNARY:
+            return type_of(codegen, ((TernaryExpressionNode*)expr)->true_expr);
+        default:
+            return CG_TYPE_UNKNOWN;
+    }
+}
+
+/**
+ * Whether evaluating `expr` may make temporary Strings, which the statement
+ * holding it then releases. Conservative: true means "may".
+ */
+static bool makes_temps(CodeGenerator* codegen, ASTNode* expr);
+
+// The same for `expr` generated as a value of `type`, converting it to a
+// String if `type` is one
+static bool makes_temps_as(CodeGenerator* codegen, ASTNode* expr, CodegenType type) {
+    if (expr == NULL) return false;
+    if (type == CG_TYPE_STRING && type_of(codegen, expr) != CG_TYPE_STRING) return true;
+    return makes_temps(codegen, expr);
+}
 
-    // This switch will grow significantly as more AST node types are added.
-    switch (node->base_type) {
-        case NODE_PROGRAM:
-            generate_code_for_program(codegen, (ProgramNode*)node);
+static bool makes_temps(CodeGenerator* codegen, ASTNode* expr) {
+    if (expr == NULL || expr->base_type != NODE_EXPRESSION) return false; // Literals and variables
+    if (type_of(codegen, expr) == CG_TYPE_STRING) return true;
+    switch (expression_type(expr)) {
+        case EXPR_BINARY:
+            return makes_temps(codegen, ((BinaryExpressionNode*)expr)->left) ||
+                   makes_temps(codegen, ((BinaryExpressionNode*)expr)->right);
+        case EXPR_UNARY:
+            return makes_temps(codegen, ((UnaryExpressionNode*)expr)->operand);
+        case EXPR_ASSIGNMENT:
+            return makes_temps(codegen, ((AssignmentExpressionNode*)expr)->value);
+        case EXPR_CAST:
+            return makes_temps(codegen, ((CastExpressionNode*)expr)->operand);
+        case EXPR_TERNARY: {
+            TernaryExpressionNode* ternary = (TernaryExpressionNode*)expr;
+            return makes_temps(codegen, ternary->condition) || makes_temps(codegen, ternary->true_expr) ||
+                   makes_temps(codegen, ternary->false_expr);
+        }
+        case EXPR_CALL: {
+            CallExpressionNode* call = (CallExpressionNode*)expr;
+            CodegenSymbol* symbol = call->callee && call->callee->base_type == NODE_IDENTIFIER
+                                        ? find_function(codegen, ((IdentifierNode*)call->callee)->name)
+                                        : NULL;
+            FunctionDeclarationNode* function = symbol ? (FunctionDeclarationNode*)symbol->declaration : NULL;
+            for (size_t i = 0; i < call->argument_count; ++i) {
+                CodegenType type = function && i < function->parameter_count
+                                       ? type_from_reference(function->parameters[i]->type)
+                                       : CG_TYPE_UNKNOWN;
+                if (makes_temps_as(codegen, call->arguments[i], type)) return true;
+            }
+            for (size_t i = call->argument_count; function && i < function->parameter_count; ++i) {
+                ParameterNode* param = function->parameters[i];
+                if (makes_temps_as(codegen, (ASTNode*)param->default_value, type_from_reference(param->type))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+// --- Expressions ---
+
+static void generate_string_literal(CodeGenerator* codegen, const char* s) {
+    FILE* out = codegen->output_file;
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)s; *p; ++p) {
+        switch (*p) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\t': fputs("\\t", out); break;
+            case '\r': fputs("\\r", out); break;
+            default:
+                if (*p < 0x20 || *p == 0x7f) fprintf(out, "\\%03o", *p); // Octal: a hex escape would swallow following digits
+                else fputc(*p, out);
+                break;
+        }
+    }
+    fputc('"', out);
+}
+
+static void generate_literal(CodeGenerator* codegen, LiteralNode* literal) {
+    FILE* out = codegen->output_file;
+    switch (literal->literal_type) {
+        case BOOLEAN_LITERAL:
+            fputs(literal->value.boolean_val ? "true" : "false", out);
             break;
-        case NODE_EXPRESSION:
-            generate_code_for_expression(codegen, (ExpressionNode*)node);
+        case INTEGER_LITERAL: {
+            long long v = literal->value.integer_val;
+            if (v == INT64_MIN) fputs("INT64_MIN", out);
+            else fprintf(out, v >= INT32_MIN && v <= INT32_MAX ? "%lld" : "%lldLL", v);
             break;
-        // Placeholder for other nodes
-        case NODE_PACKAGE_DECLARATION:
-            fprintf(codegen->output_file, "// Package Declaration: %s\n", ((PackageDeclarationNode*)node)->package_name->name);
+        }
+        case FLOATING_POINT_LITERAL: {
+            char buf[40];
+            snprintf(buf, sizeof buf, "%.17g", literal->value.float_val);
+            if (!strpbrk(buf, ".en")) strcat(buf, ".0"); // Stays a double; "inf" and "nan" cannot come from the lexer
+            fputs(buf, out);
             break;
-        case NODE_IMPORT_DECLARATION:
-            fprintf(codegen->output_file, "// Import Declaration: %s%s\n",
-                    ((ImportDeclarationNode*)node)->imported_name->name,
-                    ((ImportDeclarationNode*)node)->is_wildcard ? ".*" : "");
+        }
+        case STRING_LITERAL:
+            generate_string_literal(codegen, literal->value.string_val ? literal->value.string_val : "");
             break;
-        case NODE_CLASS_INTERFACE_DECLARATION:
-            fprintf(codegen->output_file, "// Class Declaration: %s\n", ((ClassInterfaceDeclarationNode*)node)->name->name);
-            // Recursively generate code for class members
-            for (size_t i = 0; i < ((ClassInterfaceDeclarationNode*)node)->member_count; ++i) {
-                generate_code_for_node(codegen, ((ClassInterfaceDeclarationNode*)node)->members[i]);
-            }
+        case CHARACTER_LITERAL: {
+            unsigned char c = (unsigned char)literal->value.char_val;
+            if (c == '\'' || c == '\\') fprintf(out, "'\\%c'", c);
+            else if (c < 0x20 || c >= 0x7f) fprintf(out, "'\\%03o'", c);
+            else fprintf(out, "'%c'", c);
             break;
-        case NODE_FUNCTION_DECLARATION:
-            fprintf(codegen->output_file, "// Function Declaration: %s\n", ((FunctionDeclarationNode*)node)->name->name);
-            // Generate code for function body (if any)
-            if (((FunctionDeclarationNode*)node)->body) {
-                generate_code_for_node(codegen, (ASTNode*)((FunctionDeclarationNode*)node)->body);
-            }
+        }
+        case NULL_LITERAL:
+            fputs("NULL", out);
             break;
-        case NODE_FIELD_DECLARATION:
-            fprintf(codegen->output_file, "// Field Declaration: %s %s\n",
-                    ((FieldDeclarationNode*)node)->type->name,
-                    ((FieldDeclarationNode*)node)->name->name);
-            if (((FieldDeclarationNode*)node)->initializer) {
-                fprintf(codegen->output_file, "// Field Initializer:\n");
-                generate_code_for_expression(codegen, ((FieldDeclarationNode*)node)->initializer);
-            }
+        default:
+            codegen_error(codegen, (ASTNode*)literal, "Unknown literal type.");
             break;
-        case NODE_CONSTRUCTOR_DECLARATION:
-             fprintf(codegen->output_file, "// Constructor Declaration for: %s\n", ((ConstructorDeclarationNode*)node)->class_name->name);
-             if (((ConstructorDeclarationNode*)node)->body) {
-                generate_code_for_node(codegen, (ASTNode*)((ConstructorDeclarationNode*)node)->body);
+    }
+}
+
+/**
+ * Generates an expression converted to a String, as `+` does when either
+ * operand is one.
+ */
+static void generate_as_string(CodeGenerator* codegen, ASTNode* expr) {
+    CodegenType type = type_of(codegen, expr);
+    const char* convert = NULL;
+    switch (type) {
+        case CG_TYPE_STRING: generate_expression(codegen, expr); return;
+        case CG_TYPE_BOOLEAN: convert = "ouro_from_bool"; break;
+        case CG_TYPE_CHAR: convert = "ouro_from_char"; break;
+        case CG_TYPE_FLOAT: case CG_TYPE_DOUBLE: convert = "ouro_from_double"; break;
+        case CG_TYPE_SHORT: case CG_TYPE_INT: case CG_TYPE_LONG: convert = "ouro_from_long"; break;
+        default:
+            codegen_error(codegen, expr, "Cannot convert this value to a String.");
+            emit(codegen, "NULL");
+            return;
+    }
+    fprintf(codegen->output_file, "%s(", convert);
+    generate_expression(codegen, expr);
+    emit(codegen, ")");
+}
+
+static const char* c_operator(TokenType type) {
+    switch (type) {
+        case PLUS: case PLUS_EQUALS: return "+";
+        case MINUS: case MINUS_EQUALS: return "-";
+        case MULTIPLY: case MULTIPLY_EQUALS: return "*";
+        case DIVIDE: case DIVIDE_EQUALS: return "/";
+        case MODULO: case MODULO_EQUALS: return "%";
+        case BIT_AND: case BIT_AND_EQUALS: return "&";
+        case BIT_OR: case BIT_OR_EQUALS: return "|";
+        case BIT_XOR: case BIT_XOR_EQUALS: return "^";
+        case LEFT_SHIFT: case LEFT_SHIFT_EQUALS: return "<<";
+        case RIGHT_SHIFT: case RIGHT_SHIFT_EQUALS: return ">>";
+        case EQ: return "==";
+        case NE: return "!=";
+        case LT: return "<";
+        case GT: return ">";
+        case LE: return "<=";
+        case GE: return ">=";
+        case AND: return "&&";
+        case OR: return "||";
+        case NOT: return "!";
+        case BIT_NOT: return "~";
+        case ASSIGN: return "=";
+        default: return NULL;
+    }
+}
+
+/**
+ * Generates `left op right` computed in `type`, for both binary operators
+ * and compound assignments. Integer division and remainder check for zero;
+ * `%` on floating-point values is fmod, and `>>>` shifts in zeros.
+ */
+static void generate_arithmetic(CodeGenerator* codegen, TokenType op, CodegenType type, ASTNode* left, ASTNode* right) {
+    FILE* out = codegen->output_file;
+    bool divide = op == DIVIDE || op == DIVIDE_EQUALS;
+    bool modulo = op == MODULO || op == MODULO_EQUALS;
+    const char* call = NULL;
+    if (is_integral(type) && (divide || modulo)) call = divide ? "ouro_idiv" : "ouro_imod";
+    else if (modulo) call = "fmod";
+    if (call) {
+        fprintf(out, "((%s)%s(", c_type(type), call);
+        generate_expression(codegen, left);
+        emit(codegen, ", ");
+        generate_expression(codegen, right);
+        emit(codegen, "))");
+        return;
+    }
+    if (op == UNSIGNED_RIGHT_SHIFT || op == UNSIGNED_RIGHT_SHIFT_EQUALS) {
+        const char* unsigned_type = type == CG_TYPE_LONG ? "uint64_t" : "uint32_t";
+        fprintf(out, "((%s)((%s)", c_type(type), unsigned_type);
+        generate_expression(codegen, left);
+        emit(codegen, " >> ");
+        generate_expression(codegen, right);
+        emit(codegen, "))");
+        return;
+    }
+    const char* symbol = c_operator(op);
+    if (symbol == NULL) {
+        codegen_error(codegen, left, "Operator not supported by the C backend.");
+        return;
+    }
+    emit(codegen, "(");
+    generate_expression(codegen, left);
+    fprintf(out, " %s ", symbol);
+    generate_expression(codegen, right);
+    emit(codegen, ")");
+}
+
+static void generate_binary(CodeGenerator* codegen, BinaryExpressionNode* binary) {
+    TokenType op = binary->operator->type;
+    CodegenType left = type_of(codegen, binary->left);
+    CodegenType right = type_of(codegen, binary->right);
+    if (op == PLUS && (left == CG_TYPE_STRING || right == CG_TYPE_STRING)) {
+        emit(codegen, "ouro_concat(");
+        generate_as_string(codegen, binary->left);
+        emit(codegen, ", ");
+        generate_as_string(codegen, binary->right);
+        emit(codegen, ")");
+        return;
+    }
+    if ((op == EQ || op == NE) && left == CG_TYPE_STRING && right == CG_TYPE_STRING) {
+        emit(codegen, op == EQ ? "ouro_string_equals(" : "!ouro_string_equals(");
+        generate_expression(codegen, binary->left);
+        emit(codegen, ", ");
+        generate_expression(codegen, binary->right);
+        emit(codegen, ")");
+        return;
+    }
+    CodegenType type = type_of(codegen, (ASTNode*)binary);
+    if (type == CG_TYPE_UNKNOWN) {
+        codegen_error(codegen, (ASTNode*)binary, "Operands of this operator have unsupported types.");
+        emit(codegen, "0");
+        return;
+    }
+    if (type == CG_TYPE_BOOLEAN && op != AND && op != OR && !(op >= BIT_AND && op <= BIT_XOR)) {
+        // A comparison: computed in the operands' promoted type by C itself
+        generate_arithmetic(codegen, op, left > right ? left : right, binary->left, binary->right);
+        return;
+    }
+    generate_arithmetic(codegen, op, type, binary->left, binary->right);
+}
+
+// Whether `++`/`--` follows its operand in the source
+static bool is_postfix(UnaryExpressionNode* unary) {
+    Token* op = unary->operator;
+    Token* operand = unary->operand ? unary->operand->token : NULL;
+    if (operand == NULL) return false;
+    return op->line > operand->line || (op->line == operand->line && op->column > operand->column);
+}
+
+static void generate_unary(CodeGenerator* codegen, UnaryExpressionNode* unary) {
+    TokenType op = unary->operator->type;
+    if (op == INCREMENT || op == DECREMENT) {
+        if (unary->operand == NULL || unary->operand->base_type != NODE_IDENTIFIER) {
+            codegen_error(codegen, (ASTNode*)unary, "Only variables can be incremented or decremented.");
+            emit(codegen, "0");
+            return;
+        }
+        const char* symbol = op == INCREMENT ? "++" : "--";
+        bool postfix = is_postfix(unary);
+        emit(codegen, "(");
+        if (!postfix) emit(codegen, symbol);
+        generate_expression(codegen, unary->operand);
+        if (postfix) emit(codegen, symbol);
+        emit(codegen, ")");
+        return;
+    }
+    const char* symbol = op == MINUS ? "-" : op == PLUS ? "+" : c_operator(op);
+    if (symbol == NULL) {
+        codegen_error(codegen, (ASTNode*)unary, "Unary operator not supported by the C backend.");
+        emit(codegen, "0");
+        return;
+    }
+    fprintf(codegen->output_file, "(%s", symbol);
+    generate_expression(codegen, unary->operand);
+    emit(codegen, ")");
+}
+
+static void generate_assignment(CodeGenerator* codegen, AssignmentExpressionNode* assign) {
+    if (assign->target == NULL || assign->target->base_type != NODE_IDENTIFIER) {
+        codegen_error(codegen, (ASTNode*)assign, "Only variables can be assigned by the C backend.");
+        emit(codegen, "0");
+        return;
+    }
+    TokenType op = assign->operator->type;
+    CodegenType target = type_of(codegen, assign->target);
+    if (target == CG_TYPE_STRING && (op == ASSIGN || op == PLUS_EQUALS)) {
+        // The variable takes ownership of its new value
+        emit(codegen, "ouro_assign(&");
+        generate_expression(codegen, assign->target);
+        emit(codegen, ", ");
+        if (op == PLUS_EQUALS) {
+            emit(codegen, "ouro_concat(");
+            generate_expression(codegen, assign->target);
+            emit(codegen, ", ");
+        }
+        generate_as_string(codegen, assign->value);
+        emit(codegen, op == PLUS_EQUALS ? "))" : ")");
+        return;
+    }
+    emit(codegen, "(");
+    generate_expression(codegen, assign->target);
+    emit(codegen, " = ");
+    if (op == ASSIGN) {
+        generate_expression(codegen, assign->value);
+    } else {
+        // x op= y is x = (T)(x op y), computed in the promoted type
+        CodegenType value = type_of(codegen, assign->value);
+        CodegenType wider = target > value ? target : value;
+        if (wider < CG_TYPE_INT) wider = CG_TYPE_INT;
+        if (op == LEFT_SHIFT_EQUALS || op == RIGHT_SHIFT_EQUALS || op == UNSIGNED_RIGHT_SHIFT_EQUALS) {
+            wider = target < CG_TYPE_INT ? CG_TYPE_INT : target;
+        }
+        if (!is_numeric(target) || !is_numeric(value)) {
+            codegen_error(codegen, (ASTNode*)assign, "Compound assignment needs numeric operands.");
+        }
+        fprintf(codegen->output_file, "(%s)", c_type(target));
+        generate_arithmetic(codegen, op, wider, assign->target, assign->value);
+    }
+    emit(codegen, ")");
+}
+
+/**
+ * print and println write their arguments one after another; println ends
+ * the line. Other calls go to the program's own functions, with the default
+ * values of parameters the call leaves out.
+ */
+static void generate_call(CodeGenerator* codegen, CallExpressionNode* call) {
+    if (call->callee == NULL || call->callee->base_type != NODE_IDENTIFIER) {
+        codegen_error(codegen, (ASTNode*)call, "Only calls to top-level functions are supported by the C backend.");
+        emit(codegen, "0");
+        return;
+    }
+    const char* name = ((IdentifierNode*)call->callee)->name;
+    CodegenSymbol* symbol = find_function(codegen, name);
+    if (symbol == NULL && is_print(name)) {
+        emit(codegen, "(");
+        for (size_t i = 0; i < call->argument_count; ++i) {
+            ASTNode* arg = call->arguments[i];
+            const char* print = NULL;
+            switch (type_of(codegen, arg)) {
+                case CG_TYPE_STRING: print = "ouro_print"; break;
+                case CG_TYPE_BOOLEAN: print = "ouro_print_bool"; break;
+                case CG_TYPE_CHAR: print = "ouro_print_char"; break;
+                case CG_TYPE_FLOAT: case CG_TYPE_DOUBLE: print = "ouro_print_double"; break;
+                case CG_TYPE_SHORT: case CG_TYPE_INT: case CG_TYPE_LONG: print = "ouro_print_long"; break;
+                default:
+                    codegen_error(codegen, arg, "Cannot print this value.");
+                    continue;
             }
+            fprintf(codegen->output_file, "%s(", print);
+            generate_expression(codegen, arg);
+            emit(codegen, "), ");
+        }
+        emit(codegen, strcmp(name, "println") == 0 ? "putchar('\\n'), (void)0)" : "(void)0)");
+        return;
+    }
+    if (symbol == NULL) {
+        codegen_error(codegen, (ASTNode*)call, "Call to an undefined function.");
+        emit(codegen, "0");
+        return;
+    }
+    FunctionDeclarationNode* function = (FunctionDeclarationNode*)symbol->declaration;
+    if (call->argument_count > function->parameter_count) {
+        codegen_error(codegen, (ASTNode*)call, "Too many arguments in call.");
+    }
+    emit_name(codegen, name);
+    emit(codegen, "(");
+    for (size_t i = 0; i < function->parameter_count; ++i) {
+        if (i > 0) emit(codegen, ", ");
+        ParameterNode* param = function->parameters[i];
+        ASTNode* arg = i < call->argument_count ? call->arguments[i] : (ASTNode*)param->default_value;
+        if (arg == NULL) {
+            codegen_error(codegen, (ASTNode*)call, "Too few arguments in call.");
             break;
-        case NODE_ENUM_DECLARATION:
-             fprintf(codegen->output_file, "// Enum Declaration: %s\n", ((EnumDeclarationNode*)node)->name->name);
-             // TODO: Generate code for enum members
+        }
+        if (type_from_reference(param->type) == CG_TYPE_STRING) generate_as_string(codegen, arg);
+        else generate_expression(codegen, arg);
+    }
+    emit(codegen, ")");
+}
+
+static void generate_expression(CodeGenerator* codegen, ASTNode* expr) {
+    if (expr == NULL) return;
+
+    if (expr->base_type == NODE_LITERAL) {
+        generate_literal(codegen, (LiteralNode*)expr);
+        return;
+    }
+    if (expr->base_type == NODE_IDENTIFIER) {
+        IdentifierNode* id = (IdentifierNode*)expr;
+        if (find_variable(codegen, id->name) == NULL) codegen_error(codegen, expr, "Use of an undefined variable.");
+        emit_name(codegen, id->name);
+        return;
+    }
+    if (expr->base_type != NODE_EXPRESSION) {
+        codegen_error(codegen, expr, "Expected an expression.");
+        return;
+    }
+
+    switch (expression_type(expr)) {
+        case EXPR_BINARY:
+            generate_binary(codegen, (BinaryExpressionNode*)expr);
             break;
-        case NODE_STATEMENT:
-            // Statements need individual handling based on their specific type
-            if (node->statement_type == STMT_BLOCK) {
-                BlockStatementNode* block = (BlockStatementNode*)node;
-                fprintf(codegen->output_file, "{\n"); // Simple brace for C-like output
-                for (size_t i = 0; i < block->statement_count; ++i) {
-                    generate_code_for_node(codegen, (ASTNode*)block->statements[i]);
-                }
-                fprintf(codegen->output_file, "}\n");
-            } else if (node->statement_type == STMT_EXPRESSION) {
-                ExpressionStatementNode* expr_stmt = (ExpressionStatementNode*)node;
-                generate_code_for_expression(codegen, expr_stmt->expression);
-                fprintf(codegen->output_file, ";\n");
+        case EXPR_UNARY:
+            generate_unary(codegen, (UnaryExpressionNode*)expr);
+            break;
+        case EXPR_ASSIGNMENT:
+            generate_assignment(codegen, (AssignmentExpressionNode*)expr);
+            break;
+        case EXPR_CALL:
+            generate_call(codegen, (CallExpressionNode*)expr);
+            break;
+        case EXPR_CAST: {
+            CastExpressionNode* cast = (CastExpressionNode*)expr;
+            CodegenType type = type_from_reference(cast->target_type);
+            if (type == CG_TYPE_STRING) {
+                generate_as_string(codegen, cast->operand);
+            } else if (is_numeric(type) || type == CG_TYPE_BOOLEAN) {
+                fprintf(codegen->output_file, "((%s)", c_type(type));
+                generate_expression(codegen, cast->operand);
+                emit(codegen, ")");
+            } else {
+                codegen_error(codegen, expr, "Cast to a type the C backend does not support.");
             }
-            // Add more statement types here as they are parsed
             break;
-        case NODE_TYPE_REFERENCE:
-        case NODE_IDENTIFIER:
-        case NODE_PARAMETER:
-            // These might not generate code directly but are part of other nodes.
-            // For now, just a comment.
-            fprintf(codegen->output_file, "// Encountered AST Node: %s\n", ast_node_type_to_string(node->base_type));
+        }
+        case EXPR_TERNARY: {
+            TernaryExpressionNode* ternary = (TernaryExpressionNode*)expr;
+            emit(codegen, "(");
+            generate_expression(codegen, ternary->condition);
+            emit(codegen, " ? ");
+            generate_expression(codegen, ternary->true_expr);
+            emit(codegen, " : ");
+            generate_expression(codegen, ternary->false_expr);
+            emit(codegen, ")");
+            break;
+        }
+        case EXPR_MEMBER_ACCESS:
+        case EXPR_ARRAY_ACCESS:
+        case EXPR_NEW_OBJECT:
+        case EXPR_NEW_ARRAY:
+            codegen_error(codegen, expr, "Objects and arrays are not supported by the C backend yet.");
+            emit(codegen, "0");
+            break;
+        case EXPR_REF_PARAM:
+            codegen_error(codegen, expr, "ref and out arguments are not supported by the C backend yet.");
+            emit(codegen, "0");
             break;
         default:
-            fprintf(codegen->output_file, "// WARNING: Unknown AST Node Type encountered: %s\n", ast_node_type_to_string(node->base_type));
+            codegen_error(codegen, expr, "Unknown expression type.");
             break;
     }
 }
 
+// --- Statements ---
 
-static void generate_code_for_program(CodeGenerator* codegen, ProgramNode* program_node) {
-    if (program_node == NULL) return;
+/**
+ * Declares a variable in the current scope and writes its C declaration,
+ * without the trailing semicolon. The type is inferred from the initializer
+ * when none is given (var, let). A String variable owns its value.
+ * @return The variable's type.
+ */
+static CodegenType generate_variable(CodeGenerator* codegen, ASTNode* node, TypeReferenceNode* type_ref,
+                              IdentifierNode* name, ASTNode* initializer, bool with_initializer) {
+    CodegenType type = type_ref ? type_from_reference(type_ref) : type_of(codegen, initializer);
+    if (type == CG_TYPE_UNKNOWN || type == CG_TYPE_VOID) {
+        codegen_error(codegen, node, type_ref || initializer ? "Variable of a type the C backend does not support."
+                                                             : "Variable needs a type or an initializer.");
+        type = CG_TYPE_LONG; // Keep going, so later uses are not reported as undefined
+    }
+    fprintf(codegen->output_file, "%s ", c_type(type));
+    emit_name(codegen, name->name);
+    if (with_initializer) {
+        emit(codegen, " = ");
+        if (initializer == NULL) {
+            emit(codegen, zero_value(type));
+        } else if (type == CG_TYPE_STRING) {
+            emit(codegen, "ouro_own(");
+            generate_as_string(codegen, initializer);
+            emit(codegen, ")");
+        } else {
+            generate_expression(codegen, initializer);
+        }
+    }
+    declare_variable(codegen, name->name, type); // After the initializer, which cannot see it
+    return type;
+}
 
-    for (size_t i = 0; i < program_node->declaration_count; ++i) {
-        generate_code_for_node(codegen, program_node->declarations[i]);
-        fprintf(codegen->output_file, "\n"); // Separate top-level declarations
-    }
-}
-
-static void generate_code_for_expression(CodeGenerator* codegen, ExpressionNode* expr_node) {
-    if (expr_node == NULL) return;
-
-    switch (expr_node->expr_type) {
-        case EXPR_LITERAL: {
-            LiteralNode* literal = (LiteralNode*)expr_node;
-            switch (literal->value_type) {
-                case BOOLEAN_LITERAL:
-                    fprintf(codegen->output_file, "%s", literal->value.boolean_val ? "true" : "false");
-                    break;
-                case INTEGER_LITERAL:
-                    fprintf(codegen->output_file, "%lld", literal->value.integer_val);
-                    break;
-                case FLOATING_POINT_LITERAL:
-                    fprintf(codegen->output_file, "%f", literal->value.float_val);
-                    break;
-                case STRING_LITERAL:
-                    // Simple string literal, needs proper escaping for C output
-                    fprintf(codegen->output_file, "\"%s\"", literal->value.string_val);
-                    break;
-                case CHARACTER_LITERAL:
-                    fprintf(codegen->output_file, "'%c'", literal->value.char_val);
-                    break;
-                case NULL_LITERAL:
-                    fprintf(codegen->output_file, "null");
-                    break;
-                default:
-                    fprintf(codegen->output_file, "/* UNKNOWN_LITERAL_TYPE */");
-                    break;
-            }
-            break;
+// Whether a String variable declared since `scope` is still in scope
+static bool owns_strings(CodeGenerator* codegen, size_t scope) {
+    for (size_t i = scope; i < codegen->variable_count; ++i) {
+        if (codegen->variables[i].type == CG_TYPE_STRING) return true;
+    }
+    return false;
+}
+
+// Frees the Strings of the variables declared since `scope`, on leaving it,
+// except `kept`'s, which has been handed on
+static void emit_free_strings_except(CodeGenerator* codegen, size_t scope, const CodegenSymbol* kept) {
+    for (size_t i = codegen->variable_count; i-- > scope;) {
+        if (codegen->variables[i].type != CG_TYPE_STRING || &codegen->variables[i] == kept) continue;
+        emit_indent(codegen);
+        emit(codegen, "ouro_free(");
+        emit_name(codegen, codegen->variables[i].name);
+        emit(codegen, ");\n");
+    }
+}
+
+static void emit_free_strings(CodeGenerator* codegen, size_t scope) {
+    emit_free_strings_except(codegen, scope, NULL);
+}
+
+// Ends a statement that may have made temporaries by freeing them
+static void emit_release(CodeGenerator* codegen, bool temps) {
+    emit(codegen, temps ? "; ouro_temp_release(ouro_mark);\n" : ";\n");
+}
+
+// A loop or if body, in braces of its own so its declarations stay inside
+static void generate_body(CodeGenerator* codegen, ASTNode* stmt);
+
+// A loop body, where break and continue free what was declared inside it
+static void generate_loop_body(CodeGenerator* codegen, ASTNode* stmt) {
+    size_t outer = codegen->loop_scope;
+    codegen->loop_scope = codegen->variable_count;
+    generate_body(codegen, stmt);
+    codegen->loop_scope = outer;
+}
+
+static void generate_body(CodeGenerator* codegen, ASTNode* stmt) {
+    if (stmt != NULL && stmt->base_type == NODE_STATEMENT && statement_type(stmt) == STMT_BLOCK) {
+        generate_statement(codegen, stmt);
+        return;
+    }
+    emit_indent(codegen);
+    emit(codegen, "{\n");
+    codegen->indent++;
+    size_t scope = codegen->variable_count;
+    generate_statement(codegen, stmt);
+    emit_free_strings(codegen, scope);
+    codegen->variable_count = scope;
+    codegen->indent--;
+    emit_indent(codegen);
+    emit(codegen, "}\n");
+}
+
+// Frees the condition's temporaries once it has been tested, each time it is
+static void generate_condition(CodeGenerator* codegen, ASTNode* condition) {
+    emit(codegen, "(");
+    if (condition == NULL) {
+        emit(codegen, "true");
+    } else if (makes_temps(codegen, condition)) {
+        emit(codegen, "ouro_released(ouro_mark, ");
+        generate_expression(codegen, condition);
+        emit(codegen, ")");
+    } else {
+        generate_expression(codegen, condition);
+    }
+    emit(codegen, ")");
+}
+
+/**
+ * Writes `return`. Strings owned by the function's variables are freed
+ * first; a String result is handed to the caller as a temporary, so the
+ * statement that called the function frees it.
+ */
+static void generate_return(CodeGenerator* codegen, ReturnStatementNode* ret) {
+    ASTNode* value = (ASTNode*)ret->value;
+    bool string_result = codegen->return_type == CG_TYPE_STRING;
+    if (!owns_strings(codegen, codegen->function_scope)) {
+        emit_indent(codegen);
+        if (value == NULL) {
+            emit(codegen, "return;\n");
+            return;
         }
-        case EXPR_IDENTIFIER: {
-            IdentifierNode* id = (IdentifierNode*)expr_node;
-            fprintf(codegen->output_file, "%s", id->name);
-            break;
+        emit(codegen, "return ");
+        if (string_result) generate_as_string(codegen, value);
+        else generate_expression(codegen, value);
+        emit(codegen, ";\n");
+        return;
+    }
+
+    CodegenSymbol* local = NULL;
+    emit_indent(codegen);
+    emit(codegen, "{\n");
+    codegen->indent++;
+    if (value != NULL) {
+        emit_indent(codegen);
+        fprintf(codegen->output_file, "%s ouro_result = ", c_type(codegen->return_type));
+        if (string_result && value->base_type == NODE_IDENTIFIER) {
+            local = find_variable(codegen, ((IdentifierNode*)value)->name);
+            if (local && (size_t)(local - codegen->variables) < codegen->function_scope) local = NULL; // A global
         }
-        case EXPR_UNARY: {
-            UnaryExpressionNode* unary = (UnaryExpressionNode*)expr_node;
-            // Determine if prefix or postfix (based on token type and context in a real impl)
-            // For now, assume prefix if it's a typical unary op, postfix for increment/decrement
-            if (unary->operator->type == INCREMENT || unary->operator->type == DECREMENT) {
-                generate_code_for_expression(codegen, (ExpressionNode*)unary->operand);
-                fprintf(codegen->output_file, "%s", unary->operator->lexeme);
-            } else {
-                fprintf(codegen->output_file, "%s", unary->operator->lexeme);
-                generate_code_for_expression(codegen, (ExpressionNode*)unary->operand);
+        if (local && local->type != CG_TYPE_STRING) local = NULL;
+        if (local) {
+            // Returning a local: its String moves to the result instead of being copied
+            emit_name(codegen, local->name);
+            emit(codegen, ";\n");
+        } else if (string_result) {
+            emit(codegen, "ouro_own(");
+            generate_as_string(codegen, value);
+            emit(codegen, ");\n");
+        } else {
+            generate_expression(codegen, value);
+            emit(codegen, ";\n");
+        }
+    }
+    emit_free_strings_except(codegen, codegen->function_scope, local);
+    emit_indent(codegen);
+    if (value == NULL) emit(codegen, "return;\n");
+    else emit(codegen, string_result ? "return ouro_temp(ouro_result);\n" : "return ouro_result;\n");
+    codegen->indent--;
+    emit_indent(codegen);
+    emit(codegen, "}\n");
+}
+
+static void generate_statement(CodeGenerator* codegen, ASTNode* stmt) {
+    if (stmt == NULL) return;
+    if (stmt->base_type != NODE_STATEMENT) {
+        codegen_error(codegen, stmt, "Expected a statement.");
+        return;
+    }
+
+    switch (statement_type(stmt)) {
+        case STMT_BLOCK: {
+            BlockStatementNode* block = (BlockStatementNode*)stmt;
+            emit_indent(codegen);
+            emit(codegen, "{\n");
+            codegen->indent++;
+            size_t scope = codegen->variable_count;
+            for (size_t i = 0; i < block->statement_count; ++i) {
+                generate_statement(codegen, (ASTNode*)block->statements[i]);
             }
+            emit_free_strings(codegen, scope);
+            codegen->variable_count = scope;
+            codegen->indent--;
+            emit_indent(codegen);
+            emit(codegen, "}\n");
             break;
         }
-        case EXPR_BINARY: {
-            BinaryExpressionNode* binary = (BinaryExpressionNode*)expr_node;
-            fprintf(codegen->output_file, "("); // Add parentheses for correct precedence
-            generate_code_for_expression(codegen, (ExpressionNode*)binary->left);
-            fprintf(codegen->output_file, " %s ", binary->operator->lexeme);
-            generate_code_for_expression(codegen, (ExpressionNode*)binary->right);
-            fprintf(codegen->output_file, ")");
+        case STMT_EXPRESSION: {
+            ASTNode* expression = (ASTNode*)((ExpressionStatementNode*)stmt)->expression;
+            emit_indent(codegen);
+            generate_expression(codegen, expression);
+            emit_release(codegen, makes_temps(codegen, expression));
             break;
         }
-        case EXPR_ASSIGNMENT: {
-            AssignmentExpressionNode* assign = (AssignmentExpressionNode*)expr_node;
-            generate_code_for_expression(codegen, (ExpressionNode*)assign->target);
-            fprintf(codegen->output_file, " %s ", assign->operator->lexeme);
-            generate_code_for_expression(codegen, (ExpressionNode*)assign->value);
+        case STMT_VAR_DECL: {
+            VariableDeclarationStatementNode* var = (VariableDeclarationStatementNode*)stmt;
+            ASTNode* initializer = (ASTNode*)var->initializer;
+            emit_indent(codegen);
+            CodegenType type = generate_variable(codegen, stmt, var->type, var->name, initializer, true);
+            emit_release(codegen, makes_temps_as(codegen, initializer, type));
             break;
         }
-        case EXPR_CALL: {
-            CallExpressionNode* call = (CallExpressionNode*)expr_node;
-            generate_code_for_expression(codegen, (ExpressionNode*)call->callee);
-            fprintf(codegen->output_file, "(");
-            for (size_t i = 0; i < call->argument_count; ++i) {
-                generate_code_for_expression(codegen, (ExpressionNode*)call->arguments[i]);
-                if (i < call->argument_count - 1) {
-                    fprintf(codegen->output_file, ", ");
-                }
+        case STMT_IF: {
+            IfStatementNode* if_stmt = (IfStatementNode*)stmt;
+            emit_indent(codegen);
+            emit(codegen, "if ");
+            generate_condition(codegen, (ASTNode*)if_stmt->condition);
+            emit(codegen, "\n");
+            generate_body(codegen, (ASTNode*)if_stmt->then_branch);
+            if (if_stmt->else_branch) {
+                emit_indent(codegen);
+                emit(codegen, "else\n");
+                generate_body(codegen, (ASTNode*)if_stmt->else_branch);
             }
-            fprintf(codegen->output_file, ")");
             break;
         }
-        case EXPR_MEMBER_ACCESS: {
-            MemberAccessExpressionNode* member = (MemberAccessExpressionNode*)expr_node;
-            generate_code_for_expression(codegen, (ExpressionNode*)member->object);
-            fprintf(codegen->output_file, ".%s", member->member_name->name);
+        case STMT_WHILE: {
+            WhileStatementNode* loop = (WhileStatementNode*)stmt;
+            emit_indent(codegen);
+            emit(codegen, "while ");
+            generate_condition(codegen, (ASTNode*)loop->condition);
+            emit(codegen, "\n");
+            generate_loop_body(codegen, (ASTNode*)loop->body);
             break;
         }
-        case EXPR_ARRAY_ACCESS: {
-            ArrayAccessExpressionNode* array_access = (ArrayAccessExpressionNode*)expr_node;
-            generate_code_for_expression(codegen, (ExpressionNode*)array_access->array);
-            fprintf(codegen->output_file, "[");
-            generate_code_for_expression(codegen, (ExpressionNode*)array_access->index);
-            fprintf(codegen->output_file, "]");
+        case STMT_DO_WHILE: {
+            DoWhileStatementNode* loop = (DoWhileStatementNode*)stmt;
+            emit_indent(codegen);
+            emit(codegen, "do\n");
+            generate_loop_body(codegen, (ASTNode*)loop->body);
+            emit_indent(codegen);
+            emit(codegen, "while ");
+            generate_condition(codegen, (ASTNode*)loop->condition);
+            emit(codegen, ";\n");
             break;
         }
-        case EXPR_TERNARY: {
-            TernaryExpressionNode* ternary = (TernaryExpressionNode*)expr_node;
-            fprintf(codegen->output_file, "(");
-            generate_code_for_expression(codegen, (ExpressionNode*)ternary->condition);
-            fprintf(codegen->output_file, " ? ");
-            generate_code_for_expression(codegen, (ExpressionNode*)ternary->true_expr);
-            fprintf(codegen->output_file, " : ");
-            generate_code_for_expression(codegen, (ExpressionNode*)ternary->false_expr);
-            fprintf(codegen->output_file, ")");
+        case STMT_FOR: {
+            ForStatementNode* loop = (ForStatementNode*)stmt;
+            ASTNode* init = (ASTNode*)loop->initializer;
+            bool declares = init && init->base_type == NODE_STATEMENT && statement_type(init) == STMT_VAR_DECL;
+            size_t scope = codegen->variable_count; // The loop variable ends with the loop
+            // Temporaries from the header are freed each time the condition is tested
+            bool temps = makes_temps(codegen, (ASTNode*)loop->condition) ||
+                         makes_temps(codegen, (ASTNode*)loop->incrementer);
+            VariableDeclarationStatementNode* var = declares ? (VariableDeclarationStatementNode*)init : NULL;
+            bool string_variable = var && (var->type ? type_from_reference(var->type)
+                                                     : type_of(codegen, (ASTNode*)var->initializer)) == CG_TYPE_STRING;
+            if (string_variable) {
+                // Its String is freed after the loop, outside the C for statement
+                emit_indent(codegen);
+                emit(codegen, "{\n");
+                codegen->indent++;
+            }
+            emit_indent(codegen);
+            emit(codegen, "for (");
+            if (declares) {
+                CodegenType type = generate_variable(codegen, init, var->type, var->name, (ASTNode*)var->initializer, true);
+                temps = temps || makes_temps_as(codegen, (ASTNode*)var->initializer, type);
+            } else if (init && init->base_type == NODE_STATEMENT && statement_type(init) == STMT_EXPRESSION) {
+                ASTNode* expression = (ASTNode*)((ExpressionStatementNode*)init)->expression;
+                generate_expression(codegen, expression);
+                temps = temps || makes_temps(codegen, expression);
+            } else if (init) {
+                codegen_error(codegen, init, "Unsupported for-loop initializer.");
+            }
+            emit(codegen, "; ");
+            if (temps) {
+                emit(codegen, "ouro_released(ouro_mark, ");
+                if (loop->condition) generate_expression(codegen, (ASTNode*)loop->condition);
+                else emit(codegen, "true");
+                emit(codegen, ")");
+            } else if (loop->condition) {
+                generate_expression(codegen, (ASTNode*)loop->condition);
+            }
+            emit(codegen, "; ");
+            if (loop->incrementer) generate_expression(codegen, (ASTNode*)loop->incrementer);
+            emit(codegen, ")\n");
+            generate_loop_body(codegen, (ASTNode*)loop->body);
+            if (string_variable) {
+                emit_free_strings(codegen, scope);
+                codegen->indent--;
+                emit_indent(codegen);
+                emit(codegen, "}\n");
+            }
+            codegen->variable_count = scope;
             break;
         }
-        // Add more expression types here
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            if (((JumpStatementNode*)stmt)->label) {
+                codegen_error(codegen, stmt, "Labeled break and continue are not supported by the C backend yet.");
+            }
+            emit_free_strings(codegen, codegen->loop_scope);
+            emit_indent(codegen);
+            emit(codegen, statement_type(stmt) == STMT_BREAK ? "break;\n" : "continue;\n");
+            break;
+        case STMT_RETURN:
+            generate_return(codegen, (ReturnStatementNode*)stmt);
+            break;
+        case STMT_FOREACH:
+        case STMT_THROW:
+        case STMT_TRY_CATCH_FINALLY:
+            codegen_error(codegen, stmt, "foreach and exceptions are not supported by the C backend yet.");
+            break;
         default:
-            fprintf(codegen->output_file, "/* UNKNOWN_EXPRESSION_TYPE (%s) */", ast_node_type_to_string(expr_node->base.base_type));
+            codegen_error(codegen, stmt, "Unknown statement type.");
             break;
     }
-}
\ No newline at end of file
+}
+
+// --- Declarations ---
+
+static void generate_signature(CodeGenerator* codegen, FunctionDeclarationNode* function) {
+    CodegenType result = type_from_reference(function->return_type);
+    fprintf(codegen->output_file, "static %s ", c_type(result));
+    emit_name(codegen, function->name->name);
+    emit(codegen, "(");
+    if (function->parameter_count == 0) emit(codegen, "void");
+    for (size_t i = 0; i < function->parameter_count; ++i) {
+        ParameterNode* param = function->parameters[i];
+        if (i > 0) emit(codegen, ", ");
+        fprintf(codegen->output_file, "%s ", c_type(type_from_reference(param->type)));
+        emit_name(codegen, param->name->name);
+    }
+    emit(codegen, ")");
+}
+
+/**
+ * Writes a function. Its statements release their temporaries back to
+ * `ouro_mark`, which leaves those of the statement that called it alone.
+ * String parameters are copied (or adopted, if the caller passed a
+ * temporary), so the function may assign them like any other variable.
+ */
+static void generate_function(CodeGenerator* codegen, FunctionDeclarationNode* function) {
+    size_t scope = codegen->variable_count;
+    codegen->function_scope = scope;
+    for (size_t i = 0; i < function->parameter_count; ++i) {
+        ParameterNode* param = function->parameters[i];
+        declare_variable(codegen, param->name->name, type_from_reference(param->type));
+    }
+    codegen->return_type = type_from_reference(function->return_type);
+    generate_signature(codegen, function);
+    emit(codegen, "\n{\n");
+    codegen->indent = 1;
+    emit(codegen, "    size_t ouro_mark = ouro_temp_count;\n    (void)ouro_mark;\n");
+    for (size_t i = 0; i < function->parameter_count; ++i) {
+        if (codegen->variables[scope + i].type != CG_TYPE_STRING) continue;
+        emit_indent(codegen);
+        emit_name(codegen, codegen->variables[scope + i].name);
+        emit(codegen, " = ouro_own(");
+        emit_name(codegen, codegen->variables[scope + i].name);
+        emit(codegen, ");\n");
+    }
+    BlockStatementNode* body = function->body;
+    ASTNode* last = NULL;
+    for (size_t i = 0; body && i < body->statement_count; ++i) {
+        last = (ASTNode*)body->statements[i];
+        generate_statement(codegen, last);
+    }
+    if (last == NULL || last->base_type != NODE_STATEMENT || statement_type(last) != STMT_RETURN) {
+        emit_free_strings(codegen, scope); // A return has freed them already
+    }
+    codegen->indent = 0;
+    emit(codegen, "}\n");
+    codegen->variable_count = scope;
+    codegen->return_type = CG_TYPE_VOID;
+}
+
+/**
+ * Checks what a function's signature needs before anything is written, and
+ * records it so calls anywhere in the program can be typed.
+ */
+static void declare_function(CodeGenerator* codegen, FunctionDeclarationNode* function) {
+    ASTNode* node = (ASTNode*)function;
+    if (find_function(codegen, function->name->name)) {
+        codegen_error(codegen, node, "Function declared twice; overloading is not supported by the C backend.");
+        return;
+    }
+    CodegenType result = type_from_reference(function->return_type);
+    if (result == CG_TYPE_UNKNOWN) codegen_error(codegen, node, "Return type not supported by the C backend.");
+    for (size_t i = 0; i < function->parameter_count; ++i) {
+        ParameterNode* param = function->parameters[i];
+        CodegenType type = type_from_reference(param->type);
+        if (type == CG_TYPE_UNKNOWN || type == CG_TYPE_VOID) {
+            codegen_error(codegen, node, "Parameter type not supported by the C backend.");
+        }
+        if (param->modifier) codegen_error(codegen, node, "ref and out parameters are not supported by the C backend yet.");
+    }
+    codegen->functions = (CodegenSymbol*)ouro_realloc(codegen->functions,
+                                                      (codegen->function_count + 1) * sizeof(CodegenSymbol));
+    codegen->functions[codegen->function_count++] = (CodegenSymbol){function->name->name, result, function};
+}
+
+/**
+ * Writes the whole translation unit: globals, function prototypes and
+ * definitions, then the C entry point. Global initializers run in source
+ * order before the program's main, since C only allows constants in static
+ * initializers.
+ */
+static void generate_code_for_program(CodeGenerator* codegen, ProgramNode* program_node) {
+    if (program_node == NULL) return;
+    FILE* out = codegen->output_file;
+
+    // Signatures first, so calls may come before the function they call
+    for (size_t i = 0; i < program_node->declaration_count; ++i) {
+        ASTNode* decl = program_node->declarations[i];
+        if (decl && decl->base_type == NODE_DECLARATION && declaration_type(decl) == DECL_FUNCTION) {
+            declare_function(codegen, (FunctionDeclarationNode*)decl);
+        }
+    }
+
+    fprintf(out, "\n// Globals\n");
+    for (size_t i = 0; i < program_node->declaration_count; ++i) {
+        ASTNode* decl = program_node->declarations[i];
+        if (decl == NULL || decl->base_type != NODE_DECLARATION) continue;
+        switch (declaration_type(decl)) {
+            case DECL_VARIABLE: {
+                FieldDeclarationNode* field = (FieldDeclarationNode*)decl;
+                emit(codegen, "static ");
+                generate_variable(codegen, decl, field->type, field->name, (ASTNode*)field->initializer, false);
+                emit(codegen, ";\n");
+                break;
+            }
+            case DECL_PACKAGE:
+                fprintf(out, "// package %s\n", ((PackageDeclarationNode*)decl)->package_name->name);
+                break;
+            case DECL_IMPORT:
+                fprintf(out, "// import %s%s\n", ((ImportDeclarationNode*)decl)->imported_name->name,
+                        ((ImportDeclarationNode*)decl)->is_wildcard_import ? ".*" : "");
+                break;
+            case DECL_FUNCTION:
+                break;
+            default:
+                codegen_error(codegen, decl, "Classes, interfaces and enums are not supported by the C backend yet.");
+                break;
+        }
+    }
+
+    fprintf(out, "\n// Functions\n");
+    for (size_t i = 0; i < codegen->function_count; ++i) {
+        generate_signature(codegen, (FunctionDeclarationNode*)codegen->functions[i].declaration);
+        emit(codegen, ";\n");
+    }
+    for (size_t i = 0; i < codegen->function_count; ++i) {
+        emit(codegen, "\n");
+        generate_function(codegen, (FunctionDeclarationNode*)codegen->functions[i].declaration);
+    }
+
+    fprintf(out, "\nstatic void ouro_init_globals(void) {\n");
+    codegen->indent = 1;
+    for (size_t i = 0; i < program_node->declaration_count; ++i) {
+        ASTNode* decl = program_node->declarations[i];
+        if (decl == NULL || decl->base_type != NODE_DECLARATION || declaration_type(decl) != DECL_VARIABLE) continue;
+        FieldDeclarationNode* field = (FieldDeclarationNode*)decl;
+        CodegenSymbol* global = find_variable(codegen, field->name->name);
+        emit_indent(codegen);
+        emit_name(codegen, field->name->name);
+        emit(codegen, " = ");
+        if (field->initializer == NULL) {
+            emit(codegen, zero_value(global->type));
+        } else if (global->type == CG_TYPE_STRING) {
+            emit(codegen, "ouro_own(");
+            generate_as_string(codegen, (ASTNode*)field->initializer);
+            emit(codegen, ")");
+        } else {
+            generate_expression(codegen, (ASTNode*)field->initializer);
+        }
+        emit(codegen, ";\n");
+    }
+    codegen->indent = 0;
+    fprintf(out, "}\n");
+
+    CodegenSymbol* entry = find_function(codegen, "main");
+    FunctionDeclarationNode* main_function = entry ? (FunctionDeclarationNode*)entry->declaration : NULL;
+    if (main_function == NULL) {
+        codegen_error(codegen, (ASTNode*)program_node, "The program has no main function.");
+        return;
+    }
+    if (main_function->parameter_count > 0) {
+        codegen_error(codegen, (ASTNode*)main_function, "main must take no parameters.");
+    }
+    fprintf(out, "\nint main(void) {\n    ouro_init_globals();\n");
+    if (is_integral(entry->type)) {
+        fprintf(out, "    int status = (int)o_main();\n    fflush(stdout);\n    return status;\n}\n");
+    } else {
+        fprintf(out, "    o_main();\n    fflush(stdout);\n    return 0;\n}\n");
+    }
+}
@@ -5,7 +5,7 @@
 #include <token.h>
 #include <stdio.h> // For fprintf, EOF
 #include <stdlib.h> // For malloc, free, exit, strtol, strtod
-#include <string.h> // For strlen, strncmp, strcpy
+#include <string.h> // For strlen, strncmp, memcpy
 #include <ctype.h>  // For isalpha, isdigit, isalnum, isspace
 
 // --- Static helper function declarations ---
@@ -14,13 +14,15 @@ static char lexer_peek_next(Lexer* lexer);
 static char lexer_advance(Lexer* lexer);
 static int lexer_match(Lexer* lexer, char expected);
 static void lexer_skip_whitespace(Lexer* lexer); // Now strictly for whitespace and comments
-static Token* lexer_make_token(Lexer* lexer, TokenType type);
-static Token* lexer_make_literal_token(Lexer* lexer, TokenType type, LiteralValue literal);
-static Token* lexer_make_error_token(Lexer* lexer, const char* message);
-static Token* lexer_scan_string_literal(Lexer* lexer); // Returns Token*
-static Token* lexer_scan_char_literal(Lexer* lexer);  // Returns Token*
-static Token* lexer_scan_number_literal(Lexer* lexer); // Returns Token*
-static Token* lexer_scan_identifier_or_keyword(Lexer* lexer); // Returns Token*
+static void lexer_scan_span(Lexer* lexer, TokenSpan* span); // Scans one token without allocating
+static void lexer_make_token(Lexer* lexer, TokenSpan* span, TokenType type);
+static void lexer_make_literal_token(Lexer* lexer, TokenSpan* span, TokenType type, LiteralValue literal);
+static void lexer_make_error_token(Lexer* lexer, TokenSpan* span, const char* message);
+static void lexer_scan_string_literal(Lexer* lexer, TokenSpan* span);
+static void lexer_scan_char_literal(Lexer* lexer, TokenSpan* span);
+static void lexer_scan_number_literal(Lexer* lexer, TokenSpan* span);
+static void lexer_scan_identifier_or_keyword(Lexer* lexer, TokenSpan* span);
+static char* lexer_copy_text(const char* text, int length);
 
 // --- Keyword mapping ---
 // A simple array of structs and linear search for simplicity.
@@ -47,6 +49,19 @@ static KeywordMapping keywords[] = {
 };
 
 
+// Blocks of the TokenBuffer string arena. Payloads are bump-allocated and
+// never move, so string_val pointers stay valid while the buffer grows.
+struct StringArenaBlock {
+    StringArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+};
+
+#define STRING_ARENA_BLOCK_SIZE 65536
+#define TOKEN_BUFFER_INITIAL_CAPACITY 1024
+
+
 // --- Public API Implementations ---
 
 /**
@@ -66,6 +81,8 @@ Lexer* lexer_init(const char* source_code, const char* source_name) {
     lexer->source_length = (int)strlen(source_code);
     lexer->current_pos = 0;
     lexer->start_pos = 0;
+    lexer->start_line = 1;
+    lexer->start_column = 1;
     lexer->current_line = 1;
     lexer->current_column = 1;
     lexer->source_name = source_name; // source_name is assumed to be a persistent string (e.g., a literal or path)
@@ -80,122 +97,257 @@ Lexer* lexer_init(const char* source_code, const char* source_name) {
  * @return A dynamically allocated Token pointer, or NULL if an unrecoverable error occurs.
  */
 Token* lexer_scan_token(Lexer* lexer) {
+    TokenSpan span;
+    lexer_scan_span(lexer, &span);
+
+    char* lexeme = lexer_copy_text(lexer->source_code + span.offset, span.length);
+    Token* token;
+    if (span.type == ERROR_TOKEN) {
+        token = create_error_token(lexeme, span.error_message, span.line, span.column, lexer->source_name);
+    } else if (span.type == STRING_LITERAL) {
+        // The payload is the lexeme without its quotes
+        char* payload = lexer_copy_text(lexer->source_code + span.offset + 1, span.length - 2);
+        LiteralValue lit_val;
+        lit_val.string_val = payload; // create_token_with_literal will duplicate this
+        token = create_token_with_literal(span.type, lexeme, lit_val, span.line, span.column, lexer->source_name);
+        free(payload);
+    } else if (span.type == INTEGER_LITERAL || span.type == FLOATING_POINT_LITERAL ||
+               span.type == CHARACTER_LITERAL || span.type == BOOLEAN_LITERAL) {
+        token = create_token_with_literal(span.type, lexeme, span.literal, span.line, span.column, lexer->source_name);
+    } else {
+        token = create_token(span.type, lexeme, span.line, span.column, lexer->source_name);
+    }
+    free(lexeme); // create_token duplicates it, so free this temp buffer
+    return token;
+}
+
+/**
+ * Scans the rest of the source into a TokenBuffer, up to and including EOF_TOKEN.
+ * Lexemes stay in the source as (offset, length) spans; only string literal
+ * payloads are copied, into the buffer's arena.
+ * Responsibility: Caller must release the buffer with token_buffer_free().
+ * @param lexer A pointer to the Lexer instance.
+ * @param buffer The TokenBuffer to fill.
+ * @return true if the source had no lexical errors.
+ */
+bool lexer_scan_all(Lexer* lexer, TokenBuffer* buffer) {
+    memset(buffer, 0, sizeof(TokenBuffer));
+    buffer->source_code = lexer->source_code;
+    buffer->source_name = lexer->source_name;
+
+    // Doubling keeps regrowth to a few copies even for large files, and the
+    // buffer at most twice the size of its tokens
+    buffer->capacity = TOKEN_BUFFER_INITIAL_CAPACITY;
+    buffer->tokens = (TokenSpan*)malloc(buffer->capacity * sizeof(TokenSpan));
+    if (buffer->tokens == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for token buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (;;) {
+        if (buffer->count == buffer->capacity) {
+            buffer->capacity *= 2;
+            TokenSpan* grown = (TokenSpan*)realloc(buffer->tokens, buffer->capacity * sizeof(TokenSpan));
+            if (grown == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed for token buffer.\n");
+                exit(EXIT_FAILURE);
+            }
+            buffer->tokens = grown;
+        }
+
+        TokenSpan* span = &buffer->tokens[buffer->count++];
+        lexer_scan_span(lexer, span);
+
+        if (span->type == STRING_LITERAL) {
+            // Copy the payload, the lexeme without its quotes, into the arena
+            size_t length = (size_t)span->length - 2;
+            StringArenaBlock* block = buffer->strings;
+            if (block == NULL || block->capacity - block->used < length + 1) {
+                size_t capacity = length + 1 > STRING_ARENA_BLOCK_SIZE ? length + 1 : STRING_ARENA_BLOCK_SIZE;
+                block = (StringArenaBlock*)malloc(sizeof(StringArenaBlock) + capacity);
+                if (block == NULL) {
+                    fprintf(stderr, "Error: Memory allocation failed for string arena.\n");
+                    exit(EXIT_FAILURE);
+                }
+                block->next = buffer->strings;
+                block->used = 0;
+                block->capacity = capacity;
+                buffer->strings = block;
+            }
+            char* payload = block->data + block->used;
+            memcpy(payload, lexer->source_code + span->offset + 1, length);
+            payload[length] = '\0';
+            block->used += length + 1;
+            span->literal.string_val = payload;
+        } else if (span->type == ERROR_TOKEN) {
+            buffer->error_count++;
+        } else if (span->type == EOF_TOKEN) {
+            break;
+        }
+    }
+    return buffer->error_count == 0;
+}
+
+/**
+ * Frees the tokens and string payloads of a TokenBuffer, leaving it empty.
+ * Note: This does NOT free the source code the tokens refer to.
+ * @param buffer A pointer to the TokenBuffer to release.
+ */
+void token_buffer_free(TokenBuffer* buffer) {
+    if (buffer) {
+        free(buffer->tokens);
+        StringArenaBlock* block = buffer->strings;
+        while (block) {
+            StringArenaBlock* next = block->next;
+            free(block);
+            block = next;
+        }
+        memset(buffer, 0, sizeof(TokenBuffer));
+    }
+}
+
+/**
+ * Frees the memory associated with a Lexer instance.
+ * Note: This does NOT free the source_code string, as it is assumed to be owned externally.
+ * @param lexer A pointer to the Lexer instance to free.
+ */
+void lexer_free(Lexer* lexer) {
+    if (lexer) {
+        free(lexer);
+    }
+}
+
+
+// --- Static Helper Function Implementations ---
+
+/**
+ * Scans the next token into `span`. The lexeme is left in the source and
+ * nothing is allocated; a string literal's payload is the lexeme without
+ * its quotes, and is copied by the caller.
+ */
+static void lexer_scan_span(Lexer* lexer, TokenSpan* span) {
     lexer_skip_whitespace(lexer); // Skip any leading whitespace or comments
 
     lexer->start_pos = lexer->current_pos; // Mark the beginning of the new token
+    lexer->start_line = lexer->current_line;
+    lexer->start_column = lexer->current_column;
 
     if (lexer->current_pos >= lexer->source_length) {
-        return lexer_make_token(lexer, EOF_TOKEN);
+        lexer_make_token(lexer, span, EOF_TOKEN);
+        return;
     }
 
     char c = lexer_advance(lexer); // Consume the current character
 
     switch (c) {
         // --- Single-character tokens ---
-        case '(': return lexer_make_token(lexer, LPARENT);
-        case ')': return lexer_make_token(lexer, RPARENT);
-        case '{': return lexer_make_token(lexer, LBRACE);
-        case '}': return lexer_make_token(lexer, RBRACE);
-        case '[': return lexer_make_token(lexer, LBRACKET);
-        case ']': return lexer_make_token(lexer, RBRACKET);
-        case ',': return lexer_make_token(lexer, COMMA);
-        case ';': return lexer_make_token(lexer, SEMICOLON);
-        case ':': return lexer_make_token(lexer, COLON);
-        case '?': return lexer_make_token(lexer, QUESTION_MARK);
-        case '~': return lexer_make_token(lexer, BIT_NOT);
+        case '(': lexer_make_token(lexer, span, LPARENT); return;
+        case ')': lexer_make_token(lexer, span, RPARENT); return;
+        case '{': lexer_make_token(lexer, span, LBRACE); return;
+        case '}': lexer_make_token(lexer, span, RBRACE); return;
+        case '[': lexer_make_token(lexer, span, LBRACKET); return;
+        case ']': lexer_make_token(lexer, span, RBRACKET); return;
+        case ',': lexer_make_token(lexer, span, COMMA); return;
+        case ';': lexer_make_token(lexer, span, SEMICOLON); return;
+        case ':': lexer_make_token(lexer, span, COLON); return;
+        case '?': lexer_make_token(lexer, span, QUESTION_MARK); return;
+        case '~': lexer_make_token(lexer, span, BIT_NOT); return;
 
         // --- Multi-character operators and period/range ---
         case '.':
             if (lexer_match(lexer, '.')) {
-                if (lexer_match(lexer, '.')) return lexer_make_token(lexer, RANGE); // ...
-                if (lexer_match(lexer, '<')) return lexer_make_token(lexer, EXCLUSIVE_RANGE); // ..<
+                if (lexer_match(lexer, '.')) { lexer_make_token(lexer, span, RANGE); return; } // ...
+                if (lexer_match(lexer, '<')) { lexer_make_token(lexer, span, EXCLUSIVE_RANGE); return; } // ..<
             }
-            return lexer_make_token(lexer, PERIOD);
+            lexer_make_token(lexer, span, PERIOD);
+            return;
 
         case '+':
-            if (lexer_match(lexer, '+')) return lexer_make_token(lexer, INCREMENT);
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, PLUS_EQUALS);
-            return lexer_make_token(lexer, PLUS);
+            if (lexer_match(lexer, '+')) { lexer_make_token(lexer, span, INCREMENT); return; }
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, PLUS_EQUALS); return; }
+            lexer_make_token(lexer, span, PLUS);
+            return;
         case '-':
-            if (lexer_match(lexer, '-')) return lexer_make_token(lexer, DECREMENT);
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, MINUS_EQUALS);
-            return lexer_make_token(lexer, MINUS);
+            if (lexer_match(lexer, '-')) { lexer_make_token(lexer, span, DECREMENT); return; }
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, MINUS_EQUALS); return; }
+            lexer_make_token(lexer, span, MINUS);
+            return;
         case '*':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, MULTIPLY_EQUALS);
-            return lexer_make_token(lexer, MULTIPLY);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, MULTIPLY_EQUALS); return; }
+            lexer_make_token(lexer, span, MULTIPLY);
+            return;
         case '/':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, DIVIDE_EQUALS);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, DIVIDE_EQUALS); return; }
             // Comments are handled in lexer_skip_whitespace, so this '/' is always division here.
-            return lexer_make_token(lexer, DIVIDE);
+            lexer_make_token(lexer, span, DIVIDE);
+            return;
         case '%':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, MODULO_EQUALS);
-            return lexer_make_token(lexer, MODULO);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, MODULO_EQUALS); return; }
+            lexer_make_token(lexer, span, MODULO);
+            return;
         case '!':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, NE);
-            return lexer_make_token(lexer, NOT);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, NE); return; }
+            lexer_make_token(lexer, span, NOT);
+            return;
         case '=':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, EQ);
-            return lexer_make_token(lexer, ASSIGN);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, EQ); return; }
+            lexer_make_token(lexer, span, ASSIGN);
+            return;
         case '<':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, LE);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, LE); return; }
             if (lexer_match(lexer, '<')) {
-                if (lexer_match(lexer, '=')) return lexer_make_token(lexer, LEFT_SHIFT_EQUALS);
-                return lexer_make_token(lexer, LEFT_SHIFT);
+                if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, LEFT_SHIFT_EQUALS); return; }
+                lexer_make_token(lexer, span, LEFT_SHIFT);
+                return;
             }
-            return lexer_make_token(lexer, LT);
+            lexer_make_token(lexer, span, LT);
+            return;
         case '>':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, GE);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, GE); return; }
             if (lexer_match(lexer, '>')) {
-                if (lexer_match(lexer, '=')) return lexer_make_token(lexer, RIGHT_SHIFT_EQUALS);
+                if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, RIGHT_SHIFT_EQUALS); return; }
                 if (lexer_match(lexer, '>')) { // >>>
-                    if (lexer_match(lexer, '=')) return lexer_make_token(lexer, UNSIGNED_RIGHT_SHIFT_EQUALS); // >>>=
-                    return lexer_make_token(lexer, UNSIGNED_RIGHT_SHIFT);
+                    if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, UNSIGNED_RIGHT_SHIFT_EQUALS); return; } // >>>=
+                    lexer_make_token(lexer, span, UNSIGNED_RIGHT_SHIFT);
+                    return;
                 }
-                return lexer_make_token(lexer, RIGHT_SHIFT);
+                lexer_make_token(lexer, span, RIGHT_SHIFT);
+                return;
             }
-            return lexer_make_token(lexer, GT);
+            lexer_make_token(lexer, span, GT);
+            return;
         case '&':
-            if (lexer_match(lexer, '&')) return lexer_make_token(lexer, AND);
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, BIT_AND_EQUALS);
-            return lexer_make_token(lexer, BIT_AND);
+            if (lexer_match(lexer, '&')) { lexer_make_token(lexer, span, AND); return; }
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, BIT_AND_EQUALS); return; }
+            lexer_make_token(lexer, span, BIT_AND);
+            return;
         case '|':
-            if (lexer_match(lexer, '|')) return lexer_make_token(lexer, OR);
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, BIT_OR_EQUALS);
-            return lexer_make_token(lexer, BIT_OR);
+            if (lexer_match(lexer, '|')) { lexer_make_token(lexer, span, OR); return; }
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, BIT_OR_EQUALS); return; }
+            lexer_make_token(lexer, span, BIT_OR);
+            return;
         case '^':
-            if (lexer_match(lexer, '=')) return lexer_make_token(lexer, BIT_XOR_EQUALS);
-            return lexer_make_token(lexer, BIT_XOR);
+            if (lexer_match(lexer, '=')) { lexer_make_token(lexer, span, BIT_XOR_EQUALS); return; }
+            lexer_make_token(lexer, span, BIT_XOR);
+            return;
 
         // --- Literals ---
-        case '"': return lexer_scan_string_literal(lexer);
-        case '\'': return lexer_scan_char_literal(lexer);
+        case '"': lexer_scan_string_literal(lexer, span); return;
+        case '\'': lexer_scan_char_literal(lexer, span); return;
 
         default:
-            if (isdigit(c)) {
-                return lexer_scan_number_literal(lexer);
-            } else if (isalpha(c) || c == '_') {
-                return lexer_scan_identifier_or_keyword(lexer);
+            if (isdigit((unsigned char)c)) {
+                lexer_scan_number_literal(lexer, span);
+            } else if (isalpha((unsigned char)c) || c == '_') {
+                lexer_scan_identifier_or_keyword(lexer, span);
             } else {
                 // If we reach here, it's an unrecognized character
-                return lexer_make_error_token(lexer, "Unrecognized character.");
+                lexer_make_error_token(lexer, span, "Unrecognized character.");
             }
+            return;
     }
 }
 
-/**
- * Frees the memory associated with a Lexer instance.
- * Note: This does NOT free the source_code string, as it is assumed to be owned externally.
- * @param lexer A pointer to the Lexer instance to free.
- */
-void lexer_free(Lexer* lexer) {
-    if (lexer) {
-        free(lexer);
-    }
-}
-
-
-// --- Static Helper Function Implementations ---
-
 /**
  * Returns the character at the current position without advancing.
  * Returns EOF if at the end of the source.
@@ -217,7 +369,6 @@ static char lexer_peek_next(Lexer* lexer) {
     }
     return lexer->source_code[lexer->current_pos + 1];
 }
-
 /**
  * Consumes the current character and advances the position.
  * Also updates line and column numbers.
@@ -301,96 +452,70 @@ static void lexer_skip_whitespace(Lexer* lexer) {
     }
 }
 
+
 /**
- * Creates a basic token with the current lexeme range.
- * Automatically extracts the lexeme string and duplicates it.
+ * Fills `span` with a basic token over the current lexeme range.
+ * The lexeme is not copied; the span records where it is in the source.
  * @param lexer The lexer instance.
+ * @param span The TokenSpan to fill.
  * @param type The TokenType.
- * @return A new Token*. Caller must free.
  */
-static Token* lexer_make_token(Lexer* lexer, TokenType type) {
-    int lexeme_length = lexer->current_pos - lexer->start_pos;
-    char* lexeme_buf = (char*)malloc(lexeme_length + 1);
-    if (lexeme_buf == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for lexeme_buf in make_token.\n");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(lexeme_buf, lexer->source_code + lexer->start_pos, lexeme_length);
-    lexeme_buf[lexeme_length] = '\0';
-
-    int token_start_column = lexer->current_column - lexeme_length;
-    // Special handling for tokens that might start right after a newline, resetting column.
-    if (lexer->source_code[lexer->start_pos] == '\n' || lexer->start_pos == 0) {
-        token_start_column = 1;
-    }
-
-    Token* token = create_token(type, lexeme_buf, lexer->current_line, token_start_column, lexer->source_name);
-    free(lexeme_buf); // create_token duplicates it, so free this temp buffer
-    return token;
+static void lexer_make_token(Lexer* lexer, TokenSpan* span, TokenType type) {
+    span->type = type;
+    span->offset = lexer->start_pos;
+    span->length = lexer->current_pos - lexer->start_pos;
+    span->line = lexer->start_line;
+    span->column = lexer->start_column;
+    span->literal.integer_val = 0;
+    span->error_message = NULL;
 }
 
 /**
- * Creates a token with a literal value from the current lexeme range.
+ * Fills `span` with a token with a literal value over the current lexeme range.
  * @param lexer The lexer instance.
+ * @param span The TokenSpan to fill.
  * @param type The TokenType (must be a literal type).
  * @param literal The LiteralValue union containing the parsed value.
- * @return A new Token*. Caller must free.
  */
-static Token* lexer_make_literal_token(Lexer* lexer, TokenType type, LiteralValue literal) {
-    int lexeme_length = lexer->current_pos - lexer->start_pos;
-    char* lexeme_buf = (char*)malloc(lexeme_length + 1);
-    if (lexeme_buf == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for lexeme_buf in make_literal_token.\n");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(lexeme_buf, lexer->source_code + lexer->start_pos, lexeme_length);
-    lexeme_buf[lexeme_length] = '\0';
-
-    int token_start_column = lexer->current_column - lexeme_length;
-     if (lexer->source_code[lexer->start_pos] == '\n' || lexer->start_pos == 0) {
-        token_start_column = 1;
-    }
-
-    Token* token = create_token_with_literal(type, lexeme_buf, literal, lexer->current_line, token_start_column, lexer->source_name);
-    free(lexeme_buf);
-    return token;
+static void lexer_make_literal_token(Lexer* lexer, TokenSpan* span, TokenType type, LiteralValue literal) {
+    lexer_make_token(lexer, span, type);
+    span->literal = literal;
 }
 
 /**
- * Creates an error token from the current lexeme range.
+ * Fills `span` with an error token over the current lexeme range.
  * @param lexer The lexer instance.
- * @param message The specific error message.
- * @return A new Token*. Caller must free.
+ * @param span The TokenSpan to fill.
+ * @param message The specific error message; a static string.
  */
-static Token* lexer_make_error_token(Lexer* lexer, const char* message) {
-    int lexeme_length = lexer->current_pos - lexer->start_pos;
-    char* lexeme_buf = (char*)malloc(lexeme_length + 1);
-    if (lexeme_buf == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for lexeme_buf in make_error_token.\n");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(lexeme_buf, lexer->source_code + lexer->start_pos, lexeme_length);
-    lexeme_buf[lexeme_length] = '\0';
+static void lexer_make_error_token(Lexer* lexer, TokenSpan* span, const char* message) {
+    lexer_make_token(lexer, span, ERROR_TOKEN);
+    span->error_message = message;
+}
 
-    int token_start_column = lexer->current_column - lexeme_length;
-     if (lexer->source_code[lexer->start_pos] == '\n' || lexer->start_pos == 0) {
-        token_start_column = 1;
+/**
+ * Returns a NUL-terminated copy of `length` bytes of `text`.
+ * Responsibility: Caller must free the returned string.
+ */
+static char* lexer_copy_text(const char* text, int length) {
+    char* copy = (char*)malloc((size_t)length + 1);
+    if (copy == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for lexeme copy.\n");
+        exit(EXIT_FAILURE);
     }
-
-    Token* token = create_error_token(lexeme_buf, message, lexer->current_line, token_start_column, lexer->source_name);
-    free(lexeme_buf);
-    return token;
+    memcpy(copy, text, (size_t)length);
+    copy[length] = '\0';
+    return copy;
 }
 
 /**
  * Scans a string literal (e.g., "hello world").
  * The initial '"' should already be consumed by lexer_advance().
+ * The payload, the text between the quotes, is left to the caller to copy.
  * @param lexer The lexer instance.
- * @return A STRING_LITERAL token or an ERROR_TOKEN if unterminated/invalid.
+ * @param span Receives a STRING_LITERAL token or an ERROR_TOKEN if unterminated/invalid.
  */
-static Token* lexer_scan_string_literal(Lexer* lexer) {
-    int literal_start_pos = lexer->current_pos; // Start after the opening '"'
-
+static void lexer_scan_string_literal(Lexer* lexer, TokenSpan* span) {
     while (lexer_peek(lexer) != '"' && lexer_peek(lexer) != EOF) {
         if (lexer_peek(lexer) == '\\') { // Handle escape sequences within string
             lexer_advance(lexer); // Consume '\'
@@ -402,45 +527,36 @@ static Token* lexer_scan_string_literal(Lexer* lexer) {
     }
 
     if (lexer_peek(lexer) == EOF) {
-        return lexer_make_error_token(lexer, "Unterminated string literal.");
-    }
-
-    // Extract the content *before* consuming the closing quote
-    int string_content_length = lexer->current_pos - literal_start_pos;
-    char* string_content = (char*)malloc(string_content_length + 1);
-    if (string_content == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for string_content.\n");
-        exit(EXIT_FAILURE);
+        lexer_make_error_token(lexer, span, "Unterminated string literal.");
+        return;
     }
-    strncpy(string_content, lexer->source_code + literal_start_pos, string_content_length);
-    string_content[string_content_length] = '\0';
 
     lexer_advance(lexer); // Consume the closing '"'
 
     LiteralValue lit_val;
-    lit_val.string_val = string_content; // create_token_with_literal will duplicate this
-    Token* token = lexer_make_literal_token(lexer, STRING_LITERAL, lit_val);
-    free(string_content); // Free the temporary buffer, as create_token_with_literal duplicates it
-    return token;
+    lit_val.string_val = NULL; // Set by the caller once the payload is copied
+    lexer_make_literal_token(lexer, span, STRING_LITERAL, lit_val);
 }
 
 /**
  * Scans a character literal (e.g., 'a', '\n').
  * The initial "'" should already be consumed by lexer_advance().
  * @param lexer The lexer instance.
- * @return A CHARACTER_LITERAL token or an ERROR_TOKEN if unterminated/invalid.
+ * @param span Receives a CHARACTER_LITERAL token or an ERROR_TOKEN if unterminated/invalid.
  */
-static Token* lexer_scan_char_literal(Lexer* lexer) {
+static void lexer_scan_char_literal(Lexer* lexer, TokenSpan* span) {
     char char_val;
 
     if (lexer_peek(lexer) == EOF) {
-        return lexer_make_error_token(lexer, "Unterminated character literal.");
+        lexer_make_error_token(lexer, span, "Unterminated character literal.");
+        return;
     }
 
     if (lexer_peek(lexer) == '\\') { // Handle escape sequences
         lexer_advance(lexer); // Consume '\'
         if (lexer_peek(lexer) == EOF) {
-            return lexer_make_error_token(lexer, "Incomplete escape sequence in character literal.");
+            lexer_make_error_token(lexer, span, "Incomplete escape sequence in character literal.");
+            return;
         }
         char escaped_char = lexer_advance(lexer);
         switch (escaped_char) {
@@ -454,137 +570,114 @@ static Token* lexer_scan_char_literal(Lexer* lexer) {
             case '"': char_val = '"'; break;
             // Add more escape sequences as needed (e.g., \u for unicode, \x for hex)
             default:
-                return lexer_make_error_token(lexer, "Unknown escape sequence in character literal.");
+                lexer_make_error_token(lexer, span, "Unknown escape sequence in character literal.");
+                return;
         }
     } else {
         char_val = lexer_advance(lexer); // Consume the character
     }
 
     if (lexer_peek(lexer) != '\'') {
-        return lexer_make_error_token(lexer, "Unterminated or invalid character literal. Expected single character followed by closing quote.");
+        lexer_make_error_token(lexer, span, "Unterminated or invalid character literal. Expected single character followed by closing quote.");
+        return;
     }
     lexer_advance(lexer); // Consume the closing "'"
 
     LiteralValue lit_val;
     lit_val.char_val = char_val;
-    return lexer_make_literal_token(lexer, CHARACTER_LITERAL, lit_val);
+    lexer_make_literal_token(lexer, span, CHARACTER_LITERAL, lit_val);
 }
 
 /**
  * Scans an integer or floating-point number literal.
  * The first digit should already be consumed by lexer_advance().
  * @param lexer The lexer instance.
- * @return An INTEGER_LITERAL or FLOATING_POINT_LITERAL token, or an ERROR_TOKEN.
+ * @param span Receives an INTEGER_LITERAL or FLOATING_POINT_LITERAL token, or an ERROR_TOKEN.
  */
-static Token* lexer_scan_number_literal(Lexer* lexer) {
+static void lexer_scan_number_literal(Lexer* lexer, TokenSpan* span) {
     // Consume digits before a potential decimal point
-    while (isdigit(lexer_peek(lexer))) {
+    while (isdigit((unsigned char)lexer_peek(lexer))) {
         lexer_advance(lexer);
     }
 
     // Check for a fractional part
     int is_float = 0;
-    if (lexer_peek(lexer) == '.' && isdigit(lexer_peek_next(lexer))) {
+    if (lexer_peek(lexer) == '.' && isdigit((unsigned char)lexer_peek_next(lexer))) {
         is_float = 1;
         lexer_advance(lexer); // Consume '.'
-        while (isdigit(lexer_peek(lexer))) {
+        while (isdigit((unsigned char)lexer_peek(lexer))) {
             lexer_advance(lexer); // Consume digits after decimal
         }
     }
 
     // Check for exponent part (e.g., 1.2e-5)
     if ((lexer_peek(lexer) == 'e' || lexer_peek(lexer) == 'E') &&
-        (isdigit(lexer_peek_next(lexer)) ||
-         ((lexer_peek_next(lexer) == '+' || lexer_peek_next(lexer) == '-') && isdigit(lexer->source_code[lexer->current_pos + 2])))) {
+        (isdigit((unsigned char)lexer_peek_next(lexer)) ||
+         ((lexer_peek_next(lexer) == '+' || lexer_peek_next(lexer) == '-') && isdigit((unsigned char)lexer->source_code[lexer->current_pos + 2])))) {
         is_float = 1;
         lexer_advance(lexer); // Consume 'e' or 'E'
         if (lexer_peek(lexer) == '+' || lexer_peek(lexer) == '-') {
             lexer_advance(lexer); // Consume '+' or '-'
         }
-        while (isdigit(lexer_peek(lexer))) {
+        while (isdigit((unsigned char)lexer_peek(lexer))) {
             lexer_advance(lexer); // Consume exponent digits
         }
     }
 
-    // Extract the numeric lexeme string
-    int lexeme_length = lexer->current_pos - lexer->start_pos;
-    char* num_str = (char*)malloc(lexeme_length + 1);
-    if (num_str == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for number string in scan_number_literal.\n");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(num_str, lexer->source_code + lexer->start_pos, lexeme_length);
-    num_str[lexeme_length] = '\0';
-
+    // Convert straight from the source: the conversion must stop exactly where the lexeme ends
+    const char* num_str = lexer->source_code + lexer->start_pos;
+    const char* num_end = lexer->source_code + lexer->current_pos;
+    char* endptr;
     LiteralValue lit_val;
-    Token* token = NULL;
 
     if (is_float) {
-        char *endptr;
         lit_val.float_val = strtod(num_str, &endptr);
-        if (*endptr != '\0') {
-            token = lexer_make_error_token(lexer, "Invalid floating point literal.");
+        if (endptr != num_end) {
+            lexer_make_error_token(lexer, span, "Invalid floating point literal.");
         } else {
-            token = lexer_make_literal_token(lexer, FLOATING_POINT_LITERAL, lit_val);
+            lexer_make_literal_token(lexer, span, FLOATING_POINT_LITERAL, lit_val);
         }
     } else {
-        char *endptr;
         lit_val.integer_val = strtoll(num_str, &endptr, 10); // Base 10
-        if (*endptr != '\0') {
-             token = lexer_make_error_token(lexer, "Invalid integer literal.");
+        if (endptr != num_end) {
+            lexer_make_error_token(lexer, span, "Invalid integer literal.");
         } else {
-            token = lexer_make_literal_token(lexer, INTEGER_LITERAL, lit_val);
+            lexer_make_literal_token(lexer, span, INTEGER_LITERAL, lit_val);
         }
     }
-    free(num_str); // Free the temporary buffer
-    return token;
 }
 
 /**
  * Scans an identifier or a keyword.
  * The first character (alpha or underscore) should already be consumed.
  * @param lexer The lexer instance.
- * @return An IDENTIFIER token or a keyword TokenType token.
+ * @param span Receives an IDENTIFIER token or a keyword TokenType token.
  */
-static Token* lexer_scan_identifier_or_keyword(Lexer* lexer) {
-    while (isalnum(lexer_peek(lexer)) || lexer_peek(lexer) == '_') {
+static void lexer_scan_identifier_or_keyword(Lexer* lexer, TokenSpan* span) {
+    while (isalnum((unsigned char)lexer_peek(lexer)) || lexer_peek(lexer) == '_') {
         lexer_advance(lexer);
     }
 
+    const char* text = lexer->source_code + lexer->start_pos;
     int lexeme_length = lexer->current_pos - lexer->start_pos;
-    char* text = (char*)malloc(lexeme_length + 1);
-    if (text == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed for identifier/keyword text.\n");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(text, lexer->source_code + lexer->start_pos, lexeme_length);
-    text[lexeme_length] = '\0';
 
     TokenType type = IDENTIFIER; // Assume it's an identifier by default
 
-    // Check if it's a reserved keyword
+    // Check if it's a reserved keyword, comparing against the source in place
     for (int i = 0; keywords[i].lexeme != NULL; i++) {
-        if (strcmp(text, keywords[i].lexeme) == 0) {
+        if (strncmp(text, keywords[i].lexeme, lexeme_length) == 0 && keywords[i].lexeme[lexeme_length] == '\0') {
             type = keywords[i].type;
             break;
         }
     }
-    
-    // For boolean and null literals, the lexeme is also the literal value
-    LiteralValue lit_val;
+
+    // For boolean literals, the lexeme is also the literal value
     if (type == BOOLEAN_LITERAL) {
-        lit_val.boolean_val = (strcmp(text, "true") == 0);
-        Token* token = lexer_make_literal_token(lexer, type, lit_val);
-        free(text);
-        return token;
-    } else if (type == NULL_LITERAL) {
-        // NULL_LITERAL typically doesn't hold a value in the union, just its type is enough
-        Token* token = lexer_make_token(lexer, type); // Use make_token as no literal value for union
-        free(text);
-        return token;
+        LiteralValue lit_val;
+        lit_val.boolean_val = (text[0] == 't');
+        lexer_make_literal_token(lexer, span, type, lit_val);
     } else {
-        Token* token = lexer_make_token(lexer, type);
-        free(text); // Free the temporary text buffer
-        return token;
+        // NULL_LITERAL doesn't hold a value in the union, just its type is enough
+        lexer_make_token(lexer, span, type);
     }
 }
@@ -1,14 +1,23 @@
 // main.c
 // Main entry point for the Ouroboros compiler.
-// This program currently implements the lexical analysis phase.
+// Without options it prints the tokens of a source file. With -o it parses the
+// file and compiles it to a native executable through the C backend.
 
 #include <stdio.h>  // For printf, fprintf, FILE*, fopen, fread, fclose
 #include <stdlib.h> // For EXIT_SUCCESS, EXIT_FAILURE, malloc, free
 #include <string.h> // For strlen, strerror
 #include <errno.h>  // For errno
+#ifdef _WIN32
+#include <process.h>  // For _spawnvp
+#else
+#include <sys/wait.h> // For waitpid
+#include <unistd.h>   // For fork, execvp
+#endif
 
-#include "ouroboros/lexer.h" // Include the Lexer header
-#include "ouroboros/token.h" // Include the Token header
+#include "lexer.h" // Include the Lexer header
+#include "token.h" // Include the Token header
+#include "parser.h"
+#include "ouroboros/codegen.h"
 
 // Function to read the entire content of a file into a dynamically allocated string.
 // @param file_path The path to the file.
@@ -59,7 +68,8 @@ static int read_file_to_string(const char* file_path, char** out_buffer, int* ou
 }
 
 // Helper function to print token information.
-static void print_token(Token* token) {
+// The lexeme is printed from its span of the buffer's source code.
+static void print_token(const TokenBuffer* buffer, const TokenSpan* token) {
     // A mapping from TokenType to string for better output.
     // This could be made into a separate function in token.c if desired for reuse.
     const char* token_type_to_string(TokenType type) {
@@ -112,14 +122,14 @@ static void print_token(Token* token) {
         }
     }
 
-    printf("Type: %s (Lexeme: '%s') at %s Line: %d, Column: %d",
+    printf("Type: %s (Lexeme: '%.*s') at %s Line: %d, Column: %d",
            token_type_to_string(token->type),
-           token->lexeme ? token->lexeme : "N/A", // Handle NULL lexeme
-           token->source_name ? token->source_name : "UnknownSource",
+           token->length, buffer->source_code + token->offset,
+           buffer->source_name ? buffer->source_name : "UnknownSource",
            token->line,
            token->column);
 
-    if (token->has_literal) {
+    if (token->type >= INTEGER_LITERAL && token->type <= BOOLEAN_LITERAL) {
         printf(" [Literal: ");
         switch (token->type) {
             case INTEGER_LITERAL: printf("Int(%lld)", token->literal.integer_val); break;
@@ -139,13 +149,186 @@ static void print_token(Token* token) {
 }
 
 
+// Runs $CC (cc by default) on the generated C. $CC names the compiler alone,
+// without flags. Each path is passed as an argument of its own, not through
+// a shell, so quotes, `$` and backquotes in it are taken literally.
+// @return True if the compiler ran and succeeded.
+static bool run_c_compiler(const char* c_path, const char* output) {
+    const char* cc = getenv("CC");
+    if (cc == NULL || *cc == '\0') {
+        cc = "cc";
+    }
+    const char* args[] = {cc, "-O2", "-fwrapv", "-o", output, c_path, "-lm", NULL};
+    printf("--- Compiling: %s -O2 -fwrapv -o %s %s -lm ---\n", cc, output, c_path);
+    fflush(stdout); // Before the compiler's own output
+
+#ifdef _WIN32
+    return _spawnvp(_P_WAIT, cc, args) == 0;
+#else
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: Could not start '%s': %s\n", cc, strerror(errno));
+        return false;
+    }
+    if (pid == 0) {
+        execvp(cc, (char* const*)args);
+        fprintf(stderr, "Error: Could not run '%s': %s\n", cc, strerror(errno));
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+
+// Generates C for the program in `source_code` and builds it into `output`.
+// An output ending in ".c" receives the C itself; anything else is an
+// executable, compiled from `<output>.c` by $CC (cc by default) at -O2.
+// @return 0 on success, -1 on failure.
+static int compile_to(const char* source_code, const char* file_path, const char* output) {
+    Lexer* lexer = lexer_init(source_code, file_path);
+    if (lexer == NULL) {
+        return -1;
+    }
+
+    // Lex the whole file in one pass so every lexical error is reported
+    TokenBuffer buffer;
+    bool lexed = lexer_scan_all(lexer, &buffer);
+    lexer_free(lexer);
+    if (!lexed) {
+        for (size_t i = 0; i < buffer.count; ++i) {
+            const TokenSpan* span = &buffer.tokens[i];
+            if (span->type == ERROR_TOKEN) {
+                fprintf(stderr, "Lexical error at %s:%d:%d: %s\n", file_path, span->line, span->column,
+                        span->error_message ? span->error_message : "Invalid token.");
+            }
+        }
+        token_buffer_free(&buffer);
+        return -1;
+    }
+
+    // The parser takes ownership of the token array and the tokens in it.
+    // Each lexeme is staged in one scratch buffer that the constructors copy.
+    size_t token_count = buffer.count;
+    Token** tokens = (Token**)malloc(token_count * sizeof(Token*));
+    size_t scratch_capacity = 64;
+    char* scratch = (char*)malloc(scratch_capacity);
+    if (tokens == NULL || scratch == NULL) {
+        free(tokens);
+        free(scratch);
+        token_buffer_free(&buffer);
+        return -1;
+    }
+    for (size_t i = 0; i < token_count; ++i) {
+        const TokenSpan* span = &buffer.tokens[i];
+        if ((size_t)span->length + 1 > scratch_capacity) {
+            while ((size_t)span->length + 1 > scratch_capacity) {
+                scratch_capacity *= 2;
+            }
+            char* grown = (char*)realloc(scratch, scratch_capacity);
+            if (grown == NULL) {
+                for (size_t j = 0; j < i; ++j) {
+                    free_token(tokens[j]);
+                }
+                free(tokens);
+                free(scratch);
+                token_buffer_free(&buffer);
+                return -1;
+            }
+            scratch = grown;
+        }
+        memcpy(scratch, source_code + span->offset, (size_t)span->length);
+        scratch[span->length] = '\0';
+
+        switch (span->type) {
+            case STRING_LITERAL:
+            case INTEGER_LITERAL:
+            case FLOATING_POINT_LITERAL:
+            case CHARACTER_LITERAL:
+            case BOOLEAN_LITERAL:
+                tokens[i] = create_token_with_literal(span->type, scratch, span->literal, span->line,
+                                                      span->column, file_path);
+                break;
+            default:
+                tokens[i] = create_token(span->type, scratch, span->line, span->column, file_path);
+                break;
+        }
+    }
+    free(scratch);
+    token_buffer_free(&buffer); // The tokens hold their own copies of the string payloads
+
+    Parser* parser = parser_init(tokens, token_count, file_path);
+    if (parser == NULL) {
+        return -1;
+    }
+    ASTNode* program = parser_parse(parser);
+    if (program == NULL) {
+        parser_free(parser);
+        return -1;
+    }
+
+    size_t output_length = strlen(output);
+    bool c_only = output_length > 2 && strcmp(output + output_length - 2, ".c") == 0;
+    char* c_path = (char*)malloc(output_length + 5);
+    if (c_path == NULL) {
+        parser_free(parser);
+        return -1;
+    }
+    // A leading "./" keeps the compiler from reading "-x.c" as an option
+    sprintf(c_path, c_only ? "%s" : output[0] == '-' ? "./%s.c" : "%s.c", output);
+
+    int status = -1;
+    FILE* c_file = fopen(c_path, "w");
+    if (c_file == NULL) {
+        fprintf(stderr, "Error: Could not open file '%s': %s\n", c_path, strerror(errno));
+    } else {
+        CodeGenerator* codegen = codegen_init(c_file);
+        bool generated = codegen_generate(codegen, program);
+        codegen_free(codegen);
+        fclose(c_file);
+        status = generated ? 0 : -1;
+    }
+    // The nodes share their tokens with the parser, which frees them; the
+    // tree itself is released when the process exits.
+    parser_free(parser);
+
+    if (status == 0 && !c_only) {
+        if (!run_c_compiler(c_path, output)) {
+            fprintf(stderr, "Error: C compilation failed; the generated code is in '%s'.\n", c_path);
+            status = -1;
+        } else {
+            remove(c_path);
+        }
+    }
+    free(c_path);
+    return status;
+}
+
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <ouroboros_source_file.ouro>\n", argv[0]);
+    const char* file_path = NULL;
+    const char* output = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (file_path == NULL && argv[i][0] != '-') {
+            file_path = argv[i];
+        } else {
+            file_path = NULL;
+            break;
+        }
+    }
+    if (file_path == NULL) {
+        fprintf(stderr, "Usage: %s [-o <output>] <ouroboros_source_file.ouro>\n", argv[0]);
+        fprintf(stderr, "  -o <output>  Compile to an executable, or to C if <output> ends in .c\n");
         return EXIT_FAILURE;
     }
 
-    const char* file_path = argv[1];
     char* source_code = NULL;
     int source_length = 0;
 
@@ -154,6 +337,12 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE; // Error already printed by read_file_to_string
     }
 
+    if (output != NULL) {
+        int status = compile_to(source_code, file_path, output);
+        free(source_code);
+        return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     printf("--- Source Code Loaded (%s) ---\n%s\n--------------------------\n\n", file_path, source_code);
     printf("--- Starting Lexical Analysis ---\n");
 
@@ -164,37 +353,22 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    // Scan and print tokens
-    Token* token = NULL;
-    do {
-        token = lexer_scan_token(lexer);
-        if (token == NULL) {
-            fprintf(stderr, "Error: Lexer returned NULL token (unrecoverable error).\n");
-            break; // Exit loop on critical error
-        }
-        print_token(token);
-
-        if (token->type == ERROR_TOKEN) {
-            // For now, stop on first lexical error. A real compiler might try to recover.
-            free_token(token);
-            break;
-        }
-        
-        // Break if it's the end of file token
-        if (token->type == EOF_TOKEN) {
-            free_token(token);
-            break;
-        }
-
-        free_token(token); // Free the token after printing, as lexer_scan_token returns a new one each time.
-
-    } while (1); // Loop indefinitely until break condition (EOF or ERROR)
+    // Scan the whole file into one buffer, then print its tokens
+    TokenBuffer tokens;
+    bool lexed = lexer_scan_all(lexer, &tokens);
+    for (size_t i = 0; i < tokens.count; ++i) {
+        print_token(&tokens, &tokens.tokens[i]);
+    }
+    if (!lexed) {
+        fprintf(stderr, "Found %zu lexical error(s).\n", tokens.error_count);
+    }
 
     printf("\n--- Lexical Analysis Complete ---\n");
 
     // Cleanup
+    token_buffer_free(&tokens);
     lexer_free(lexer);
     free(source_code);
 
-    return EXIT_SUCCESS;
+    return lexed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
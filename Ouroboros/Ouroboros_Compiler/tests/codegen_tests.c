@@ -0,0 +1,523 @@
+// codegen_tests.c
+// Tests for the C backend. Each program is built as an AST by hand (the
+// parser does not produce one yet), translated by codegen_generate, compiled
+// with $CC (cc by default) and run; its output and exit status are checked.
+//
+// Build and run with `zig build ouroboros-test`, or by hand from this
+// directory:
+//   cc -std=c11 -Iinclude tests/codegen_tests.c src/ouroboros/codegen.c -o codegen_tests && ./codegen_tests
+
+#define _POSIX_C_SOURCE 200809L // mkdtemp, popen
+#include "ast.h"
+#include "ouroboros/codegen.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Address space for a program under test: room for the C library, but far
+// less than a String loop takes if it never frees what it makes
+#define PROGRAM_MEMORY_LIMIT (64L * 1024 * 1024)
+
+static int failures = 0;
+static int column = 1;
+static char directory[] = "/tmp/ouro_codegen_XXXXXX";
+
+// --- AST construction ---
+
+#define ALLOC(T) ((T*)calloc(1, sizeof(T)))
+
+// Tokens only carry positions here; each one gets the next column
+static Token* token(TokenType type) {
+    Token* token = ALLOC(Token);
+    token->type = type;
+    token->line = 1;
+    token->column = column++;
+    token->source_name = "codegen_tests.ouro";
+    return token;
+}
+
+static ASTNode* identifier(const char* name) {
+    IdentifierNode* node = ALLOC(IdentifierNode);
+    node->base.base_type = NODE_IDENTIFIER;
+    node->base.token = token(IDENTIFIER);
+    node->name = (char*)name;
+    return &node->base;
+}
+
+static TypeReferenceNode* type(const char* name) {
+    TypeReferenceNode* node = ALLOC(TypeReferenceNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->name = (char*)name;
+    return node;
+}
+
+static LiteralNode* literal(TokenType literal_type) {
+    LiteralNode* node = ALLOC(LiteralNode);
+    node->base.base_type = NODE_LITERAL;
+    node->base.token = token(literal_type);
+    node->literal_type = literal_type;
+    return node;
+}
+
+static ASTNode* int_literal(long long value) {
+    LiteralNode* node = literal(INTEGER_LITERAL);
+    node->value.integer_val = value;
+    return &node->base;
+}
+
+static ASTNode* double_literal(double value) {
+    LiteralNode* node = literal(FLOATING_POINT_LITERAL);
+    node->value.float_val = value;
+    return &node->base;
+}
+
+static ASTNode* string_literal(const char* value) {
+    LiteralNode* node = literal(STRING_LITERAL);
+    node->value.string_val = (char*)value;
+    return &node->base;
+}
+
+static ASTNode* bool_literal(bool value) {
+    LiteralNode* node = literal(BOOLEAN_LITERAL);
+    node->value.boolean_val = value;
+    return &node->base;
+}
+
+static ASTNode* char_literal(char value) {
+    LiteralNode* node = literal(CHARACTER_LITERAL);
+    node->value.char_val = value;
+    return &node->base;
+}
+
+static ASTNode* binary(ASTNode* left, TokenType op, ASTNode* right) {
+    BinaryExpressionNode* node = ALLOC(BinaryExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_BINARY;
+    node->left = left;
+    node->operator = token(op);
+    node->right = right;
+    return &node->base;
+}
+
+// The operator's column tells prefix from postfix, so the operand's token
+// is placed after it for prefix operators
+static ASTNode* prefix(TokenType op, ASTNode* operand) {
+    UnaryExpressionNode* node = ALLOC(UnaryExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_UNARY;
+    node->operator = token(op);
+    node->operand = operand;
+    operand->token->column = column++;
+    return &node->base;
+}
+
+static ASTNode* postfix(ASTNode* operand, TokenType op) {
+    UnaryExpressionNode* node = ALLOC(UnaryExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_UNARY;
+    node->operand = operand;
+    node->operator = token(op);
+    return &node->base;
+}
+
+static ASTNode* assign(const char* name, TokenType op, ASTNode* value) {
+    AssignmentExpressionNode* node = ALLOC(AssignmentExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_ASSIGNMENT;
+    node->target = identifier(name);
+    node->operator = token(op);
+    node->value = value;
+    return &node->base;
+}
+
+static ASTNode* call(const char* name, int argument_count, ...) {
+    CallExpressionNode* node = ALLOC(CallExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->base.token = token(IDENTIFIER);
+    node->expr_type = EXPR_CALL;
+    node->callee = identifier(name);
+    node->arguments = (ASTNode**)calloc(argument_count + 1, sizeof(ASTNode*));
+    va_list args;
+    va_start(args, argument_count);
+    for (int i = 0; i < argument_count; ++i) {
+        node->arguments[i] = va_arg(args, ASTNode*);
+    }
+    va_end(args);
+    node->argument_count = argument_count;
+    return &node->base;
+}
+
+static ASTNode* cast(const char* type_name, ASTNode* operand) {
+    CastExpressionNode* node = ALLOC(CastExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_CAST;
+    node->target_type = type(type_name);
+    node->operand = operand;
+    return &node->base;
+}
+
+static ASTNode* ternary(ASTNode* condition, ASTNode* true_expr, ASTNode* false_expr) {
+    TernaryExpressionNode* node = ALLOC(TernaryExpressionNode);
+    node->base.base_type = NODE_EXPRESSION;
+    node->expr_type = EXPR_TERNARY;
+    node->condition = condition;
+    node->true_expr = true_expr;
+    node->false_expr = false_expr;
+    return &node->base;
+}
+
+static ASTNode* expression_statement(ASTNode* expression) {
+    ExpressionStatementNode* node = ALLOC(ExpressionStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_EXPRESSION;
+    node->expression = (ExpressionNode*)expression;
+    return &node->base;
+}
+
+// A NULL type_name declares the variable with `var`
+static ASTNode* variable(const char* type_name, const char* name, ASTNode* initializer) {
+    VariableDeclarationStatementNode* node = ALLOC(VariableDeclarationStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_VAR_DECL;
+    node->type = type_name ? type(type_name) : NULL;
+    node->name = (IdentifierNode*)identifier(name);
+    node->initializer = (ExpressionNode*)initializer;
+    return &node->base;
+}
+
+static ASTNode* block(int statement_count, ...) {
+    BlockStatementNode* node = ALLOC(BlockStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_BLOCK;
+    node->statements = (StatementNode**)calloc(statement_count + 1, sizeof(StatementNode*));
+    va_list args;
+    va_start(args, statement_count);
+    for (int i = 0; i < statement_count; ++i) {
+        node->statements[i] = va_arg(args, StatementNode*);
+    }
+    va_end(args);
+    node->statement_count = statement_count;
+    return &node->base;
+}
+
+static ASTNode* if_statement(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch) {
+    IfStatementNode* node = ALLOC(IfStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_IF;
+    node->condition = (ExpressionNode*)condition;
+    node->then_branch = (StatementNode*)then_branch;
+    node->else_branch = (StatementNode*)else_branch;
+    return &node->base;
+}
+
+static ASTNode* while_statement(ASTNode* condition, ASTNode* body) {
+    WhileStatementNode* node = ALLOC(WhileStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_WHILE;
+    node->condition = (ExpressionNode*)condition;
+    node->body = (StatementNode*)body;
+    return &node->base;
+}
+
+static ASTNode* do_while_statement(ASTNode* body, ASTNode* condition) {
+    DoWhileStatementNode* node = ALLOC(DoWhileStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_DO_WHILE;
+    node->condition = (ExpressionNode*)condition;
+    node->body = (StatementNode*)body;
+    return &node->base;
+}
+
+static ASTNode* for_statement(ASTNode* initializer, ASTNode* condition, ASTNode* incrementer, ASTNode* body) {
+    ForStatementNode* node = ALLOC(ForStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_FOR;
+    node->initializer = (StatementNode*)initializer;
+    node->condition = (ExpressionNode*)condition;
+    node->incrementer = (ExpressionNode*)incrementer;
+    node->body = (StatementNode*)body;
+    return &node->base;
+}
+
+static ASTNode* jump(StatementType stmt_type) {
+    JumpStatementNode* node = ALLOC(JumpStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = stmt_type;
+    return &node->base;
+}
+
+static ASTNode* return_statement(ASTNode* value) {
+    ReturnStatementNode* node = ALLOC(ReturnStatementNode);
+    node->base.base_type = NODE_STATEMENT;
+    node->stmt_type = STMT_RETURN;
+    node->value = (ExpressionNode*)value;
+    return &node->base;
+}
+
+static ParameterNode* parameter(const char* type_name, const char* name, ASTNode* default_value) {
+    ParameterNode* node = ALLOC(ParameterNode);
+    node->type = type(type_name);
+    node->name = (IdentifierNode*)identifier(name);
+    node->default_value = (ExpressionNode*)default_value;
+    return node;
+}
+
+static ASTNode* function(const char* return_type, const char* name, int parameter_count,
+                         ParameterNode** parameters, ASTNode* body) {
+    FunctionDeclarationNode* node = ALLOC(FunctionDeclarationNode);
+    node->base.base_type = NODE_DECLARATION;
+    node->base.token = token(IDENTIFIER);
+    node->decl_type = DECL_FUNCTION;
+    node->return_type = type(return_type);
+    node->name = (IdentifierNode*)identifier(name);
+    node->parameters = parameters;
+    node->parameter_count = parameter_count;
+    node->body = (BlockStatementNode*)body;
+    return &node->base;
+}
+
+static ASTNode* global(const char* type_name, const char* name, ASTNode* initializer) {
+    FieldDeclarationNode* node = ALLOC(FieldDeclarationNode);
+    node->base.base_type = NODE_DECLARATION;
+    node->decl_type = DECL_VARIABLE;
+    node->type = type(type_name);
+    node->name = (IdentifierNode*)identifier(name);
+    node->initializer = (ExpressionNode*)initializer;
+    return &node->base;
+}
+
+// --- Running programs ---
+
+static bool generate(const char* c_path, ASTNode** declarations, size_t declaration_count) {
+    ProgramNode program = {{NODE_PROGRAM, NULL}, declarations, declaration_count};
+    FILE* out = fopen(c_path, "w");
+    if (out == NULL) {
+        perror(c_path);
+        exit(EXIT_FAILURE);
+    }
+    CodeGenerator* codegen = codegen_init(out);
+    bool generated = codegen_generate(codegen, (ASTNode*)&program);
+    codegen_free(codegen);
+    fclose(out);
+    return generated;
+}
+
+/**
+ * Translates, compiles and runs a program, and checks that it prints
+ * `expected_output` and exits with `expected_status`.
+ */
+static void check_program(const char* name, ASTNode** declarations, size_t declaration_count,
+                          const char* expected_output, int expected_status) {
+    char c_path[128], exe_path[128], command[512];
+    snprintf(c_path, sizeof c_path, "%s/%s.c", directory, name);
+    snprintf(exe_path, sizeof exe_path, "%s/%s", directory, name);
+    if (!generate(c_path, declarations, declaration_count)) {
+        fprintf(stderr, "FAIL %s: code generation failed\n", name);
+        failures++;
+        return;
+    }
+
+    const char* cc = getenv("CC");
+    snprintf(command, sizeof command, "%s -O2 -fwrapv -Wall -Werror -o %s %s -lm",
+             cc && *cc ? cc : "cc", exe_path, c_path);
+    if (system(command) != 0) {
+        fprintf(stderr, "FAIL %s: the generated C does not compile (%s)\n", name, c_path);
+        failures++;
+        return;
+    }
+
+    // The limit is inherited by the program, then lifted again for the compiler
+    struct rlimit saved_limit;
+    getrlimit(RLIMIT_AS, &saved_limit);
+    struct rlimit limit = {PROGRAM_MEMORY_LIMIT, saved_limit.rlim_max};
+    if (saved_limit.rlim_max != RLIM_INFINITY && saved_limit.rlim_max < limit.rlim_cur) limit = saved_limit;
+    setrlimit(RLIMIT_AS, &limit);
+    FILE* program = popen(exe_path, "r");
+    setrlimit(RLIMIT_AS, &saved_limit);
+    char output[4096];
+    size_t length = fread(output, 1, sizeof output - 1, program);
+    output[length] = '\0';
+    int status = pclose(program);
+    status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    if (strcmp(output, expected_output) != 0 || status != expected_status) {
+        fprintf(stderr, "FAIL %s: exited with %d and printed\n%s\nexpected %d and\n%s\n", name, status, output,
+                expected_status, expected_output);
+        failures++;
+    }
+    remove(exe_path);
+    remove(c_path);
+}
+
+// A program the backend cannot translate is reported, not written half-done
+static void check_rejected(const char* name, ASTNode** declarations, size_t declaration_count) {
+    char c_path[128];
+    snprintf(c_path, sizeof c_path, "%s/%s.c", directory, name);
+    if (generate(c_path, declarations, declaration_count)) {
+        fprintf(stderr, "FAIL %s: code generation should have failed\n", name);
+        failures++;
+    }
+    remove(c_path);
+}
+
+// --- Programs ---
+
+// Globals, recursion, default arguments, for/while/do-while with break and
+// continue, String conversions and comparison, Java's numeric promotion and
+// wrapping, and a division by zero that stops the program
+static void test_language(void) {
+    ParameterNode* fib_parameters[] = {parameter("int", "n", NULL)};
+    ParameterNode* sum_parameters[] = {parameter("int", "n", NULL), parameter("int", "step", int_literal(1))};
+    ASTNode* declarations[] = {
+        global("int", "counter", binary(int_literal(5), MULTIPLY, int_literal(2))),
+        global("String", "greeting", string_literal("hi \"there\"\n")),
+        function("int", "fib", 1, fib_parameters, block(2,
+            if_statement(binary(identifier("n"), LT, int_literal(2)), return_statement(identifier("n")), NULL),
+            return_statement(binary(call("fib", 1, binary(identifier("n"), MINUS, int_literal(1))), PLUS,
+                                    call("fib", 1, binary(identifier("n"), MINUS, int_literal(2))))))),
+        function("long", "sum", 2, sum_parameters, block(3,
+            variable("long", "total", int_literal(0)),
+            for_statement(variable("int", "i", int_literal(0)), binary(identifier("i"), LT, identifier("n")),
+                          assign("i", PLUS_EQUALS, identifier("step")),
+                          block(1, expression_statement(assign("total", PLUS_EQUALS, identifier("i"))))),
+            return_statement(identifier("total")))),
+        function("void", "main", 0, NULL, block(14,
+            expression_statement(call("println", 2, string_literal("fib "), call("fib", 1, int_literal(20)))),
+            variable(NULL, "s",
+                binary(binary(binary(binary(binary(binary(identifier("greeting"), PLUS, string_literal(" ")),
+                    PLUS, identifier("counter")), PLUS, string_literal(" ")), PLUS, double_literal(2.5)),
+                    PLUS, bool_literal(true)), PLUS, char_literal('c'))),
+            expression_statement(call("println", 1, identifier("s"))),
+            expression_statement(call("println", 3, call("sum", 1, int_literal(100)), string_literal(" "),
+                                      call("sum", 2, int_literal(100), int_literal(3)))),
+            variable("int", "x", int_literal(7)),
+            expression_statement(assign("x", DIVIDE_EQUALS, int_literal(2))),
+            expression_statement(call("println", 11,
+                identifier("x"), string_literal(" "),
+                postfix(identifier("x"), INCREMENT), string_literal(" "),
+                prefix(INCREMENT, identifier("x")), string_literal(" "),
+                binary(int_literal(7), MODULO, int_literal(3)), string_literal(" "),
+                binary(double_literal(7.5), MODULO, double_literal(2.0)), string_literal(" "),
+                binary(prefix(MINUS, int_literal(8)), UNSIGNED_RIGHT_SHIFT, int_literal(28)))),
+            variable("double", "d", binary(cast("double", identifier("x")), DIVIDE, int_literal(4))),
+            expression_statement(call("println", 2, identifier("d"),
+                                      binary(double_literal(0.1), PLUS, double_literal(0.2)))),
+            while_statement(binary(identifier("x"), GT, int_literal(0)), block(3,
+                expression_statement(postfix(identifier("x"), DECREMENT)),
+                if_statement(binary(identifier("x"), EQ, int_literal(5)), jump(STMT_CONTINUE), NULL),
+                if_statement(binary(identifier("x"), EQ, int_literal(2)), jump(STMT_BREAK), NULL))),
+            do_while_statement(block(1, expression_statement(assign("x", MULTIPLY_EQUALS, int_literal(3)))),
+                               binary(identifier("x"), LT, int_literal(100))),
+            expression_statement(call("println", 2, identifier("x"),
+                ternary(binary(identifier("s"), EQ,
+                               binary(string_literal("hi \"there\"\n "), PLUS, string_literal("10 2.5truec"))),
+                        string_literal(" eq"), string_literal(" ne")))),
+            variable("short", "sh", int_literal(32767)),
+            expression_statement(call("println", 2, assign("sh", PLUS_EQUALS, int_literal(1)),
+                                      binary(int_literal(1), DIVIDE,
+                                             binary(identifier("x"), MINUS, identifier("x"))))))),
+    };
+    check_program("language", declarations, sizeof declarations / sizeof *declarations,
+                  "fib 6765\n"
+                  "hi \"there\"\n"
+                  " 10 2.5truec\n"
+                  "4950 1683\n"
+                  "3 3 5 1 1.5 15\n"
+                  "1.250.30000000000000004\n"
+                  "162 eq\n"
+                  "-32768",
+                  1);
+}
+
+// Strings made in loops, in conditions, in calls and in returns are freed,
+// so the loops run in the program's memory limit; values still read after
+// a variable is reassigned or leaves its scope stay intact
+static void test_strings(void) {
+    ParameterNode* join_parameters[] = {parameter("String", "s", NULL), parameter("int", "n", NULL)};
+    ParameterNode* pick_parameters[] = {parameter("String", "a", NULL), parameter("String", "b", NULL)};
+    ParameterNode* label_parameters[] = {parameter("int", "n", NULL)};
+    ASTNode* declarations[] = {
+        global("String", "last", string_literal("none")),
+        // Appends 0, 1, 2 to its parameter and stops
+        function("String", "join", 2, join_parameters, block(2,
+            for_statement(variable("int", "i", int_literal(0)), binary(identifier("i"), LT, identifier("n")),
+                          postfix(identifier("i"), INCREMENT),
+                          block(3,
+                              variable("String", "piece", binary(string_literal(""), PLUS, identifier("i"))),
+                              expression_statement(assign("s", PLUS_EQUALS, identifier("piece"))),
+                              if_statement(binary(identifier("i"), EQ, int_literal(2)), jump(STMT_BREAK), NULL))),
+            return_statement(identifier("s")))),
+        function("String", "pick", 2, pick_parameters, block(1,
+            return_statement(ternary(binary(identifier("a"), EQ, identifier("b")), identifier("a"),
+                                     binary(identifier("b"), PLUS, string_literal("!")))))),
+        function("String", "label", 1, label_parameters, block(2,
+            variable("String", "unused", binary(string_literal("#"), PLUS, identifier("n"))),
+            return_statement(binary(string_literal("n"), PLUS, identifier("n"))))),
+        function("void", "main", 0, NULL, block(13,
+            variable("String", "total", string_literal("")),
+            for_statement(variable("int", "i", int_literal(0)), binary(identifier("i"), LT, int_literal(1000000)),
+                          postfix(identifier("i"), INCREMENT),
+                          block(3,
+                              variable("String", "piece", binary(string_literal("x"), PLUS, identifier("i"))),
+                              expression_statement(assign("total", ASSIGN, identifier("piece"))),
+                              expression_statement(assign("last", ASSIGN, call("label", 1, identifier("i")))))),
+            expression_statement(call("println", 3, identifier("total"), string_literal(" "), identifier("last"))),
+            variable("String", "s", string_literal("")),
+            variable("int", "n", int_literal(0)),
+            while_statement(binary(assign("s", ASSIGN, binary(identifier("s"), PLUS, string_literal("ab"))), NE,
+                                   string_literal("abababab")),
+                            expression_statement(postfix(identifier("n"), INCREMENT))),
+            expression_statement(call("println", 3, identifier("s"), string_literal(" "), identifier("n"))),
+            expression_statement(call("println", 3, call("join", 2, string_literal("j"), int_literal(10)),
+                                      string_literal(" "), call("join", 2, identifier("s"), int_literal(1)))),
+            expression_statement(call("println", 2, call("pick", 2, string_literal("a"), string_literal("b")),
+                                      call("pick", 2, identifier("s"), identifier("s")))),
+            variable("String", "t", string_literal("k")),
+            for_statement(NULL, binary(call("label", 1, identifier("n")), NE, string_literal("n200000")),
+                          postfix(identifier("n"), INCREMENT),
+                          expression_statement(assign("t", PLUS_EQUALS, string_literal("")))),
+            expression_statement(assign("t", PLUS_EQUALS, binary(binary(binary(int_literal(1), PLUS, char_literal('c')),
+                                                               PLUS, string_literal("")), PLUS, bool_literal(true)))),
+            expression_statement(call("println", 4, identifier("t"), string_literal(" "), identifier("n"),
+                                      binary(assign("s", ASSIGN, identifier("s")), EQ, string_literal("abababab")))))),
+    };
+    check_program("strings", declarations, sizeof declarations / sizeof *declarations,
+                  "x999999 n999999\n"
+                  "abababab 3\n"
+                  "j012 abababab0\n"
+                  "b!abababab\n"
+                  "k100true 200000true\n",
+                  0);
+}
+
+static void test_rejected(void) {
+    ASTNode* no_main[] = {
+        function("void", "helper", 0, NULL, block(0)),
+    };
+    check_rejected("no_main", no_main, sizeof no_main / sizeof *no_main);
+
+    ASTNode* undefined[] = {
+        function("void", "main", 0, NULL, block(1, expression_statement(call("missing", 0)))),
+    };
+    check_rejected("undefined", undefined, sizeof undefined / sizeof *undefined);
+}
+
+int main(void) {
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+
+    test_language();
+    test_strings();
+    test_rejected();
+
+    remove(directory);
+    if (failures > 0) {
+        fprintf(stderr, "%d codegen test(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
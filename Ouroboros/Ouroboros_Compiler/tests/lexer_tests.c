@@ -0,0 +1,198 @@
+// lexer_tests.c
+// Tests for lexer_scan_all. Every source is lexed twice, by lexer_scan_all
+// and token by token with lexer_scan_token, and the two must agree on each
+// token's type, lexeme, position, literal and error message.
+//
+// Build and run with `zig build ouroboros-test`, or by hand from this
+// directory:
+//   cc -std=c11 -Iinclude tests/lexer_tests.c src/ouroboros/lexer.c -o lexer_tests && ./lexer_tests
+
+#define _POSIX_C_SOURCE 200809L // strdup
+#include "lexer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Token constructors as token.h declares them; token.c still has older
+// signatures, so the test brings its own
+Token* create_token(TokenType type, const char* lexeme, int line, int column, const char* source_name) {
+    Token* token = (Token*)calloc(1, sizeof(Token));
+    token->type = type;
+    token->lexeme = strdup(lexeme);
+    token->line = line;
+    token->column = column;
+    token->source_name = (char*)source_name;
+    return token;
+}
+
+Token* create_token_with_literal(TokenType type, const char* lexeme, LiteralValue literal, int line, int column,
+                                 const char* source_name) {
+    Token* token = create_token(type, lexeme, line, column, source_name);
+    token->literal = literal;
+    token->has_literal = 1;
+    if (type == STRING_LITERAL) {
+        token->literal.string_val = strdup(literal.string_val);
+    }
+    return token;
+}
+
+Token* create_error_token(const char* lexeme, const char* error_message, int line, int column,
+                          const char* source_name) {
+    Token* token = create_token(ERROR_TOKEN, lexeme, line, column, source_name);
+    token->error_message = strdup(error_message);
+    return token;
+}
+
+void free_token(Token* token) {
+    free(token->lexeme);
+    if (token->type == STRING_LITERAL) {
+        free(token->literal.string_val);
+    }
+    free(token->error_message);
+    free(token);
+}
+
+/**
+ * Lexes the rest of `source` after its first `skip` tokens both ways and
+ * checks that the results agree. Returns the number of tokens scanned.
+ */
+static size_t compare_from(const char* source, int skip) {
+    Lexer* by_token = lexer_init(source, "test.ouro");
+    Lexer* all = lexer_init(source, "test.ouro");
+    for (int i = 0; i < skip; ++i) {
+        free_token(lexer_scan_token(by_token));
+        free_token(lexer_scan_token(all));
+    }
+
+    TokenBuffer buffer;
+    bool clean = lexer_scan_all(all, &buffer);
+    assert(buffer.source_code == source);
+    assert(buffer.count > 0 && buffer.tokens[buffer.count - 1].type == EOF_TOKEN);
+
+    size_t errors = 0;
+    for (size_t i = 0; i < buffer.count; ++i) {
+        const TokenSpan* span = &buffer.tokens[i];
+        Token* token = lexer_scan_token(by_token);
+        assert(token->type == span->type);
+        assert((int)strlen(token->lexeme) == span->length);
+        assert(memcmp(token->lexeme, source + span->offset, span->length) == 0);
+        assert(token->line == span->line && token->column == span->column);
+        switch (span->type) {
+            case STRING_LITERAL: assert(strcmp(token->literal.string_val, span->literal.string_val) == 0); break;
+            case INTEGER_LITERAL: assert(token->literal.integer_val == span->literal.integer_val); break;
+            case FLOATING_POINT_LITERAL: assert(token->literal.float_val == span->literal.float_val); break;
+            case CHARACTER_LITERAL: assert(token->literal.char_val == span->literal.char_val); break;
+            case BOOLEAN_LITERAL: assert(token->literal.boolean_val == span->literal.boolean_val); break;
+            case ERROR_TOKEN:
+                errors++;
+                assert(strcmp(token->error_message, span->error_message) == 0);
+                break;
+            default: break;
+        }
+        free_token(token);
+    }
+    assert(errors == buffer.error_count);
+    assert(clean == (errors == 0));
+
+    size_t count = buffer.count;
+    token_buffer_free(&buffer);
+    assert(buffer.tokens == NULL && buffer.count == 0 && buffer.strings == NULL);
+    lexer_free(by_token);
+    lexer_free(all);
+    return count;
+}
+
+static size_t compare(const char* source) {
+    return compare_from(source, 0);
+}
+
+int main(void) {
+    // Spans: offsets, lengths, positions and literals, as written
+    {
+        const char* source = "int x = 42;\n  s = \"a\\\"b\";";
+        Lexer* lexer = lexer_init(source, "spans.ouro");
+        TokenBuffer buffer;
+        assert(lexer_scan_all(lexer, &buffer));
+        assert(buffer.count == 10);
+        const TokenSpan* t = buffer.tokens;
+        assert(t[0].type == INT_TYPE && t[0].offset == 0 && t[0].length == 3 && t[0].line == 1 && t[0].column == 1);
+        assert(t[1].type == IDENTIFIER && t[1].offset == 4 && t[1].length == 1 && t[1].column == 5);
+        assert(t[3].type == INTEGER_LITERAL && t[3].literal.integer_val == 42 && t[3].column == 9);
+        assert(t[5].type == IDENTIFIER && t[5].line == 2 && t[5].column == 3);
+        assert(t[7].type == STRING_LITERAL && t[7].length == 6 && t[7].line == 2 && t[7].column == 7);
+        assert(strcmp(t[7].literal.string_val, "a\\\"b") == 0); // Escapes are kept as written
+        assert(t[9].type == EOF_TOKEN && t[9].offset == (int)strlen(source) && t[9].length == 0);
+        token_buffer_free(&buffer);
+        lexer_free(lexer);
+    }
+
+    // Every kind of token, comments and whitespace, the same both ways
+    compare("int main() { String s = \"hi \\\"x\\\"\"; s += 'c'; x >>>= 3; y = 1.5e-3 + 42 + 7.; // c\n"
+            " /* multi\nline */ for (i ..< 3) { a...b; } true false null }");
+    compare("");
+    compare("   \n\t // only a comment");
+
+    // Scanning goes on past errors; an unterminated string runs to the end
+    compare("a\n  b = \"multi\nline\" $ 'ab' '\\q' @");
+    compare("x = \"unterminated");
+    compare("$ @ \"one\" # \"never closed\n  still = the string;");
+    {
+        const char* source = "a $ b @ c \"open";
+        Lexer* lexer = lexer_init(source, "errors.ouro");
+        TokenBuffer buffer;
+        assert(!lexer_scan_all(lexer, &buffer));
+        assert(buffer.error_count == 3);
+        assert(buffer.count == 7);
+        assert(buffer.tokens[1].type == ERROR_TOKEN && buffer.tokens[3].type == ERROR_TOKEN);
+        assert(buffer.tokens[4].type == IDENTIFIER && buffer.tokens[4].column == 9);
+        assert(buffer.tokens[5].type == ERROR_TOKEN && buffer.tokens[5].column == 11);
+        assert(buffer.tokens[6].type == EOF_TOKEN);
+        token_buffer_free(&buffer);
+        lexer_free(lexer);
+    }
+
+    // lexer_scan_all picks up where lexer_scan_token left off, with the
+    // start line and column of the next token
+    assert(compare_from("first second\n   third \"fourth\" 5", 2) == 4);
+    {
+        const char* source = "a b\n  c";
+        Lexer* lexer = lexer_init(source, "resume.ouro");
+        free_token(lexer_scan_token(lexer));
+        free_token(lexer_scan_token(lexer));
+        TokenBuffer buffer;
+        assert(lexer_scan_all(lexer, &buffer));
+        assert(buffer.count == 2 && buffer.tokens[0].line == 2 && buffer.tokens[0].column == 3);
+        token_buffer_free(&buffer);
+        lexer_free(lexer);
+    }
+
+    // Enough tokens to regrow the buffer, enough strings to fill several
+    // arena blocks, and one string longer than a block
+    {
+        size_t strings = 200000, long_length = 70000;
+        char* source = (char*)malloc(strings * 12 + long_length + 8);
+        char* p = source;
+        for (size_t i = 0; i < strings; ++i) {
+            p += sprintf(p, "s%zu=\"ab\";", i % 10);
+        }
+        *p++ = '"';
+        memset(p, 'z', long_length);
+        p += long_length;
+        *p++ = '"';
+        *p = '\0';
+        assert(compare(source) == strings * 4 + 2);
+
+        Lexer* lexer = lexer_init(source, "big.ouro");
+        TokenBuffer buffer;
+        assert(lexer_scan_all(lexer, &buffer));
+        assert(buffer.capacity >= buffer.count && buffer.capacity < 2 * buffer.count);
+        assert(strlen(buffer.tokens[buffer.count - 2].literal.string_val) == long_length);
+        token_buffer_free(&buffer);
+        lexer_free(lexer);
+        free(source);
+    }
+
+    printf("lexer tests passed\n");
+    return 0;
+}
@@ -47,6 +47,31 @@ pub fn build(b: *std.Build) void {
     ourolang_cpp.linkSystemLibrary("llvm");
     b.installArtifact(ourolang_cpp);
 
+    // The ouro:: interpreter's REPL, with hot numeric functions JIT-compiled
+    const ouro = b.addExecutable(.{
+        .name = "ouro",
+        .target = target,
+        .optimize = optimize,
+    });
+    ouro.linkLibC();
+    ouro.linkLibCpp();
+    ouro.addIncludePath(b.path("include"));
+    ouro.addCSourceFiles(.{
+        .files = &[_][]const u8{"src/main.cc"},
+        .flags = &[_][]const u8{ "-std=c++23", "-DOURO_JIT" },
+    });
+    ouro.linkSystemLibrary("llvm");
+    b.installArtifact(ouro);
+
+    // One binary per feature of the ouro:: interpreter; `zig build test` runs them all
+    const test_step = b.step("test", "Run the ouro:: interpreter tests");
+    for ([_][]const u8{ "lexer_tests", "session_tests", "resolver_tests", "engine_tests", "async_tests", "gpu_tests", "parallel_tests" }) |name| {
+        test_step.dependOn(&b.addRunArtifact(addOuroTest(b, target, optimize, name, &.{"-std=c++23"})).step);
+    }
+    const jit_tests = addOuroTest(b, target, optimize, "jit_tests", &.{ "-std=c++23", "-DOURO_JIT" });
+    jit_tests.linkSystemLibrary("llvm");
+    test_step.dependOn(&b.addRunArtifact(jit_tests).step);
+
     const ouroboros = b.addExecutable(.{
         .name = "ouroboros",
         .target = target,
@@ -68,6 +93,42 @@ pub fn build(b: *std.Build) void {
     ouroboros.addIncludePath(b.path("Ouroboros/Ouroboros_Compiler/include"));
     b.installArtifact(ouroboros);
 
+    // Translates hand-built ASTs with the C backend, then compiles and runs the C
+    const ouroboros_tests = b.addExecutable(.{
+        .name = "ouroboros_codegen_tests",
+        .target = target,
+        .optimize = optimize,
+    });
+    ouroboros_tests.linkLibC();
+    ouroboros_tests.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "Ouroboros/Ouroboros_Compiler/tests/codegen_tests.c",
+            "Ouroboros/Ouroboros_Compiler/src/ouroboros/codegen.c",
+        },
+        .flags = &[_][]const u8{"-std=c23"},
+    });
+    ouroboros_tests.addIncludePath(b.path("Ouroboros/Ouroboros_Compiler/include"));
+    const ouroboros_tests_run = b.addRunArtifact(ouroboros_tests);
+    const ouroboros_test_step = b.step("ouroboros-test", "Run the Ouroboros lexer and C backend tests");
+    ouroboros_test_step.dependOn(&ouroboros_tests_run.step);
+
+    // Checks lexer_scan_all against token-by-token scanning
+    const ouroboros_lexer_tests = b.addExecutable(.{
+        .name = "ouroboros_lexer_tests",
+        .target = target,
+        .optimize = optimize,
+    });
+    ouroboros_lexer_tests.linkLibC();
+    ouroboros_lexer_tests.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "Ouroboros/Ouroboros_Compiler/tests/lexer_tests.c",
+            "Ouroboros/Ouroboros_Compiler/src/ouroboros/lexer.c",
+        },
+        .flags = &[_][]const u8{"-std=c23"},
+    });
+    ouroboros_lexer_tests.addIncludePath(b.path("Ouroboros/Ouroboros_Compiler/include"));
+    ouroboros_test_step.dependOn(&b.addRunArtifact(ouroboros_lexer_tests).step);
+
     const ouro_mod = b.addExecutable(.{
         .name = "ouro_mod",
         .target = target,
@@ -122,6 +183,101 @@ pub fn build(b: *std.Build) void {
     const test_cmd = b.addRunArtifact(mod_tests);
     b.step("mod-test", "Run module tests").dependOn(&test_cmd.step);
 
+    const lex_bench = b.addExecutable(.{
+        .name = "lex_bench",
+        .target = target,
+        .optimize = .ReleaseFast,
+    });
+    lex_bench.linkLibC();
+    lex_bench.linkLibCpp();
+    lex_bench.addIncludePath(b.path("include"));
+    lex_bench.addCSourceFiles(.{
+        .files = &[_][]const u8{"tools/bench/lex_bench.cc"},
+        .flags = &[_][]const u8{"-std=c++23"},
+    });
+    lex_bench.addCSourceFiles(.{
+        .files = &[_][]const u8{"ouroboros-lang/ouroboros/lexer.c"},
+        .flags = &[_][]const u8{"-std=c23"},
+    });
+    const lex_bench_run = b.addRunArtifact(lex_bench);
+    if (b.args) |args| lex_bench_run.addArgs(args);
+    b.step("lex-bench", "Measure lexer throughput").dependOn(&lex_bench_run.step);
+
+    const gpu_bench = b.addExecutable(.{
+        .name = "gpu_bench",
+        .target = target,
+        .optimize = .ReleaseFast,
+    });
+    gpu_bench.linkLibC();
+    gpu_bench.linkLibCpp();
+    gpu_bench.addIncludePath(b.path("include"));
+    gpu_bench.addCSourceFiles(.{
+        .files = &[_][]const u8{"tools/bench/gpu_bench.cc"},
+        .flags = &[_][]const u8{"-std=c++23"},
+    });
+    const gpu_bench_run = b.addRunArtifact(gpu_bench);
+    if (b.args) |args| gpu_bench_run.addArgs(args);
+    b.step("gpu-bench", "Compare gpu fn on the CPU backend with the interpreter").dependOn(&gpu_bench_run.step);
+
+    // The shared SSA IR, lowered from both front ends
+    const ir_tests = b.addExecutable(.{
+        .name = "ir_tests",
+        .target = target,
+        .optimize = optimize,
+    });
+    ir_tests.linkLibC();
+    ir_tests.linkLibCpp();
+    ir_tests.addIncludePath(b.path("include"));
+    ir_tests.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "tests/codegen_tests.cc",
+            "src/ir/ir.cc",
+            "src/ir/lower.cc",
+            "src/ir/passes.cc",
+        },
+        .flags = &[_][]const u8{"-std=c++23"},
+    });
+    ir_tests.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "ouroboros-lang/ouroboros/lexer.c",
+            "ouroboros-lang/ouroboros/parser.c",
+            "ouroboros-lang/ouroboros/ast.c",
+            "ouroboros-lang/ouroboros/semantic.c",
+        },
+        .flags = &[_][]const u8{"-std=c23"},
+    });
+    const ir_tests_run = b.addRunArtifact(ir_tests);
+    b.step("ir-test", "Run the IR tests").dependOn(&ir_tests_run.step);
+
+    // Lowers a program to the IR and prints it optimized at -O0, -O1 or -O2
+    const ouro_opt = b.addExecutable(.{
+        .name = "ouro_opt",
+        .target = target,
+        .optimize = optimize,
+    });
+    ouro_opt.linkLibC();
+    ouro_opt.linkLibCpp();
+    ouro_opt.addIncludePath(b.path("include"));
+    ouro_opt.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "tools/ir/ouro_opt.cc",
+            "src/ir/ir.cc",
+            "src/ir/lower.cc",
+            "src/ir/passes.cc",
+        },
+        .flags = &[_][]const u8{"-std=c++23"},
+    });
+    ouro_opt.addCSourceFiles(.{
+        .files = &[_][]const u8{
+            "ouroboros-lang/ouroboros/lexer.c",
+            "ouroboros-lang/ouroboros/parser.c",
+            "ouroboros-lang/ouroboros/ast.c",
+            "ouroboros-lang/ouroboros/semantic.c",
+        },
+        .flags = &[_][]const u8{"-std=c23"},
+    });
+    b.installArtifact(ouro_opt);
+
     const zig_nvim = b.addExecutable(.{
         .name = "zig_nvim",
         .target = target,
@@ -145,3 +301,25 @@ pub fn build(b: *std.Build) void {
     const all_step = b.step("all", "Build all artifacts");
     all_step.dependOn(b.getInstallStep());
 }
+
+fn addOuroTest(
+    b: *std.Build,
+    target: std.Build.ResolvedTarget,
+    optimize: std.builtin.OptimizeMode,
+    name: []const u8,
+    flags: []const []const u8,
+) *std.Build.Step.Compile {
+    const tests = b.addExecutable(.{
+        .name = name,
+        .target = target,
+        .optimize = optimize,
+    });
+    tests.linkLibC();
+    tests.linkLibCpp();
+    tests.addIncludePath(b.path("include"));
+    tests.addCSourceFiles(.{
+        .files = &.{b.fmt("tests/{s}.cc", .{name})},
+        .flags = flags,
+    });
+    return tests;
+}
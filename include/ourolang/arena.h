@@ -1,16 +1,81 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <memory_resource>
 #include <vector>
 
 namespace ouro {
 
+// Backs one compilation unit. The source copy, tokens, AST nodes and their
+// strings and lists are all allocated here. Nothing is freed one by one: the
+// whole unit goes at once when the Arena is destroyed.
 class Arena {
+public:
+    struct Stats {
+        std::size_t allocations = 0; // Requests served by the arena
+        std::size_t bytes = 0;
+        std::size_t chunks = 0;      // Buffers the arena took from the heap to serve them
+        std::size_t chunk_bytes = 0;
+    };
+
+private:
+    // Sits under the monotonic buffer and counts the chunks it takes from the heap
+    class ChunkCounter : public std::pmr::memory_resource {
+        Stats& stats;
+
+    public:
+        explicit ChunkCounter(Stats& s) : stats(s) {}
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            stats.chunks++;
+            stats.chunk_bytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    // Sits on top of the monotonic buffer and counts the requests it serves
+    class RequestCounter : public std::pmr::memory_resource {
+        Stats& stats;
+        std::pmr::memory_resource& buffer;
+
+    public:
+        RequestCounter(Stats& s, std::pmr::memory_resource& b) : stats(s), buffer(b) {}
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            stats.allocations++;
+            stats.bytes += bytes;
+            return buffer.allocate(bytes, align);
+        }
+        void do_deallocate(void*, std::size_t, std::size_t) override {} // Released with the arena
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
     static constexpr std::size_t DEFAULT_SIZE = 1024 * 1024; // 1MB
+    Stats counters;
+    ChunkCounter chunks{counters};
     std::pmr::monotonic_buffer_resource resource;
+    RequestCounter requests{counters, resource};
+
 public:
-    Arena() : resource(DEFAULT_SIZE) {}
+    explicit Arena(std::size_t initial_size = DEFAULT_SIZE) : resource(initial_size, &chunks) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // A first chunk big enough for a typical unit of `source_bytes`, so most
+    // units take a single chunk; later chunks grow geometrically. A REPL line
+    // needs about 1KB whatever its length.
+    static std::size_t size_for_source(std::size_t source_bytes) {
+        return std::min<std::size_t>(source_bytes * 32 + 1024, DEFAULT_SIZE);
+    }
 
-    std::pmr::memory_resource* get_resource() { return &resource; }
+    std::pmr::memory_resource* get_resource() { return &requests; }
+    const Stats& stats() const { return counters; }
 };
 
 } // namespace ouro
@@ -1,22 +1,33 @@
 #pragma once
 #include "token.h"
-#include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <variant>
 #include <vector>
-#include <string>
 
 namespace ouro {
 
+// Nodes, their lists and the text their names view are all placed in the
+// compilation unit's Arena by Parser. Nothing here is destroyed one by one;
+// the tree lives exactly as long as that arena.
 struct Expr;
 struct Stmt;
-using ExprPtr = std::unique_ptr<Expr>;
-using StmtPtr = std::unique_ptr<Stmt>;
+using ExprPtr = Expr*;
+using StmtPtr = Stmt*;
+using ExprList = std::pmr::vector<ExprPtr>;
+using StmtList = std::pmr::vector<StmtPtr>;
 
 struct NumberExpr { double value; };
-struct StringExpr { std::string value; };
-struct IdentExpr { std::string name; };
+struct StringExpr { std::string_view value; };
+struct IdentExpr {
+    std::string_view name;
+    int slot = -1;  // Filled in by Resolver: index in the frame `depth` scopes out
+    int depth = 0;
+    const IdentExpr* shadowed = nullptr; // Read instead while the slot is empty: what the
+                                         // name meant before a later `let` in this function
+};
 struct BinaryExpr { TokenType op; ExprPtr left; ExprPtr right; };
-struct CallExpr { std::string name; std::vector<ExprPtr> args; };
+struct CallExpr { std::string_view name; ExprList args; };
 struct AwaitExpr { ExprPtr expr; };
 
 using ExprVariant = std::variant<NumberExpr, StringExpr, IdentExpr, BinaryExpr, CallExpr, AwaitExpr>;
@@ -26,20 +37,28 @@ struct Expr {
     explicit Expr(T&& v) : value(std::forward<T>(v)) {}
 };
 
-struct VarDeclStmt { std::string name; std::string type; ExprPtr value; };
+struct VarDeclStmt { std::string_view name; std::string_view type; ExprPtr value; int slot = -1; };
 struct FnDeclStmt {
-    std::string name;
-    std::vector<std::pair<std::string, std::string>> params;
-    std::string return_type;
-    std::vector<StmtPtr> body;
+    std::string_view name;
+    std::pmr::vector<std::pair<std::string_view, std::string_view>> params;
+    std::string_view return_type;
+    StmtList body;
     bool is_async;
     bool is_gpu;
     bool is_generic;
-    std::vector<std::string> generic_params;
+    std::pmr::vector<std::string_view> generic_params;
+    std::size_t frame_size = 0; // Parameters and locals, counted by Resolver
+};
+struct IfStmt { ExprPtr condition; StmtList then_branch; StmtList else_branch; };
+struct ForStmt {
+    std::string_view var;
+    ExprPtr start;
+    ExprPtr end;
+    StmtList body;
+    bool parallel = false; // `parallel for`: TypeChecker has proved the iterations independent
+    int slot = -1;
 };
-struct IfStmt { ExprPtr condition; std::vector<StmtPtr> then_branch; std::vector<StmtPtr> else_branch; };
-struct ForStmt { std::string var; ExprPtr start; ExprPtr end; std::vector<StmtPtr> body; };
-struct ReturnStmt { ExprPtr value; };
+struct ReturnStmt { ExprPtr value = nullptr; };
 
 using StmtVariant = std::variant<VarDeclStmt, FnDeclStmt, IfStmt, ForStmt, ReturnStmt>;
 struct Stmt {
@@ -0,0 +1,287 @@
+#pragma once
+#include "ast.h"
+#include "value.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ouro {
+
+// Operands follow the opcode inline: u8 is one byte, u16 two (little-endian).
+// Jump offsets are measured from the end of the instruction.
+enum class OpCode : std::uint8_t {
+    CONSTANT,      // u16 constant: push it
+    NIL,           // Push the tree walker's "no value", the number 0
+    GET_LOCAL,     // u16 slot in the current frame
+    SET_LOCAL,     // u16 slot: pop into it
+    GET_GLOBAL,    // u16 slot in the global frame
+    GET_OUTER,     // u8 depth, u16 slot in the frame of an enclosing function
+    TRY_LOCAL,     // u16 slot, u16 offset: if the slot is set, push it and jump
+    TRY_OUTER,     // u8 depth, u16 slot, u16 offset: the same for an enclosing function's slot
+    UNDEFINED,     // A name Resolver could not place: always an error
+    ADD, SUB, MUL, DIV, GT,
+    JUMP,          // u16 forward offset
+    JUMP_IF_FALSE, // u16 forward offset; pops the condition
+    FOR_PREP,      // u16 slot, u16 exit offset: turns [start end] into [counter end]
+    FOR_LOOP,      // u16 slot, u16 back offset: bumps the counter, loops or pops it
+    DEFINE_FN,     // u16 child function, u16 callee slot
+    CALL,          // u16 callee slot, u8 argc
+    SET_RETURN,    // Pop into the return register
+    END,           // End of a function or script: yields the return register
+};
+
+// A compiled function body, or a whole script
+struct FunctionProto {
+    std::string name;
+    std::vector<std::uint8_t> code;
+    std::vector<Value> constants;
+    std::vector<const FunctionProto*> children; // Functions it declares, for DEFINE_FN
+    std::vector<std::pair<std::size_t, const std::string*>> reads; // End of each variable read -> its name
+    std::size_t params = 0;
+    std::size_t frame_size = 0; // Parameters and locals
+    std::size_t max_stack = 0;  // Operand stack high-water mark
+    bool captured = false;      // Declares functions, so its frame must outlive the call
+
+    const std::string& name_read_at(std::size_t offset) const {
+        auto it = std::lower_bound(reads.begin(), reads.end(), std::make_pair(offset, static_cast<const std::string*>(nullptr)));
+        return *it->second;
+    }
+};
+
+// A program the VM would run differently from the interpreter: it has no
+// tasks, GPU kernels or worker threads, and would run async and gpu functions
+// and `parallel for` one step after another
+struct Unsupported : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Lowers a resolved program to bytecode. Variables were already given slots by
+// Resolver; functions are called through callee slots, which the compiler
+// hands out by name and keeps across compile() calls like the global scope.
+class Compiler {
+    StringTable& strings;
+    std::deque<FunctionProto> functions; // Declared functions stay alive for the VM's callees
+    std::map<std::string, int, std::less<>> callees;
+    std::vector<std::string> callee_names;
+
+    FunctionProto* proto = nullptr;
+    int nesting = 0; // Functions enclosing the code being compiled
+    int stack_depth = 0;
+
+public:
+    explicit Compiler(StringTable& s) : strings(s) {}
+
+    FunctionProto compile(const StmtList& stmts) {
+        FunctionProto script;
+        script.name = "<script>";
+        script.captured = true; // Top-level code runs in the global frame
+        proto = &script;
+        nesting = 0;
+        stack_depth = 0;
+        for (const auto& s : stmts) compile_stmt(*s);
+        emit_op(OpCode::END, 0);
+        proto = nullptr;
+        return script;
+    }
+
+    int callee_slot(std::string_view name) {
+        auto it = callees.find(name);
+        if (it != callees.end()) return it->second;
+        if (callee_names.size() > UINT16_MAX) throw std::runtime_error("Too many functions");
+        int slot = static_cast<int>(callee_names.size());
+        callees.emplace(std::string(name), slot);
+        callee_names.emplace_back(name);
+        return slot;
+    }
+    std::size_t callee_count() const { return callee_names.size(); }
+    const std::string& callee_name(int slot) const { return callee_names[slot]; }
+
+private:
+    void emit_byte(std::uint8_t b) { proto->code.push_back(b); }
+    void emit_u16(std::size_t v) {
+        if (v > UINT16_MAX) throw std::runtime_error("Operand too large in " + proto->name);
+        emit_byte(static_cast<std::uint8_t>(v & 0xff));
+        emit_byte(static_cast<std::uint8_t>(v >> 8));
+    }
+    // `effect` is the net change the instruction makes to the operand stack
+    void emit_op(OpCode op, int effect) {
+        emit_byte(static_cast<std::uint8_t>(op));
+        stack_depth += effect;
+        proto->max_stack = std::max(proto->max_stack, static_cast<std::size_t>(stack_depth));
+    }
+    void emit_constant(Value v) {
+        emit_op(OpCode::CONSTANT, 1);
+        emit_u16(proto->constants.size());
+        proto->constants.push_back(v);
+    }
+    std::size_t emit_jump(OpCode op, int effect) {
+        emit_op(op, effect);
+        return emit_jump_operand();
+    }
+    std::size_t emit_jump_operand() {
+        emit_u16(0);
+        return proto->code.size() - 2;
+    }
+    void patch_jump(std::size_t at) {
+        std::size_t offset = proto->code.size() - (at + 2);
+        if (offset > UINT16_MAX) throw std::runtime_error("Too much code to jump over in " + proto->name);
+        proto->code[at] = static_cast<std::uint8_t>(offset & 0xff);
+        proto->code[at + 1] = static_cast<std::uint8_t>(offset >> 8);
+    }
+
+    static bool declares_functions(const StmtList& body) {
+        for (const auto& s : body) {
+            if (std::holds_alternative<FnDeclStmt>(s->value)) return true;
+            if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                if (declares_functions(i.then_branch) || declares_functions(i.else_branch)) return true;
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                if (declares_functions(std::get<ForStmt>(s->value).body)) return true;
+            }
+        }
+        return false;
+    }
+
+    const FunctionProto& compile_function(const FnDeclStmt& fn) {
+        FunctionProto& child = functions.emplace_back();
+        child.name = fn.name;
+        child.params = fn.params.size();
+        child.frame_size = fn.frame_size;
+        child.captured = declares_functions(fn.body);
+
+        FunctionProto* saved_proto = proto;
+        int saved_depth = stack_depth;
+        proto = &child;
+        stack_depth = 0;
+        ++nesting;
+        for (const auto& b : fn.body) compile_stmt(*b);
+        emit_op(OpCode::END, 0);
+        --nesting;
+        stack_depth = saved_depth;
+        proto = saved_proto;
+        return child;
+    }
+
+    void compile_stmt(const Stmt& stmt) {
+        if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
+            const auto& v = std::get<VarDeclStmt>(stmt.value);
+            compile_expr(*v.value);
+            emit_op(OpCode::SET_LOCAL, -1);
+            emit_u16(v.slot);
+        } else if (std::holds_alternative<FnDeclStmt>(stmt.value)) {
+            const auto& fn = std::get<FnDeclStmt>(stmt.value);
+            if (fn.is_async) throw Unsupported("async fn " + std::string(fn.name) + " needs the interpreter");
+            if (fn.is_gpu) throw Unsupported("gpu fn " + std::string(fn.name) + " needs the interpreter");
+            proto->children.push_back(&compile_function(fn));
+            emit_op(OpCode::DEFINE_FN, 0);
+            emit_u16(proto->children.size() - 1);
+            emit_u16(callee_slot(fn.name));
+        } else if (std::holds_alternative<IfStmt>(stmt.value)) {
+            const auto& i = std::get<IfStmt>(stmt.value);
+            compile_expr(*i.condition);
+            std::size_t else_jump = emit_jump(OpCode::JUMP_IF_FALSE, -1);
+            for (const auto& s : i.then_branch) compile_stmt(*s);
+            if (i.else_branch.empty()) {
+                patch_jump(else_jump);
+            } else {
+                std::size_t end_jump = emit_jump(OpCode::JUMP, 0);
+                patch_jump(else_jump);
+                for (const auto& s : i.else_branch) compile_stmt(*s);
+                patch_jump(end_jump);
+            }
+        } else if (std::holds_alternative<ForStmt>(stmt.value)) {
+            // The counter and the bound stay on the operand stack, so the body
+            // can reassign the loop variable without changing the iteration
+            const auto& f = std::get<ForStmt>(stmt.value);
+            if (f.parallel) throw Unsupported("parallel for needs the interpreter");
+            compile_expr(*f.start);
+            compile_expr(*f.end);
+            emit_op(OpCode::FOR_PREP, 0);
+            emit_u16(f.slot);
+            std::size_t exit_jump = proto->code.size();
+            emit_u16(0);
+            std::size_t loop_start = proto->code.size();
+            for (const auto& s : f.body) compile_stmt(*s);
+            emit_op(OpCode::FOR_LOOP, -2);
+            emit_u16(f.slot);
+            std::size_t back = proto->code.size() + 2 - loop_start;
+            if (back > UINT16_MAX) throw std::runtime_error("Loop body too large in " + proto->name);
+            emit_u16(back);
+            patch_jump(exit_jump);
+        } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
+            // Like the tree walker, return records the value and execution goes on
+            const auto& r = std::get<ReturnStmt>(stmt.value);
+            if (r.value) compile_expr(*r.value);
+            else emit_op(OpCode::NIL, 1);
+            emit_op(OpCode::SET_RETURN, -1);
+        }
+    }
+
+    void compile_read(const IdentExpr& id) {
+        if (id.slot < 0) {
+            emit_op(OpCode::UNDEFINED, 1);
+        } else if (id.shadowed) {
+            // While the slot is empty the read falls through to what it shadows
+            if (id.depth == 0) {
+                emit_op(OpCode::TRY_LOCAL, 0);
+            } else {
+                emit_op(OpCode::TRY_OUTER, 0);
+                emit_byte(static_cast<std::uint8_t>(id.depth));
+            }
+            emit_u16(id.slot);
+            std::size_t found = emit_jump_operand();
+            compile_read(*id.shadowed);
+            patch_jump(found);
+            return;
+        } else if (id.depth == 0) {
+            emit_op(OpCode::GET_LOCAL, 1);
+            emit_u16(id.slot);
+        } else if (id.depth == nesting) {
+            emit_op(OpCode::GET_GLOBAL, 1);
+            emit_u16(id.slot);
+        } else {
+            emit_op(OpCode::GET_OUTER, 1);
+            emit_byte(static_cast<std::uint8_t>(id.depth));
+            emit_u16(id.slot);
+        }
+        proto->reads.emplace_back(proto->code.size(), strings.intern(id.name));
+    }
+
+    void compile_expr(const Expr& expr) {
+        if (std::holds_alternative<NumberExpr>(expr.value)) {
+            emit_constant(Value::number(std::get<NumberExpr>(expr.value).value));
+        } else if (std::holds_alternative<StringExpr>(expr.value)) {
+            emit_constant(Value::string(strings.intern(std::get<StringExpr>(expr.value).value)));
+        } else if (std::holds_alternative<IdentExpr>(expr.value)) {
+            compile_read(std::get<IdentExpr>(expr.value));
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            compile_expr(*b.left);
+            compile_expr(*b.right);
+            switch (b.op) {
+                case TokenType::PLUS: emit_op(OpCode::ADD, -1); break;
+                case TokenType::MINUS: emit_op(OpCode::SUB, -1); break;
+                case TokenType::MUL: emit_op(OpCode::MUL, -1); break;
+                case TokenType::DIV: emit_op(OpCode::DIV, -1); break;
+                case TokenType::GT: emit_op(OpCode::GT, -1); break;
+                default: throw std::runtime_error("Invalid operator");
+            }
+        } else if (std::holds_alternative<CallExpr>(expr.value)) {
+            const auto& c = std::get<CallExpr>(expr.value);
+            if (c.args.size() > UINT8_MAX) throw std::runtime_error("Too many arguments to " + std::string(c.name));
+            for (const auto& a : c.args) compile_expr(*a);
+            emit_op(OpCode::CALL, 1 - static_cast<int>(c.args.size()));
+            emit_u16(callee_slot(c.name));
+            emit_byte(static_cast<std::uint8_t>(c.args.size()));
+        } else if (std::holds_alternative<AwaitExpr>(expr.value)) {
+            // Without async functions there is nothing to wait for
+            compile_expr(*std::get<AwaitExpr>(expr.value).expr);
+        }
+    }
+};
+
+} // namespace ouro
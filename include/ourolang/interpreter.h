@@ -1,26 +1,110 @@
 #pragma once
-#include "parser.h"
-#include "type_checker.h"
-#include "arena.h"
+#include "session.h"
+#include "resolver.h"
+#include "scheduler.h"
+#include "kernel.h"
+#if defined(OURO_JIT)
+#include "jit.h"
+#endif
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <functional>
 #include <variant>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <thread>
 #include <chrono>
 #include <iostream>
+#include <utility>
 
 namespace ouro {
 
+// Calling an `async fn` starts its body as a coroutine on a work-stealing
+// pool and gives back a Task; `await` suspends the awaiting coroutine until
+// the task settles, so thousands of tasks can wait without a thread each.
+// The environments and function table are shared, so interpreter code only
+// runs under `gil`: run() holds it for the top-level statements and a pool
+// job for as long as it resumes a task. Tasks let go of it when they suspend.
+//
+// A `gpu fn` whose body Kernel can compile runs on the CPU backend instead,
+// spread over `threads` threads (see kernel.h), and so does the range of a
+// `parallel for` (see run_parallel). Built with OURO_JIT, plain functions
+// with numeric signatures move to native code once they are hot (see jit.h).
 class Interpreter {
-    using Value = std::variant<double, std::string, std::monostate>;
+    struct Task;
+    using Value = std::variant<double, std::string, std::monostate, std::shared_ptr<Task>>;
     using Function = std::function<Value(const std::vector<Value>&, Interpreter&)>;
-    std::map<std::string, Value> env;
-    std::map<std::string, Function> functions;
+
+    // A running async call or a pending sleep. Guarded by `gil`.
+    struct Task {
+        bool done = false;
+        Value result;
+        std::exception_ptr error;
+        std::vector<std::coroutine_handle<>> waiters; // Coroutines suspended in an await on this
+    };
+
+    // Suspends the awaiting coroutine until `task` settles
+    struct Join {
+        Task& task;
+        bool await_ready() const noexcept { return task.done; }
+        void await_suspend(std::coroutine_handle<> awaiter) { task.waiters.push_back(awaiter); }
+        Value await_resume() const { return result(task); }
+    };
+
+    // One scope's variables, indexed by the slots Resolver assigned, plus a
+    // link to the scope it was declared in. A call allocates only its own
+    // parameters and locals; globals and the variables of enclosing functions
+    // are reached through `parent`.
+    class Environment : public std::enable_shared_from_this<Environment> {
+        std::vector<std::optional<Value>> slots; // Empty until the declaration runs
+        std::shared_ptr<Environment> parent;
+
+    public:
+        explicit Environment(std::size_t size, std::shared_ptr<Environment> p = nullptr)
+            : slots(size), parent(std::move(p)) {}
+
+        void resize(std::size_t size) { slots.resize(size); }
+        void set(int slot, Value value) { slots[slot] = std::move(value); }
+        void reset(int slot) { slots[slot].reset(); }
+
+        const std::optional<Value>& get(int depth, int slot) const {
+            const Environment* scope = this;
+            for (; depth > 0; --depth) scope = scope->parent.get();
+            return scope->slots[slot];
+        }
+    };
+
+    Session session;   // Parses and checks each input against everything before it
+    Resolver resolver; // Keeps the global slots across run() calls
+    std::shared_ptr<Environment> globals = std::make_shared<Environment>(0);
+    std::map<std::string, Function, std::less<>> functions;
+    std::map<std::string, Function, std::less<>> suspending; // Natives whose Task every call awaits
     Value return_value;
-    std::vector<StmtPtr> program;
+    std::vector<std::shared_ptr<Arena>> units; // Declared functions run straight off their unit's AST
+
+    unsigned threads; // Used by kernels, counting the caller
+    std::mutex gil;
+    std::condition_variable_any settled; // Signalled under `gil` when a task settles
+    std::size_t live_tasks = 0;
+    // Both started on first use. The wheel submits to the pool, so it stops first.
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<TimerWheel> timers;
+#if defined(OURO_JIT)
+    std::unique_ptr<Jit> jit; // Started by the first function to get hot
+
+    struct Tier {
+        unsigned calls = 0;
+        Jit::Entry native = nullptr;
+    };
+#endif
 
 public:
-    Interpreter() {
+    // `threads` of 0 means one per hardware thread
+    explicit Interpreter(unsigned threads = 0)
+        : threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {
         functions["print"] = [](const std::vector<Value>& args, Interpreter&) -> Value {
             for (const auto& a : args) {
                 if (std::holds_alternative<double>(a)) std::cout << std::get<double>(a);
@@ -29,45 +113,82 @@ public:
             std::cout << std::endl;
             return {};
         };
-        functions["sleep"] = [](const std::vector<Value>& args, Interpreter&) -> Value {
-            if (!args.empty() && std::holds_alternative<double>(args[0])) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(std::get<double>(args[0]))));
-            }
-            return {};
+        // Suspends an async caller and blocks any other, letting tasks run meanwhile
+        suspending["sleep"] = [](const std::vector<Value>& args, Interpreter& interp) -> Value {
+            if (args.empty() || !std::holds_alternative<double>(args[0])) return {};
+            return interp.after(std::chrono::milliseconds(static_cast<int>(std::get<double>(args[0]))));
         };
+        session.declare_function("print", "");
+        session.declare_function("sleep", "");
+    }
+
+    // Tasks nobody awaited still run to the end, as they would in a process
+    // that outlived the script
+    ~Interpreter() {
+        std::unique_lock lock(gil);
+        settled.wait(lock, [this] { return live_tasks == 0; });
+    }
+
+    // Runs complete statements; input that stops mid-statement is an error
+    void run(const std::string& source) { run(parse(source, false)); }
+
+    // Adds input that may stop mid-statement, like a line typed into the REPL,
+    // and runs the statements it completes. False while one is still open.
+    bool feed(const std::string& input) {
+        run(parse(input, true));
+        return !session.pending();
     }
 
-    void run(const std::string& source) {
-        Arena arena;
-        Lexer lex(source, arena.get_resource());
-        auto tokens = lex.tokenize();
-        Parser parser(tokens);
-        auto ast = parser.parse();
-        TypeChecker checker;
-        checker.check(ast);
-        for (auto& s : ast) {
-            program.push_back(std::move(s));
-            execute_stmt(*program.back());
+    void run(Session::Update update) {
+        std::lock_guard lock(gil);
+        resolver.resolve(update.stmts);
+        globals->resize(resolver.global_count());
+        units.push_back(std::move(update.arena));
+        for (const auto* s : update.stmts) {
+            execute_stmt(*s, *globals);
         }
     }
 
 private:
-    void execute_stmt(const Stmt& stmt, std::map<std::string, Value>* local_env = nullptr) {
-        auto& e = local_env ? *local_env : env;
+    Session::Update parse(const std::string& input, bool allow_pending) {
+        // The line break keeps the next input off this one's last line
+        auto update = session.append(input + '\n', allow_pending);
+        session.discard_statements(); // They live on in `update` for as long as they are needed
+        return update;
+    }
+
+    void execute_stmt(const Stmt& stmt, Environment& e) {
         if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
             const auto& v = std::get<VarDeclStmt>(stmt.value);
-            e[v.name] = evaluate_expr(*v.value, e);
+            e.set(v.slot, evaluate_expr(*v.value, e));
         } else if (std::holds_alternative<FnDeclStmt>(stmt.value)) {
             auto& fn = std::get<FnDeclStmt>(stmt.value);
-            functions[fn.name] = [this, &fn](const std::vector<Value>& args, Interpreter& interp) -> Value {
-                std::map<std::string, Value> fn_env = env;
-                for (size_t i = 0; i < args.size() && i < fn.params.size(); ++i) {
-                    fn_env[fn.params[i].first] = args[i];
-                }
-                for (const auto& b : fn.body) {
-                    interp.execute_stmt(*b, &fn_env);
+            if (fn.is_async) {
+                functions[std::string(fn.name)] = [&fn, closure = e.shared_from_this()](const std::vector<Value>& args, Interpreter& interp) -> Value {
+                    return interp.spawn(fn, frame(fn, closure, args));
+                };
+                return;
+            }
+            if (fn.is_gpu) {
+                if (auto kernel = Kernel::compile(fn)) {
+                    functions[std::string(fn.name)] = [&fn, closure = e.shared_from_this(),
+                                                       kernel = std::make_shared<const Kernel>(std::move(*kernel))](const std::vector<Value>& args, Interpreter& interp) -> Value {
+                        return interp.offload(*kernel, fn, closure, args);
+                    };
+                    return;
                 }
-                return interp.return_value;
+            }
+#if defined(OURO_JIT)
+            if (Jit::supports(fn)) {
+                functions[std::string(fn.name)] = [&fn, closure = e.shared_from_this(), tier = std::make_shared<Tier>()](const std::vector<Value>& args, Interpreter& interp) -> Value {
+                    return interp.call_tiered(fn, closure, *tier, args);
+                };
+                return;
+            }
+#endif
+            // The body sees the scope the function was declared in, not a copy of it
+            functions[std::string(fn.name)] = [&fn, closure = e.shared_from_this()](const std::vector<Value>& args, Interpreter& interp) -> Value {
+                return interp.call(fn, closure, args);
             };
         } else if (std::holds_alternative<IfStmt>(stmt.value)) {
             const auto& i = std::get<IfStmt>(stmt.value);
@@ -75,9 +196,9 @@ private:
             bool truth = false;
             if (std::holds_alternative<double>(cond)) truth = std::get<double>(cond) != 0;
             if (truth) {
-                for (const auto& s : i.then_branch) execute_stmt(*s, &e);
+                for (const auto& s : i.then_branch) execute_stmt(*s, e);
             } else {
-                for (const auto& s : i.else_branch) execute_stmt(*s, &e);
+                for (const auto& s : i.else_branch) execute_stmt(*s, e);
             }
         } else if (std::holds_alternative<ForStmt>(stmt.value)) {
             const auto& f = std::get<ForStmt>(stmt.value);
@@ -85,9 +206,13 @@ private:
             auto end = evaluate_expr(*f.end, e);
             int s = static_cast<int>(std::get<double>(start));
             int en = static_cast<int>(std::get<double>(end));
+            if (f.parallel) {
+                run_parallel(f, e, s, en);
+                return;
+            }
             for (int i = s; i < en; ++i) {
-                e[f.var] = static_cast<double>(i);
-                for (const auto& st : f.body) execute_stmt(*st, &e);
+                e.set(f.slot, static_cast<double>(i));
+                for (const auto& st : f.body) execute_stmt(*st, e);
             }
         } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
             const auto& r = std::get<ReturnStmt>(stmt.value);
@@ -96,43 +221,392 @@ private:
         }
     }
 
-    Value evaluate_expr(const Expr& expr, std::map<std::string, Value>& e) {
+    Value evaluate_expr(const Expr& expr, Environment& e) {
         if (std::holds_alternative<NumberExpr>(expr.value)) {
             return std::get<NumberExpr>(expr.value).value;
         } else if (std::holds_alternative<StringExpr>(expr.value)) {
-            return std::get<StringExpr>(expr.value).value;
+            return std::string(std::get<StringExpr>(expr.value).value);
         } else if (std::holds_alternative<IdentExpr>(expr.value)) {
             const auto& id = std::get<IdentExpr>(expr.value);
-            if (e.find(id.name) != e.end()) return e[id.name];
-            throw std::runtime_error("Undefined variable: " + id.name);
+            for (const IdentExpr* binding = &id; binding && binding->slot >= 0; binding = binding->shadowed) {
+                const auto& value = e.get(binding->depth, binding->slot);
+                if (value) return *value;
+            }
+            throw std::runtime_error("Undefined variable: " + std::string(id.name));
         } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
             const auto& b = std::get<BinaryExpr>(expr.value);
             auto left = evaluate_expr(*b.left, e);
             auto right = evaluate_expr(*b.right, e);
-            double l = std::get<double>(left);
-            double r = std::get<double>(right);
-            switch (b.op) {
-                case TokenType::PLUS: return l + r;
-                case TokenType::MINUS: return l - r;
-                case TokenType::MUL: return l * r;
-                case TokenType::DIV: return l / r;
-                case TokenType::GT: return l > r ? 1.0 : 0.0;
-                default: throw std::runtime_error("Invalid operator");
-            }
+            return arithmetic(b.op, left, right);
         } else if (std::holds_alternative<CallExpr>(expr.value)) {
             const auto& c = std::get<CallExpr>(expr.value);
-            if (functions.find(c.name) == functions.end()) {
-                throw std::runtime_error("Undefined function: " + c.name);
-            }
+            auto [fn, awaited] = callee(c.name);
             std::vector<Value> args;
             for (const auto& a : c.args) args.push_back(evaluate_expr(*a, e));
-            return functions[c.name](args, *this);
+            auto value = (*fn)(args, *this);
+            return awaited ? wait(value) : value;
         } else if (std::holds_alternative<AwaitExpr>(expr.value)) {
             const auto& a = std::get<AwaitExpr>(expr.value);
-            return evaluate_expr(*a.expr, e);
+            return wait(evaluate_expr(*a.expr, e));
         }
         throw std::runtime_error("Invalid expression");
     }
+
+    static Value arithmetic(TokenType op, const Value& left, const Value& right) {
+        double l = std::get<double>(left);
+        double r = std::get<double>(right);
+        switch (op) {
+            case TokenType::PLUS: return l + r;
+            case TokenType::MINUS: return l - r;
+            case TokenType::MUL: return l * r;
+            case TokenType::DIV: return l / r;
+            case TokenType::GT: return l > r ? 1.0 : 0.0;
+            default: throw std::runtime_error("Invalid operator");
+        }
+    }
+
+    // The function a call names, and whether what it returns is a Task the
+    // call waits for. Functions the program declares hide natives.
+    std::pair<const Function*, bool> callee(std::string_view name) const {
+        if (auto fn = functions.find(name); fn != functions.end()) return {&fn->second, false};
+        if (auto fn = suspending.find(name); fn != suspending.end()) return {&fn->second, true};
+        throw std::runtime_error("Undefined function: " + std::string(name));
+    }
+
+    Value call(const FnDeclStmt& fn, const std::shared_ptr<Environment>& closure, const std::vector<Value>& args) {
+        auto fn_env = frame(fn, closure, args);
+        for (const auto& b : fn.body) {
+            execute_stmt(*b, *fn_env);
+        }
+        return return_value;
+    }
+
+    // Arguments that are not all numbers send the call back to the interpreter
+    Value offload(const Kernel& kernel, const FnDeclStmt& fn, const std::shared_ptr<Environment>& closure,
+                  const std::vector<Value>& args) {
+        std::vector<double> numbers;
+        for (const auto& a : args) {
+            if (!std::holds_alternative<double>(a)) return call(fn, closure, args);
+            numbers.push_back(std::get<double>(a));
+        }
+        auto result = kernel.run(numbers, threads > 1 ? &workers() : nullptr, threads - 1);
+        return_value = result ? Value(*result) : Value();
+        return return_value;
+    }
+
+#if defined(OURO_JIT)
+    // Interpreted until the function has been called Jit::HOT_CALLS times.
+    // Calls with the wrong number of arguments, or ones that are not all
+    // numbers, stay on the interpreter, which reports the errors they cause.
+    Value call_tiered(const FnDeclStmt& fn, const std::shared_ptr<Environment>& closure, Tier& tier,
+                      const std::vector<Value>& args) {
+        if (!tier.native && ++tier.calls == Jit::HOT_CALLS) {
+            if (!jit) jit = std::make_unique<Jit>();
+            tier.native = jit->compile(fn);
+        }
+        if (!tier.native || args.size() != fn.params.size()) return call(fn, closure, args);
+        std::vector<double> numbers;
+        for (const auto& a : args) {
+            if (!std::holds_alternative<double>(a)) return call(fn, closure, args);
+            numbers.push_back(std::get<double>(a));
+        }
+        return_value = tier.native(numbers.data());
+        return return_value;
+    }
+#endif
+
+    static std::shared_ptr<Environment> frame(const FnDeclStmt& fn, const std::shared_ptr<Environment>& closure,
+                                              const std::vector<Value>& args) {
+        auto fn_env = std::make_shared<Environment>(fn.frame_size, closure); // Shared so nested fns can capture it
+        for (size_t i = 0; i < args.size() && i < fn.params.size(); ++i) {
+            fn_env->set(static_cast<int>(i), args[i]); // Parameters take the first slots
+        }
+        return fn_env;
+    }
+
+    // --- parallel for ------------------------------------------------------------
+    //
+    // The range is cut into CHUNK-iteration pieces that the calling thread and
+    // up to `threads` - 1 workers share. Each piece runs in its own copy of the
+    // frame, where what the body sets starts out unset, or at the identity for
+    // a reduction. Afterwards a variable takes the value the last piece to set
+    // it left, and a reduction folds in the pieces' results in order, so the
+    // outcome does not depend on the thread count. TypeChecker has made sure
+    // the body only computes, so a piece touches nothing shared besides reading
+    // the enclosing scopes, which nothing writes while `gil` is held.
+
+    static constexpr std::size_t CHUNK = 1024;
+
+    struct Written {
+        std::string_view name;
+        std::optional<TokenType> op; // Set for a reduction
+        const Expr* total = nullptr; // A reduction's read of its own variable
+    };
+
+    static void written(const StmtList& stmts, std::map<int, Written>& sets) {
+        for (const auto* s : stmts) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                const auto& v = std::get<VarDeclStmt>(s->value);
+                auto op = TypeChecker::reduction(v);
+                const Expr* total = nullptr;
+                if (op) {
+                    const auto& b = std::get<BinaryExpr>(v.value->value);
+                    bool left = std::holds_alternative<IdentExpr>(b.left->value) && std::get<IdentExpr>(b.left->value).name == v.name;
+                    total = left ? b.left : b.right;
+                }
+                auto [it, added] = sets.try_emplace(v.slot, Written{v.name, op, total});
+                if (!added && it->second.op != op) it->second.op.reset();
+            } else if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                written(i.then_branch, sets);
+                written(i.else_branch, sets);
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                const auto& f = std::get<ForStmt>(s->value);
+                sets.insert_or_assign(f.slot, Written{f.var, std::nullopt});
+                written(f.body, sets);
+            }
+        }
+    }
+
+    void run_parallel(const ForStmt& f, Environment& e, int start, int end) {
+        if (start >= end) return;
+        std::map<int, Written> sets;
+        written(f.body, sets);
+        for (const auto& [slot, w] : sets) {
+            // A sum not yet set starts from what the first iteration would read
+            if (w.op && !e.get(0, slot)) e.set(slot, evaluate_expr(*w.total, e));
+        }
+
+        auto n = static_cast<std::size_t>(static_cast<long long>(end) - start);
+        std::size_t pieces = (n + CHUNK - 1) / CHUNK;
+        std::vector<std::vector<std::optional<Value>>> results(pieces); // What each piece left in `sets`
+        std::vector<std::exception_ptr> errors(pieces);
+        auto piece = [&](std::size_t p) {
+            try {
+                Environment local = e;
+                for (const auto& [slot, w] : sets) {
+                    if (w.op) local.set(slot, *w.op == TokenType::MUL ? 1.0 : 0.0);
+                    else local.reset(slot);
+                }
+                for (std::size_t i = p * CHUNK; i < std::min(n, (p + 1) * CHUNK); ++i) {
+                    local.set(f.slot, static_cast<double>(start + static_cast<long long>(i)));
+                    for (const auto& st : f.body) execute_stmt(*st, local);
+                }
+                for (const auto& [slot, w] : sets) results[p].push_back(local.get(0, slot));
+            } catch (...) {
+                errors[p] = std::current_exception();
+            }
+        };
+        if (threads > 1 && pieces > 1) {
+            workers().parallel(pieces, threads - 1, piece);
+        } else {
+            for (std::size_t p = 0; p < pieces; ++p) piece(p);
+        }
+        for (const auto& error : errors) { // The earliest, as the plain loop would have stopped there
+            if (error) std::rethrow_exception(error);
+        }
+
+        std::size_t k = 0;
+        for (const auto& [slot, w] : sets) {
+            if (w.op) {
+                Value total = *e.get(0, slot);
+                auto fold = *w.op == TokenType::MUL ? TokenType::MUL : TokenType::PLUS; // A piece's `s - e`s start from 0
+                for (const auto& r : results) total = arithmetic(fold, total, *r[k]);
+                e.set(slot, std::move(total));
+            } else {
+                for (auto r = results.rbegin(); r != results.rend(); ++r) {
+                    if ((*r)[k]) {
+                        e.set(slot, *(*r)[k]);
+                        break;
+                    }
+                }
+            }
+            ++k;
+        }
+        e.set(f.slot, static_cast<double>(end - 1));
+    }
+
+    // --- Tasks ---------------------------------------------------------------
+
+    static Value result(const Task& task) {
+        if (task.error) std::rethrow_exception(task.error);
+        return task.result;
+    }
+
+    ThreadPool& workers() {
+        if (!pool) pool = std::make_unique<ThreadPool>(std::max(2u, threads));
+        return *pool;
+    }
+
+    ThreadPool::Job resume(std::coroutine_handle<> h) {
+        return [this, h] {
+            std::lock_guard lock(gil);
+            h.resume();
+        };
+    }
+
+    Value spawn(const FnDeclStmt& fn, std::shared_ptr<Environment> env) {
+        auto task = std::make_shared<Task>();
+        ++live_tasks;
+        workers().submit(resume(run_task(task, fn, std::move(env)).handle));
+        return task;
+    }
+
+    Detached run_task(std::shared_ptr<Task> task, const FnDeclStmt& fn, std::shared_ptr<Environment> env) {
+        try {
+            Value value;
+            co_await execute_async(fn.body, *env, value);
+            task->result = std::move(value);
+        } catch (...) {
+            task->error = std::current_exception();
+        }
+        settle(*task);
+    }
+
+    // A Task that settles once `delay` has passed, off the timer wheel
+    Value after(std::chrono::milliseconds delay) {
+        auto task = std::make_shared<Task>();
+        ++live_tasks;
+        workers();
+        if (!timers) timers = std::make_unique<TimerWheel>();
+        timers->schedule(delay, [this, task] {
+            pool->submit([this, task] {
+                std::lock_guard lock(gil);
+                settle(*task);
+            });
+        });
+        return task;
+    }
+
+    void settle(Task& task) {
+        task.done = true;
+        for (auto h : task.waiters) pool->submit(resume(h));
+        task.waiters.clear();
+        --live_tasks;
+        settled.notify_all();
+    }
+
+    // Await from code that cannot suspend: top-level statements and plain
+    // functions. Blocks with `gil` let go, so the tasks can run. A worker runs
+    // queued jobs while it waits, or a pool whose workers all wait would stall.
+    Value wait(Value value) {
+        if (!std::holds_alternative<std::shared_ptr<Task>>(value)) return value;
+        auto task = std::get<std::shared_ptr<Task>>(std::move(value));
+        Value saved = std::move(return_value); // Other code returns meanwhile
+        while (!task->done) {
+            if (pool->on_worker()) {
+                gil.unlock();
+                bool ran = pool->run_pending();
+                gil.lock();
+                if (!ran && !task->done) settled.wait_for(gil, std::chrono::milliseconds(1));
+            } else {
+                settled.wait(gil);
+            }
+        }
+        return_value = std::move(saved);
+        return result(*task);
+    }
+
+    // --- Async bodies ----------------------------------------------------------
+    //
+    // The statements of an async body run on the plain evaluator, unless they
+    // can suspend. Those run here as coroutines, one frame per node on the way
+    // down to the await. `value` is the task's own return value.
+
+    Lazy<void> execute_async(const StmtList& stmts, Environment& e, Value& value) {
+        for (const auto* s : stmts) {
+            if (suspends(*s)) co_await execute_async(*s, e, value);
+            else execute_stmt(*s, e);
+        }
+    }
+
+    Lazy<void> execute_async(const Stmt& stmt, Environment& e, Value& value) {
+        if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
+            const auto& v = std::get<VarDeclStmt>(stmt.value);
+            e.set(v.slot, co_await evaluate_async(*v.value, e));
+        } else if (std::holds_alternative<IfStmt>(stmt.value)) {
+            const auto& i = std::get<IfStmt>(stmt.value);
+            auto cond = co_await evaluate_async(*i.condition, e);
+            bool truth = false;
+            if (std::holds_alternative<double>(cond)) truth = std::get<double>(cond) != 0;
+            co_await execute_async(truth ? i.then_branch : i.else_branch, e, value);
+        } else if (std::holds_alternative<ForStmt>(stmt.value)) {
+            const auto& f = std::get<ForStmt>(stmt.value);
+            auto start = co_await evaluate_async(*f.start, e);
+            auto end = co_await evaluate_async(*f.end, e);
+            int s = static_cast<int>(std::get<double>(start));
+            int en = static_cast<int>(std::get<double>(end));
+            if (f.parallel) {
+                run_parallel(f, e, s, en); // Its body cannot suspend
+                co_return;
+            }
+            for (int i = s; i < en; ++i) {
+                e.set(f.slot, static_cast<double>(i));
+                co_await execute_async(f.body, e, value);
+            }
+        } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
+            const auto& r = std::get<ReturnStmt>(stmt.value);
+            if (r.value) value = co_await evaluate_async(*r.value, e);
+            else value = {};
+        }
+    }
+
+    Lazy<Value> evaluate_async(const Expr& expr, Environment& e) {
+        if (!suspends(expr)) co_return evaluate_expr(expr, e);
+        if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            auto left = co_await evaluate_async(*b.left, e);
+            auto right = co_await evaluate_async(*b.right, e);
+            co_return arithmetic(b.op, left, right);
+        } else if (std::holds_alternative<CallExpr>(expr.value)) {
+            const auto& c = std::get<CallExpr>(expr.value);
+            auto [fn, awaited] = callee(c.name);
+            std::vector<Value> args;
+            for (const auto& a : c.args) args.push_back(co_await evaluate_async(*a, e));
+            auto value = (*fn)(args, *this);
+            co_return awaited ? co_await join(std::move(value)) : value;
+        } else {
+            const auto& a = std::get<AwaitExpr>(expr.value);
+            co_return co_await join(co_await evaluate_async(*a.expr, e));
+        }
+    }
+
+    // Await from an async body; anything but a Task is its own result
+    Lazy<Value> join(Value value) {
+        if (!std::holds_alternative<std::shared_ptr<Task>>(value)) co_return value;
+        auto task = std::get<std::shared_ptr<Task>>(std::move(value)); // Kept alive across the suspension
+        co_return co_await Join{*task};
+    }
+
+    bool suspends(const Expr& expr) const {
+        if (std::holds_alternative<AwaitExpr>(expr.value)) return true;
+        if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            return suspends(*b.left) || suspends(*b.right);
+        }
+        if (std::holds_alternative<CallExpr>(expr.value)) {
+            const auto& c = std::get<CallExpr>(expr.value);
+            if (!functions.contains(c.name) && suspending.contains(c.name)) return true;
+            return std::any_of(c.args.begin(), c.args.end(), [this](const Expr* a) { return suspends(*a); });
+        }
+        return false;
+    }
+
+    bool suspends(const Stmt& stmt) const {
+        auto any = [this](const StmtList& stmts) {
+            return std::any_of(stmts.begin(), stmts.end(), [this](const Stmt* s) { return suspends(*s); });
+        };
+        if (std::holds_alternative<VarDeclStmt>(stmt.value)) return suspends(*std::get<VarDeclStmt>(stmt.value).value);
+        if (std::holds_alternative<IfStmt>(stmt.value)) {
+            const auto& i = std::get<IfStmt>(stmt.value);
+            return suspends(*i.condition) || any(i.then_branch) || any(i.else_branch);
+        }
+        if (std::holds_alternative<ForStmt>(stmt.value)) {
+            const auto& f = std::get<ForStmt>(stmt.value);
+            return suspends(*f.start) || suspends(*f.end) || any(f.body);
+        }
+        return std::holds_alternative<ReturnStmt>(stmt.value); // It sets the task's value, not return_value
+    }
 };
 
 } // namespace ouro
@@ -0,0 +1,323 @@
+#pragma once
+#include "ast.h"
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ouro {
+
+// Compiles functions to native code with LLVM's ORC JIT. The interpreter
+// uses it when built with OURO_JIT: a function that qualifies runs
+// interpreted for its first HOT_CALLS calls and natively after that.
+//
+// A function qualifies if its parameters and its return type are declared
+// `int` or `float` and its body only computes with them: `let`, `if`, `for`
+// and `return` over arithmetic on numbers, its own parameters and locals,
+// and calls to itself. Every read must follow a `let` that surely ran, and
+// every path must return a value, so the interpreter could not have raised
+// an error or returned something left over from another call. Anything else
+// stays on the interpreter.
+//
+// Native code computes in doubles like the interpreter, with the same
+// operations in the same order, so it gives the same results bit for bit.
+// As in the interpreter, `return` records a value without leaving, and the
+// last value recorded is the result.
+class Jit {
+public:
+    using Entry = double (*)(const double* args);
+    static constexpr unsigned HOT_CALLS = 100;
+
+    Jit() {
+        static std::once_flag init;
+        std::call_once(init, [] {
+            llvm::InitializeNativeTarget();
+            llvm::InitializeNativeTargetAsmPrinter();
+        });
+    }
+
+    static bool supports(const FnDeclStmt& fn) {
+        if (fn.is_async || !numeric(fn.return_type) || fn.params.size() > fn.frame_size) return false;
+        for (const auto& p : fn.params) {
+            if (!numeric(p.second)) return false;
+        }
+        std::vector<bool> set(fn.frame_size);
+        std::fill_n(set.begin(), fn.params.size(), true);
+        bool returned = false;
+        return supported(fn, fn.body, set, returned) && returned;
+    }
+
+    // Entry takes the arguments in order. Null if `fn` does not qualify or
+    // LLVM could not compile it.
+    Entry compile(const FnDeclStmt& fn) {
+        if (!supports(fn) || (!jit && !start())) return nullptr;
+        auto context = std::make_unique<llvm::LLVMContext>();
+        auto module = std::make_unique<llvm::Module>("ouro", *context);
+        module->setDataLayout(jit->getDataLayout());
+        module->setTargetTriple(jit->getTargetTriple().str());
+        std::string name = "ouro." + std::string(fn.name) + "." + std::to_string(compiled++);
+        Emitter(fn, *module, name).emit();
+        if (llvm::verifyModule(*module)) return nullptr;
+        optimize(*module);
+        if (auto error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+            llvm::consumeError(std::move(error));
+            return nullptr;
+        }
+        auto symbol = jit->lookup(name + ".entry");
+        if (!symbol) {
+            llvm::consumeError(symbol.takeError());
+            return nullptr;
+        }
+#if LLVM_VERSION_MAJOR >= 15
+        return symbol->toPtr<Entry>();
+#else
+        return reinterpret_cast<Entry>(symbol->getAddress());
+#endif
+    }
+
+private:
+    std::unique_ptr<llvm::TargetMachine> machine; // For the optimizer's cost model
+    std::unique_ptr<llvm::orc::LLJIT> jit;        // Started by the first compile
+    unsigned compiled = 0;
+
+    static bool numeric(std::string_view type) { return type == "int" || type == "float"; }
+
+    // `set` tracks the slots surely set by this point, `returned` whether a
+    // `return` surely ran
+    static bool supported(const FnDeclStmt& fn, const StmtList& stmts, std::vector<bool>& set, bool& returned) {
+        for (const Stmt* s : stmts) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                const auto& v = std::get<VarDeclStmt>(s->value);
+                if (!supported(fn, *v.value, set)) return false;
+                set[v.slot] = true;
+            } else if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                if (!supported(fn, *i.condition, set)) return false;
+                auto then_set = set, else_set = set;
+                bool then_returned = returned, else_returned = returned;
+                if (!supported(fn, i.then_branch, then_set, then_returned)) return false;
+                if (!supported(fn, i.else_branch, else_set, else_returned)) return false;
+                for (std::size_t k = 0; k < set.size(); ++k) set[k] = then_set[k] && else_set[k];
+                returned = then_returned && else_returned;
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                // A parallel for's sums are folded in pieces, which plain loops would not match
+                const auto& f = std::get<ForStmt>(s->value);
+                if (f.parallel || !supported(fn, *f.start, set) || !supported(fn, *f.end, set)) return false;
+                auto body_set = set; // The body may not run at all
+                body_set[f.slot] = true;
+                bool body_returned = returned;
+                if (!supported(fn, f.body, body_set, body_returned)) return false;
+            } else if (std::holds_alternative<ReturnStmt>(s->value)) {
+                const auto& r = std::get<ReturnStmt>(s->value);
+                if (!r.value || !supported(fn, *r.value, set)) return false;
+                returned = true;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool supported(const FnDeclStmt& fn, const Expr& expr, const std::vector<bool>& set) {
+        if (std::holds_alternative<NumberExpr>(expr.value)) return true;
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            const auto& id = std::get<IdentExpr>(expr.value);
+            return id.depth == 0 && id.slot >= 0 && set[id.slot]; // Globals and captures may not be numbers
+        }
+        if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            switch (b.op) {
+                case TokenType::PLUS:
+                case TokenType::MINUS:
+                case TokenType::MUL:
+                case TokenType::DIV:
+                case TokenType::GT: return supported(fn, *b.left, set) && supported(fn, *b.right, set);
+                default: return false;
+            }
+        }
+        if (std::holds_alternative<CallExpr>(expr.value)) {
+            // Nothing a qualifying body runs can rebind the name, so it stays this function
+            const auto& c = std::get<CallExpr>(expr.value);
+            if (c.name != fn.name || c.args.size() != fn.params.size()) return false;
+            return std::all_of(c.args.begin(), c.args.end(), [&](const Expr* a) { return supported(fn, *a, set); });
+        }
+        return false;
+    }
+
+    bool start() {
+        auto host = llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!host) {
+            llvm::consumeError(host.takeError());
+            return false;
+        }
+        auto target = host->createTargetMachine();
+        if (!target) {
+            llvm::consumeError(target.takeError());
+            return false;
+        }
+        machine = std::move(*target);
+        auto created = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(*host)).create();
+        if (!created) {
+            llvm::consumeError(created.takeError());
+            return false;
+        }
+        jit = std::move(*created);
+        return true;
+    }
+
+    void optimize(llvm::Module& module) {
+        llvm::LoopAnalysisManager loops;
+        llvm::FunctionAnalysisManager functions;
+        llvm::CGSCCAnalysisManager sccs;
+        llvm::ModuleAnalysisManager modules;
+        llvm::PassBuilder builder(machine.get());
+        builder.registerModuleAnalyses(modules);
+        builder.registerCGSCCAnalyses(sccs);
+        builder.registerFunctionAnalyses(functions);
+        builder.registerLoopAnalyses(loops);
+        builder.crossRegisterProxies(loops, functions, sccs, modules);
+        builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2).run(module, modules);
+    }
+
+    // Builds `double <name>(double...)` from a qualifying function, and
+    // `double <name>.entry(const double*)` to call it from C++. Every slot
+    // lives in a stack variable, which the optimizer turns into registers.
+    class Emitter {
+        const FnDeclStmt& fn;
+        llvm::Module& module;
+        llvm::IRBuilder<> b;
+        llvm::Type* number;
+        llvm::Function* function;
+        std::vector<llvm::AllocaInst*> slots;
+        llvm::AllocaInst* result = nullptr; // The last value returned
+
+    public:
+        Emitter(const FnDeclStmt& f, llvm::Module& m, const std::string& name)
+            : fn(f), module(m), b(m.getContext()), number(b.getDoubleTy()) {
+            std::vector<llvm::Type*> params(fn.params.size(), number);
+            function = llvm::Function::Create(llvm::FunctionType::get(number, params, false),
+                                              llvm::Function::InternalLinkage, name, module);
+        }
+
+        void emit() {
+            b.SetInsertPoint(llvm::BasicBlock::Create(module.getContext(), "entry", function));
+            for (std::size_t i = 0; i < fn.frame_size; ++i) slots.push_back(local(number));
+            result = local(number);
+            for (std::size_t i = 0; i < fn.params.size(); ++i) b.CreateStore(function->getArg(i), slots[i]);
+            emit(fn.body);
+            b.CreateRet(b.CreateLoad(number, result));
+
+            auto* pointer = llvm::PointerType::getUnqual(number);
+            auto* entry = llvm::Function::Create(llvm::FunctionType::get(number, {pointer}, false),
+                                                 llvm::Function::ExternalLinkage, function->getName() + ".entry", module);
+            b.SetInsertPoint(llvm::BasicBlock::Create(module.getContext(), "entry", entry));
+            std::vector<llvm::Value*> args;
+            for (std::size_t i = 0; i < fn.params.size(); ++i) {
+                args.push_back(b.CreateLoad(number, b.CreateConstGEP1_64(number, entry->getArg(0), i)));
+            }
+            b.CreateRet(b.CreateCall(function, args));
+        }
+
+    private:
+        void emit(const StmtList& stmts) {
+            for (const Stmt* s : stmts) emit(*s);
+        }
+
+        void emit(const Stmt& stmt) {
+            auto& context = module.getContext();
+            if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
+                const auto& v = std::get<VarDeclStmt>(stmt.value);
+                b.CreateStore(emit(*v.value), slots[v.slot]);
+            } else if (std::holds_alternative<IfStmt>(stmt.value)) {
+                const auto& i = std::get<IfStmt>(stmt.value);
+                auto* truth = b.CreateFCmpUNE(emit(*i.condition), llvm::ConstantFP::get(number, 0.0));
+                auto* then_block = llvm::BasicBlock::Create(context, "then", function);
+                auto* else_block = llvm::BasicBlock::Create(context, "else", function);
+                auto* done = llvm::BasicBlock::Create(context, "endif", function);
+                b.CreateCondBr(truth, then_block, else_block);
+                b.SetInsertPoint(then_block);
+                emit(i.then_branch);
+                b.CreateBr(done);
+                b.SetInsertPoint(else_block);
+                emit(i.else_branch);
+                b.CreateBr(done);
+                b.SetInsertPoint(done);
+            } else if (std::holds_alternative<ForStmt>(stmt.value)) {
+                // The counter is separate from the loop variable, which the body may set
+                const auto& f = std::get<ForStmt>(stmt.value);
+                auto* counter = local(b.getInt32Ty());
+                b.CreateStore(to_int(emit(*f.start)), counter);
+                auto* end = to_int(emit(*f.end));
+                auto* test = llvm::BasicBlock::Create(context, "for", function);
+                auto* body = llvm::BasicBlock::Create(context, "body", function);
+                auto* done = llvm::BasicBlock::Create(context, "endfor", function);
+                b.CreateBr(test);
+                b.SetInsertPoint(test);
+                auto* i = b.CreateLoad(b.getInt32Ty(), counter);
+                b.CreateCondBr(b.CreateICmpSLT(i, end), body, done);
+                b.SetInsertPoint(body);
+                b.CreateStore(b.CreateSIToFP(i, number), slots[f.slot]);
+                emit(f.body);
+                b.CreateStore(b.CreateAdd(b.CreateLoad(b.getInt32Ty(), counter), b.getInt32(1)), counter);
+                b.CreateBr(test);
+                b.SetInsertPoint(done);
+            } else {
+                b.CreateStore(emit(*std::get<ReturnStmt>(stmt.value).value), result);
+            }
+        }
+
+        llvm::Value* emit(const Expr& expr) {
+            if (std::holds_alternative<NumberExpr>(expr.value)) {
+                return llvm::ConstantFP::get(number, std::get<NumberExpr>(expr.value).value);
+            }
+            if (std::holds_alternative<IdentExpr>(expr.value)) {
+                return b.CreateLoad(number, slots[std::get<IdentExpr>(expr.value).slot]);
+            }
+            if (std::holds_alternative<BinaryExpr>(expr.value)) {
+                const auto& bin = std::get<BinaryExpr>(expr.value);
+                auto* l = emit(*bin.left);
+                auto* r = emit(*bin.right);
+                switch (bin.op) {
+                    case TokenType::PLUS: return b.CreateFAdd(l, r);
+                    case TokenType::MINUS: return b.CreateFSub(l, r);
+                    case TokenType::MUL: return b.CreateFMul(l, r);
+                    case TokenType::DIV: return b.CreateFDiv(l, r);
+                    default: return b.CreateUIToFP(b.CreateFCmpOGT(l, r), number);
+                }
+            }
+            // The callee's return is the caller's latest too, since both
+            // write the interpreter's one return value
+            const auto& c = std::get<CallExpr>(expr.value);
+            std::vector<llvm::Value*> args;
+            for (const Expr* a : c.args) args.push_back(emit(*a));
+            auto* value = b.CreateCall(function, args);
+            b.CreateStore(value, result);
+            return value;
+        }
+
+        // In the entry block, where the optimizer promotes it to a register
+        llvm::AllocaInst* local(llvm::Type* type) {
+            auto& entry = function->getEntryBlock();
+            return llvm::IRBuilder<>(&entry, entry.begin()).CreateAlloca(type);
+        }
+
+        // static_cast<int>, saturating where C++ leaves it undefined
+        llvm::Value* to_int(llvm::Value* value) {
+            return b.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {b.getInt32Ty(), number}, {value});
+        }
+    };
+};
+
+} // namespace ouro
@@ -0,0 +1,393 @@
+#pragma once
+#include "ast.h"
+#include "scheduler.h"
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ouro {
+
+namespace detail {
+
+// Four doubles: one AVX register, two SSE2 ones, or a plain array. Sums keep
+// four partials on every target, so they come out the same whichever one
+// the build picked.
+#if defined(__AVX__)
+struct Vec4 {
+    __m256d v;
+    static Vec4 load(const double* p) { return {_mm256_loadu_pd(p)}; }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+    friend Vec4 operator+(Vec4 a, Vec4 b) { return {_mm256_add_pd(a.v, b.v)}; }
+    friend Vec4 operator-(Vec4 a, Vec4 b) { return {_mm256_sub_pd(a.v, b.v)}; }
+    friend Vec4 operator*(Vec4 a, Vec4 b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    friend Vec4 operator/(Vec4 a, Vec4 b) { return {_mm256_div_pd(a.v, b.v)}; }
+    friend Vec4 greater(Vec4 a, Vec4 b) {
+        return {_mm256_and_pd(_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ), _mm256_set1_pd(1.0))};
+    }
+};
+#elif defined(__SSE2__)
+struct Vec4 {
+    __m128d lo, hi;
+    static Vec4 load(const double* p) { return {_mm_loadu_pd(p), _mm_loadu_pd(p + 2)}; }
+    void store(double* p) const {
+        _mm_storeu_pd(p, lo);
+        _mm_storeu_pd(p + 2, hi);
+    }
+    friend Vec4 operator+(Vec4 a, Vec4 b) { return {_mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi)}; }
+    friend Vec4 operator-(Vec4 a, Vec4 b) { return {_mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi)}; }
+    friend Vec4 operator*(Vec4 a, Vec4 b) { return {_mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi)}; }
+    friend Vec4 operator/(Vec4 a, Vec4 b) { return {_mm_div_pd(a.lo, b.lo), _mm_div_pd(a.hi, b.hi)}; }
+    friend Vec4 greater(Vec4 a, Vec4 b) {
+        const __m128d one = _mm_set1_pd(1.0);
+        return {_mm_and_pd(_mm_cmpgt_pd(a.lo, b.lo), one), _mm_and_pd(_mm_cmpgt_pd(a.hi, b.hi), one)};
+    }
+};
+#else
+struct Vec4 {
+    double d[4];
+    static Vec4 load(const double* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    void store(double* p) const { std::copy(d, d + 4, p); }
+    template <typename F>
+    static Vec4 each(Vec4 a, Vec4 b, F f) { return {{f(a.d[0], b.d[0]), f(a.d[1], b.d[1]), f(a.d[2], b.d[2]), f(a.d[3], b.d[3])}}; }
+    friend Vec4 operator+(Vec4 a, Vec4 b) { return each(a, b, [](double l, double r) { return l + r; }); }
+    friend Vec4 operator-(Vec4 a, Vec4 b) { return each(a, b, [](double l, double r) { return l - r; }); }
+    friend Vec4 operator*(Vec4 a, Vec4 b) { return each(a, b, [](double l, double r) { return l * r; }); }
+    friend Vec4 operator/(Vec4 a, Vec4 b) { return each(a, b, [](double l, double r) { return l / r; }); }
+    friend Vec4 greater(Vec4 a, Vec4 b) { return each(a, b, [](double l, double r) { return l > r ? 1.0 : 0.0; }); }
+};
+#endif
+
+} // namespace detail
+
+// Runs a `gpu fn` on the CPU. Each `for` range is cut into CHUNK-iteration
+// pieces that the calling thread and the pool's workers share, and a piece
+// runs its loop body BLOCK iterations at a time: every operation in the
+// body is applied to a whole block with SIMD before the next one starts.
+//
+// Bodies qualify if they only compute with numbers: `let`, `return` and
+// `for` loops of `let`s, over arithmetic on numbers and the function's own
+// parameters and locals. Inside a loop, each `let` must either only read
+// what the same iteration set, or be a sum `let s = s + ...` that nothing
+// else in the loop reads. Such a loop has no other dependence between
+// iterations, so the iterations can run in any order.
+//
+// Every operation rounds as the interpreter's would. Sums are added in
+// another order: four partial sums per piece, pieces in order. That order
+// depends on CHUNK alone, so a result does not change with the thread count.
+class Kernel {
+public:
+    static constexpr std::size_t BLOCK = 256;        // Iterations per vector operation
+    static constexpr std::size_t CHUNK = 64 * BLOCK; // Iterations per piece of work
+
+    // nullopt if the body uses anything outside what the backend handles,
+    // in which case the interpreter runs it as it would any function
+    static std::optional<Kernel> compile(const FnDeclStmt& fn) {
+        Kernel k;
+        k.frame_size = fn.frame_size;
+        k.params = fn.params.size();
+        for (const Stmt* s : fn.body) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                const auto& v = std::get<VarDeclStmt>(s->value);
+                if (!numeric(*v.value)) return std::nullopt;
+                k.steps.push_back(Assign{v.slot, v.value});
+            } else if (std::holds_alternative<ReturnStmt>(s->value)) {
+                const auto& r = std::get<ReturnStmt>(s->value);
+                if (r.value && !numeric(*r.value)) return std::nullopt;
+                k.steps.push_back(Return{r.value});
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                auto loop = compile_loop(std::get<ForStmt>(s->value));
+                if (!loop) return std::nullopt;
+                k.steps.push_back(std::move(*loop));
+            } else {
+                return std::nullopt;
+            }
+        }
+        return k;
+    }
+
+    // Runs the body on `args` and returns the value of the last `return` it
+    // ran. Loops use up to `helpers` of `pool`'s workers besides the caller.
+    std::optional<double> run(std::span<const double> args, ThreadPool* pool, unsigned helpers) const {
+        Frame f{std::vector<double>(frame_size), std::vector<char>(frame_size)};
+        for (std::size_t i = 0; i < args.size() && i < params; ++i) f.set(static_cast<int>(i), args[i]);
+        std::optional<double> result;
+        for (const Step& step : steps) {
+            if (std::holds_alternative<Assign>(step)) {
+                const auto& a = std::get<Assign>(step);
+                f.set(a.slot, evaluate(*a.value, f));
+            } else if (std::holds_alternative<Return>(step)) {
+                const auto& r = std::get<Return>(step);
+                result = r.value ? std::optional<double>(evaluate(*r.value, f)) : std::nullopt;
+            } else {
+                run_loop(std::get<Loop>(step), f, pool, helpers);
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Frame {
+        std::vector<double> values;
+        std::vector<char> defined;
+        void set(int slot, double value) {
+            values[slot] = value;
+            defined[slot] = 1;
+        }
+    };
+
+    // The loop body, as operations on registers of BLOCK doubles
+    struct Op {
+        TokenType op;
+        int out, left, right;
+    };
+    struct Input {        // A part of the body that is the same in every iteration,
+        const Expr* value; // evaluated once and copied across its register
+        int reg;
+    };
+    struct Sum {
+        const IdentExpr* total; // The `s` of `let s = s + ...`
+        int reg;                // What each iteration adds
+    };
+    struct Loop {
+        const ForStmt* stmt = nullptr;
+        int counter = 0; // Register holding the loop variable
+        int registers = 1;
+        std::vector<Input> inputs;
+        std::vector<Op> ops;
+        std::vector<Sum> sums;
+        std::vector<std::pair<int, int>> locals; // Slot and register; they keep the last iteration's value
+    };
+    struct Assign {
+        int slot;
+        const Expr* value;
+    };
+    struct Return {
+        const Expr* value;
+    };
+    using Step = std::variant<Assign, Return, Loop>;
+
+    std::vector<Step> steps;
+    std::size_t frame_size = 0;
+    std::size_t params = 0;
+
+    static bool numeric(const Expr& expr) {
+        if (std::holds_alternative<NumberExpr>(expr.value)) return true;
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            const auto& id = std::get<IdentExpr>(expr.value);
+            // Globals and captures may change under a running kernel; a read
+            // that may fall back to one is no different
+            return id.depth == 0 && id.slot >= 0 && !id.shadowed;
+        }
+        if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            switch (b.op) {
+                case TokenType::PLUS:
+                case TokenType::MINUS:
+                case TokenType::MUL:
+                case TokenType::DIV:
+                case TokenType::GT: return numeric(*b.left) && numeric(*b.right);
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    template <typename F>
+    static void for_each_read(const Expr& expr, F f) {
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            f(std::get<IdentExpr>(expr.value));
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            for_each_read(*b.left, f);
+            for_each_read(*b.right, f);
+        }
+    }
+
+    static std::optional<Loop> compile_loop(const ForStmt& f) {
+        if (!numeric(*f.start) || !numeric(*f.end)) return std::nullopt;
+        std::map<int, int> sets, reads; // How many `let`s in the body set a slot, and how many reads of it
+        for (const Stmt* s : f.body) {
+            if (!std::holds_alternative<VarDeclStmt>(s->value)) return std::nullopt;
+            const auto& v = std::get<VarDeclStmt>(s->value);
+            if (!numeric(*v.value) || v.slot == f.slot) return std::nullopt;
+            ++sets[v.slot];
+            for_each_read(*v.value, [&](const IdentExpr& id) { ++reads[id.slot]; });
+        }
+
+        Loop loop;
+        loop.stmt = &f;
+        std::map<int, int> local; // Slots this iteration has set so far, and their registers
+        for (const Stmt* s : f.body) {
+            const auto& v = std::get<VarDeclStmt>(s->value);
+            const Expr* value = v.value;
+            const Expr* addend = value;
+            const IdentExpr* total = sum_of(v, addend);
+            if (total && sets[v.slot] == 1 && reads[v.slot] == 1) value = addend;
+            else total = nullptr;
+            // Anything else the body sets must have been set earlier in the iteration
+            bool carried = false;
+            for_each_read(*value, [&](const IdentExpr& id) {
+                if (id.slot != f.slot && sets.contains(id.slot) && !local.contains(id.slot)) carried = true;
+            });
+            if (carried) return std::nullopt;
+            int reg = lanes(loop, local, *value);
+            if (total) loop.sums.push_back({total, reg});
+            else local[v.slot] = reg;
+        }
+        loop.locals.assign(local.begin(), local.end());
+        return loop;
+    }
+
+    // For `let s = s + e` or `let s = e + s`, the read of `s`; `value` is
+    // narrowed to `e`
+    static const IdentExpr* sum_of(const VarDeclStmt& v, const Expr*& value) {
+        if (!std::holds_alternative<BinaryExpr>(value->value)) return nullptr;
+        const auto& b = std::get<BinaryExpr>(value->value);
+        if (b.op != TokenType::PLUS) return nullptr;
+        auto is_total = [&](const Expr* e) {
+            return std::holds_alternative<IdentExpr>(e->value) && std::get<IdentExpr>(e->value).slot == v.slot;
+        };
+        if (is_total(b.left)) {
+            value = b.right;
+            return &std::get<IdentExpr>(b.left->value);
+        }
+        if (is_total(b.right)) {
+            value = b.left;
+            return &std::get<IdentExpr>(b.right->value);
+        }
+        return nullptr;
+    }
+
+    static bool varies(const Loop& loop, const std::map<int, int>& local, const Expr& expr) {
+        bool found = false;
+        for_each_read(expr, [&](const IdentExpr& id) {
+            if (id.slot == loop.stmt->slot || local.contains(id.slot)) found = true;
+        });
+        return found;
+    }
+
+    // Emits the operations for `expr` and returns the register its value ends up in
+    static int lanes(Loop& loop, const std::map<int, int>& local, const Expr& expr) {
+        if (!varies(loop, local, expr)) {
+            loop.inputs.push_back({&expr, loop.registers});
+            return loop.registers++;
+        }
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            const auto& id = std::get<IdentExpr>(expr.value);
+            return id.slot == loop.stmt->slot ? loop.counter : local.at(id.slot);
+        }
+        const auto& b = std::get<BinaryExpr>(expr.value);
+        int left = lanes(loop, local, *b.left);
+        int right = lanes(loop, local, *b.right);
+        loop.ops.push_back({b.op, loop.registers, left, right});
+        return loop.registers++;
+    }
+
+    static double evaluate(const Expr& expr, const Frame& f) {
+        if (std::holds_alternative<NumberExpr>(expr.value)) return std::get<NumberExpr>(expr.value).value;
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            const auto& id = std::get<IdentExpr>(expr.value);
+            if (!f.defined[id.slot]) throw std::runtime_error("Undefined variable: " + std::string(id.name));
+            return f.values[id.slot];
+        }
+        const auto& b = std::get<BinaryExpr>(expr.value);
+        double l = evaluate(*b.left, f);
+        double r = evaluate(*b.right, f);
+        switch (b.op) {
+            case TokenType::PLUS: return l + r;
+            case TokenType::MINUS: return l - r;
+            case TokenType::MUL: return l * r;
+            case TokenType::DIV: return l / r;
+            default: return l > r ? 1.0 : 0.0;
+        }
+    }
+
+    static void apply(TokenType op, const double* a, const double* b, double* out) {
+        using detail::Vec4;
+        auto each = [&](auto f) {
+            for (std::size_t k = 0; k < BLOCK; k += 4) f(Vec4::load(a + k), Vec4::load(b + k)).store(out + k);
+        };
+        switch (op) {
+            case TokenType::PLUS: each([](Vec4 l, Vec4 r) { return l + r; }); break;
+            case TokenType::MINUS: each([](Vec4 l, Vec4 r) { return l - r; }); break;
+            case TokenType::MUL: each([](Vec4 l, Vec4 r) { return l * r; }); break;
+            case TokenType::DIV: each([](Vec4 l, Vec4 r) { return l / r; }); break;
+            default: each([](Vec4 l, Vec4 r) { return greater(l, r); }); break;
+        }
+    }
+
+    // Adds the first `count` values into four partial sums, value k into partial k % 4
+    static void accumulate(const double* values, std::size_t count, double* partial) {
+        using detail::Vec4;
+        Vec4 acc = Vec4::load(partial);
+        std::size_t k = 0;
+        for (; k + 4 <= count; k += 4) acc = acc + Vec4::load(values + k);
+        acc.store(partial);
+        for (; k < count; ++k) partial[k % 4] += values[k];
+    }
+
+    void run_loop(const Loop& loop, Frame& f, ThreadPool* pool, unsigned helpers) const {
+        const ForStmt& stmt = *loop.stmt;
+        int start = static_cast<int>(evaluate(*stmt.start, f));
+        int end = static_cast<int>(evaluate(*stmt.end, f));
+        if (start >= end) return;
+        for (const Sum& s : loop.sums) {
+            if (!f.defined[s.total->slot]) throw std::runtime_error("Undefined variable: " + std::string(s.total->name));
+        }
+        std::vector<double> inputs;
+        for (const Input& in : loop.inputs) inputs.push_back(evaluate(*in.value, f));
+
+        auto n = static_cast<std::size_t>(static_cast<long long>(end) - start);
+        std::size_t pieces = (n + CHUNK - 1) / CHUNK;
+        std::vector<double> sums(pieces * loop.sums.size());
+        std::vector<double> last(loop.locals.size());
+        auto piece = [&](std::size_t p) {
+            std::vector<double> regs(static_cast<std::size_t>(loop.registers) * BLOCK);
+            auto reg = [&](int r) { return regs.data() + static_cast<std::size_t>(r) * BLOCK; };
+            for (std::size_t i = 0; i < inputs.size(); ++i) std::fill_n(reg(loop.inputs[i].reg), BLOCK, inputs[i]);
+            std::vector<double> partial(loop.sums.size() * 4);
+            std::size_t first = p * CHUNK, stop = std::min(n, first + CHUNK);
+            for (std::size_t b = first; b < stop; b += BLOCK) {
+                std::size_t count = std::min(BLOCK, stop - b);
+                double* counter = reg(loop.counter);
+                for (std::size_t k = 0; k < BLOCK; ++k) counter[k] = static_cast<double>(start + static_cast<long long>(b + k));
+                for (const Op& op : loop.ops) apply(op.op, reg(op.left), reg(op.right), reg(op.out));
+                for (std::size_t s = 0; s < loop.sums.size(); ++s) accumulate(reg(loop.sums[s].reg), count, &partial[s * 4]);
+                if (b + count == n) {
+                    for (std::size_t l = 0; l < loop.locals.size(); ++l) last[l] = reg(loop.locals[l].second)[count - 1];
+                }
+            }
+            for (std::size_t s = 0; s < loop.sums.size(); ++s) {
+                const double* q = &partial[s * 4];
+                sums[p * loop.sums.size() + s] = (q[0] + q[1]) + (q[2] + q[3]);
+            }
+        };
+        if (pool && helpers > 0 && pieces > 1) {
+            pool->parallel(pieces, helpers, piece);
+        } else {
+            for (std::size_t p = 0; p < pieces; ++p) piece(p);
+        }
+
+        for (std::size_t s = 0; s < loop.sums.size(); ++s) {
+            int slot = loop.sums[s].total->slot;
+            double total = f.values[slot];
+            for (std::size_t p = 0; p < pieces; ++p) total += sums[p * loop.sums.size() + s];
+            f.set(slot, total);
+        }
+        for (std::size_t l = 0; l < loop.locals.size(); ++l) f.set(loop.locals[l].first, last[l]);
+        f.set(stmt.slot, end - 1);
+    }
+};
+
+} // namespace ouro
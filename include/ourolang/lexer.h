@@ -1,36 +1,109 @@
 #pragma once
 #include "token.h"
 #include "arena.h"
+#include "scan.h"
+#include <array>
 #include <string>
+#include <string_view>
 #include <memory_resource>
 #include <vector>
-#include <cctype>
 #include <stdexcept>
 
 namespace ouro {
 
+namespace detail {
+
+enum : unsigned char { DIGIT = 2, IDENT_START = 4 };
+
+// What a token's first byte can start: the C locale's isdigit/isalpha, plus '_'
+// as a letter. The runs themselves are scanned by scan.h.
+inline constexpr std::array<unsigned char, 256> char_classes = [] {
+    std::array<unsigned char, 256> classes{};
+    for (int c = '0'; c <= '9'; ++c) classes[c] = DIGIT;
+    for (int c = 'a'; c <= 'z'; ++c) classes[c] = IDENT_START;
+    for (int c = 'A'; c <= 'Z'; ++c) classes[c] = IDENT_START;
+    classes['_'] = IDENT_START;
+    return classes;
+}();
+inline unsigned char char_class(char c) { return char_classes[static_cast<unsigned char>(c)]; }
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+// Perfect hash over the keywords: every keyword lands in its own slot, so an
+// identifier costs one hash and at most one comparison
+constexpr std::size_t keyword_slot(std::string_view word) {
+    return (word.size() + 3u * static_cast<unsigned char>(word.front()) + 3u * static_cast<unsigned char>(word.back())) & 31;
+}
+inline constexpr std::array<Keyword, 32> keywords = [] {
+    std::array<Keyword, 32> table{};
+    for (const Keyword& k : {Keyword{"let", TokenType::LET}, Keyword{"fn", TokenType::FN},
+                             Keyword{"if", TokenType::IF}, Keyword{"else", TokenType::ELSE},
+                             Keyword{"return", TokenType::RETURN}, Keyword{"for", TokenType::FOR},
+                             Keyword{"in", TokenType::IN}, Keyword{"async", TokenType::ASYNC},
+                             Keyword{"await", TokenType::AWAIT}, Keyword{"gpu", TokenType::GPU},
+                             Keyword{"int", TokenType::INT}, Keyword{"float", TokenType::FLOAT},
+                             Keyword{"string", TokenType::STRING}, Keyword{"parallel", TokenType::PARALLEL}}) {
+        table[keyword_slot(k.text)] = k;
+    }
+    return table;
+}();
+static_assert([] {
+    std::size_t filled = 0;
+    for (const Keyword& k : keywords) filled += !k.text.empty();
+    return filled == 14;
+}(), "keyword hash has a collision");
+
+} // namespace detail
+
+// Tokens are views of the source text. The usual constructor copies the
+// source into `mem` and the tokens view that copy, so they are valid while
+// the lexer lives. Lexer::borrowing skips the copy and lexes the caller's
+// buffer in place; its tokens are valid while that buffer is. Its tokens
+// can also be numbered from a line other than 1, for text cut from the
+// middle of a document.
+//
+// Whitespace, `//` comments and the bodies of identifiers, numbers and
+// strings are scanned with the vectorized routines in scan.h.
 class Lexer {
-    std::string source;
+    std::pmr::string storage; // Copy of the source, empty when borrowing
+    std::string_view source;
     size_t pos = 0;
     int line = 1;
     std::pmr::memory_resource* mem;
 
+    struct Borrow {};
+    Lexer(std::string_view buffer, std::pmr::memory_resource* r, int first_line, Borrow)
+        : storage(r), source(buffer), line(first_line), mem(r) {}
+
 public:
     explicit Lexer(const std::string& src, std::pmr::memory_resource* r = std::pmr::get_default_resource())
-        : source(src), mem(r) {}
+        : storage(src, r), source(storage), mem(r) {}
+
+    static Lexer borrowing(std::string_view buffer, std::pmr::memory_resource* r = std::pmr::get_default_resource(),
+                           int first_line = 1) {
+        return Lexer(buffer, r, first_line, Borrow{});
+    }
+
+    // `source` may point into `storage`, so a lexer stays where it was built
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
 
-    std::vector<Token> tokenize() {
+    std::pmr::vector<Token> tokenize() {
         std::pmr::vector<Token> tokens(mem);
-        while (pos < source.size()) {
+        tokens.reserve(source.size() / 4 + 1); // Typical code runs 4-6 bytes per token
+        for (;;) {
+            OuroScanLines lines = {0, 0};
+            pos = ouro_skip_space_and_comments(source.data(), pos, source.size(), &lines, 0);
+            line += static_cast<int>(lines.count);
+            if (pos >= source.size()) break;
             char c = source[pos];
-            if (std::isspace(static_cast<unsigned char>(c))) {
-                if (c == '\n') line++;
-                pos++;
-                continue;
-            }
-            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            unsigned char cls = detail::char_class(c);
+            if (cls & detail::IDENT_START) {
                 tokens.push_back(parse_identifier());
-            } else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            } else if ((cls & detail::DIGIT) || (c == '.' && pos + 1 < source.size() && (detail::char_class(source[pos + 1]) & detail::DIGIT))) {
                 tokens.push_back(parse_number());
             } else if (c == '"') {
                 tokens.push_back(parse_string());
@@ -38,77 +111,65 @@ public:
                 tokens.push_back(parse_symbol());
             }
         }
-        tokens.push_back({TokenType::EOF_TOKEN, "", line});
-        return std::vector<Token>(tokens.begin(), tokens.end());
+        tokens.push_back({TokenType::EOF_TOKEN, {}, line});
+        return tokens;
     }
 
 private:
     Token parse_identifier() {
-        std::string value;
-        while (pos < source.size() && (std::isalnum(static_cast<unsigned char>(source[pos])) || source[pos] == '_')) {
-            value += source[pos++];
-        }
-        if (value == "let") return {TokenType::LET, value, line};
-        if (value == "fn") return {TokenType::FN, value, line};
-        if (value == "if") return {TokenType::IF, value, line};
-        if (value == "else") return {TokenType::ELSE, value, line};
-        if (value == "return") return {TokenType::RETURN, value, line};
-        if (value == "for") return {TokenType::FOR, value, line};
-        if (value == "in") return {TokenType::IN, value, line};
-        if (value == "async") return {TokenType::ASYNC, value, line};
-        if (value == "await") return {TokenType::AWAIT, value, line};
-        if (value == "gpu") return {TokenType::GPU, value, line};
-        if (value == "int") return {TokenType::INT, value, line};
-        if (value == "float") return {TokenType::FLOAT, value, line};
-        if (value == "string") return {TokenType::STRING, value, line};
+        size_t start = pos;
+        pos = ouro_scan_ident(source.data(), pos, source.size());
+        std::string_view value = source.substr(start, pos - start);
+        const detail::Keyword& k = detail::keywords[detail::keyword_slot(value)];
+        if (k.text == value) return {k.type, value, line};
         return {TokenType::IDENTIFIER, value, line};
     }
 
+    // Digits with at most one '.', which must not start a `..` range
     Token parse_number() {
-        std::string value;
-        bool has_dot = false;
-        while (pos < source.size() && (std::isdigit(static_cast<unsigned char>(source[pos])) || source[pos] == '.')) {
-            if (source[pos] == '.') has_dot = true;
-            value += source[pos++];
+        size_t start = pos;
+        pos = ouro_scan_digits(source.data(), pos, source.size());
+        if (pos < source.size() && source[pos] == '.' && !(pos + 1 < source.size() && source[pos + 1] == '.')) {
+            pos = ouro_scan_digits(source.data(), pos + 1, source.size());
         }
-        return {TokenType::NUMBER, value, line};
+        return {TokenType::NUMBER, source.substr(start, pos - start), line};
     }
 
     Token parse_string() {
-        std::string value;
-        pos++; // Skip opening quote
-        while (pos < source.size() && source[pos] != '"') {
-            value += source[pos++];
-        }
+        size_t start = ++pos; // Skip opening quote
+        pos = ouro_find_byte(source.data(), pos, source.size(), '"');
+        std::string_view value = source.substr(start, pos - start);
         pos++; // Skip closing quote
         return {TokenType::STRING_LITERAL, value, line};
     }
 
     Token parse_symbol() {
+        size_t start = pos;
         char c = source[pos++];
+        auto token = [&](TokenType type) { return Token{type, source.substr(start, pos - start), line}; };
         switch (c) {
-            case ':': return {TokenType::COLON, ":", line};
-            case '=': return {TokenType::EQUALS, "=", line};
-            case '(': return {TokenType::LPAREN, "(", line};
-            case ')': return {TokenType::RPAREN, ")", line};
-            case '{': return {TokenType::LBRACE, "{", line};
-            case '}': return {TokenType::RBRACE, "}", line};
-            case ';': return {TokenType::SEMICOLON, ";", line};
-            case ',': return {TokenType::COMMA, ",", line};
-            case '+': return {TokenType::PLUS, "+", line};
+            case ':': return token(TokenType::COLON);
+            case '=': return token(TokenType::EQUALS);
+            case '(': return token(TokenType::LPAREN);
+            case ')': return token(TokenType::RPAREN);
+            case '{': return token(TokenType::LBRACE);
+            case '}': return token(TokenType::RBRACE);
+            case ';': return token(TokenType::SEMICOLON);
+            case ',': return token(TokenType::COMMA);
+            case '+': return token(TokenType::PLUS);
             case '-':
                 if (pos < source.size() && source[pos] == '>') {
                     pos++;
-                    return {TokenType::ARROW, "->", line};
+                    return token(TokenType::ARROW);
                 }
-                return {TokenType::MINUS, "-", line};
-            case '*': return {TokenType::MUL, "*", line};
-            case '/': return {TokenType::DIV, "/", line};
-            case '>': return {TokenType::GT, ">", line};
+                return token(TokenType::MINUS);
+            case '*': return token(TokenType::MUL);
+            case '/': return token(TokenType::DIV);
+            case '>': return token(TokenType::GT);
             case '.':
                 if (pos < source.size() && source[pos] == '.') {
                     pos++;
-                    return {TokenType::DOTDOT, "..", line};
+                    return token(TokenType::DOTDOT);
                 }
                 break;
         }
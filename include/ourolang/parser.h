@@ -1,31 +1,64 @@
 #pragma once
 #include "lexer.h"
 #include "ast.h"
+#include <cstring>
+#include <span>
 #include <vector>
 
 namespace ouro {
 
+// Builds the AST in `mem`, which must outlive it: nodes, lists and copies of
+// the token text are all allocated there and never freed individually. The
+// tokens, which end with EOF_TOKEN, only need to last until parsing is done.
 class Parser {
-    std::vector<Token> tokens;
+    std::span<const Token> tokens;
     size_t pos = 0;
+    std::pmr::memory_resource* mem;
 
 public:
-    explicit Parser(const std::vector<Token>& t) : tokens(t) {}
+    Parser(std::span<const Token> t, std::pmr::memory_resource* m) : tokens(t), mem(m) {}
 
-    std::vector<StmtPtr> parse() {
-        std::vector<StmtPtr> stmts;
-        while (tokens[pos].type != TokenType::EOF_TOKEN) {
+    StmtList parse() {
+        StmtList stmts(mem);
+        while (!at_end()) {
             stmts.push_back(parse_stmt());
         }
         return stmts;
     }
 
+    // One top-level statement at a time, for Session. After a parse error,
+    // at_end() tells whether the input stopped short rather than going wrong.
+    StmtPtr parse_statement() { return parse_stmt(); }
+    bool at_end() const { return peek().type == TokenType::EOF_TOKEN; }
+    size_t position() const { return pos; } // Index of the next token
+
 private:
-    Token peek() { return tokens[pos]; }
-    Token advance() { return tokens[pos++]; }
-    Token consume(TokenType type, const std::string& msg) {
+    const Token& peek() const { return tokens[pos]; }
+    const Token& advance() { return tokens[pos++]; }
+    const Token& consume(TokenType type, const char* msg) { // Not a std::string: the message is built only on error
         if (peek().type == type) return advance();
-        throw std::runtime_error(msg + " at line " + std::to_string(peek().line));
+        throw std::runtime_error(std::string(msg) + " at line " + std::to_string(peek().line));
+    }
+    // Copies a token's text into `mem`, where the AST's names point
+    std::string_view text(const Token& token) {
+        if (token.value.empty()) return {};
+        auto* chars = static_cast<char*>(mem->allocate(token.value.size(), 1));
+        std::memcpy(chars, token.value.data(), token.value.size());
+        return {chars, token.value.size()};
+    }
+    template <typename Node, typename T>
+    Node* make(T&& value) {
+        return std::pmr::polymorphic_allocator<>(mem).new_object<Node>(std::forward<T>(value));
+    }
+
+    // A type name: one of the built-in type keywords or an identifier
+    std::string_view parse_type(const char* msg) {
+        switch (peek().type) {
+            case TokenType::INT:
+            case TokenType::FLOAT:
+            case TokenType::STRING: return text(advance());
+            default: return text(consume(TokenType::IDENTIFIER, msg));
+        }
     }
 
     StmtPtr parse_stmt() {
@@ -34,23 +67,23 @@ private:
             return parse_fn_decl();
         }
         if (peek().type == TokenType::IF) return parse_if_stmt();
-        if (peek().type == TokenType::FOR) return parse_for_stmt();
+        if (peek().type == TokenType::FOR || peek().type == TokenType::PARALLEL) return parse_for_stmt();
         if (peek().type == TokenType::RETURN) return parse_return_stmt();
         throw std::runtime_error("Unexpected token at line " + std::to_string(peek().line));
     }
 
     StmtPtr parse_var_decl() {
         consume(TokenType::LET, "Expected 'let'");
-        auto name = consume(TokenType::IDENTIFIER, "Expected identifier").value;
-        std::string type;
+        auto name = text(consume(TokenType::IDENTIFIER, "Expected identifier"));
+        std::string_view type;
         if (peek().type == TokenType::COLON) {
             consume(TokenType::COLON, "Expected ':'");
-            type = consume(TokenType::IDENTIFIER, "Expected type").value;
+            type = parse_type("Expected type");
         }
         consume(TokenType::EQUALS, "Expected '='");
         auto value = parse_expr();
         consume(TokenType::SEMICOLON, "Expected ';'");
-        return std::make_unique<Stmt>(VarDeclStmt{name, type, std::move(value)});
+        return make<Stmt>(VarDeclStmt{name, type, value});
     }
 
     StmtPtr parse_fn_decl() {
@@ -58,44 +91,45 @@ private:
         if (peek().type == TokenType::ASYNC) { consume(TokenType::ASYNC, ""); is_async = true; }
         else if (peek().type == TokenType::GPU) { consume(TokenType::GPU, ""); is_gpu = true; }
         consume(TokenType::FN, "Expected 'fn'");
-        auto name = consume(TokenType::IDENTIFIER, "Expected identifier").value;
+        auto name = text(consume(TokenType::IDENTIFIER, "Expected identifier"));
         consume(TokenType::LPAREN, "Expected '('");
-        std::vector<std::pair<std::string, std::string>> params;
+        std::pmr::vector<std::pair<std::string_view, std::string_view>> params(mem);
         if (peek().type != TokenType::RPAREN) {
             do {
-                auto param_name = consume(TokenType::IDENTIFIER, "Expected param name").value;
+                auto param_name = text(consume(TokenType::IDENTIFIER, "Expected param name"));
                 consume(TokenType::COLON, "Expected ':'");
-                auto param_type = consume(TokenType::IDENTIFIER, "Expected param type").value;
+                auto param_type = parse_type("Expected param type");
                 params.push_back({param_name, param_type});
                 if (peek().type == TokenType::COMMA) consume(TokenType::COMMA, "");
             } while (peek().type != TokenType::RPAREN);
         }
         consume(TokenType::RPAREN, "Expected ')'");
-        std::string return_type;
+        std::string_view return_type;
         if (peek().type == TokenType::ARROW) {
             consume(TokenType::ARROW, "Expected '->'");
-            return_type = consume(TokenType::IDENTIFIER, "Expected return type").value;
+            return_type = parse_type("Expected return type");
         }
         consume(TokenType::LBRACE, "Expected '{'");
-        std::vector<StmtPtr> body;
+        StmtList body(mem);
         while (peek().type != TokenType::RBRACE) {
             body.push_back(parse_stmt());
         }
         consume(TokenType::RBRACE, "Expected '}'");
-        auto fn = FnDeclStmt{name, params, return_type, std::move(body), is_async, is_gpu, false, {}};
-        return std::make_unique<Stmt>(std::move(fn));
+        auto fn = FnDeclStmt{name, std::move(params), return_type, std::move(body), is_async, is_gpu, false,
+                             std::pmr::vector<std::string_view>(mem)};
+        return make<Stmt>(std::move(fn));
     }
 
     StmtPtr parse_if_stmt() {
         consume(TokenType::IF, "Expected 'if'");
         auto condition = parse_expr();
         consume(TokenType::LBRACE, "Expected '{'");
-        std::vector<StmtPtr> then_branch;
+        StmtList then_branch(mem);
         while (peek().type != TokenType::RBRACE && peek().type != TokenType::ELSE) {
             then_branch.push_back(parse_stmt());
         }
         consume(TokenType::RBRACE, "Expected '}'");
-        std::vector<StmtPtr> else_branch;
+        StmtList else_branch(mem);
         if (peek().type == TokenType::ELSE) {
             consume(TokenType::ELSE, "");
             consume(TokenType::LBRACE, "Expected '{'");
@@ -104,33 +138,35 @@ private:
             }
             consume(TokenType::RBRACE, "Expected '}'");
         }
-        return std::make_unique<Stmt>(IfStmt{std::move(condition), std::move(then_branch), std::move(else_branch)});
+        return make<Stmt>(IfStmt{condition, std::move(then_branch), std::move(else_branch)});
     }
 
     StmtPtr parse_for_stmt() {
+        bool parallel = false;
+        if (peek().type == TokenType::PARALLEL) { consume(TokenType::PARALLEL, ""); parallel = true; }
         consume(TokenType::FOR, "Expected 'for'");
-        auto var = consume(TokenType::IDENTIFIER, "Expected loop variable").value;
+        auto var = text(consume(TokenType::IDENTIFIER, "Expected loop variable"));
         consume(TokenType::IN, "Expected 'in'");
         auto start = parse_expr();
         consume(TokenType::DOTDOT, "Expected '..'");
         auto end = parse_expr();
         consume(TokenType::LBRACE, "Expected '{'");
-        std::vector<StmtPtr> body;
+        StmtList body(mem);
         while (peek().type != TokenType::RBRACE) {
             body.push_back(parse_stmt());
         }
         consume(TokenType::RBRACE, "Expected '}'");
-        return std::make_unique<Stmt>(ForStmt{var, std::move(start), std::move(end), std::move(body)});
+        return make<Stmt>(ForStmt{var, start, end, std::move(body), parallel});
     }
 
     StmtPtr parse_return_stmt() {
         consume(TokenType::RETURN, "Expected 'return'");
-        ExprPtr value;
+        ExprPtr value = nullptr;
         if (peek().type != TokenType::SEMICOLON) {
             value = parse_expr();
         }
         consume(TokenType::SEMICOLON, "Expected ';'");
-        return std::make_unique<Stmt>(ReturnStmt{std::move(value)});
+        return make<Stmt>(ReturnStmt{value});
     }
 
     ExprPtr parse_expr() { return parse_binary_expr(0); }
@@ -154,25 +190,29 @@ private:
             if (op_prec <= prec) break;
             advance();
             auto right = parse_binary_expr(op_prec);
-            left = std::make_unique<Expr>(BinaryExpr{op, std::move(left), std::move(right)});
+            left = make<Expr>(BinaryExpr{op, left, right});
         }
         return left;
     }
 
     ExprPtr parse_primary_expr() {
+        if (peek().type == TokenType::AWAIT) {
+            consume(TokenType::AWAIT, "");
+            return make<Expr>(AwaitExpr{parse_primary_expr()}); // Binds tighter than any operator
+        }
         if (peek().type == TokenType::NUMBER) {
-            double val = std::stod(consume(TokenType::NUMBER, "Expected number").value);
-            return std::make_unique<Expr>(NumberExpr{val});
+            double val = std::stod(std::string(consume(TokenType::NUMBER, "Expected number").value));
+            return make<Expr>(NumberExpr{val});
         }
         if (peek().type == TokenType::STRING_LITERAL) {
-            auto val = consume(TokenType::STRING_LITERAL, "Expected string").value;
-            return std::make_unique<Expr>(StringExpr{val});
+            auto val = text(consume(TokenType::STRING_LITERAL, "Expected string"));
+            return make<Expr>(StringExpr{val});
         }
         if (peek().type == TokenType::IDENTIFIER) {
-            auto name = consume(TokenType::IDENTIFIER, "Expected identifier").value;
+            auto name = text(consume(TokenType::IDENTIFIER, "Expected identifier"));
             if (peek().type == TokenType::LPAREN) {
                 consume(TokenType::LPAREN, "Expected '('");
-                std::vector<ExprPtr> args;
+                ExprList args(mem);
                 if (peek().type != TokenType::RPAREN) {
                     do {
                         args.push_back(parse_expr());
@@ -180,9 +220,9 @@ private:
                     } while (peek().type != TokenType::RPAREN);
                 }
                 consume(TokenType::RPAREN, "Expected ')'");
-                return std::make_unique<Expr>(CallExpr{name, std::move(args)});
+                return make<Expr>(CallExpr{name, std::move(args)});
             }
-            return std::make_unique<Expr>(IdentExpr{name});
+            return make<Expr>(IdentExpr{name});
         }
         throw std::runtime_error("Unexpected token in expression at line " + std::to_string(peek().line));
     }
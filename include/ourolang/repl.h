@@ -1,20 +1,55 @@
 #pragma once
 #include "interpreter.h"
+#include "vm.h"
 #include <iostream>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace ouro {
 
+// Engine is Interpreter (walks the AST) or VM (compiles each line to bytecode).
+// A statement can span lines; "... " prompts for the rest of it. When the VM
+// rejects a line it cannot run like the interpreter, the REPL replays the
+// input so far on an Interpreter, quietly, and carries on there.
+template <typename Engine = Interpreter>
 inline void repl() {
-    Interpreter interp;
+    Engine interp;
+    std::optional<Interpreter> fallback;
+    std::vector<std::string> input; // Every line so far, to replay on the fallback
     std::string line;
+    bool complete = true;
     std::cout << "OuroLang REPL (type 'exit' to quit)\n";
     while (true) {
-        std::cout << "> ";
-        std::getline(std::cin, line);
+        std::cout << (complete ? "> " : "... ");
+        if (!std::getline(std::cin, line)) break;
         if (line == "exit") break;
         try {
-            interp.run(line);
+            if (fallback) {
+                complete = fallback->feed(line);
+                continue;
+            }
+            if constexpr (!std::is_same_v<Engine, Interpreter>) input.push_back(line);
+            try {
+                complete = interp.feed(line); // A rejected line leaves the session as it was
+            } catch (const Unsupported& e) {
+                std::cerr << "Note: " << e.what() << "; switching to it" << std::endl;
+                fallback.emplace();
+                std::ostringstream replayed;
+                auto* saved = std::cout.rdbuf(replayed.rdbuf());
+                for (std::size_t i = 0; i + 1 < input.size(); ++i) {
+                    try {
+                        fallback->feed(input[i]);
+                    } catch (const std::exception&) {
+                        // It failed the first time too
+                    }
+                }
+                std::cout.rdbuf(saved);
+                complete = fallback->feed(line);
+                input.clear();
+            }
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
         }
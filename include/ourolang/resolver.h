@@ -0,0 +1,150 @@
+#pragma once
+#include "ast.h"
+#include <algorithm>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ouro {
+
+// Assigns every variable a slot in the frame of the function (or the global
+// scope) that declares it, so the interpreter indexes a flat vector instead of
+// looking names up. Blocks do not open scopes: like the old environments, a
+// `let` inside an if or for body belongs to the enclosing function, from the
+// function's first statement on.
+//
+// Until its `let` has run, though, the old environments found the name further
+// out. So a read that may come before the declaration (`let t = t + i` in a
+// loop, or a use after an if that declares it) also gets `shadowed`: the
+// variable to read while the local slot is still empty.
+//
+// The global scope persists across resolve() calls, so REPL lines see the
+// globals declared by earlier ones.
+class Resolver {
+    struct Scope {
+        std::map<std::string, int, std::less<>> slots;
+        std::vector<std::string_view> declared; // Names set on every path to the current statement
+    };
+    std::vector<Scope> scopes{1}; // scopes[0] is the global scope
+    std::pmr::memory_resource* mem = nullptr; // The unit's arena, for `shadowed` bindings
+
+public:
+    void resolve(StmtList& stmts) {
+        mem = stmts.get_allocator().resource();
+        for (auto& s : stmts) resolve_stmt(*s);
+    }
+
+    std::size_t global_count() const { return scopes.front().slots.size(); }
+
+private:
+    int declare(std::string_view name) {
+        auto& scope = scopes.back().slots;
+        auto it = scope.find(name);
+        if (it != scope.end()) return it->second; // Redeclaring reuses the slot
+        int slot = static_cast<int>(scope.size());
+        scope.emplace(std::string(name), slot); // Owned: the global scope outlives this unit's AST
+        return slot;
+    }
+
+    // Gives every `let` and loop variable in a function body its slot up front
+    void hoist(const StmtList& stmts) {
+        for (const auto* s : stmts) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                declare(std::get<VarDeclStmt>(s->value).name);
+            } else if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                hoist(i.then_branch);
+                hoist(i.else_branch);
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                const auto& f = std::get<ForStmt>(s->value);
+                declare(f.var);
+                hoist(f.body);
+            }
+        }
+    }
+
+    void resolve_block(StmtList& stmts) {
+        auto& declared = scopes.back().declared;
+        std::size_t mark = declared.size();
+        for (auto& s : stmts) resolve_stmt(*s);
+        declared.resize(mark); // A branch or loop body may not run
+    }
+
+    void resolve_stmt(Stmt& stmt) {
+        if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
+            auto& var = std::get<VarDeclStmt>(stmt.value);
+            resolve_expr(*var.value); // The initializer cannot see the variable itself
+            var.slot = declare(var.name);
+            scopes.back().declared.push_back(var.name);
+        } else if (std::holds_alternative<FnDeclStmt>(stmt.value)) {
+            auto& fn = std::get<FnDeclStmt>(stmt.value);
+            scopes.emplace_back();
+            for (const auto& p : fn.params) {
+                declare(p.first);
+                scopes.back().declared.push_back(p.first);
+            }
+            hoist(fn.body);
+            for (auto& b : fn.body) resolve_stmt(*b);
+            fn.frame_size = scopes.back().slots.size();
+            scopes.pop_back();
+        } else if (std::holds_alternative<IfStmt>(stmt.value)) {
+            auto& i = std::get<IfStmt>(stmt.value);
+            resolve_expr(*i.condition);
+            resolve_block(i.then_branch);
+            resolve_block(i.else_branch);
+        } else if (std::holds_alternative<ForStmt>(stmt.value)) {
+            auto& f = std::get<ForStmt>(stmt.value);
+            resolve_expr(*f.start);
+            resolve_expr(*f.end);
+            f.slot = declare(f.var);
+            auto& declared = scopes.back().declared;
+            std::size_t mark = declared.size();
+            declared.push_back(f.var); // Set before each run of the body
+            resolve_block(f.body);
+            declared.resize(mark);
+        } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
+            auto& r = std::get<ReturnStmt>(stmt.value);
+            if (r.value) resolve_expr(*r.value);
+        }
+    }
+
+    // Binds `id` to the innermost of scopes[0, end) that has the name, and
+    // chains on what to read instead while that slot may still be empty
+    void bind(IdentExpr& id, std::size_t end) {
+        for (std::size_t i = end; i-- > 0;) {
+            const auto& scope = scopes[i];
+            auto it = scope.slots.find(id.name);
+            if (it == scope.slots.end()) continue;
+            id.slot = it->second;
+            id.depth = static_cast<int>(scopes.size() - 1 - i);
+            bool set = i == 0 || std::find(scope.declared.begin(), scope.declared.end(), id.name) != scope.declared.end();
+            if (!set) {
+                auto* outer = std::pmr::polymorphic_allocator<>(mem).new_object<IdentExpr>(IdentExpr{id.name});
+                bind(*outer, i);
+                if (outer->slot >= 0) id.shadowed = outer;
+            }
+            return;
+        }
+        // Left unresolved: reading it is an "Undefined variable" error at runtime
+    }
+
+    void resolve_expr(Expr& expr) {
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            bind(std::get<IdentExpr>(expr.value), scopes.size());
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            auto& b = std::get<BinaryExpr>(expr.value);
+            resolve_expr(*b.left);
+            resolve_expr(*b.right);
+        } else if (std::holds_alternative<CallExpr>(expr.value)) {
+            auto& c = std::get<CallExpr>(expr.value);
+            for (auto& a : c.args) resolve_expr(*a);
+        } else if (std::holds_alternative<AwaitExpr>(expr.value)) {
+            auto& a = std::get<AwaitExpr>(expr.value);
+            resolve_expr(*a.expr);
+        }
+    }
+};
+
+} // namespace ouro
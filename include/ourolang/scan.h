@@ -0,0 +1,204 @@
+#ifndef OURO_SCAN_H
+#define OURO_SCAN_H
+
+/*
+ * Byte-run scanners shared by the C++ lexer (ouro::Lexer) and the C lexer in
+ * ouroboros-lang. Each scanner takes the buffer, a start offset and the
+ * buffer length, and returns the offset where the run ends (len if it runs
+ * to the end). None of them reads at or past len.
+ *
+ * With SSE2 (every x86-64 target) they test 16 bytes per step, or 32 when the
+ * build enables AVX2. Other targets use the scalar loops, which are also
+ * used for each buffer's tail. Plain C99, so both lexers can include it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OURO_SCAN_WIDTH 32
+typedef __m256i ouro_vec;
+static inline ouro_vec ouro_vec_load(const char *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline ouro_vec ouro_vec_splat(char c) { return _mm256_set1_epi8(c); }
+static inline ouro_vec ouro_vec_eq(ouro_vec a, ouro_vec b) { return _mm256_cmpeq_epi8(a, b); }
+static inline ouro_vec ouro_vec_gt(ouro_vec a, ouro_vec b) { return _mm256_cmpgt_epi8(a, b); }
+static inline ouro_vec ouro_vec_or(ouro_vec a, ouro_vec b) { return _mm256_or_si256(a, b); }
+static inline ouro_vec ouro_vec_and(ouro_vec a, ouro_vec b) { return _mm256_and_si256(a, b); }
+static inline uint32_t ouro_vec_mask(ouro_vec v) { return (uint32_t)_mm256_movemask_epi8(v); }
+#define OURO_SCAN_FULL 0xFFFFFFFFu
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define OURO_SCAN_WIDTH 16
+typedef __m128i ouro_vec;
+static inline ouro_vec ouro_vec_load(const char *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline ouro_vec ouro_vec_splat(char c) { return _mm_set1_epi8(c); }
+static inline ouro_vec ouro_vec_eq(ouro_vec a, ouro_vec b) { return _mm_cmpeq_epi8(a, b); }
+static inline ouro_vec ouro_vec_gt(ouro_vec a, ouro_vec b) { return _mm_cmpgt_epi8(a, b); }
+static inline ouro_vec ouro_vec_or(ouro_vec a, ouro_vec b) { return _mm_or_si128(a, b); }
+static inline ouro_vec ouro_vec_and(ouro_vec a, ouro_vec b) { return _mm_and_si128(a, b); }
+static inline uint32_t ouro_vec_mask(ouro_vec v) { return (uint32_t)_mm_movemask_epi8(v); }
+#define OURO_SCAN_FULL 0xFFFFu
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+static inline unsigned ouro_ctz(uint32_t x) { return (unsigned)__builtin_ctz(x); }
+static inline unsigned ouro_highest_bit(uint32_t x) { return 31u - (unsigned)__builtin_clz(x); }
+static inline unsigned ouro_popcount(uint32_t x) { return (unsigned)__builtin_popcount(x); }
+#else
+static inline unsigned ouro_ctz(uint32_t x) { unsigned n = 0; while (!(x & 1u)) { x >>= 1; n++; } return n; }
+static inline unsigned ouro_highest_bit(uint32_t x) { unsigned n = 0; while (x >>= 1) n++; return n; }
+static inline unsigned ouro_popcount(uint32_t x) { unsigned n = 0; while (x) { x &= x - 1; n++; } return n; }
+#endif
+
+/* Newlines passed by a scan, so the caller can keep line and column numbers */
+typedef struct OuroScanLines {
+    size_t count;
+    size_t last; /* Offset of the last one; meaningful when count > 0 */
+} OuroScanLines;
+
+/* Scalar classes; the C locale's isspace/isdigit/isalnum, plus '_' */
+static inline int ouro_is_space(unsigned char c) { return c == ' ' || (unsigned)(c - '\t') <= '\r' - '\t'; }
+static inline int ouro_is_digit(unsigned char c) { return (unsigned)(c - '0') < 10u; }
+static inline int ouro_is_ident(unsigned char c) {
+    return (unsigned)((c | 0x20) - 'a') < 26u || ouro_is_digit(c) || c == '_';
+}
+
+#ifdef OURO_SCAN_WIDTH
+/* Bytes are signed in the compares, so everything >= 0x80 falls outside the ranges */
+static inline ouro_vec ouro_vec_range(ouro_vec v, char lo, char hi) {
+    return ouro_vec_and(ouro_vec_gt(v, ouro_vec_splat((char)(lo - 1))), ouro_vec_gt(ouro_vec_splat((char)(hi + 1)), v));
+}
+static inline uint32_t ouro_space_mask(ouro_vec v) {
+    return ouro_vec_mask(ouro_vec_or(ouro_vec_eq(v, ouro_vec_splat(' ')), ouro_vec_range(v, '\t', '\r')));
+}
+static inline uint32_t ouro_digit_mask(ouro_vec v) { return ouro_vec_mask(ouro_vec_range(v, '0', '9')); }
+static inline uint32_t ouro_ident_mask(ouro_vec v) {
+    ouro_vec letter = ouro_vec_range(ouro_vec_or(v, ouro_vec_splat(0x20)), 'a', 'z');
+    ouro_vec other = ouro_vec_or(ouro_vec_range(v, '0', '9'), ouro_vec_eq(v, ouro_vec_splat('_')));
+    return ouro_vec_mask(ouro_vec_or(letter, other));
+}
+#endif
+
+static inline void ouro_note_lines(OuroScanLines *lines, size_t base, uint32_t newlines) {
+    if (newlines) {
+        lines->count += ouro_popcount(newlines);
+        lines->last = base + ouro_highest_bit(newlines);
+    }
+}
+
+/* Counts the newlines in [pos, end) */
+static inline void ouro_count_lines(const char *s, size_t pos, size_t end, OuroScanLines *lines) {
+#ifdef OURO_SCAN_WIDTH
+    const ouro_vec newline = ouro_vec_splat('\n');
+    for (; pos + OURO_SCAN_WIDTH <= end; pos += OURO_SCAN_WIDTH) {
+        ouro_note_lines(lines, pos, ouro_vec_mask(ouro_vec_eq(ouro_vec_load(s + pos), newline)));
+    }
+#endif
+    for (; pos < end; pos++) {
+        if (s[pos] == '\n') { lines->count++; lines->last = pos; }
+    }
+}
+
+/* First offset holding `c` */
+static inline size_t ouro_find_byte(const char *s, size_t pos, size_t len, char c) {
+#ifdef OURO_SCAN_WIDTH
+    const ouro_vec target = ouro_vec_splat(c);
+    for (; pos + OURO_SCAN_WIDTH <= len; pos += OURO_SCAN_WIDTH) {
+        uint32_t hit = ouro_vec_mask(ouro_vec_eq(ouro_vec_load(s + pos), target));
+        if (hit) return pos + ouro_ctz(hit);
+    }
+#endif
+    while (pos < len && s[pos] != c) pos++;
+    return pos;
+}
+
+/* First offset holding `a` or `b`: a string's closing quote or its next escape */
+static inline size_t ouro_find_either(const char *s, size_t pos, size_t len, char a, char b) {
+#ifdef OURO_SCAN_WIDTH
+    const ouro_vec va = ouro_vec_splat(a), vb = ouro_vec_splat(b);
+    for (; pos + OURO_SCAN_WIDTH <= len; pos += OURO_SCAN_WIDTH) {
+        ouro_vec v = ouro_vec_load(s + pos);
+        uint32_t hit = ouro_vec_mask(ouro_vec_or(ouro_vec_eq(v, va), ouro_vec_eq(v, vb)));
+        if (hit) return pos + ouro_ctz(hit);
+    }
+#endif
+    while (pos < len && s[pos] != a && s[pos] != b) pos++;
+    return pos;
+}
+
+/* End of a run of [A-Za-z0-9_] */
+static inline size_t ouro_scan_ident(const char *s, size_t pos, size_t len) {
+#ifdef OURO_SCAN_WIDTH
+    for (; pos + OURO_SCAN_WIDTH <= len; pos += OURO_SCAN_WIDTH) {
+        uint32_t run = ouro_ident_mask(ouro_vec_load(s + pos));
+        if (run != OURO_SCAN_FULL) return pos + ouro_ctz(~run);
+    }
+#endif
+    while (pos < len && ouro_is_ident((unsigned char)s[pos])) pos++;
+    return pos;
+}
+
+/* End of a run of [0-9] */
+static inline size_t ouro_scan_digits(const char *s, size_t pos, size_t len) {
+#ifdef OURO_SCAN_WIDTH
+    for (; pos + OURO_SCAN_WIDTH <= len; pos += OURO_SCAN_WIDTH) {
+        uint32_t run = ouro_digit_mask(ouro_vec_load(s + pos));
+        if (run != OURO_SCAN_FULL) return pos + ouro_ctz(~run);
+    }
+#endif
+    while (pos < len && ouro_is_digit((unsigned char)s[pos])) pos++;
+    return pos;
+}
+
+/* End of a run of whitespace, counting the newlines in it */
+static inline size_t ouro_skip_space(const char *s, size_t pos, size_t len, OuroScanLines *lines) {
+#ifdef OURO_SCAN_WIDTH
+    const ouro_vec newline = ouro_vec_splat('\n');
+    for (; pos + OURO_SCAN_WIDTH <= len; pos += OURO_SCAN_WIDTH) {
+        ouro_vec v = ouro_vec_load(s + pos);
+        uint32_t space = ouro_space_mask(v);
+        uint32_t newlines = ouro_vec_mask(ouro_vec_eq(v, newline));
+        if (space != OURO_SCAN_FULL) {
+            unsigned stop = ouro_ctz(~space);
+            ouro_note_lines(lines, pos, newlines & ((1u << stop) - 1u));
+            return pos + stop;
+        }
+        ouro_note_lines(lines, pos, newlines);
+    }
+#endif
+    for (; pos < len && ouro_is_space((unsigned char)s[pos]); pos++) {
+        if (s[pos] == '\n') { lines->count++; lines->last = pos; }
+    }
+    return pos;
+}
+
+/*
+ * Skips whitespace and `//` comments, plus `/ * ... * /` block comments when
+ * `block_comments` is set. An unterminated block comment runs to the end.
+ */
+static inline size_t ouro_skip_space_and_comments(const char *s, size_t pos, size_t len, OuroScanLines *lines,
+                                                  int block_comments) {
+    for (;;) {
+        /* Most tokens are followed by nothing or a single space */
+        if (pos < len && !ouro_is_space((unsigned char)s[pos]) && s[pos] != '/') return pos;
+        pos = ouro_skip_space(s, pos, len, lines);
+        if (pos + 1 >= len || s[pos] != '/') return pos;
+        if (s[pos + 1] == '/') {
+            pos = ouro_find_byte(s, pos + 2, len, '\n'); /* The newline is counted by the next skip */
+        } else if (block_comments && s[pos + 1] == '*') {
+            size_t end = pos + 2;
+            for (;;) {
+                end = ouro_find_byte(s, end, len, '*');
+                if (end >= len || (end + 1 < len && s[end + 1] == '/')) break;
+                end++;
+            }
+            ouro_count_lines(s, pos + 2, end, lines);
+            pos = end + 2 < len ? end + 2 : len;
+        } else {
+            return pos;
+        }
+    }
+}
+
+#endif /* OURO_SCAN_H */
@@ -0,0 +1,333 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ouro {
+
+// Runs jobs on a fixed set of threads. Each worker has its own deque: jobs a
+// worker submits go on the back of its deque and it takes from the back, so
+// a task that wakes another tends to run it next while it is still in cache.
+// A worker whose deque is empty steals from the front of the others'. Jobs
+// submitted from other threads are dealt round-robin.
+class ThreadPool {
+public:
+    using Job = std::function<void()>;
+
+    explicit ThreadPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; ++i) workers.emplace_back([this, i] { work(i); });
+    }
+
+    // Jobs still queued are dropped
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(idle_mutex);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+    bool on_worker() const { return current == this; }
+
+    void submit(Job job) {
+        unsigned target = on_worker() ? current_index : next.fetch_add(1, std::memory_order_relaxed) % size();
+        {
+            std::lock_guard lock(queues[target]->mutex);
+            queues[target]->jobs.push_back(std::move(job));
+            queued.fetch_add(1, std::memory_order_release); // Under the lock, so a take never sees it go negative
+        }
+        {
+            std::lock_guard lock(idle_mutex); // A worker between its check and its wait sees the job
+        }
+        idle.notify_one();
+    }
+
+    // Runs one queued job on the calling thread, for a worker that has to wait
+    // on something another job will do. False if there was none.
+    bool run_pending() {
+        auto job = take(on_worker() ? current_index : 0);
+        if (!job) return false;
+        (*job)();
+        return true;
+    }
+
+    // Calls body(0) .. body(count - 1), each once, on the calling thread and
+    // up to `helpers` workers, and returns when all have returned. Which
+    // thread gets an index varies from run to run, so anything that must not
+    // depend on the thread count has to be keyed by index. The first
+    // exception a call throws is rethrown here.
+    void parallel(std::size_t count, unsigned helpers, const std::function<void(std::size_t)>& body) {
+        struct Shared {
+            const std::function<void(std::size_t)>* body;
+            std::size_t count;
+            std::atomic<std::size_t> next{0}, finished{0};
+            std::mutex mutex;
+            std::condition_variable all_done;
+            std::exception_ptr error;
+        };
+        // Shared, since a helper can start after the caller has returned; it
+        // then finds no index left and never touches `body`
+        auto shared = std::make_shared<Shared>();
+        shared->body = &body;
+        shared->count = count;
+        auto claim = [shared] {
+            for (std::size_t i; (i = shared->next.fetch_add(1, std::memory_order_relaxed)) < shared->count;) {
+                try {
+                    (*shared->body)(i);
+                } catch (...) {
+                    std::lock_guard lock(shared->mutex);
+                    if (!shared->error) shared->error = std::current_exception();
+                }
+                if (shared->finished.fetch_add(1, std::memory_order_acq_rel) + 1 == shared->count) {
+                    std::lock_guard lock(shared->mutex);
+                    shared->all_done.notify_all();
+                }
+            }
+        };
+        for (std::size_t h = 0; h < helpers && h + 1 < count; ++h) submit(claim);
+        claim();
+        std::unique_lock lock(shared->mutex);
+        shared->all_done.wait(lock, [&] { return shared->finished.load(std::memory_order_acquire) == count; });
+        if (shared->error) std::rethrow_exception(shared->error);
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<unsigned> next{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    bool stopping = false;
+
+    inline static thread_local ThreadPool* current = nullptr;
+    inline static thread_local unsigned current_index = 0;
+
+    // The back of `home`'s deque, else the front of another's
+    std::optional<Job> take(unsigned home) {
+        if (queued.load(std::memory_order_acquire) == 0) return std::nullopt;
+        for (unsigned n = 0; n < size(); ++n) {
+            Queue& q = *queues[(home + n) % size()];
+            std::lock_guard lock(q.mutex);
+            if (q.jobs.empty()) continue;
+            Job job;
+            if (n == 0) {
+                job = std::move(q.jobs.back());
+                q.jobs.pop_back();
+            } else {
+                job = std::move(q.jobs.front());
+                q.jobs.pop_front();
+            }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+        return std::nullopt;
+    }
+
+    void work(unsigned index) {
+        current = this;
+        current_index = index;
+        for (;;) {
+            if (auto job = take(index)) {
+                (*job)();
+                continue;
+            }
+            std::unique_lock lock(idle_mutex);
+            idle.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+};
+
+// Fires callbacks after a delay, from one thread, without a sleeping thread
+// per timer. Timers hash into SLOTS buckets by the tick they are due on; a
+// bucket holds every timer due on a tick that lands there, each with the
+// number of further turns of the wheel it has to wait. Adding and expiring
+// a timer are O(1). The thread sleeps until the next tick while any timer
+// is pending, and until one is added otherwise.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t SLOTS = 256;
+    static constexpr Clock::duration TICK = std::chrono::milliseconds(1);
+
+    TimerWheel() : thread([this] { run(); }) {}
+
+    // Timers that have not fired are dropped
+    ~TimerWheel() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // `fire` runs on the wheel's thread, no sooner than `delay` from now, and
+    // should only hand work off
+    void schedule(Clock::duration delay, std::function<void()> fire) {
+        {
+            std::lock_guard lock(mutex);
+            auto now = Clock::now();
+            if (pending == 0) tick_start = now; // The wheel stood still while it was empty
+            auto ticks = static_cast<std::uint64_t>((now - tick_start + delay + TICK - Clock::duration(1)) / TICK);
+            if (ticks == 0) ticks = 1;
+            slots[(cursor + ticks) % SLOTS].push_back({(ticks - 1) / SLOTS, std::move(fire)});
+            ++pending;
+        }
+        wake.notify_one();
+    }
+
+private:
+    struct Timer {
+        std::uint64_t turns; // Times the wheel passes this bucket before it fires
+        std::function<void()> fire;
+    };
+
+    std::array<std::vector<Timer>, SLOTS> slots;
+    std::size_t cursor = 0;          // Bucket of the current tick
+    Clock::time_point tick_start;    // When the current tick began
+    std::size_t pending = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;              // Last, so it starts after the rest is built
+
+    void run() {
+        std::vector<std::function<void()>> due;
+        std::unique_lock lock(mutex);
+        while (!stopping) {
+            if (pending == 0) {
+                wake.wait(lock);
+                continue;
+            }
+            if (Clock::now() < tick_start + TICK) {
+                wake.wait_until(lock, tick_start + TICK);
+                continue;
+            }
+            // Catch up on every tick that has passed
+            auto now = Clock::now();
+            while (tick_start + TICK <= now) {
+                tick_start += TICK;
+                cursor = (cursor + 1) % SLOTS;
+                auto& bucket = slots[cursor];
+                for (std::size_t i = 0; i < bucket.size();) {
+                    if (bucket[i].turns == 0) {
+                        due.push_back(std::move(bucket[i].fire));
+                        if (i + 1 != bucket.size()) bucket[i] = std::move(bucket.back());
+                        bucket.pop_back();
+                    } else {
+                        --bucket[i].turns;
+                        ++i;
+                    }
+                }
+            }
+            pending -= due.size();
+            lock.unlock();
+            for (auto& fire : due) fire();
+            due.clear();
+            lock.lock();
+        }
+    }
+};
+
+// A lazily started coroutine that another coroutine awaits. Awaiting it runs
+// it on the awaiting thread until it finishes or suspends; when it finishes it
+// resumes the awaiter directly, so a chain of them uses no stack between
+// suspensions. Exceptions are rethrown to the awaiter.
+template <typename T>
+class Lazy {
+    template <typename R>
+    struct Result {
+        std::optional<R> value;
+        void return_value(R v) { value = std::move(v); }
+        R take() { return std::move(*value); }
+    };
+    struct Nothing {
+        void return_void() {}
+        void take() {}
+    };
+
+public:
+    struct promise_type : std::conditional_t<std::is_void_v<T>, Nothing, Result<T>> {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+
+        Lazy get_return_object() { return Lazy(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct Resume {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    return h.promise().continuation;
+                }
+                void await_resume() noexcept {}
+            };
+            return Resume{};
+        }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Lazy(Lazy&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Lazy& operator=(Lazy&&) = delete;
+    ~Lazy() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    T await_resume() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        return handle.promise().take();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+    explicit Lazy(std::coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+// A coroutine nobody awaits. It is created suspended; whoever holds `handle`
+// starts it, and its frame frees itself when it finishes. Its body must not
+// let an exception out.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    std::coroutine_handle<> handle;
+};
+
+} // namespace ouro
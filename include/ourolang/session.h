@@ -0,0 +1,186 @@
+#pragma once
+#include "parser.h"
+#include "type_checker.h"
+#include "arena.h"
+#include "scan.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ouro {
+
+// Keeps a document parsed and type-checked while it grows or changes, for
+// the REPL and for editors. The document is split into units, one per
+// top-level statement, keyed by the byte range each covers. An edit re-lexes
+// and re-parses only the units its range touches, then checks the new
+// statements against the type environment everything before it built. The
+// other units keep their tokens and AST.
+//
+// Text after the last statement that stops short, like the first line of a
+// function typed into the REPL, is held back as pending until an edit
+// completes it.
+class Session {
+public:
+    struct Unit {
+        std::size_t begin;             // Byte range in text(), from the end of the previous unit
+        std::size_t end;               // Just past the statement's last token
+        int line;                      // Line `begin` is on
+        StmtPtr stmt;
+        std::span<const Token> tokens; // Numbered by the lines they were parsed on
+        std::shared_ptr<Arena> arena;  // Shared with the units parsed by the same edit
+    };
+
+    // The statements an edit parsed, in document order, for an engine to run.
+    // The AST lives as long as some copy of `arena` does.
+    struct Update {
+        std::shared_ptr<Arena> arena;
+        StmtList stmts;
+    };
+
+private:
+    // What parsing part of the document got to
+    struct Stop {
+        std::size_t end;   // Just past the last complete statement
+        int line;          // Line `end` is on
+        bool short_of_end; // Input ran out in the middle of a statement
+    };
+
+    std::string document;
+    std::vector<Unit> units;   // In order; together they cover the document up to units.back().end
+    int tail_line = 1;         // Line the text after the last unit starts on
+    bool incomplete = false;   // That text stops in the middle of a statement
+    TypeChecker checker;
+
+public:
+    std::string_view text() const { return document; }
+    const std::vector<Unit>& statements() const { return units; }
+    bool pending() const { return incomplete; }
+
+    void declare_function(std::string_view name, std::string_view return_type) {
+        checker.declare_function(name, return_type);
+    }
+
+    // Forgets the complete statements and their text, keeping the type
+    // environment, any pending input and the line count. For callers that
+    // only append and are done with a statement once they have its Update.
+    void discard_statements() {
+        document.erase(0, units.empty() ? 0 : units.back().end);
+        units.clear();
+    }
+
+    Update append(std::string_view text, bool allow_pending = true) {
+        return edit(document.size(), document.size(), text, allow_pending);
+    }
+
+    // Replaces bytes [begin, end) of the document with `text` and returns the
+    // statements that were parsed again. If the result does not lex, parse or
+    // type-check, the error is thrown and the session is left as it was, except
+    // that functions declared before the error stay declared. Input that runs
+    // out mid-statement is an error too, unless `allow_pending`.
+    Update edit(std::size_t begin, std::size_t end, std::string_view text, bool allow_pending = true) {
+        if (begin > end || end > document.size()) throw std::out_of_range("Edit outside the document");
+
+        // The units the edit touches, counting those that end or start right at it
+        auto first = std::lower_bound(units.begin(), units.end(), begin,
+                                      [](const Unit& u, std::size_t pos) { return u.end < pos; });
+        auto last = std::upper_bound(first, units.end(), end,
+                                     [](std::size_t pos, const Unit& u) { return pos < u.begin; });
+        std::size_t from = first != units.end() ? first->begin : (units.empty() ? 0 : units.back().end);
+        int line = first != units.end() ? first->line : tail_line;
+
+        OuroScanLines removed_lines = {0, 0}, added_lines = {0, 0};
+        ouro_count_lines(document.data(), begin, end, &removed_lines);
+        ouro_count_lines(text.data(), 0, text.size(), &added_lines);
+        int line_delta = static_cast<int>(added_lines.count) - static_cast<int>(removed_lines.count);
+        std::string removed = document.substr(begin, end - begin);
+        auto delta = static_cast<std::ptrdiff_t>(text.size()) - static_cast<std::ptrdiff_t>(removed.size());
+        document.replace(begin, end - begin, text);
+
+        try {
+            std::size_t to = last != units.end() ? last->begin + delta : document.size();
+            auto arena = std::make_shared<Arena>(Arena::size_for_source(to - from));
+            std::vector<Unit> parsed;
+            Stop stop = parse(arena, from, to, line, parsed);
+            if (last != units.end() && (stop.short_of_end || ends_in_comment(stop.end, to))) {
+                // A brace or comment the edit opened can take in everything after it
+                last = units.end();
+                parsed.clear();
+                stop = parse(arena, from, document.size(), line, parsed);
+            }
+            if (stop.short_of_end && !allow_pending) {
+                throw std::runtime_error("Unexpected end of input at line " + std::to_string(stop.line));
+            }
+            for (const Unit& u : parsed) checker.check(*u.stmt);
+
+            Update update{arena, StmtList(arena->get_resource())};
+            for (const Unit& u : parsed) update.stmts.push_back(u.stmt);
+
+            for (auto it = last; it != units.end(); ++it) {
+                it->begin += delta;
+                it->end += delta;
+                it->line += line_delta;
+            }
+            if (last != units.end()) {
+                last->begin = stop.end; // Whitespace and comments after the new statements
+                last->line = stop.line;
+                tail_line += line_delta;
+            } else {
+                tail_line = stop.line;
+                incomplete = stop.short_of_end;
+            }
+            auto at = units.erase(first, last);
+            units.insert(at, std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+            return update;
+        } catch (...) {
+            document.replace(begin, text.size(), removed);
+            throw;
+        }
+    }
+
+private:
+    // Whether the whitespace and comments in [from, to) end inside a `//` comment
+    bool ends_in_comment(std::size_t from, std::size_t to) const {
+        std::string_view trivia(document.data() + from, to - from);
+        std::size_t line_start = trivia.rfind('\n');
+        return trivia.find("//", line_start == std::string_view::npos ? 0 : line_start) != std::string_view::npos;
+    }
+
+    // Parses document bytes [from, to), which start on `line`, into `out`
+    Stop parse(const std::shared_ptr<Arena>& arena, std::size_t from, std::size_t to, int line, std::vector<Unit>& out) {
+        auto* mem = arena->get_resource();
+        // The tokens view a copy, so later edits to the document leave them alone
+        auto* chars = static_cast<char*>(mem->allocate(std::max<std::size_t>(to - from, 1), 1));
+        std::memcpy(chars, document.data() + from, to - from);
+        auto* tokens = std::pmr::polymorphic_allocator<>(mem).new_object<std::pmr::vector<Token>>(
+            Lexer::borrowing(std::string_view(chars, to - from), mem, line).tokenize());
+
+        Parser parser(*tokens, mem);
+        std::size_t begin = from;
+        while (!parser.at_end()) {
+            std::size_t first = parser.position();
+            StmtPtr stmt;
+            try {
+                stmt = parser.parse_statement();
+            } catch (const std::runtime_error&) {
+                if (!parser.at_end()) throw;
+                return {begin, line, true};
+            }
+            const Token& last = (*tokens)[parser.position() - 1]; // A ';' or '}'
+            std::size_t end = from + static_cast<std::size_t>(last.value.data() + last.value.size() - chars);
+            auto span = std::span<const Token>(*tokens).subspan(first, parser.position() - first);
+            out.push_back(Unit{begin, end, line, stmt, span, arena});
+            OuroScanLines lines = {0, 0};
+            ouro_count_lines(document.data(), begin, end, &lines);
+            line += static_cast<int>(lines.count);
+            begin = end;
+        }
+        return {begin, line, false};
+    }
+};
+
+} // namespace ouro
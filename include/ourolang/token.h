@@ -7,7 +7,7 @@
 namespace ouro {
 
 enum class TokenType {
-    LET, FN, IF, ELSE, RETURN, FOR, IN, ASYNC, AWAIT, GPU,
+    LET, FN, IF, ELSE, RETURN, FOR, IN, ASYNC, AWAIT, GPU, PARALLEL,
     INT, FLOAT, STRING, IDENTIFIER, NUMBER, STRING_LITERAL,
     COLON, EQUALS, LPAREN, RPAREN, LBRACE, RBRACE, SEMICOLON, COMMA,
     PLUS, MINUS, MUL, DIV, GT, DOTDOT, ARROW, EOF_TOKEN
@@ -15,7 +15,7 @@ enum class TokenType {
 
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value; // Into the lexed text; see Lexer
     int line;
 };
 
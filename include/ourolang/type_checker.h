@@ -1,83 +1,252 @@
 #pragma once
 #include "ast.h"
 #include <map>
+#include <optional>
+#include <set>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace ouro {
 
+// Names and types are copied in, so one checker can be kept across inputs
+// (see Session) and outlive the ASTs it has checked. A function body gets its
+// own scope on top of the globals rather than a copy of them.
 class TypeChecker {
-    std::map<std::string, std::string> env;
-    std::map<std::string, FnDeclStmt*> functions;
+    using Scope = std::map<std::string, std::string, std::less<>>;
+    std::vector<Scope> scopes{1}; // scopes[0] is the global scope
+    Scope functions; // Return types
 
 public:
-    void check(const std::vector<StmtPtr>& stmts) {
-        for (const auto& s : stmts) check_stmt(*s);
+    void check(const StmtList& stmts) {
+        for (const auto& s : stmts) check(*s);
+    }
+    void check(const Stmt& stmt) {
+        scopes.resize(1); // A failed check can leave a function's scope open
+        check_stmt(stmt);
+    }
+
+    // For functions with no declaration in the source, like an engine's natives
+    void declare_function(std::string_view name, std::string_view return_type) { set(functions, name, return_type); }
+
+    // The operator of a reduction `let s = s + e`, `s - e` or `s * e` (or
+    // `e + s`, `e * s`); nullopt for any other `let`
+    static std::optional<TokenType> reduction(const VarDeclStmt& var) {
+        if (!std::holds_alternative<BinaryExpr>(var.value->value)) return std::nullopt;
+        const auto& b = std::get<BinaryExpr>(var.value->value);
+        auto is_total = [&](const Expr* e) {
+            return std::holds_alternative<IdentExpr>(e->value) && std::get<IdentExpr>(e->value).name == var.name;
+        };
+        switch (b.op) {
+            case TokenType::PLUS:
+            case TokenType::MUL:
+                if (is_total(b.right)) return b.op;
+                [[fallthrough]];
+            case TokenType::MINUS:
+                if (is_total(b.left)) return b.op;
+                [[fallthrough]];
+            default: return std::nullopt;
+        }
     }
 
 private:
+    // Redeclaring reuses the entry's strings
+    static void set(Scope& names, std::string_view name, std::string_view type) {
+        auto it = names.find(name);
+        if (it != names.end()) it->second = type;
+        else names.emplace(name, type);
+    }
+
     void check_stmt(const Stmt& stmt) {
         if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
             const auto& var = std::get<VarDeclStmt>(stmt.value);
-            auto inferred = infer_type(var.value.get());
+            auto inferred = infer_type(var.value);
             if (!var.type.empty() && var.type != inferred) {
-                throw std::runtime_error("Type mismatch for " + var.name);
+                throw std::runtime_error("Type mismatch for " + std::string(var.name));
             }
-            env[var.name] = var.type.empty() ? inferred : var.type;
+            set(scopes.back(), var.name, var.type.empty() ? inferred : var.type);
         } else if (std::holds_alternative<FnDeclStmt>(stmt.value)) {
             const auto& fn = std::get<FnDeclStmt>(stmt.value);
-            functions[fn.name] = const_cast<FnDeclStmt*>(&fn);
-            auto saved = env;
-            for (const auto& p : fn.params) env[p.first] = p.second;
+            declare_function(fn.name, fn.return_type);
+            auto& scope = scopes.emplace_back();
+            for (const auto& p : fn.params) set(scope, p.first, p.second);
             for (const auto& b : fn.body) check_stmt(*b);
-            env = saved;
+            scopes.pop_back();
         } else if (std::holds_alternative<IfStmt>(stmt.value)) {
             const auto& i = std::get<IfStmt>(stmt.value);
-            if (infer_type(i.condition.get()) != "int") {
+            if (infer_type(i.condition) != "int") {
                 throw std::runtime_error("If condition must be int");
             }
             for (const auto& s : i.then_branch) check_stmt(*s);
             for (const auto& s : i.else_branch) check_stmt(*s);
         } else if (std::holds_alternative<ForStmt>(stmt.value)) {
             const auto& f = std::get<ForStmt>(stmt.value);
-            if (infer_type(f.start.get()) != "int" || infer_type(f.end.get()) != "int") {
-                throw std::runtime_error("For loop bounds must be int");
+            auto start = infer_type(f.start), end = infer_type(f.end);
+            auto numeric = [](std::string_view t) { return t == "int" || t == "float"; };
+            if (!numeric(start) || !numeric(end)) {
+                throw std::runtime_error("For loop bounds must be int or float");
             }
-            env[f.var] = "int";
+            // Number literals are floats, so `0..n` counts in floats unless both ends are ints
+            set(scopes.back(), f.var, start == "int" && end == "int" ? "int" : "float");
             for (const auto& s : f.body) check_stmt(*s);
+            if (f.parallel) check_parallel(f);
         } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
             const auto& r = std::get<ReturnStmt>(stmt.value);
             if (r.value) {
-                infer_type(r.value.get());
+                infer_type(r.value);
+            }
+        }
+    }
+
+    // --- parallel for -----------------------------------------------------------
+    //
+    // The iterations of a `parallel for` run in any order and on any thread,
+    // so none may see what another did. Its body may only compute: no calls,
+    // awaits, functions or returns. A name it sets is either a reduction,
+    // set only by reductions with one operator and read nowhere else, or
+    // private to the iteration, every read of it preceded by a `let` the same
+    // iteration is sure to have run.
+
+    struct Access {
+        int sets = 0, reads = 0;
+        std::optional<TokenType> op; // Of the reductions setting it, while they all agree
+        bool reduction = true;
+    };
+    using Accesses = std::map<std::string_view, Access>;
+
+    void check_parallel(const ForStmt& f) {
+        Accesses names;
+        gather(f.body, names);
+        if (auto it = names.find(f.var); it != names.end() && it->second.sets > 0) {
+            throw std::runtime_error("Parallel for cannot set its loop variable " + std::string(f.var));
+        }
+        for (auto& [name, access] : names) {
+            if (access.sets == 0 || access.reads != access.sets) access.reduction = false;
+            if (!access.reduction) continue;
+            auto type = type_of(name);
+            if (type != "int" && type != "float") {
+                throw std::runtime_error("Parallel for reduction " + std::string(name) + " must be int or float");
+            }
+        }
+        std::set<std::string_view> assigned{f.var};
+        check_private(f.body, names, assigned);
+    }
+
+    static void gather(const StmtList& stmts, Accesses& names) {
+        for (const auto* s : stmts) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                const auto& v = std::get<VarDeclStmt>(s->value);
+                gather(*v.value, names);
+                auto& access = names[v.name];
+                ++access.sets;
+                auto op = reduction(v);
+                if (!op || (access.op && access.op != op)) access.reduction = false;
+                access.op = op;
+            } else if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                gather(*i.condition, names);
+                gather(i.then_branch, names);
+                gather(i.else_branch, names);
+            } else if (std::holds_alternative<ForStmt>(s->value)) {
+                const auto& f = std::get<ForStmt>(s->value);
+                gather(*f.start, names);
+                gather(*f.end, names);
+                auto& access = names[f.var];
+                ++access.sets;
+                access.reduction = false;
+                gather(f.body, names);
+            } else if (std::holds_alternative<FnDeclStmt>(s->value)) {
+                throw std::runtime_error("Cannot declare a function in a parallel for");
+            } else {
+                throw std::runtime_error("Cannot return from a parallel for");
             }
         }
     }
 
-    std::string infer_type(const Expr* expr) {
+    static void gather(const Expr& expr, Accesses& names) {
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            ++names[std::get<IdentExpr>(expr.value).name].reads;
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            gather(*b.left, names);
+            gather(*b.right, names);
+        } else if (std::holds_alternative<CallExpr>(expr.value)) {
+            throw std::runtime_error("Cannot call " + std::string(std::get<CallExpr>(expr.value).name) + " in a parallel for");
+        } else if (std::holds_alternative<AwaitExpr>(expr.value)) {
+            throw std::runtime_error("Cannot await in a parallel for");
+        }
+    }
+
+    // `assigned` holds the names this iteration has surely set so far
+    static void check_private(const StmtList& stmts, const Accesses& names, std::set<std::string_view>& assigned) {
+        for (const auto* s : stmts) {
+            if (std::holds_alternative<VarDeclStmt>(s->value)) {
+                const auto& v = std::get<VarDeclStmt>(s->value);
+                check_private(*v.value, names, assigned);
+                if (!names.at(v.name).reduction) assigned.insert(v.name);
+            } else if (std::holds_alternative<IfStmt>(s->value)) {
+                const auto& i = std::get<IfStmt>(s->value);
+                check_private(*i.condition, names, assigned);
+                auto then_assigned = assigned, else_assigned = assigned;
+                check_private(i.then_branch, names, then_assigned);
+                check_private(i.else_branch, names, else_assigned);
+                for (auto name : then_assigned) {
+                    if (else_assigned.contains(name)) assigned.insert(name);
+                }
+            } else {
+                const auto& f = std::get<ForStmt>(s->value);
+                check_private(*f.start, names, assigned);
+                check_private(*f.end, names, assigned);
+                auto inner = assigned; // The body may not run at all
+                inner.insert(f.var);
+                check_private(f.body, names, inner);
+            }
+        }
+    }
+
+    static void check_private(const Expr& expr, const Accesses& names, const std::set<std::string_view>& assigned) {
+        if (std::holds_alternative<IdentExpr>(expr.value)) {
+            auto name = std::get<IdentExpr>(expr.value).name;
+            auto it = names.find(name);
+            if (it->second.sets > 0 && !it->second.reduction && !assigned.contains(name)) {
+                throw std::runtime_error("Parallel for reads " + std::string(name) + " from an earlier iteration");
+            }
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            const auto& b = std::get<BinaryExpr>(expr.value);
+            check_private(*b.left, names, assigned);
+            check_private(*b.right, names, assigned);
+        }
+    }
+
+    std::string_view type_of(std::string_view name) const {
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            auto it = scope->find(name);
+            if (it != scope->end()) return it->second;
+        }
+        throw std::runtime_error("Undefined variable: " + std::string(name));
+    }
+
+    std::string_view infer_type(const Expr* expr) {
         if (std::holds_alternative<NumberExpr>(expr->value)) return "float";
         if (std::holds_alternative<StringExpr>(expr->value)) return "string";
-        if (std::holds_alternative<IdentExpr>(expr->value)) {
-            const auto& id = std::get<IdentExpr>(expr->value);
-            if (env.find(id.name) != env.end()) return env[id.name];
-            throw std::runtime_error("Undefined variable: " + id.name);
-        }
+        if (std::holds_alternative<IdentExpr>(expr->value)) return type_of(std::get<IdentExpr>(expr->value).name);
         if (std::holds_alternative<BinaryExpr>(expr->value)) {
             const auto& b = std::get<BinaryExpr>(expr->value);
-            auto lt = infer_type(b.left.get());
-            auto rt = infer_type(b.right.get());
+            auto lt = infer_type(b.left);
+            auto rt = infer_type(b.right);
             if (lt != rt) throw std::runtime_error("Type mismatch in binary op");
             if (b.op == TokenType::GT) return "int";
             return lt;
         }
         if (std::holds_alternative<CallExpr>(expr->value)) {
             const auto& c = std::get<CallExpr>(expr->value);
-            if (functions.find(c.name) != functions.end()) {
-                return functions[c.name]->return_type;
-            }
-            throw std::runtime_error("Undefined function: " + c.name);
+            auto it = functions.find(c.name);
+            if (it != functions.end()) return it->second;
+            throw std::runtime_error("Undefined function: " + std::string(c.name));
         }
         if (std::holds_alternative<AwaitExpr>(expr->value)) {
             const auto& a = std::get<AwaitExpr>(expr->value);
-            return infer_type(a.expr.get());
+            return infer_type(a.expr);
         }
         return "unknown";
     }
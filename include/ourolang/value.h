@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace ouro {
+
+// A bytecode VM value NaN-boxed into 64 bits. Numbers are their own IEEE-754
+// bits. Everything else is a quiet NaN that arithmetic never produces: with the
+// sign bit set the low bits are an interned string's address, otherwise a tag.
+// Values never own memory, so copying one is copying a word.
+class Value {
+    static constexpr std::uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr std::uint64_t SIGN_BIT = 0x8000000000000000;
+    static constexpr std::uint64_t TAG_NIL = 1;
+    static constexpr std::uint64_t TAG_EMPTY = 2; // A slot whose declaration has not run
+
+    std::uint64_t bits;
+
+    explicit constexpr Value(std::uint64_t b) : bits(b) {}
+
+public:
+    constexpr Value() : bits(QNAN | TAG_NIL) {}
+
+    static Value number(double d) {
+        std::uint64_t b;
+        std::memcpy(&b, &d, sizeof b);
+        return Value(b);
+    }
+    static constexpr Value nil() { return Value(QNAN | TAG_NIL); }
+    static constexpr Value empty() { return Value(QNAN | TAG_EMPTY); }
+    static Value string(const std::string* s) {
+        return Value(SIGN_BIT | QNAN | static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(s)));
+    }
+
+    bool is_number() const { return (bits & QNAN) != QNAN; }
+    bool is_string() const { return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN); }
+    bool is_nil() const { return bits == (QNAN | TAG_NIL); }
+    bool is_empty() const { return bits == (QNAN | TAG_EMPTY); }
+
+    double as_number() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d;
+    }
+    const std::string& as_string() const {
+        return *reinterpret_cast<const std::string*>(static_cast<std::uintptr_t>(bits & ~(SIGN_BIT | QNAN)));
+    }
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay one word");
+
+// Owns one copy of every string the VM has seen. A string Value holds the
+// address of its copy here, so equal strings share storage.
+class StringTable {
+    std::unordered_set<std::string> strings; // Node-based: addresses survive rehashing
+
+public:
+    const std::string* intern(std::string_view s) { return &*strings.emplace(s).first; }
+};
+
+} // namespace ouro
@@ -0,0 +1,291 @@
+#pragma once
+#include "session.h"
+#include "resolver.h"
+#include "compiler.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace ouro {
+
+// Runs programs by compiling them to bytecode first. run() behaves like
+// Interpreter::run, so the REPL can use either engine: same scoping, same
+// errors for unset variables and unknown functions, and the same shared
+// return register. Programs with async or gpu functions or `parallel for`
+// are rejected with Unsupported before any of them runs.
+class VM {
+    // The frame of a call that declares functions. Closures keep it alive after
+    // the call returns; every other call keeps its locals on the value stack.
+    struct Env {
+        std::vector<Value> slots;
+        std::shared_ptr<Env> parent;
+    };
+
+    using Native = Value (*)(const Value* args, int argc);
+
+    // What a callee slot currently names: nothing, a native, or a closure
+    struct Callee {
+        const FunctionProto* proto = nullptr;
+        std::shared_ptr<Env> closure;
+        Native native = nullptr;
+    };
+
+    struct CallFrame {
+        const FunctionProto* proto;
+        const std::uint8_t* ip;
+        Value* slots;                 // On the value stack, or in `env`
+        Value* base;                  // Where the result goes on return
+        std::shared_ptr<Env> env;     // Heap frame of a captured call
+        std::shared_ptr<Env> closure; // Scope the function was declared in
+    };
+
+    static constexpr std::size_t STACK_MAX = 1 << 18;
+    static constexpr std::size_t FRAMES_MAX = 1 << 13;
+
+    Session session;
+    StringTable strings;
+    Compiler compiler{strings};
+    Resolver resolver; // Keeps the global slots across run() calls
+    std::shared_ptr<Env> globals = std::make_shared<Env>();
+    std::vector<Callee> callees;
+    std::unique_ptr<Value[]> stack{new Value[STACK_MAX]};
+    std::vector<CallFrame> frames;
+    Value return_value = Value::number(0); // Like the tree walker, "no value" is 0
+
+public:
+    VM() {
+        frames.reserve(FRAMES_MAX);
+        define_native("print", [](const Value* args, int argc) -> Value {
+            for (int i = 0; i < argc; ++i) {
+                if (args[i].is_number()) std::cout << args[i].as_number();
+                else if (args[i].is_string()) std::cout << args[i].as_string();
+            }
+            std::cout << std::endl;
+            return Value::number(0);
+        });
+        define_native("sleep", [](const Value* args, int argc) -> Value {
+            if (argc > 0 && args[0].is_number()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(args[0].as_number())));
+            }
+            return Value::number(0);
+        });
+    }
+
+    void run(const std::string& source) { run(parse(source, false)); }
+
+    bool feed(const std::string& input) {
+        run(parse(input, true));
+        return !session.pending();
+    }
+
+    void run(Session::Update update) { // The AST goes with `update` once it is compiled
+        resolver.resolve(update.stmts);
+        globals->slots.resize(resolver.global_count(), Value::empty());
+        FunctionProto script = compiler.compile(update.stmts);
+        callees.resize(compiler.callee_count());
+        execute(script);
+    }
+
+private:
+    Session::Update parse(const std::string& input, bool allow_pending) {
+        // The line break keeps the next input off this one's last line
+        auto update = session.append(input + '\n', allow_pending);
+        session.discard_statements(); // They live on in `update` for as long as they are needed
+        return update;
+    }
+
+    void define_native(const std::string& name, Native fn) {
+        int slot = compiler.callee_slot(name);
+        callees.resize(compiler.callee_count());
+        callees[slot].native = fn;
+        session.declare_function(name, "");
+    }
+
+    [[noreturn]] static void undefined_variable(const CallFrame& frame, const std::uint8_t* ip) {
+        auto offset = static_cast<std::size_t>(ip - frame.proto->code.data());
+        throw std::runtime_error("Undefined variable: " + frame.proto->name_read_at(offset));
+    }
+
+    void execute(const FunctionProto& script) {
+        Value* const stack_end = stack.get() + STACK_MAX;
+        Value* sp = stack.get();
+        if (script.max_stack > STACK_MAX) throw std::runtime_error("Stack overflow");
+        frames.clear();
+        frames.push_back(CallFrame{&script, script.code.data(), globals->slots.data(), sp, globals, nullptr});
+
+        CallFrame* frame = &frames.back();
+        const std::uint8_t* ip = frame->ip;
+        Value* slots = frame->slots;
+        Value* const global_slots = globals->slots.data();
+
+        auto read_u16 = [&ip]() -> std::uint16_t {
+            ip += 2;
+            return static_cast<std::uint16_t>(ip[-2] | (ip[-1] << 8));
+        };
+        auto pop_numbers = [&sp](double& l, double& r) {
+            Value b = *--sp;
+            Value a = sp[-1];
+            if (!a.is_number() || !b.is_number()) throw std::runtime_error("Operands must be numbers");
+            l = a.as_number();
+            r = b.as_number();
+        };
+
+        for (;;) {
+            switch (static_cast<OpCode>(*ip++)) {
+                case OpCode::CONSTANT: *sp++ = frame->proto->constants[read_u16()]; break;
+                case OpCode::NIL: *sp++ = Value::number(0); break;
+                case OpCode::GET_LOCAL: {
+                    Value v = slots[read_u16()];
+                    if (v.is_empty()) undefined_variable(*frame, ip);
+                    *sp++ = v;
+                    break;
+                }
+                case OpCode::SET_LOCAL: slots[read_u16()] = *--sp; break;
+                case OpCode::GET_GLOBAL: {
+                    Value v = global_slots[read_u16()];
+                    if (v.is_empty()) undefined_variable(*frame, ip);
+                    *sp++ = v;
+                    break;
+                }
+                case OpCode::GET_OUTER: {
+                    int depth = *ip++;
+                    const Env* env = frame->closure.get();
+                    while (--depth > 0) env = env->parent.get();
+                    Value v = env->slots[read_u16()];
+                    if (v.is_empty()) undefined_variable(*frame, ip);
+                    *sp++ = v;
+                    break;
+                }
+                case OpCode::TRY_LOCAL: {
+                    Value v = slots[read_u16()];
+                    std::uint16_t offset = read_u16();
+                    if (!v.is_empty()) {
+                        *sp++ = v;
+                        ip += offset;
+                    }
+                    break;
+                }
+                case OpCode::TRY_OUTER: {
+                    int depth = *ip++;
+                    const Env* env = frame->closure.get();
+                    while (--depth > 0) env = env->parent.get();
+                    Value v = env->slots[read_u16()];
+                    std::uint16_t offset = read_u16();
+                    if (!v.is_empty()) {
+                        *sp++ = v;
+                        ip += offset;
+                    }
+                    break;
+                }
+                case OpCode::UNDEFINED: undefined_variable(*frame, ip);
+                case OpCode::ADD: { double l, r; pop_numbers(l, r); sp[-1] = Value::number(l + r); break; }
+                case OpCode::SUB: { double l, r; pop_numbers(l, r); sp[-1] = Value::number(l - r); break; }
+                case OpCode::MUL: { double l, r; pop_numbers(l, r); sp[-1] = Value::number(l * r); break; }
+                case OpCode::DIV: { double l, r; pop_numbers(l, r); sp[-1] = Value::number(l / r); break; }
+                case OpCode::GT: { double l, r; pop_numbers(l, r); sp[-1] = Value::number(l > r ? 1.0 : 0.0); break; }
+                case OpCode::JUMP: {
+                    std::uint16_t offset = read_u16();
+                    ip += offset;
+                    break;
+                }
+                case OpCode::JUMP_IF_FALSE: {
+                    std::uint16_t offset = read_u16();
+                    Value cond = *--sp;
+                    if (!(cond.is_number() && cond.as_number() != 0)) ip += offset;
+                    break;
+                }
+                case OpCode::FOR_PREP: {
+                    std::uint16_t slot = read_u16();
+                    std::uint16_t exit = read_u16();
+                    if (!sp[-2].is_number() || !sp[-1].is_number()) throw std::runtime_error("For loop bounds must be numbers");
+                    double start = static_cast<int>(sp[-2].as_number());
+                    double end = static_cast<int>(sp[-1].as_number());
+                    if (start < end) {
+                        sp[-2] = Value::number(start);
+                        sp[-1] = Value::number(end);
+                        slots[slot] = sp[-2];
+                    } else {
+                        sp -= 2;
+                        ip += exit;
+                    }
+                    break;
+                }
+                case OpCode::FOR_LOOP: {
+                    std::uint16_t slot = read_u16();
+                    std::uint16_t back = read_u16();
+                    double next = sp[-2].as_number() + 1;
+                    if (next < sp[-1].as_number()) {
+                        sp[-2] = Value::number(next);
+                        slots[slot] = sp[-2];
+                        ip -= back;
+                    } else {
+                        sp -= 2;
+                    }
+                    break;
+                }
+                case OpCode::DEFINE_FN: {
+                    const FunctionProto* proto = frame->proto->children[read_u16()];
+                    Callee& callee = callees[read_u16()];
+                    callee.proto = proto;
+                    callee.closure = frame->env; // Only captured frames declare functions
+                    callee.native = nullptr;
+                    break;
+                }
+                case OpCode::CALL: {
+                    std::uint16_t slot = read_u16();
+                    int argc = *ip++;
+                    const Callee& callee = callees[slot];
+                    if (callee.native) {
+                        Value result = callee.native(sp - argc, argc);
+                        sp -= argc;
+                        *sp++ = result;
+                        break;
+                    }
+                    if (!callee.proto) throw std::runtime_error("Undefined function: " + compiler.callee_name(slot));
+                    const FunctionProto& fn = *callee.proto;
+                    Value* base = sp - argc;
+                    std::size_t passed = std::min<std::size_t>(argc, fn.params);
+                    std::size_t locals = fn.captured ? 0 : fn.frame_size;
+                    if (frames.size() == FRAMES_MAX || static_cast<std::size_t>(stack_end - base) < locals + fn.max_stack) {
+                        throw std::runtime_error("Stack overflow");
+                    }
+                    frame->ip = ip;
+                    CallFrame next{&fn, fn.code.data(), base, base, nullptr, callee.closure};
+                    if (fn.captured) {
+                        next.env = std::make_shared<Env>(Env{std::vector<Value>(fn.frame_size, Value::empty()), callee.closure});
+                        std::copy(base, base + passed, next.env->slots.begin());
+                        next.slots = next.env->slots.data();
+                        sp = base;
+                    } else {
+                        // Parameters are already in place; extra arguments are dropped
+                        std::fill(base + passed, base + fn.frame_size, Value::empty());
+                        sp = base + fn.frame_size;
+                    }
+                    frames.push_back(std::move(next));
+                    frame = &frames.back();
+                    ip = frame->ip;
+                    slots = frame->slots;
+                    break;
+                }
+                case OpCode::SET_RETURN: return_value = *--sp; break;
+                case OpCode::END: {
+                    if (frames.size() == 1) {
+                        frames.clear();
+                        return;
+                    }
+                    sp = frame->base;
+                    frames.pop_back();
+                    frame = &frames.back();
+                    ip = frame->ip;
+                    slots = frame->slots;
+                    *sp++ = return_value;
+                    break;
+                }
+            }
+        }
+    }
+};
+
+} // namespace ouro
@@ -1,23 +1,144 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "ast_types.h"
 
+#define AST_ARENA_BLOCK_SIZE (64 * 1024)
+#define AST_ARENA_ALIGN 16
+
+typedef struct AstArenaBlock {
+    struct AstArenaBlock *next;
+    size_t used;
+    size_t capacity;
+    unsigned char *data;
+} AstArenaBlock;
+
+struct AstArena {
+    AstArenaBlock *blocks;   // Newest first; allocations come from the head
+    const char **strings;    // Intern table, open addressing (NULL = empty)
+    int string_count;
+    int string_capacity;
+};
+
+static AstArena *active_arena = NULL;
+
+static AstArenaBlock* add_block(AstArena *arena, size_t min_size) {
+    size_t capacity = min_size > AST_ARENA_BLOCK_SIZE ? min_size : AST_ARENA_BLOCK_SIZE;
+    AstArenaBlock *block = (AstArenaBlock*)malloc(sizeof(AstArenaBlock) + AST_ARENA_ALIGN + capacity);
+    if (!block) {
+        fprintf(stderr, "Error: Failed to allocate memory for AST arena\n");
+        exit(EXIT_FAILURE);
+    }
+    uintptr_t data = ((uintptr_t)(block + 1) + AST_ARENA_ALIGN - 1) & ~(uintptr_t)(AST_ARENA_ALIGN - 1);
+    block->data = (unsigned char*)data;
+    block->used = 0;
+    block->capacity = capacity;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
+
+AstArena* ast_arena_create(void) {
+    AstArena *arena = (AstArena*)calloc(1, sizeof(AstArena));
+    if (!arena) {
+        fprintf(stderr, "Error: Failed to allocate memory for AST arena\n");
+        exit(EXIT_FAILURE);
+    }
+    add_block(arena, AST_ARENA_BLOCK_SIZE);
+    return arena;
+}
+
+void ast_arena_destroy(AstArena *arena) {
+    if (!arena) return;
+    if (active_arena == arena) active_arena = NULL;
+    AstArenaBlock *block = arena->blocks;
+    while (block) {
+        AstArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free((void*)arena->strings);
+    free(arena);
+}
+
+AstArena* ast_arena_activate(AstArena *arena) {
+    AstArena *previous = active_arena;
+    active_arena = arena;
+    return previous;
+}
+
+static AstArena* current_arena(void) {
+    if (!active_arena) {
+        fprintf(stderr, "Error: No AST arena is active\n");
+        exit(EXIT_FAILURE);
+    }
+    return active_arena;
+}
+
+void* ast_alloc(size_t size) {
+    AstArena *arena = current_arena();
+    size = (size + AST_ARENA_ALIGN - 1) & ~(size_t)(AST_ARENA_ALIGN - 1);
+    AstArenaBlock *block = arena->blocks;
+    if (block->capacity - block->used < size) block = add_block(arena, size);
+    void *memory = block->data + block->used;
+    block->used += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+static uint32_t hash_string(const char *s) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *s; s++) {
+        hash ^= (uint8_t)*s;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void grow_strings(AstArena *arena) {
+    int new_capacity = arena->string_capacity ? arena->string_capacity * 2 : 256;
+    const char **grown = (const char**)calloc((size_t)new_capacity, sizeof(const char*));
+    if (!grown) {
+        fprintf(stderr, "Error: Failed to allocate memory for AST string table\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < arena->string_capacity; i++) {
+        const char *s = arena->strings[i];
+        if (!s) continue;
+        uint32_t bucket = hash_string(s) & (uint32_t)(new_capacity - 1);
+        while (grown[bucket]) bucket = (bucket + 1) & (uint32_t)(new_capacity - 1);
+        grown[bucket] = s;
+    }
+    free((void*)arena->strings);
+    arena->strings = grown;
+    arena->string_capacity = new_capacity;
+}
+
+const char* ast_intern(const char *s) {
+    if (!s || !*s) return "";
+    AstArena *arena = current_arena();
+    if (arena->string_count + 1 > arena->string_capacity / 2) grow_strings(arena);
+
+    uint32_t mask = (uint32_t)(arena->string_capacity - 1);
+    uint32_t bucket = hash_string(s) & mask;
+    for (; arena->strings[bucket]; bucket = (bucket + 1) & mask) {
+        if (strcmp(arena->strings[bucket], s) == 0) return arena->strings[bucket];
+    }
+    size_t length = strlen(s);
+    char *copy = (char*)ast_alloc(length + 1);
+    memcpy(copy, s, length + 1);
+    arena->strings[bucket] = copy;
+    arena->string_count++;
+    return copy;
+}
+
 // Create a new AST node
 ASTNode* create_node(ASTNodeType type, const char* value, int line, int col) { // Added line, col
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (!node) {
-        fprintf(stderr, "Error: Failed to allocate memory for AST node\n");
-        return NULL;
-    }
+    ASTNode* node = (ASTNode*)ast_alloc(sizeof(ASTNode));
     
     node->type = type;
-    if (value) {
-        strncpy(node->value, value, sizeof(node->value) - 1);
-        node->value[sizeof(node->value) - 1] = '\0';
-    } else {
-        node->value[0] = '\0';
-    }
+    node->value = ast_intern(value);
     
     node->left = NULL;
     node->right = NULL;
@@ -27,13 +148,26 @@ ASTNode* create_node(ASTNodeType type, const char* value, int line, int col) { /
     node->col = col;   // Initialize col
     
     // Initialize other fields
-    node->data_type[0] = '\0';
-    node->generic_type[0] = '\0';
+    node->data_type = "";
+    node->generic_type = "";
     node->is_void = 0;
     node->is_array = 0;
     node->array_size = 0;
-    node->access_modifier[0] = '\0';
+    node->access_modifier = "";
     node->parent_class_name = NULL; // Changed from parent_class
+    node->slot = -1;
+    node->depth = 0;
+    node->local_count = -1;
+    node->local_names = NULL;
+    node->bytecode = NULL;
+    node->cached_shape = NULL;
+    node->cached_slot = -1;
+    node->cached_callee = NULL;
+    node->cached_native = NULL;
+    node->cached_call_kind = 0;
+    node->cached_epoch = 0;
+    node->cached_receiver = NULL;
+    node->call_cache = NULL;
     
     return node;
 }
@@ -125,6 +259,13 @@ void print_ast(ASTNode* node, int indent) {
     if (node->parent_class_name) {
         printf(" [ParentClass: %s]", node->parent_class_name);
     }
+
+    // Print resolver results
+    if (node->local_count >= 0) {
+        printf(" [Locals: %d]", node->local_count);
+    } else if (node->slot >= 0) {
+        printf(" [Slot: %d, Depth: %d]", node->slot, node->depth);
+    }
     
     printf("\n");
     
@@ -147,22 +288,3 @@ void print_ast(ASTNode* node, int indent) {
         print_ast(node->next, indent + 1);
     }
 }
-
-// Free the AST
-void free_ast(ASTNode* node) {
-    if (!node) return;
-    
-    // Free children first
-    free_ast(node->left);
-    free_ast(node->right);
-    free_ast(node->next);
-    
-    // Free parent class name if allocated
-    if (node->parent_class_name) { // Changed from parent_class
-        free(node->parent_class_name);
-        node->parent_class_name = NULL;
-    }
-    
-    // Free this node
-    free(node);
-}
@@ -1,6 +1,8 @@
 #ifndef AST_TYPES_H
 #define AST_TYPES_H
 
+#include <stddef.h>
+
 // Node types for AST
 typedef enum {
     AST_PROGRAM,
@@ -47,7 +49,7 @@ typedef enum {
 // AST node structure
 typedef struct ASTNode {
     ASTNodeType type;
-    char value[256];
+    const char *value;       // Interned in the node's arena; never NULL ("" when empty)
     struct ASTNode *left;
     struct ASTNode *right;
     struct ASTNode *next;
@@ -57,21 +59,58 @@ typedef struct ASTNode {
     int col;
 
     // New fields for type information
-    char data_type[64];      // Data type (int, float, Vector2D, etc.)
-    char generic_type[64];   // Generic type parameter (T, U, etc.)
+    const char *data_type;   // Data type (int, float, Vector2D, etc.); interned or a literal, never NULL
+    const char *generic_type; // Generic type parameter (T, U, etc.)
     int is_void;             // Flag for void functions
     int is_array;            // Flag for array fields/variables
     int array_size;          // Size of array (if specified)
     
     // Access modifiers for object properties
-    char access_modifier[16]; // "public", "private", "static"
-    char* parent_class_name; // Name of parent class for methods (strdup'd)
+    const char *access_modifier; // "public", "private", "static"
+    const char *parent_class_name; // Name of parent class for methods (the class node's value)
+
+    // Filled in by resolve_program (semantic.c). Nodes the resolver did not
+    // place keep slot = -1 and are looked up by name at runtime.
+    int slot;                // Identifier/declaration/parameter: frame slot. Function: slot of 'this'
+    int depth;               // Identifier: frames to walk outward (0 = current). Function: nesting level
+    int local_count;         // Function/program: slots its frame needs (-1 = not resolved)
+    const char **local_names; // Function/program: name of each slot (arena-allocated, points into the AST)
+    struct BytecodeFunction *bytecode; // Function/program: compiled body (-bytecode), NULL if tree-walked
+
+    // Inline cache for member access sites (vm.c): shape last seen and its property slot
+    struct Shape *cached_shape;
+    int cached_slot;
+
+    // Call-site cache for AST_CALL (vm.c), valid while cached_epoch matches the
+    // VM's registry epoch. Plain calls keep the resolved user function or
+    // native. Method calls keep the method for the first receiver class seen
+    // (cached_receiver) and spill further classes into call_cache.
+    struct ASTNode *cached_callee;
+    void (*cached_native)(void);
+    int cached_call_kind;
+    unsigned cached_epoch;
+    const void *cached_receiver;
+    struct CallCache *call_cache;
 } ASTNode;
 
+// Nodes, their strings and other per-tree data live in an arena owned by the
+// compilation unit (the main program, or one per loaded Module). Everything is
+// released at once by ast_arena_destroy; there is no per-node free.
+typedef struct AstArena AstArena;
+
+AstArena* ast_arena_create(void);
+void ast_arena_destroy(AstArena *arena);
+// Makes `arena` the target of create_node/ast_alloc/ast_intern and returns the
+// previously active arena, so a nested unit (an imported module) can restore it.
+AstArena* ast_arena_activate(AstArena *arena);
+void* ast_alloc(size_t size);          // Zeroed memory from the active arena
+const char* ast_intern(const char *s); // One copy of each distinct string per arena
+
 // Function prototypes
 ASTNode* create_node(ASTNodeType type, const char* value, int line, int col); // Updated signature
 void print_ast(ASTNode* node, int level);
 const char* node_type_to_string(ASTNodeType type);
-void free_ast(ASTNode* node);
+// Dropping a subtree is free: its memory goes back with the arena.
+static inline void free_ast(ASTNode* node) { (void)node; }
 
 #endif // AST_TYPES_H
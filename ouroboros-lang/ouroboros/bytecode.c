@@ -0,0 +1,923 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+#include "eval.h" // For evaluate_expression, evaluate_binary_values
+#include "vm.h"   // For run_vm_node, find_user_function, vm_invoke_function
+#include "gc.h"
+
+// Shared operand stack. Each bytecode_execute call works above the caller's
+// top, so nested calls (direct or through the tree-walker) simply stack up.
+#define BYTECODE_STACK_MAX 65536
+static Value vm_stack[BYTECODE_STACK_MAX];
+static Value *vm_stack_top = vm_stack;
+
+void bytecode_mark_roots(void) {
+    for (Value *slot = vm_stack; slot < vm_stack_top; slot++) gc_mark_value(*slot);
+}
+
+static const char *opcode_names[] = {
+#define BYTECODE_NAME(name) #name,
+    BYTECODE_OPCODES(BYTECODE_NAME)
+#undef BYTECODE_NAME
+};
+
+// --- Compiler ---
+
+typedef struct LoopContext {
+    int continue_target;      // Code offset for 'continue', or -1 until known (for loops)
+    int *break_jumps;
+    int break_count;
+    int *continue_jumps;
+    int continue_count;
+    struct LoopContext *enclosing;
+} LoopContext;
+
+typedef struct Compiler {
+    BytecodeFunction *fn;
+    ASTNode *program;          // For looking up top-level function names
+    LoopContext *loop;
+    int stack_depth;
+    int last_op_offset;        // Start of the most recently emitted instruction; -1 at a jump target
+    int failed;                // Set when the body cannot be lowered faithfully
+} Compiler;
+
+static void compile_statement(Compiler *c, ASTNode *node);
+static void compile_expression(Compiler *c, ASTNode *node);
+
+static void* grow_array(void *array, int *capacity, size_t element_size) {
+    int new_capacity = *capacity ? *capacity * 2 : 16;
+    void *grown = realloc(array, (size_t)new_capacity * element_size);
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed while compiling bytecode\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = new_capacity;
+    return grown;
+}
+
+static void emit_byte(Compiler *c, uint8_t byte) {
+    BytecodeFunction *fn = c->fn;
+    if (fn->code_count == fn->code_capacity) {
+        fn->code = (uint8_t*)grow_array(fn->code, &fn->code_capacity, sizeof(uint8_t));
+    }
+    fn->code[fn->code_count++] = byte;
+}
+
+static void emit_u16(Compiler *c, int value) {
+    if (value < 0 || value > 0xFFFF) { c->failed = 1; value = 0; }
+    emit_byte(c, (uint8_t)(value & 0xFF));
+    emit_byte(c, (uint8_t)((value >> 8) & 0xFF));
+}
+
+// Emits an opcode and records its effect on the operand stack depth.
+static void emit_op(Compiler *c, OpCode op, int stack_effect) {
+    c->last_op_offset = c->fn->code_count;
+    emit_byte(c, (uint8_t)op);
+    c->stack_depth += stack_effect;
+    if (c->stack_depth > c->fn->max_stack) c->fn->max_stack = c->stack_depth;
+}
+
+static int add_constant(Compiler *c, Value value) {
+    BytecodeFunction *fn = c->fn;
+    for (int i = 0; i < fn->constant_count; i++) {
+        Value existing = fn->constants[i];
+        if (existing.type == value.type && existing.as.integer == value.as.integer) return i;
+    }
+    if (fn->constant_count == fn->constant_capacity) {
+        fn->constants = (Value*)grow_array(fn->constants, &fn->constant_capacity, sizeof(Value));
+    }
+    fn->constants[fn->constant_count] = value;
+    return fn->constant_count++;
+}
+
+static int add_node(Compiler *c, ASTNode *node) {
+    BytecodeFunction *fn = c->fn;
+    if (fn->node_count == fn->node_capacity) {
+        fn->nodes = (ASTNode**)grow_array(fn->nodes, &fn->node_capacity, sizeof(ASTNode*));
+    }
+    fn->nodes[fn->node_count] = node;
+    return fn->node_count++;
+}
+
+static int emit_jump(Compiler *c, OpCode op, int stack_effect) {
+    emit_op(c, op, stack_effect);
+    emit_byte(c, 0xFF);
+    emit_byte(c, 0xFF);
+    return c->fn->code_count - 2;
+}
+
+static void patch_jump(Compiler *c, int operand_offset) {
+    int distance = c->fn->code_count - (operand_offset + 2);
+    if (distance > 0xFFFF) { c->failed = 1; return; }
+    c->fn->code[operand_offset] = (uint8_t)(distance & 0xFF);
+    c->fn->code[operand_offset + 1] = (uint8_t)((distance >> 8) & 0xFF);
+    // Code here is reached from the jump too, so the previous instruction
+    // is no longer the only way in and must not be fused with what follows
+    c->last_op_offset = -1;
+}
+
+// Compiles a branch condition and returns the jump to patch for the false case.
+// A trailing local/constant comparison is fused into the jump.
+static int compile_condition_jump(Compiler *c, ASTNode *condition) {
+    compile_expression(c, condition);
+    int last = c->last_op_offset;
+    OpCode last_op = last >= 0 && last == c->fn->code_count - 5 ? (OpCode)c->fn->code[last] : OP_POP;
+    if (last_op >= OP_LT_LL && last_op <= OP_GE_LL) {
+        c->fn->code[last] = (uint8_t)(OP_JUMP_UNLESS_LT_LL + (last_op - OP_LT_LL));
+    } else if (last_op >= OP_LT_LK && last_op <= OP_GE_LK) {
+        c->fn->code[last] = (uint8_t)(OP_JUMP_UNLESS_LT_LK + (last_op - OP_LT_LK));
+    } else {
+        return emit_jump(c, OP_JUMP_IF_FALSE, -1);
+    }
+    c->stack_depth--; // The comparison result is no longer pushed
+    emit_byte(c, 0xFF);
+    emit_byte(c, 0xFF);
+    return c->fn->code_count - 2;
+}
+
+static void emit_loop(Compiler *c, int loop_start) {
+    emit_op(c, OP_LOOP, 0);
+    emit_u16(c, c->fn->code_count + 2 - loop_start);
+}
+
+static void record_jump(int **jumps, int *count, int offset) {
+    int *grown = (int*)realloc(*jumps, (size_t)(*count + 1) * sizeof(int));
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed while compiling bytecode\n");
+        exit(EXIT_FAILURE);
+    }
+    *jumps = grown;
+    (*jumps)[(*count)++] = offset;
+}
+
+// Hands the node to the tree-walker at runtime.
+static void emit_eval_ast(Compiler *c, ASTNode *node) {
+    emit_op(c, OP_EVAL_AST, 1);
+    emit_u16(c, add_node(c, node));
+}
+
+static int is_top_level_function(Compiler *c, const char *name) {
+    for (ASTNode *decl = c->program->left; decl; decl = decl->next) {
+        if ((decl->type == AST_FUNCTION || decl->type == AST_TYPED_FUNCTION) && strcmp(decl->value, name) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_assignment_op(const char *op) {
+    return (op[0] == '=' && op[1] == '\0') ||
+           ((op[0] == '+' || op[0] == '-' || op[0] == '*' || op[0] == '/' || op[0] == '%') && op[1] == '=' && op[2] == '\0');
+}
+
+static void emit_get_variable(Compiler *c, ASTNode *node) {
+    if (node->depth == 0) {
+        emit_op(c, OP_GET_LOCAL, 1);
+    } else {
+        emit_op(c, OP_GET_OUTER, 1);
+        emit_byte(c, (uint8_t)node->depth);
+    }
+    emit_u16(c, node->slot);
+}
+
+static void emit_set_variable(Compiler *c, ASTNode *node) {
+    if (node->depth == 0) {
+        emit_op(c, OP_SET_LOCAL, 0);
+    } else {
+        emit_op(c, OP_SET_OUTER, 0);
+        emit_byte(c, (uint8_t)node->depth);
+    }
+    emit_u16(c, node->slot);
+}
+
+static int is_slot_variable(ASTNode *node) {
+    return node && node->type == AST_IDENTIFIER && node->slot >= 0 && node->depth < 256;
+}
+
+static void compile_binary(Compiler *c, ASTNode *node) {
+    const char *op = node->value;
+
+    if (is_assignment_op(op)) {
+        if (!is_slot_variable(node->left)) { emit_eval_ast(c, node); return; }
+        // Same order as the tree-walker: right-hand side first, then the target
+        compile_expression(c, node->right);
+        if (op[0] != '=') {
+            emit_get_variable(c, node->left);
+            emit_op(c, OP_SWAP, 0);
+            char compound_op[2] = { op[0], '\0' };
+            emit_op(c, OP_BINARY, -1);
+            emit_u16(c, add_constant(c, value_intern(compound_op)));
+        }
+        emit_set_variable(c, node->left);
+        return;
+    }
+
+    if ((op[0] == '&' && op[1] == '&') || (op[0] == '|' && op[1] == '|')) {
+        int is_and = op[0] == '&';
+        compile_expression(c, node->left);
+        int short_circuit = emit_jump(c, is_and ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE, -1);
+        compile_expression(c, node->right);
+        emit_op(c, OP_TO_BOOL, 0);
+        int done = emit_jump(c, OP_JUMP, -1);
+        patch_jump(c, short_circuit);
+        emit_op(c, is_and ? OP_FALSE : OP_TRUE, 1);
+        patch_jump(c, done);
+        return;
+    }
+
+    OpCode opcode = OP_BINARY;
+    if (op[1] == '\0') {
+        switch (op[0]) {
+            case '+': opcode = OP_ADD; break;
+            case '-': opcode = OP_SUB; break;
+            case '*': opcode = OP_MUL; break;
+            case '/': opcode = OP_DIV; break;
+            case '%': opcode = OP_MOD; break;
+            case '<': opcode = OP_LT; break;
+            case '>': opcode = OP_GT; break;
+        }
+    } else if (op[1] == '=' && op[2] == '\0') {
+        switch (op[0]) {
+            case '=': opcode = OP_EQ; break;
+            case '!': opcode = OP_NE; break;
+            case '<': opcode = OP_LE; break;
+            case '>': opcode = OP_GE; break;
+        }
+    }
+
+    // local <op> local and local <op> number skip the operand pushes
+    int specialised = -1;
+    switch (opcode) {
+        case OP_ADD: specialised = 0; break;
+        case OP_SUB: specialised = 1; break;
+        case OP_MUL: specialised = 2; break;
+        case OP_LT: specialised = 3; break;
+        case OP_LE: specialised = 4; break;
+        case OP_GT: specialised = 5; break;
+        case OP_GE: specialised = 6; break;
+        default: break;
+    }
+    if (specialised >= 0 && is_slot_variable(node->left) && node->left->depth == 0) {
+        ASTNode *right = node->right;
+        if (is_slot_variable(right) && right->depth == 0) {
+            emit_op(c, (OpCode)(OP_ADD_LL + specialised), 1);
+            emit_u16(c, node->left->slot);
+            emit_u16(c, right->slot);
+            return;
+        }
+        if (right && right->type == AST_LITERAL) {
+            Value literal = value_from_literal(right->value, right->data_type);
+            if (IS_NUMBER(literal)) {
+                emit_op(c, (OpCode)(OP_ADD_LK + specialised), 1);
+                emit_u16(c, node->left->slot);
+                emit_u16(c, add_constant(c, literal));
+                return;
+            }
+        }
+    }
+
+    compile_expression(c, node->left);
+    compile_expression(c, node->right);
+    emit_op(c, opcode, -1);
+    if (opcode == OP_BINARY) emit_u16(c, add_constant(c, value_intern(op)));
+}
+
+static void compile_expression(Compiler *c, ASTNode *node) {
+    if (!node) { emit_op(c, OP_UNDEF, 1); return; }
+
+    switch (node->type) {
+        case AST_LITERAL: {
+            Value literal = value_from_literal(node->value, node->data_type);
+            switch (literal.type) {
+                case VAL_UNDEFINED: emit_op(c, OP_UNDEF, 1); break;
+                case VAL_NULL: emit_op(c, OP_NIL, 1); break;
+                case VAL_BOOL: emit_op(c, literal.as.boolean ? OP_TRUE : OP_FALSE, 1); break;
+                default:
+                    emit_op(c, OP_CONST, 1);
+                    emit_u16(c, add_constant(c, literal));
+                    break;
+            }
+            return;
+        }
+        case AST_IDENTIFIER:
+            if (is_slot_variable(node)) emit_get_variable(c, node);
+            else emit_eval_ast(c, node);
+            return;
+        case AST_THIS:
+            if (node->slot >= 0 && node->depth < 256) emit_get_variable(c, node);
+            else emit_eval_ast(c, node);
+            return;
+        case AST_BINARY_OP:
+            compile_binary(c, node);
+            return;
+        case AST_UNARY_OP: {
+            const char *op = node->value;
+            if (strcmp(op, "-") == 0) {
+                compile_expression(c, node->left);
+                emit_op(c, OP_NEG, 0);
+                emit_u16(c, add_node(c, node));
+            } else if (strcmp(op, "!") == 0) {
+                compile_expression(c, node->left);
+                emit_op(c, OP_NOT, 0);
+            } else if ((strcmp(op, "++") == 0 || strcmp(op, "--") == 0) &&
+                       is_slot_variable(node->left) && node->left->depth == 0) {
+                emit_op(c, OP_INC_LOCAL, 1);
+                emit_u16(c, node->left->slot);
+                emit_byte(c, (uint8_t)(int8_t)(op[0] == '+' ? 1 : -1));
+                emit_u16(c, add_node(c, node));
+            } else {
+                emit_eval_ast(c, node);
+            }
+            return;
+        }
+        case AST_TERNARY: {
+            int else_jump = compile_condition_jump(c, node->left);
+            compile_expression(c, node->right);
+            int done = emit_jump(c, OP_JUMP, -1);
+            patch_jump(c, else_jump);
+            compile_expression(c, node->next); // NULL compiles to undefined
+            patch_jump(c, done);
+            return;
+        }
+        case AST_CALL: {
+            // Plain calls to program functions take evaluated arguments directly;
+            // methods, builtins and everything else go through the tree-walker.
+            if (node->right || !is_top_level_function(c, node->value)) { emit_eval_ast(c, node); return; }
+            int argc = 0;
+            for (ASTNode *arg = node->left; arg; arg = arg->next) {
+                compile_expression(c, arg);
+                argc++;
+            }
+            if (argc > 255) { c->failed = 1; return; }
+            emit_op(c, OP_CALL, 1 - argc);
+            emit_u16(c, add_constant(c, value_intern(node->value)));
+            emit_byte(c, (uint8_t)argc);
+            emit_u16(c, c->fn->call_site_count++);
+            return;
+        }
+        default:
+            emit_eval_ast(c, node);
+            return;
+    }
+}
+
+static Value typed_default_value(ASTNode *decl) {
+    if (decl->type != AST_TYPED_VAR_DECL) return value_undefined();
+    if (strcmp(decl->data_type, "int") == 0 || strcmp(decl->data_type, "long") == 0) return value_int(0);
+    if (strcmp(decl->data_type, "float") == 0 || strcmp(decl->data_type, "double") == 0) return value_double(0.0);
+    if (strcmp(decl->data_type, "bool") == 0) return value_bool(0);
+    if (strcmp(decl->data_type, "string") == 0) return value_intern("");
+    return value_undefined();
+}
+
+// Evaluates node for its side effects only. A trailing SET_LOCAL + POP pair
+// becomes STORE_LOCAL, the common shape of assignment statements.
+static void compile_discarded(Compiler *c, ASTNode *node) {
+    compile_expression(c, node);
+    int set_at = c->last_op_offset;
+    if (node->type == AST_BINARY_OP && set_at >= 0 && set_at == c->fn->code_count - 3 &&
+        c->fn->code[set_at] == OP_SET_LOCAL) {
+        c->fn->code[set_at] = OP_STORE_LOCAL;
+        c->stack_depth--;
+    } else {
+        emit_op(c, OP_POP, -1);
+    }
+}
+
+static void compile_block(Compiler *c, ASTNode *first_stmt) {
+    for (ASTNode *stmt = first_stmt; stmt && !c->failed; stmt = stmt->next) {
+        compile_statement(c, stmt);
+    }
+}
+
+static void begin_loop(Compiler *c, LoopContext *loop, int continue_target) {
+    memset(loop, 0, sizeof(*loop));
+    loop->continue_target = continue_target;
+    loop->enclosing = c->loop;
+    c->loop = loop;
+}
+
+static void end_loop(Compiler *c, LoopContext *loop) {
+    for (int i = 0; i < loop->break_count; i++) patch_jump(c, loop->break_jumps[i]);
+    free(loop->break_jumps);
+    free(loop->continue_jumps);
+    c->loop = loop->enclosing;
+}
+
+static void compile_statement(Compiler *c, ASTNode *node) {
+    switch (node->type) {
+        case AST_FUNCTION: case AST_TYPED_FUNCTION: case AST_CLASS_METHOD:
+        case AST_CLASS: case AST_STRUCT: case AST_IMPORT: case AST_ELSE:
+            return; // Declarations are registered by run_vm; else-branches belong to their if
+        case AST_BLOCK:
+            compile_block(c, node->left);
+            return;
+        case AST_PRINT:
+            compile_expression(c, node->left);
+            emit_op(c, OP_PRINT, -1);
+            return;
+        case AST_VAR_DECL: case AST_TYPED_VAR_DECL: {
+            if (node->slot < 0) { emit_op(c, OP_EXEC_AST, 0); emit_u16(c, add_node(c, node)); return; }
+            if (node->right) {
+                compile_expression(c, node->right);
+            } else {
+                Value initial_value = typed_default_value(node);
+                if (initial_value.type == VAL_UNDEFINED) {
+                    emit_op(c, OP_UNDEF, 1);
+                } else {
+                    emit_op(c, OP_CONST, 1);
+                    emit_u16(c, add_constant(c, initial_value));
+                }
+            }
+            emit_op(c, OP_STORE_LOCAL, -1);
+            emit_u16(c, node->slot);
+            return;
+        }
+        case AST_ASSIGN:
+            if (node->left && is_slot_variable(node->left)) {
+                compile_expression(c, node->right);
+                emit_set_variable(c, node->left);
+                emit_op(c, OP_POP, -1);
+            } else {
+                emit_op(c, OP_EXEC_AST, 0);
+                emit_u16(c, add_node(c, node));
+            }
+            return;
+        case AST_RETURN:
+            if (node->left) {
+                compile_expression(c, node->left);
+                emit_op(c, OP_RETURN, -1);
+            } else {
+                emit_op(c, OP_RETURN_UNDEF, 0);
+            }
+            return;
+        case AST_IF: {
+            int else_jump = compile_condition_jump(c, node->left);
+            if (node->right) compile_statement(c, node->right);
+            if (node->next && node->next->type == AST_ELSE) {
+                int done = emit_jump(c, OP_JUMP, 0);
+                patch_jump(c, else_jump);
+                if (node->next->left) compile_statement(c, node->next->left);
+                patch_jump(c, done);
+            } else {
+                patch_jump(c, else_jump);
+            }
+            return;
+        }
+        case AST_WHILE: {
+            LoopContext loop;
+            int loop_start = c->fn->code_count;
+            begin_loop(c, &loop, loop_start);
+            int exit_jump = compile_condition_jump(c, node->left);
+            if (node->right) compile_statement(c, node->right);
+            emit_loop(c, loop_start);
+            patch_jump(c, exit_jump);
+            end_loop(c, &loop);
+            return;
+        }
+        case AST_FOR: {
+            ASTNode *init_expr = node->left;
+            ASTNode *cond_expr = init_expr ? init_expr->next : NULL;
+            ASTNode *incr_expr = cond_expr ? cond_expr->next : NULL;
+
+            if (init_expr) {
+                if (init_expr->type == AST_VAR_DECL || init_expr->type == AST_TYPED_VAR_DECL) {
+                    compile_statement(c, init_expr);
+                } else {
+                    compile_discarded(c, init_expr);
+                }
+            }
+            LoopContext loop;
+            int loop_start = c->fn->code_count;
+            begin_loop(c, &loop, -1);
+            int exit_jump = -1;
+            if (cond_expr) exit_jump = compile_condition_jump(c, cond_expr);
+            if (node->right) compile_statement(c, node->right);
+            for (int i = 0; i < loop.continue_count; i++) patch_jump(c, loop.continue_jumps[i]);
+            if (incr_expr) compile_discarded(c, incr_expr);
+            emit_loop(c, loop_start);
+            if (exit_jump >= 0) patch_jump(c, exit_jump);
+            end_loop(c, &loop);
+            return;
+        }
+        case AST_BREAK:
+            if (!c->loop) { c->failed = 1; return; }
+            record_jump(&c->loop->break_jumps, &c->loop->break_count, emit_jump(c, OP_JUMP, 0));
+            return;
+        case AST_CONTINUE:
+            if (!c->loop) { c->failed = 1; return; }
+            if (c->loop->continue_target >= 0) emit_loop(c, c->loop->continue_target);
+            else record_jump(&c->loop->continue_jumps, &c->loop->continue_count, emit_jump(c, OP_JUMP, 0));
+            return;
+        case AST_CALL: case AST_BINARY_OP: case AST_UNARY_OP: case AST_LITERAL:
+        case AST_IDENTIFIER: case AST_MEMBER_ACCESS: case AST_NEW:
+            compile_discarded(c, node);
+            return;
+        default:
+            // Statements without control flow of their own (e.g. AST_ASSIGN to a member)
+            emit_op(c, OP_EXEC_AST, 0);
+            emit_u16(c, add_node(c, node));
+            return;
+    }
+}
+
+static void free_function(BytecodeFunction *fn) {
+    if (!fn) return;
+    free(fn->code);
+    free(fn->constants);
+    free(fn->nodes);
+    free(fn->call_cache);
+    free(fn);
+}
+
+static BytecodeFunction* compile_body(ASTNode *decl, ASTNode *first_stmt, ASTNode *program) {
+    BytecodeFunction *fn = (BytecodeFunction*)calloc(1, sizeof(BytecodeFunction));
+    if (!fn) {
+        fprintf(stderr, "Error: Memory allocation failed while compiling bytecode\n");
+        exit(EXIT_FAILURE);
+    }
+    fn->decl = decl;
+
+    Compiler compiler = { fn, program, NULL, 0, 0, 0 };
+    compile_block(&compiler, first_stmt);
+    emit_op(&compiler, OP_RETURN_UNDEF, 0);
+
+    if (compiler.failed) {
+        free_function(fn);
+        return NULL;
+    }
+    if (fn->call_site_count > 0) {
+        fn->call_cache = (ASTNode**)calloc((size_t)fn->call_site_count, sizeof(ASTNode*));
+        if (!fn->call_cache) {
+            fprintf(stderr, "Error: Memory allocation failed while compiling bytecode\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return fn;
+}
+
+// Compiles every resolved function reachable from node, including function
+// expressions and class methods.
+static void compile_functions_in(ASTNode *node, ASTNode *program) {
+    for (; node; node = node->next) {
+        if ((node->type == AST_FUNCTION || node->type == AST_TYPED_FUNCTION || node->type == AST_CLASS_METHOD) &&
+            node->local_count >= 0 && !node->bytecode) {
+            ASTNode *body = node->right;
+            node->bytecode = compile_body(node, body && body->type == AST_BLOCK ? body->left : body, program);
+        }
+        compile_functions_in(node->left, program);
+        compile_functions_in(node->right, program);
+    }
+}
+
+void bytecode_compile_program(ASTNode *program) {
+    if (!program || program->type != AST_PROGRAM || program->local_count < 0) return;
+    compile_functions_in(program->left, program);
+    program->bytecode = compile_body(program, program->left, program);
+}
+
+static void free_functions_in(ASTNode *node) {
+    for (; node; node = node->next) {
+        if (node->bytecode) {
+            free_function(node->bytecode);
+            node->bytecode = NULL;
+        }
+        free_functions_in(node->left);
+        free_functions_in(node->right);
+    }
+}
+
+void bytecode_free_program(ASTNode *program) {
+    if (!program) return;
+    free_functions_in(program->left);
+    free_function(program->bytecode);
+    program->bytecode = NULL;
+}
+
+// --- Interpreter ---
+
+static Value negate_value(ASTNode *node, Value operand) {
+    if (operand.type == VAL_INT) return value_int(-operand.as.integer);
+    if (operand.type == VAL_DOUBLE) return value_double(-operand.as.number);
+    if (!value_is_numeric(operand)) {
+        char buf[64];
+        fprintf(stderr, "Error (L%d:%d): Unary '-' requires numeric operand, got '%s'.\n", node->line, node->col, value_to_cstring(operand, buf, sizeof(buf)));
+        return value_undefined();
+    }
+    return value_double(-value_as_number(operand));
+}
+
+Value bytecode_execute(BytecodeFunction *fn, StackFrame *frame) {
+    Value *base = vm_stack_top;
+    if (base + fn->max_stack >= vm_stack + BYTECODE_STACK_MAX) {
+        fprintf(stderr, "[RUNTIME] Error: Stack overflow in '%s'\n", fn->decl->value);
+        return value_undefined();
+    }
+    Value *sp = base;
+    Value *slots = frame->slots;
+    const uint8_t *ip = fn->code;
+    Value result = value_undefined();
+
+#define READ_BYTE() (*ip++)
+#define READ_U16() (ip += 2, (int)(ip[-2] | (ip[-1] << 8)))
+#define PUSH(v) (*sp++ = (v))
+#define POP() (*--sp)
+#define PEEK() (sp[-1])
+// Calls out may re-enter bytecode_execute, which allocates above vm_stack_top
+#define SYNC_STACK() (vm_stack_top = sp)
+// Comparisons produce bools, so test those inline
+#define IS_TRUTHY(v) ((v).type == VAL_BOOL ? (v).as.boolean : value_is_truthy(v))
+
+#if defined(__GNUC__) || defined(__clang__)
+    static void *dispatch_table[] = {
+#define BYTECODE_LABEL(name) &&op_##name,
+        BYTECODE_OPCODES(BYTECODE_LABEL)
+#undef BYTECODE_LABEL
+    };
+#define DISPATCH() goto *dispatch_table[READ_BYTE()]
+#define TARGET(name) op_##name:
+    DISPATCH();
+#else
+#define DISPATCH() goto dispatch
+#define TARGET(name) case OP_##name:
+dispatch:
+    switch (READ_BYTE()) {
+#endif
+
+    TARGET(CONST) PUSH(fn->constants[READ_U16()]); DISPATCH();
+    TARGET(UNDEF) PUSH(value_undefined()); DISPATCH();
+    TARGET(NIL) PUSH(value_null()); DISPATCH();
+    TARGET(TRUE) PUSH(value_bool(1)); DISPATCH();
+    TARGET(FALSE) PUSH(value_bool(0)); DISPATCH();
+    TARGET(POP) sp--; DISPATCH();
+    TARGET(SWAP) { Value top = sp[-1]; sp[-1] = sp[-2]; sp[-2] = top; DISPATCH(); }
+    TARGET(GET_LOCAL) PUSH(slots[READ_U16()]); DISPATCH();
+    TARGET(SET_LOCAL) slots[READ_U16()] = PEEK(); DISPATCH();
+    TARGET(STORE_LOCAL) slots[READ_U16()] = POP(); DISPATCH();
+    TARGET(GET_OUTER) {
+        int depth = READ_BYTE();
+        Value *outer = frame_slot(frame, depth, READ_U16());
+        PUSH(outer ? *outer : value_undefined());
+        DISPATCH();
+    }
+    TARGET(SET_OUTER) {
+        int depth = READ_BYTE();
+        Value *outer = frame_slot(frame, depth, READ_U16());
+        if (outer) *outer = PEEK();
+        DISPATCH();
+    }
+    TARGET(INC_LOCAL) {
+        Value *target = &slots[READ_U16()];
+        int delta = (int8_t)READ_BYTE();
+        ASTNode *node = fn->nodes[READ_U16()];
+        if (target->type == VAL_INT) {
+            target->as.integer += delta;
+            PUSH(*target);
+        } else if (!value_is_numeric(*target)) {
+            char buf[64];
+            fprintf(stderr, "Error (L%d:%d): '%s' operator requires numeric operand, got '%s'.\n", node->line, node->col, node->value, value_to_cstring(*target, buf, sizeof(buf)));
+            PUSH(value_undefined());
+        } else {
+            *target = target->type == VAL_DOUBLE ? value_double(target->as.number + delta)
+                                                 : value_int(value_as_int(*target) + delta);
+            PUSH(*target);
+        }
+        DISPATCH();
+    }
+
+// Integer fast path, then doubles, then the shared tree-walker semantics
+#define ARITH(c_op, op_text, l, r) \
+        ((l).type == VAL_INT && (r).type == VAL_INT ? value_int((l).as.integer c_op (r).as.integer) : \
+         IS_NUMBER(l) && IS_NUMBER(r) ? value_double(value_as_number(l) c_op value_as_number(r)) : \
+         evaluate_binary_values(op_text, l, r))
+#define COMPARE(c_op, op_text, l, r) \
+        ((l).type == VAL_INT && (r).type == VAL_INT ? value_bool((l).as.integer c_op (r).as.integer) : \
+         IS_NUMBER(l) && IS_NUMBER(r) ? value_bool(value_as_number(l) c_op value_as_number(r)) : \
+         evaluate_binary_values(op_text, l, r))
+#define STACK_OP(kind, c_op, op_text) { Value right = POP(); Value left = sp[-1]; sp[-1] = kind(c_op, op_text, left, right); DISPATCH(); }
+#define LOCALS_OP(kind, c_op, op_text) { Value left = slots[READ_U16()]; Value right = slots[READ_U16()]; PUSH(kind(c_op, op_text, left, right)); DISPATCH(); }
+#define CONST_OP(kind, c_op, op_text) { Value left = slots[READ_U16()]; Value right = fn->constants[READ_U16()]; PUSH(kind(c_op, op_text, left, right)); DISPATCH(); }
+
+    TARGET(ADD) STACK_OP(ARITH, +, "+")
+    TARGET(SUB) STACK_OP(ARITH, -, "-")
+    TARGET(MUL) STACK_OP(ARITH, *, "*")
+    TARGET(DIV) {
+        Value right = POP(); Value left = PEEK();
+        if (left.type == VAL_INT && right.type == VAL_INT && right.as.integer != 0 && left.as.integer % right.as.integer == 0) {
+            sp[-1] = value_int(left.as.integer / right.as.integer);
+        } else {
+            sp[-1] = evaluate_binary_values("/", left, right);
+        }
+        DISPATCH();
+    }
+    TARGET(MOD) {
+        Value right = POP(); Value left = PEEK();
+        if (left.type == VAL_INT && right.type == VAL_INT && right.as.integer != 0) sp[-1] = value_int(left.as.integer % right.as.integer);
+        else sp[-1] = evaluate_binary_values("%", left, right);
+        DISPATCH();
+    }
+    TARGET(EQ) { Value right = POP(); sp[-1] = value_bool(value_equals(sp[-1], right)); DISPATCH(); }
+    TARGET(NE) { Value right = POP(); sp[-1] = value_bool(!value_equals(sp[-1], right)); DISPATCH(); }
+    TARGET(LT) STACK_OP(COMPARE, <, "<")
+    TARGET(LE) STACK_OP(COMPARE, <=, "<=")
+    TARGET(GT) STACK_OP(COMPARE, >, ">")
+    TARGET(GE) STACK_OP(COMPARE, >=, ">=")
+    TARGET(ADD_LL) LOCALS_OP(ARITH, +, "+")
+    TARGET(SUB_LL) LOCALS_OP(ARITH, -, "-")
+    TARGET(MUL_LL) LOCALS_OP(ARITH, *, "*")
+    TARGET(LT_LL) LOCALS_OP(COMPARE, <, "<")
+    TARGET(LE_LL) LOCALS_OP(COMPARE, <=, "<=")
+    TARGET(GT_LL) LOCALS_OP(COMPARE, >, ">")
+    TARGET(GE_LL) LOCALS_OP(COMPARE, >=, ">=")
+    TARGET(ADD_LK) CONST_OP(ARITH, +, "+")
+    TARGET(SUB_LK) CONST_OP(ARITH, -, "-")
+    TARGET(MUL_LK) CONST_OP(ARITH, *, "*")
+    TARGET(LT_LK) CONST_OP(COMPARE, <, "<")
+    TARGET(LE_LK) CONST_OP(COMPARE, <=, "<=")
+    TARGET(GT_LK) CONST_OP(COMPARE, >, ">")
+    TARGET(GE_LK) CONST_OP(COMPARE, >=, ">=")
+
+#define BRANCH_LL(c_op, op_text) { \
+        Value left = slots[READ_U16()]; Value right = slots[READ_U16()]; int offset = READ_U16(); \
+        int holds = left.type == VAL_INT && right.type == VAL_INT ? left.as.integer c_op right.as.integer \
+                                                                  : value_is_truthy(COMPARE(c_op, op_text, left, right)); \
+        if (!holds) ip += offset; \
+        DISPATCH(); }
+#define BRANCH_LK(c_op, op_text) { \
+        Value left = slots[READ_U16()]; Value right = fn->constants[READ_U16()]; int offset = READ_U16(); \
+        int holds = left.type == VAL_INT && right.type == VAL_INT ? left.as.integer c_op right.as.integer \
+                                                                  : value_is_truthy(COMPARE(c_op, op_text, left, right)); \
+        if (!holds) ip += offset; \
+        DISPATCH(); }
+    TARGET(JUMP_UNLESS_LT_LL) BRANCH_LL(<, "<")
+    TARGET(JUMP_UNLESS_LE_LL) BRANCH_LL(<=, "<=")
+    TARGET(JUMP_UNLESS_GT_LL) BRANCH_LL(>, ">")
+    TARGET(JUMP_UNLESS_GE_LL) BRANCH_LL(>=, ">=")
+    TARGET(JUMP_UNLESS_LT_LK) BRANCH_LK(<, "<")
+    TARGET(JUMP_UNLESS_LE_LK) BRANCH_LK(<=, "<=")
+    TARGET(JUMP_UNLESS_GT_LK) BRANCH_LK(>, ">")
+    TARGET(JUMP_UNLESS_GE_LK) BRANCH_LK(>=, ">=")
+#undef BRANCH_LL
+#undef BRANCH_LK
+#undef ARITH
+#undef COMPARE
+#undef STACK_OP
+#undef LOCALS_OP
+#undef CONST_OP
+    TARGET(BINARY) {
+        Value op_text = fn->constants[READ_U16()];
+        Value right = POP();
+        sp[-1] = evaluate_binary_values(op_text.as.string->chars, sp[-1], right);
+        DISPATCH();
+    }
+    TARGET(NEG) {
+        ASTNode *node = fn->nodes[READ_U16()];
+        sp[-1] = negate_value(node, sp[-1]);
+        DISPATCH();
+    }
+    TARGET(NOT) sp[-1] = value_bool(!value_is_truthy(sp[-1])); DISPATCH();
+    TARGET(TO_BOOL) sp[-1] = value_bool(value_is_truthy(sp[-1])); DISPATCH();
+    TARGET(JUMP) { int offset = READ_U16(); ip += offset; DISPATCH(); }
+    TARGET(JUMP_IF_FALSE) { int offset = READ_U16(); Value cond = POP(); if (!IS_TRUTHY(cond)) ip += offset; DISPATCH(); }
+    TARGET(JUMP_IF_TRUE) { int offset = READ_U16(); Value cond = POP(); if (IS_TRUTHY(cond)) ip += offset; DISPATCH(); }
+    TARGET(LOOP) {
+        int offset = READ_U16();
+        ip -= offset;
+        if (gc_pending) { SYNC_STACK(); gc_collect(); } // Back-edges are the loop's safe point
+        DISPATCH();
+    }
+    TARGET(CALL) {
+        Value name = fn->constants[READ_U16()];
+        int argc = READ_BYTE();
+        int site = READ_U16();
+        ASTNode *callee = fn->call_cache[site];
+        if (!callee) callee = fn->call_cache[site] = find_user_function(name.as.string->chars, NULL);
+        Value *args = sp - argc;
+        Value call_result;
+        SYNC_STACK();
+        if (callee) {
+            call_result = vm_invoke_function(callee, value_undefined(), args, argc, frame);
+        } else {
+            fprintf(stderr, "Error: Function '%s' not found\n", name.as.string->chars);
+            call_result = value_undefined();
+        }
+        sp = args;
+        PUSH(call_result);
+        DISPATCH();
+    }
+    TARGET(EVAL_AST) {
+        ASTNode *node = fn->nodes[READ_U16()];
+        SYNC_STACK();
+        Value value = evaluate_expression(node, frame);
+        PUSH(value);
+        DISPATCH();
+    }
+    TARGET(EXEC_AST) {
+        ASTNode *node = fn->nodes[READ_U16()];
+        SYNC_STACK();
+        run_vm_node(node, frame);
+        DISPATCH();
+    }
+    TARGET(PRINT) {
+        char print_buf[64];
+        printf("[OUTPUT] %s\n", value_to_cstring(POP(), print_buf, sizeof(print_buf)));
+        fflush(stdout);
+        DISPATCH();
+    }
+    TARGET(RETURN) result = POP(); goto done;
+    TARGET(RETURN_UNDEF) goto done;
+
+#if !(defined(__GNUC__) || defined(__clang__))
+    }
+#endif
+
+done:
+    vm_stack_top = base;
+    return result;
+
+#undef READ_BYTE
+#undef READ_U16
+#undef PUSH
+#undef POP
+#undef PEEK
+#undef SYNC_STACK
+#undef IS_TRUTHY
+#undef DISPATCH
+#undef TARGET
+}
+
+// --- Disassembler (-print-bytecode) ---
+
+void bytecode_disassemble(const BytecodeFunction *fn) {
+    if (!fn) return;
+    printf("== %s (%d bytes, %d constants, max stack %d) ==\n",
+           fn->decl->type == AST_PROGRAM ? "<script>" : fn->decl->value, fn->code_count, fn->constant_count, fn->max_stack);
+    int offset = 0;
+    while (offset < fn->code_count) {
+        const uint8_t *ip = fn->code + offset;
+        OpCode op = (OpCode)ip[0];
+        printf("%04d  %-14s", offset, op < OP_COUNT ? opcode_names[op] : "???");
+        int u16 = fn->code_count > offset + 2 ? (ip[1] | (ip[2] << 8)) : 0;
+        char value_buf[64];
+        switch (op) {
+            case OP_CONST: case OP_BINARY:
+                printf(" %d (%s)", u16, value_to_cstring(fn->constants[u16], value_buf, sizeof(value_buf)));
+                offset += 3; break;
+            case OP_GET_LOCAL: case OP_SET_LOCAL: case OP_STORE_LOCAL: {
+                const char *name = fn->decl->local_names && u16 < fn->decl->local_count ? fn->decl->local_names[u16] : "?";
+                printf(" %d (%s)", u16, name);
+                offset += 3; break;
+            }
+            case OP_ADD_LL: case OP_SUB_LL: case OP_MUL_LL: case OP_LT_LL: case OP_LE_LL: case OP_GT_LL: case OP_GE_LL:
+                printf(" %d, %d", u16, ip[3] | (ip[4] << 8));
+                offset += 5; break;
+            case OP_ADD_LK: case OP_SUB_LK: case OP_MUL_LK: case OP_LT_LK: case OP_LE_LK: case OP_GT_LK: case OP_GE_LK:
+                printf(" %d, %s", u16, value_to_cstring(fn->constants[ip[3] | (ip[4] << 8)], value_buf, sizeof(value_buf)));
+                offset += 5; break;
+            case OP_JUMP_UNLESS_LT_LL: case OP_JUMP_UNLESS_LE_LL: case OP_JUMP_UNLESS_GT_LL: case OP_JUMP_UNLESS_GE_LL:
+                printf(" %d, %d -> %04d", u16, ip[3] | (ip[4] << 8), offset + 7 + (ip[5] | (ip[6] << 8)));
+                offset += 7; break;
+            case OP_JUMP_UNLESS_LT_LK: case OP_JUMP_UNLESS_LE_LK: case OP_JUMP_UNLESS_GT_LK: case OP_JUMP_UNLESS_GE_LK:
+                printf(" %d, %s -> %04d", u16, value_to_cstring(fn->constants[ip[3] | (ip[4] << 8)], value_buf, sizeof(value_buf)),
+                       offset + 7 + (ip[5] | (ip[6] << 8)));
+                offset += 7; break;
+            case OP_GET_OUTER: case OP_SET_OUTER:
+                printf(" depth %d, slot %d", ip[1], ip[2] | (ip[3] << 8));
+                offset += 4; break;
+            case OP_INC_LOCAL:
+                printf(" %d, %+d", u16, (int8_t)ip[3]);
+                offset += 6; break;
+            case OP_JUMP: case OP_JUMP_IF_FALSE: case OP_JUMP_IF_TRUE:
+                printf(" -> %04d", offset + 3 + u16);
+                offset += 3; break;
+            case OP_LOOP:
+                printf(" -> %04d", offset + 3 - u16);
+                offset += 3; break;
+            case OP_CALL:
+                printf(" %s/%d", fn->constants[u16].as.string->chars, ip[3]);
+                offset += 6; break;
+            case OP_EVAL_AST: case OP_EXEC_AST: case OP_NEG:
+                printf(" %s", node_type_to_string(fn->nodes[u16]->type));
+                offset += 3; break;
+            default:
+                offset += 1; break;
+        }
+        printf("\n");
+    }
+}
+
+static void disassemble_functions_in(ASTNode *node) {
+    for (; node; node = node->next) {
+        if (node->bytecode) bytecode_disassemble(node->bytecode);
+        else if ((node->type == AST_FUNCTION || node->type == AST_TYPED_FUNCTION || node->type == AST_CLASS_METHOD))
+            printf("== %s (tree-walked) ==\n", node->value);
+        disassemble_functions_in(node->left);
+        disassemble_functions_in(node->right);
+    }
+}
+
+void bytecode_disassemble_program(ASTNode *program) {
+    if (!program) return;
+    printf("\n==== Bytecode ====\n");
+    disassemble_functions_in(program->left);
+    bytecode_disassemble(program->bytecode);
+}
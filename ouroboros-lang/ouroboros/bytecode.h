@@ -0,0 +1,96 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+#include "ast_types.h"
+#include "stack.h"
+#include "value.h"
+
+// Bytecode backend (-bytecode). After optimize_ast, every resolved function
+// body and the top-level script are lowered into a stack-machine instruction
+// stream with a constant pool. Locals live in the StackFrame slots assigned by
+// resolve_program, so bytecode and tree-walked code share frames: constructs
+// the compiler does not lower are executed by the tree-walker in place
+// (OP_EVAL_AST / OP_EXEC_AST).
+//
+// Operands follow the opcode byte, little-endian. u16 = 2 bytes, u8/i8 = 1 byte.
+#define BYTECODE_OPCODES(X) \
+    X(CONST)         /* u16 constant             -> value */ \
+    X(UNDEF)         /*                          -> undefined */ \
+    X(NIL)           /*                          -> null */ \
+    X(TRUE)          /*                          -> true */ \
+    X(FALSE)         /*                          -> false */ \
+    X(POP)           /* value                    -> */ \
+    X(SWAP)          /* a b                      -> b a */ \
+    X(GET_LOCAL)     /* u16 slot                 -> value */ \
+    X(SET_LOCAL)     /* u16 slot; value          -> value */ \
+    X(STORE_LOCAL)   /* u16 slot; value          -> (SET_LOCAL + POP) */ \
+    X(GET_OUTER)     /* u8 depth, u16 slot       -> value */ \
+    X(SET_OUTER)     /* u8 depth, u16 slot; value -> value */ \
+    X(INC_LOCAL)     /* u16 slot, i8 delta, u16 node -> new value */ \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) \
+    X(EQ) X(NE) X(LT) X(LE) X(GT) X(GE) \
+    X(BINARY)        /* u16 constant (operator text); a b -> result */ \
+    /* Operand-specialised forms: read a local slot and a second slot (LL) or */ \
+    /* constant (LK) directly instead of pushing both. u16 slot, u16 slot/constant -> result */ \
+    X(ADD_LL) X(SUB_LL) X(MUL_LL) X(LT_LL) X(LE_LL) X(GT_LL) X(GE_LL) \
+    X(ADD_LK) X(SUB_LK) X(MUL_LK) X(LT_LK) X(LE_LK) X(GT_LK) X(GE_LK) \
+    /* Comparison fused with the following conditional jump: jumps forward */ \
+    /* unless the comparison holds. u16 slot, u16 slot/constant, u16 offset */ \
+    X(JUMP_UNLESS_LT_LL) X(JUMP_UNLESS_LE_LL) X(JUMP_UNLESS_GT_LL) X(JUMP_UNLESS_GE_LL) \
+    X(JUMP_UNLESS_LT_LK) X(JUMP_UNLESS_LE_LK) X(JUMP_UNLESS_GT_LK) X(JUMP_UNLESS_GE_LK) \
+    X(NEG)           /* u16 node (for errors); value -> -value */ \
+    X(NOT)           /* value                    -> bool */ \
+    X(TO_BOOL)       /* value                    -> bool */ \
+    X(JUMP)          /* u16 forward offset */ \
+    X(JUMP_IF_FALSE) /* u16 forward offset; pops the condition */ \
+    X(JUMP_IF_TRUE)  /* u16 forward offset; pops the condition */ \
+    X(LOOP)          /* u16 backward offset */ \
+    X(CALL)          /* u16 name constant, u8 argc, u16 call site; args -> result */ \
+    X(EVAL_AST)      /* u16 node                 -> evaluate_expression(node) */ \
+    X(EXEC_AST)      /* u16 node; run_vm_node(node) */ \
+    X(PRINT)         /* value                    -> */ \
+    X(RETURN)        /* value; leaves the function */ \
+    X(RETURN_UNDEF)
+
+typedef enum {
+#define BYTECODE_ENUM(name) OP_##name,
+    BYTECODE_OPCODES(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+    OP_COUNT
+} OpCode;
+
+// Compiled body of one function (or of the top-level script)
+typedef struct BytecodeFunction {
+    ASTNode *decl;            // Function node, or the AST_PROGRAM root for the script
+    uint8_t *code;
+    int code_count;
+    int code_capacity;
+    Value *constants;
+    int constant_count;
+    int constant_capacity;
+    ASTNode **nodes;          // AST fallbacks referenced by EVAL_AST/EXEC_AST/NEG/INC_LOCAL
+    int node_count;
+    int node_capacity;
+    ASTNode **call_cache;     // Callee per CALL site, filled on first execution
+    int call_site_count;
+    int max_stack;            // Deepest operand stack use, checked on entry
+} BytecodeFunction;
+
+// Compiles the script and every resolved function in the program, storing the
+// result in each node's `bytecode` field. Functions that cannot be lowered
+// keep bytecode == NULL and run on the tree-walker.
+void bytecode_compile_program(ASTNode *program);
+void bytecode_free_program(ASTNode *program);
+
+// Runs a compiled body in `frame` (already holding the arguments) and returns
+// the function's return value.
+Value bytecode_execute(BytecodeFunction *fn, StackFrame *frame);
+
+// Marks the values on the shared operand stack (a collector root)
+void bytecode_mark_roots(void);
+
+void bytecode_disassemble(const BytecodeFunction *fn);
+void bytecode_disassemble_program(ASTNode *program);
+
+#endif // BYTECODE_H
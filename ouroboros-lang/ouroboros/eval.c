@@ -6,34 +6,23 @@
 #include "eval.h"
 #include "ast_types.h"
 #include "vm.h" // For Object, find_object_by_id, find_static_class_object, current_class, execute_function_call, etc.
+#include "gc.h"
 #include "semantic.h" // For Symbol, SymbolTable related types (if needed directly, though usually through vm)
 
-#define MAX_RESULT_LENGTH 1024
-
-extern ASTNode *program; 
-static char result_buffer[1024]; // Static buffer for string results of operations
-
-// Forward declarations for VM helpers when vm.h not available in include path
-#ifndef VM_HELPERS_DECL
-#define VM_HELPERS_DECL
-extern Object* create_object(const char *class_name);
-extern void set_object_property(Object *obj, const char *name, const char *value);
-extern void register_user_function(ASTNode *func_node);
-extern ASTNode* find_user_function(const char *name, const char *class_name);
-#endif
+extern ASTNode *program;
 
 // Helper function to check if a string represents a number
 int is_numeric_string(const char* str) {
     if (!str || !*str) return 0;
-    
+
     // Check for negative sign
     if (*str == '-') str++;
-    
+
     // Empty string after negative sign or just a negative sign is not a number
     if (!*str) return 0;
-    
+
     int has_decimal = 0;
-    
+
     while (*str) {
         if (*str == '.') {
             // Only one decimal point allowed
@@ -44,605 +33,482 @@ int is_numeric_string(const char* str) {
         }
         str++;
     }
-    
+
     return 1;
 }
 
-// Forward declarations for internal functions
-#define LOCAL_COPY_IF_ALIAS(ptr, bufname) \
-    const char *bufname = (ptr);          \
-    char bufname##_copy[512];             \
-    if ((ptr) == result_buffer) {         \
-        strncpy(bufname##_copy, (ptr), sizeof(bufname##_copy)-1); \
-        bufname##_copy[sizeof(bufname##_copy)-1] = '\0';          \
-        bufname = bufname##_copy;         \
+static Value assign_to_target(ASTNode *target_node, Value new_value, StackFrame *frame);
+
+// Splits the text of a pseudo-array ("[a,[b,c],d]") and returns element `index`
+// as a typed value. Nested brackets are skipped so that commas inside
+// sub-arrays are ignored.
+static int pseudo_array_element(const char *text, int64_t index, Value *out) {
+    char token_buf[512]; int token_len = 0; int depth = 0; int64_t curr_idx = 0; int found = 0;
+    const char *p = text + 1; /* skip opening '[' */
+    for (; *p && !(depth == 0 && *p == ']'); ++p) {
+        char ch = *p;
+        if (ch == '[') { depth++; token_buf[token_len++] = ch; }
+        else if (ch == ']') { depth--; token_buf[token_len++] = ch; }
+        else if (ch == ',' && depth == 0) {
+            token_buf[token_len] = '\0';
+            if (curr_idx == index) { found = 1; break; }
+            curr_idx++; token_len = 0; /* reset for next token */
+        } else {
+            token_buf[token_len++] = ch;
+        }
+        if (token_len >= (int)sizeof(token_buf)-1) token_len = sizeof(token_buf)-2; /* prevent overflow */
+    }
+    if (!found) {
+        token_buf[token_len] = '\0'; /* null terminate last element */
+        if (curr_idx == index && token_len > 0) found = 1; /* last element matches */
     }
+    if (!found) return 0;
 
-static const char* evaluate_binary_op_internal(ASTNode* expr_node, const char *op_str, const char *left_val_str_final, const char *right_val_str_final);
-const char* evaluate_member_access(ASTNode *member_access_expr_node, StackFrame *frame); // Added forward declaration
+    /* Trim leading/trailing whitespace */
+    char *start = token_buf; while(isspace((unsigned char)*start)) start++;
+    char *end = start + strlen(start) - 1; while(end >= start && isspace((unsigned char)*end)) { *end = '\0'; end--; }
+    *out = value_parse(start);
+    return 1;
+}
 
+Value evaluate_expression(ASTNode *expr_node, StackFrame *frame) {
+    if (!expr_node) return value_undefined();
 
-const char* evaluate_expression(ASTNode *expr_node, StackFrame *frame) {
-    if (!expr_node) return "undefined";
-    
     switch (expr_node->type) {
         case AST_LITERAL:
-            return expr_node->value;
-            
+            return value_from_literal(expr_node->value, expr_node->data_type);
+
         case AST_IDENTIFIER: {
+            if (expr_node->slot >= 0) {
+                Value *slot_value = frame_slot(frame, expr_node->depth, expr_node->slot);
+                if (slot_value) return *slot_value;
+            }
             const char *var_name = expr_node->value;
-            const char *value_str = get_variable(frame, var_name);
-            if (value_str) return value_str;
+            Value *var_value = get_variable(frame, var_name);
+            if (var_value) return *var_value;
 
             if (current_class[0] != '\0') {
-                const char *this_obj_ref_str = get_variable(frame, "this");
-                if (this_obj_ref_str && strncmp(this_obj_ref_str, "obj:", 4) == 0) {
-                    int this_obj_id = atoi(this_obj_ref_str + 4);
-                    Object *this_obj = find_object_by_id(this_obj_id);
+                Value *this_ref = get_variable(frame, "this");
+                if (this_ref && IS_OBJECT(*this_ref)) {
+                    Object *this_obj = find_object_by_id(this_ref->as.object_id);
                     if (this_obj) {
-                        const char *instance_member_val = get_object_property_with_access(this_obj, var_name, current_class);
-                        if (instance_member_val && strcmp(instance_member_val, "undefined") != 0) {
+                        Value instance_member_val = get_object_property_with_access(this_obj, var_name, current_class);
+                        if (instance_member_val.type != VAL_UNDEFINED) {
                             return instance_member_val;
                         }
                     }
                 }
                 Object *static_obj_for_current_class = find_static_class_object(current_class);
                 if (static_obj_for_current_class) {
-                     const char *static_member_val = get_object_property_with_access(static_obj_for_current_class, var_name, current_class);
-                     if (static_member_val && strcmp(static_member_val, "undefined") != 0) {
+                     Value static_member_val = get_object_property_with_access(static_obj_for_current_class, var_name, current_class);
+                     if (static_member_val.type != VAL_UNDEFINED) {
                         return static_member_val;
                      }
                 }
             }
-            
-            if (isupper((unsigned char)var_name[0])) { 
+
+            if (isupper((unsigned char)var_name[0])) {
                  // Check if it's a registered class to return its name for static member access
                  // This needs vm.c to expose a "is_class_registered" or similar.
                  // For now, relying on semantic analysis to have typed it or this heuristic.
-                 return var_name; 
+                 return value_intern(var_name);
             }
 
             // fprintf(stderr, "Error (L%d:%d): Undefined identifier '%s'.\n", expr_node->line, expr_node->col, var_name);
-            return "undefined";
+            return value_undefined();
         }
-            
+
         case AST_BINARY_OP: {
-            if (strcmp(expr_node->value, "=") == 0 || strcmp(expr_node->value, "+=") == 0 || strcmp(expr_node->value, "-=") == 0 || strcmp(expr_node->value, "*=") == 0 || strcmp(expr_node->value, "/=") == 0 || strcmp(expr_node->value, "%=") == 0) { 
-                const char *rhs_val_str = evaluate_expression(expr_node->right, frame);
+            const char *op = expr_node->value;
+            int is_assignment = (op[0] == '=' && op[1] == '\0') ||
+                                ((op[0] == '+' || op[0] == '-' || op[0] == '*' || op[0] == '/' || op[0] == '%') && op[1] == '=' && op[2] == '\0');
+            if (is_assignment) {
+                Value rhs_val = evaluate_expression(expr_node->right, frame);
 
                 /* For compound assignments, compute new RHS as lhs <op> rhs */
-                const char *effective_rhs = rhs_val_str;
-                char compound_result_buf[64];
-                if (strcmp(expr_node->value, "=") != 0) {
-                    /* Need current LHS value */
-                    const char *lhs_current_val = evaluate_expression(expr_node->left, frame);
-                    const char *op_for_compound = NULL;
-                    if (strcmp(expr_node->value, "+=") == 0) op_for_compound = "+";
-                    else if (strcmp(expr_node->value, "-=") == 0) op_for_compound = "-";
-                    else if (strcmp(expr_node->value, "*=") == 0) op_for_compound = "*";
-                    else if (strcmp(expr_node->value, "/=") == 0) op_for_compound = "/";
-                    else if (strcmp(expr_node->value, "%=") == 0) op_for_compound = "%"; /* modulus to implement later */
-
-                    if (op_for_compound) {
-                        const char *temp_res = evaluate_binary_op_internal(expr_node, op_for_compound, lhs_current_val, rhs_val_str);
-                        strncpy(compound_result_buf, temp_res, sizeof(compound_result_buf)-1);
-                        compound_result_buf[sizeof(compound_result_buf)-1] = '\0';
-                        effective_rhs = compound_result_buf;
-                    }
-                }
-
-                if (expr_node->left->type == AST_IDENTIFIER) {
-                    set_variable(frame, expr_node->left->value, effective_rhs);
-                    return effective_rhs; 
-                } else if (expr_node->left->type == AST_MEMBER_ACCESS) {
-                    ASTNode *member_access = expr_node->left; 
-                    ASTNode *target_node = member_access->left;   
-                    const char *prop_name = member_access->value; 
-
-                    const char *target_ref_str;
-                    if (target_node->type == AST_THIS) target_ref_str = get_variable(frame, "this");
-                    else target_ref_str = evaluate_expression(target_node, frame);
-
-                    if (target_ref_str && strncmp(target_ref_str, "obj:", 4) == 0) { 
-                        int obj_id = atoi(target_ref_str + 4);
-                        Object *obj_instance = find_object_by_id(obj_id);
-                        if (obj_instance) {
-                            set_object_property_with_access(obj_instance, prop_name, effective_rhs, ACCESS_MODIFIER_PUBLIC, 0);
-                            return effective_rhs;
-                        } else { fprintf(stderr, "Error (L%d:%d): Object %s not found for assignment to '%s'.\n", member_access->line, member_access->col, target_ref_str, prop_name); }
-                    } else if (target_ref_str && isupper((unsigned char)target_ref_str[0])) { // Assume ClassName for static
-                        Object* static_obj = find_static_class_object(target_ref_str);
-                        if (static_obj) {
-                             set_object_property_with_access(static_obj, prop_name, effective_rhs, ACCESS_MODIFIER_PUBLIC, 1);
-                             return effective_rhs;
-                        } else { fprintf(stderr, "Error (L%d:%d): Class %s not found for static assignment to '%s'.\n", target_node->line, target_node->col, target_ref_str, prop_name); }
-                    } else { fprintf(stderr, "Error (L%d:%d): Invalid target for member assignment to '%s'. Target was '%s'\n", target_node->line, target_node->col, prop_name, target_ref_str ? target_ref_str : "null");}
-                    return "undefined"; 
-                } else {
-                    fprintf(stderr, "Error (L%d:%d): Invalid left-hand side in assignment.\n", expr_node->left->line, expr_node->left->col);
-                    return "undefined";
-                }
-            } else { 
-                const char *left_eval_result = evaluate_expression(expr_node->left, frame);
-                char left_stable_val[1024]; 
-                const char* left_final_val_ptr;
-
-                if (left_eval_result == result_buffer) { 
-                    strncpy(left_stable_val, result_buffer, sizeof(left_stable_val) - 1);
-                    left_stable_val[sizeof(left_stable_val) - 1] = '\0';
-                    left_final_val_ptr = left_stable_val;
-                } else {
-                    left_final_val_ptr = left_eval_result; 
+                if (op[0] != '=') {
+                    char op_for_compound[2] = { op[0], '\0' };
+                    gc_push_root(rhs_val);
+                    Value lhs_current_val = evaluate_expression(expr_node->left, frame);
+                    gc_pop_roots(1);
+                    rhs_val = evaluate_binary_values(op_for_compound, lhs_current_val, rhs_val);
                 }
+                gc_push_root(rhs_val); // The target expression may still run code
+                Value assigned = assign_to_target(expr_node->left, rhs_val, frame);
+                gc_pop_roots(1);
+                return assigned;
+            } else {
+                Value left_val = evaluate_expression(expr_node->left, frame);
 
-                if (strcmp(expr_node->value, "&&") == 0) {
-                    int left_truthy = left_final_val_ptr && strcmp(left_final_val_ptr, "0") != 0 && strcmp(left_final_val_ptr, "false") != 0 && strcmp(left_final_val_ptr, "") != 0;
-                    if (!left_truthy) return "false"; 
-                    const char *right_eval_result = evaluate_expression(expr_node->right, frame);
-                    int right_truthy = right_eval_result && strcmp(right_eval_result, "0") != 0 && strcmp(right_eval_result, "false") != 0 && strcmp(right_eval_result, "") != 0;
-                    return right_truthy ? "true" : "false";
+                if (op[0] == '&' && op[1] == '&') {
+                    if (!value_is_truthy(left_val)) return value_bool(0);
+                    return value_bool(value_is_truthy(evaluate_expression(expr_node->right, frame)));
                 }
-                if (strcmp(expr_node->value, "||") == 0) {
-                    int left_truthy = left_final_val_ptr && strcmp(left_final_val_ptr, "0") != 0 && strcmp(left_final_val_ptr, "false") != 0 && strcmp(left_final_val_ptr, "") != 0;
-                    if (left_truthy) return "true"; 
-                    const char *right_eval_result = evaluate_expression(expr_node->right, frame);
-                    int right_truthy = right_eval_result && strcmp(right_eval_result, "0") != 0 && strcmp(right_eval_result, "false") != 0 && strcmp(right_eval_result, "") != 0;
-                    return right_truthy ? "true" : "false";
+                if (op[0] == '|' && op[1] == '|') {
+                    if (value_is_truthy(left_val)) return value_bool(1);
+                    return value_bool(value_is_truthy(evaluate_expression(expr_node->right, frame)));
                 }
-                const char *right_eval_result = evaluate_expression(expr_node->right, frame);
-                return evaluate_binary_op_internal(expr_node, expr_node->value, left_final_val_ptr, right_eval_result);
+                gc_push_root(left_val);
+                Value right_val = evaluate_expression(expr_node->right, frame);
+                gc_pop_roots(1);
+                return evaluate_binary_values(op, left_val, right_val);
             }
         } // End AST_BINARY_OP
         case AST_UNARY_OP: {
-            const char *operand_val_str = evaluate_expression(expr_node->left, frame);
-            if (strcmp(expr_node->value, "-") == 0) {
-                if (!operand_val_str || !is_numeric_string(operand_val_str)) {
-                     fprintf(stderr, "Error (L%d:%d): Unary '-' requires numeric operand, got '%s'.\n", expr_node->line, expr_node->col, operand_val_str ? operand_val_str : "undefined"); return "undefined";
+            Value operand_val = evaluate_expression(expr_node->left, frame);
+            if (strcmp(expr_node->value, "-") == 0 || strcmp(expr_node->value, "+") == 0) {
+                if (!value_is_numeric(operand_val)) {
+                     char buf[64];
+                     fprintf(stderr, "Error (L%d:%d): Unary '%s' requires numeric operand, got '%s'.\n", expr_node->line, expr_node->col, expr_node->value, value_to_cstring(operand_val, buf, sizeof(buf)));
+                     return value_undefined();
                 }
-                double val = atof(operand_val_str);
-                snprintf(result_buffer, sizeof(result_buffer), "%g", -val); return result_buffer;
+                int negate = expr_node->value[0] == '-';
+                if (operand_val.type == VAL_INT) return value_int(negate ? -operand_val.as.integer : operand_val.as.integer);
+                if (operand_val.type == VAL_DOUBLE) return value_double(negate ? -operand_val.as.number : operand_val.as.number);
+                double val = value_as_number(operand_val);
+                return value_double(negate ? -val : val);
             } else if (strcmp(expr_node->value, "!") == 0) {
-                 int truthy = operand_val_str && strcmp(operand_val_str, "0") != 0 && strcmp(operand_val_str, "false") != 0 && strcmp(operand_val_str, "") != 0;
-                 return truthy ? "false" : "true";
+                 return value_bool(!value_is_truthy(operand_val));
             } else if (strcmp(expr_node->value, "++") == 0 || strcmp(expr_node->value, "--") == 0) {
                  int delta = (expr_node->value[0] == '+') ? 1 : -1;
-                 if (!operand_val_str || !is_numeric_string(operand_val_str)) {
-                     fprintf(stderr, "Error (L%d:%d): '%s' operator requires numeric operand, got '%s'.\n", expr_node->line, expr_node->col, expr_node->value, operand_val_str ? operand_val_str : "undefined");
-                     return "undefined";
+                 if (!value_is_numeric(operand_val)) {
+                     char buf[64];
+                     fprintf(stderr, "Error (L%d:%d): '%s' operator requires numeric operand, got '%s'.\n", expr_node->line, expr_node->col, expr_node->value, value_to_cstring(operand_val, buf, sizeof(buf)));
+                     return value_undefined();
                  }
-                 int new_val = atoi(operand_val_str) + delta;
-                 char new_val_str[64]; snprintf(new_val_str, sizeof(new_val_str), "%d", new_val);
+                 Value new_val = operand_val.type == VAL_DOUBLE ? value_double(operand_val.as.number + delta)
+                                                                : value_int(value_as_int(operand_val) + delta);
 
                  /* Assign back to operand (identifier or member) */
-                 if (expr_node->left->type == AST_IDENTIFIER) {
-                     set_variable(frame, expr_node->left->value, new_val_str);
-                 } else if (expr_node->left->type == AST_MEMBER_ACCESS) {
-                     ASTNode *member_access = expr_node->left;
-                     const char *prop_name = member_access->value;
-                     const char *target_ref_str;
-                     if (member_access->left->type == AST_THIS) target_ref_str = get_variable(frame, "this");
-                     else target_ref_str = evaluate_expression(member_access->left, frame);
-
-                     if (target_ref_str && strncmp(target_ref_str, "obj:", 4) == 0) {
-                         int obj_id = atoi(target_ref_str + 4);
-                         Object *obj_instance = find_object_by_id(obj_id);
-                         if (obj_instance) {
-                             set_object_property_with_access(obj_instance, prop_name, new_val_str, ACCESS_MODIFIER_PUBLIC, 0);
-                         }
-                     }
+                 if (expr_node->left->type == AST_IDENTIFIER || expr_node->left->type == AST_MEMBER_ACCESS) {
+                     assign_to_target(expr_node->left, new_val, frame);
                  }
-                 strncpy(result_buffer, new_val_str, sizeof(result_buffer)-1);
-                 result_buffer[sizeof(result_buffer)-1] = '\0';
-                 return result_buffer;
+                 return new_val;
             }
             fprintf(stderr, "Error (L%d:%d): Unknown unary operator '%s'.\n", expr_node->line, expr_node->col, expr_node->value);
-            return "undefined";
+            return value_undefined();
         }
         case AST_CALL: {
             // Dispatch user-defined class methods on instances
             char qualified_name_buffer[512];
             if (expr_node->right) {
-                const char *t = evaluate_expression(expr_node->right, frame);
-                if (t && strncmp(t, "obj:", 4) == 0) {
-                    int inst_id = atoi(t + 4);
-                    Object *inst = find_object_by_id(inst_id);
+                Value target = evaluate_expression(expr_node->right, frame);
+                if (IS_ARRAY(target)) {
+                    // arr.push(x) and friends call the array_* natives with the array first
+                    Value result;
+                    gc_push_root(target); // The receiver stays live while the arguments run
+                    int handled = call_built_in_method(expr_node->value, target, expr_node->left, frame, &result);
+                    gc_pop_roots(1);
+                    if (handled) return result;
+                }
+                if (IS_OBJECT(target)) {
+                    Object *inst = find_object_by_id(target.as.object_id);
                     if (inst) {
-                        // Extract class name before '#' in instance class_name
-                        char class_name_only[128];
-                        char *hash_pos = strchr(inst->class_name, '#');
-                        if (hash_pos) {
-                            size_t class_len = hash_pos - inst->class_name;
-                            if (class_len < sizeof(class_name_only)) {
-                                strncpy(class_name_only, inst->class_name, class_len);
-                                class_name_only[class_len] = '\0';
-                            } else {
-                                strncpy(class_name_only, inst->class_name, sizeof(class_name_only) - 1);
-                                class_name_only[sizeof(class_name_only) - 1] = '\0';
-                            }
+                        Value result;
+                        gc_push_root(target);
+                        if (expr_node->right->type == AST_SUPER && g_super_target_class[0]) {
+                            snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s", g_super_target_class, expr_node->value);
+                            result = execute_function_call(qualified_name_buffer, target, expr_node->left, frame);
                         } else {
-                            strncpy(class_name_only, inst->class_name, sizeof(class_name_only) - 1);
-                            class_name_only[sizeof(class_name_only) - 1] = '\0';
+                            result = execute_method_call_at_site(expr_node, inst, frame);
                         }
-                        snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s", class_name_only, expr_node->value);
-                    } else {
-                        // Fallback if instance not found
-                        snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s", t, expr_node->value);
+                        gc_pop_roots(1);
+                        return result;
                     }
-                } else {
-                    // Plain method or function call on class/static
-                    snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s", t ? t : "undefined_target", expr_node->value);
                 }
+                // Class.method(): class names evaluate to interned strings
+                if (IS_STRING(target) && target.as.string->interned) {
+                    return execute_static_call_at_site(expr_node, target.as.string, frame);
+                }
+                // Plain method or function call on class/static
+                char target_buf[64];
+                snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s",
+                         target.type == VAL_UNDEFINED ? "undefined_target" : value_to_cstring(target, target_buf, sizeof(target_buf)),
+                         expr_node->value);
             } else {
                 // Simple function call
-                strncpy(qualified_name_buffer, expr_node->value, sizeof(qualified_name_buffer) - 1);
-                qualified_name_buffer[sizeof(qualified_name_buffer) - 1] = '\0';
+                return execute_call_at_site(expr_node, frame);
             }
-            return execute_function_call(qualified_name_buffer, expr_node->left, frame);
+            return execute_function_call(qualified_name_buffer, value_undefined(), expr_node->left, frame);
         }
         case AST_ARRAY: {
-            // Simplified: if parser put elements in value, use that. Otherwise, placeholder.
+            // Simplified: if parser put elements in value, use that.
             if (expr_node->value[0] != '\0' && strcmp(expr_node->value, "array_literal") != 0) {
-                return expr_node->value; 
-            } else if (expr_node->left) { // Chain of expression nodes for elements
-                // This needs to build a string representation or an actual array object.
-                // For now, very basic string join into result_buffer for demo.
-                result_buffer[0] = '['; result_buffer[1] = '\0';
-                ASTNode* elem = expr_node->left;
-                int first = 1;
-                size_t current_len = 1;
-                while(elem) {
-                    if (!first) { strncat(result_buffer, ",", sizeof(result_buffer) - current_len -1); current_len++;}
-                    const char* elem_val = evaluate_expression(elem, frame);
-                    strncat(result_buffer, elem_val, sizeof(result_buffer) - current_len -1);
-                    current_len += strlen(elem_val);
-                    first = 0;
-                    elem = elem->next;
-                }
-                strncat(result_buffer, "]", sizeof(result_buffer) - current_len -1);
-                return result_buffer;
+                return value_intern(expr_node->value);
             }
-            return "[array_obj_ref]"; 
+            Value array = value_array(expr_node->array_size);
+            gc_push_root(array);
+            for (ASTNode *elem = expr_node->left; elem; elem = elem->next) {
+                value_array_push(array.as.array, evaluate_expression(elem, frame));
+            }
+            gc_pop_roots(1);
+            return array;
         }
         case AST_NEW: {
             if (!expr_node->value[0]) {
                 fprintf(stderr, "Error (L%d:%d): Class name missing in new expression\n", expr_node->line, expr_node->col);
-                return "undefined";
+                return value_undefined();
             }
-            Object *obj = create_object(expr_node->value); 
+            Object *obj = create_object(expr_node->value);
             if (!obj) {
                 fprintf(stderr, "Error (L%d:%d): Failed to create object of class '%s'\n", expr_node->line, expr_node->col, expr_node->value);
-                return "undefined";
+                return value_undefined();
             }
-            int obj_id_val = 0;
-            sscanf(obj->class_name, "%*[^#]#%d", &obj_id_val);
-            snprintf(result_buffer, sizeof(result_buffer), "obj:%d", obj_id_val); 
+            Value obj_ref = value_object(obj->id);
 
             /* Only attempt to invoke constructor if user actually defined one */
-            if (find_user_function(expr_node->value, expr_node->value)) {
-                // Invoke constructor using qualified name and args list
-                execute_function_call(expr_node->value, expr_node->left, frame);
+            const char *ctor_name = NULL;
+            if (find_class_method(expr_node->value, "new")) ctor_name = "new";
+            else if (find_class_method(expr_node->value, expr_node->value)) ctor_name = expr_node->value;
+            if (ctor_name) {
+                char ctor_qualified_name[512];
+                snprintf(ctor_qualified_name, sizeof(ctor_qualified_name), "%s.%s", expr_node->value, ctor_name);
+                gc_push_root(obj_ref);
+                execute_function_call(ctor_qualified_name, obj_ref, expr_node->left, frame);
+                gc_pop_roots(1);
             }
-            return result_buffer; // Return the object reference string
+            return obj_ref; // Return the object reference
         }
         case AST_MEMBER_ACCESS: {
             return evaluate_member_access(expr_node, frame);
         }
         case AST_THIS: {
-            const char *this_val = get_variable(frame, "this");
+            Value *this_val = frame_slot(frame, expr_node->depth, expr_node->slot);
+            if (!this_val) this_val = get_variable(frame, "this");
             if (!this_val) {
                 fprintf(stderr, "Error (L%d:%d): 'this' is undefined in current context.\n", expr_node->line, expr_node->col);
-                return "undefined";
+                return value_undefined();
             }
-            return this_val;
+            return *this_val;
         }
         case AST_SUPER: {
-            /* For now, treat 'super' the same as 'this' (no real inheritance yet) */
-            const char *this_val = get_variable(frame, "this");
+            /* 'super' evaluates to 'this'; method calls on it resolve against the parent class */
+            Value *this_val = frame_slot(frame, expr_node->depth, expr_node->slot);
+            if (!this_val) this_val = get_variable(frame, "this");
             if (!this_val) {
                 fprintf(stderr, "Error (L%d:%d): 'super' is undefined in current context.\n", expr_node->line, expr_node->col);
-                return "undefined";
+                return value_undefined();
             }
-            extern char g_super_target_class[128];
-            const char *parent = NULL;
-            extern const char* get_parent_class_name(const char* class_name);
-            parent = get_parent_class_name(current_class);
+            const char *parent = get_parent_class_name(current_class);
             if (parent) { strncpy(g_super_target_class, parent, sizeof(g_super_target_class)-1); g_super_target_class[sizeof(g_super_target_class)-1] = '\0'; }
             else g_super_target_class[0] = '\0';
-            return this_val;
+            return *this_val;
         }
         case AST_INDEX_ACCESS: {
-            const char* target_val_str = evaluate_expression(expr_node->left, frame);
-            const char* index_val_str = evaluate_expression(expr_node->right, frame);
-            
+            Value target_val = evaluate_expression(expr_node->left, frame);
+            gc_push_root(target_val);
+            Value index_val = evaluate_expression(expr_node->right, frame);
+            gc_pop_roots(1);
+
             // Rudimentary string/array indexing for demo, add guard to suppress spam
-            if (!target_val_str || strcmp(target_val_str, "undefined") == 0) {
-                return "undefined"; // nothing to index
+            if (target_val.type == VAL_UNDEFINED) {
+                return value_undefined(); // nothing to index
             }
 
-            // Handle pseudo array literal represented as "[a,b,c]"
-            if (target_val_str[0] == '[' && target_val_str[strlen(target_val_str)-1] == ']') {
-                // This is a placeholder for actual array object indexing
-                // It assumes target_val_str is like "[elem1,elem2,elem3]"
-                int index_num = atoi(index_val_str);
-                /* Depth-aware tokenisation so commas inside nested sub-arrays are ignored. */
-                char token_buf[512]; int token_len = 0; int depth = 0; int curr_idx = 0; int found = 0;
-                const char *p = target_val_str + 1; /* skip opening '[' */
-                for (; *p && !(depth == 0 && *p == ']'); ++p) {
-                    char ch = *p;
-                    if (ch == '[') { depth++; token_buf[token_len++] = ch; }
-                    else if (ch == ']') { depth--; token_buf[token_len++] = ch; }
-                    else if (ch == ',' && depth == 0) {
-                        token_buf[token_len] = '\0';
-                        if (curr_idx == index_num) { found = 1; break; }
-                        curr_idx++; token_len = 0; /* reset for next token */
-                    } else {
-                        token_buf[token_len++] = ch;
+            if (IS_ARRAY(target_val)) {
+                Value *element = value_is_numeric(index_val) ? value_array_at(target_val.as.array, value_as_int(index_val)) : NULL;
+                if (element) return *element;
+                char index_buf[64];
+                fprintf(stderr, "Warning (L%d:%d): Index %s out of bounds for array of length %lld.\n", expr_node->line, expr_node->col,
+                        value_to_cstring(index_val, index_buf, sizeof(index_buf)), (long long)target_val.as.array->count);
+                return value_undefined();
+            }
+
+            if (IS_STRING(target_val) && value_is_numeric(index_val)) {
+                const OuroString *target_str = target_val.as.string;
+                int64_t index = value_as_int(index_val);
+
+                // Handle pseudo array literal represented as "[a,b,c]"
+                if (target_str->length >= 2 && target_str->chars[0] == '[' && target_str->chars[target_str->length-1] == ']') {
+                    Value element;
+                    if (pseudo_array_element(target_str->chars, index, &element)) return element;
+                    if (index < 50) {
+                        fprintf(stderr, "Warning (L%d:%d): Index %lld out of bounds for pseudo-array.\n", expr_node->line, expr_node->col, (long long)index);
                     }
-                    if (token_len >= (int)sizeof(token_buf)-1) token_len = sizeof(token_buf)-2; /* prevent overflow */
-                }
-                if (!found) {
-                    token_buf[token_len] = '\0'; /* null terminate last element */
-                    if (curr_idx == index_num) found = 1; /* last element matches */
-                }
-                if (found) {
-                    /* Trim leading/trailing whitespace */
-                    char *start = token_buf; while(isspace((unsigned char)*start)) start++;
-                    char *end = start + strlen(start) - 1; while(end >= start && isspace((unsigned char)*end)) { *end = '\0'; end--; }
-                    strncpy(result_buffer, start, sizeof(result_buffer)-1);
-                    result_buffer[sizeof(result_buffer)-1] = '\0';
-                    return result_buffer;
+                    return value_undefined();
                 }
-                if (index_num < 50) {
-                    fprintf(stderr, "Warning (L%d:%d): Index %d out of bounds for pseudo-array.\n", expr_node->line, expr_node->col, index_num);
+                // Basic string indexing on plain string
+                if (index >= 0 && index < (int64_t)target_str->length) {
+                    return value_string_n(target_str->chars + index, 1);
                 }
-                return "undefined";
-            } else if (is_numeric_string(index_val_str)) { // Basic string indexing on plain string
-                int index = atoi(index_val_str);
-                if (index >= 0 && index < (int)strlen(target_val_str)) {
-                    snprintf(result_buffer, 2, "%c", target_val_str[index]);
-                    return result_buffer;
-                } else {
-                    // warn once, but avoid spamming by length threshold
-                    if (index < 50) {
-                        fprintf(stderr, "Warning (L%d:%d): Index %d out of bounds for string '%s'.\n", expr_node->line, expr_node->col, index, target_val_str);
-                    }
-                    return "undefined";
+                // warn once, but avoid spamming by length threshold
+                if (index < 50) {
+                    fprintf(stderr, "Warning (L%d:%d): Index %lld out of bounds for string '%s'.\n", expr_node->line, expr_node->col, (long long)index, target_str->chars);
                 }
+                return value_undefined();
+            }
+            if (IS_OBJECT(target_val)) { // obj["key"] reads a property
+                Object *target_obj = find_object_by_id(target_val.as.object_id);
+                char key_buf[64];
+                if (target_obj) return get_object_property_with_access(target_obj, value_to_cstring(index_val, key_buf, sizeof(key_buf)), current_class);
             }
             // Fallback for unhandled index access
-            snprintf(result_buffer, sizeof(result_buffer), "indexed_value_of_%s_at_%s", target_val_str ? target_val_str : "null", index_val_str ? index_val_str : "null");
-            return result_buffer;
+            char target_buf[64], index_buf[64], fallback[256];
+            snprintf(fallback, sizeof(fallback), "indexed_value_of_%s_at_%s", value_to_cstring(target_val, target_buf, sizeof(target_buf)), value_to_cstring(index_val, index_buf, sizeof(index_buf)));
+            return value_string(fallback);
         }
         case AST_TERNARY: {
-            const char *cond_val = evaluate_expression(expr_node->left, frame);
-            int truthy = cond_val && strcmp(cond_val, "0") != 0 && strcmp(cond_val, "false") != 0 && strcmp(cond_val, "") != 0;
-            if (truthy) return evaluate_expression(expr_node->right, frame);
+            if (value_is_truthy(evaluate_expression(expr_node->left, frame))) return evaluate_expression(expr_node->right, frame);
             else if (expr_node->next) return evaluate_expression(expr_node->next, frame);
-            return "undefined";
+            return value_undefined();
         }
         case AST_FUNCTION: {
             /* Anonymous function expression – register on first evaluation and return its name */
             if (!find_user_function(expr_node->value, NULL)) {
                 register_user_function(expr_node);
             }
-            return expr_node->value; // function name string acts as reference
+            return value_intern(expr_node->value); // function name string acts as reference
         }
         case AST_MAP: {
             /* Create a real runtime object instead of serialising to a string */
             Object *map_obj = create_object("Object");
-            if (!map_obj) return "undefined";
+            if (!map_obj) return value_undefined();
+            gc_push_root(value_object(map_obj->id));
 
             ASTNode *pair = expr_node->left;
             while (pair) {
                 const char *key_str;
+                char key_buf[64];
                 if (pair->left->type == AST_IDENTIFIER || pair->left->type == AST_LITERAL) {
                     key_str = pair->left->value; // use raw token text
                 } else {
-                    key_str = evaluate_expression(pair->left, frame);
+                    key_str = value_to_cstring(evaluate_expression(pair->left, frame), key_buf, sizeof(key_buf));
                 }
 
-                const char *val_result;
-                if (pair->right->type == AST_FUNCTION) {
-                    /* Evaluate will register and return the synthetic name */
-                    val_result = evaluate_expression(pair->right, frame);
-                } else {
-                    val_result = evaluate_expression(pair->right, frame);
-                }
-                set_object_property_with_access(map_obj, key_str, val_result, ACCESS_MODIFIER_PUBLIC, 1);
+                /* Function values evaluate to their registered synthetic name */
+                Value val_result = evaluate_expression(pair->right, frame);
+                set_object_property_with_access(map_obj, key_str, val_result, ACCESS_MODIFIER_PUBLIC, 0);
                 pair = pair->next;
             }
 
-            /* Build and return the obj reference string */
-            static char obj_ref_buf[32];
-            int obj_id_val = 0;
-            sscanf(map_obj->class_name, "%*[^#]#%d", &obj_id_val);
-            snprintf(obj_ref_buf, sizeof(obj_ref_buf), "obj:%d", obj_id_val);
-            return obj_ref_buf;
+            gc_pop_roots(1);
+            return value_object(map_obj->id);
         }
         default:
             fprintf(stderr, "Error (L%d:%d): Cannot evaluate unknown AST node type %s (%d).\n", expr_node->line, expr_node->col, node_type_to_string(expr_node->type), expr_node->type);
-            return "undefined";
+            return value_undefined();
     }
 }
 
-// Forward declaration for binary op evaluation
-static const char* evaluate_binary_op_internal(ASTNode* expr_node, const char *op_str, const char *left_val_str_final, const char *right_val_str_final) {
-    (void)expr_node;
-    /* Single shared buffer for return value */
-    static char result_buffer[MAX_RESULT_LENGTH];
-    result_buffer[0] = '\0';
-
-    /* Ensure we never read from the same buffer we are about to overwrite */
-    LOCAL_COPY_IF_ALIAS(left_val_str_final, safe_left);
-    LOCAL_COPY_IF_ALIAS(right_val_str_final, safe_right);
-    
-    // Arithmetic operations
-    if (strcmp(op_str, "+") == 0) {
-        // Numeric addition when BOTH operands are numeric
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            double result = left_num + right_num;
-
-            // Emit integer without decimal part when possible
-            if (result == (int)result) {
-                snprintf(result_buffer, sizeof(result_buffer), "%d", (int)result);
-            } else {
-                snprintf(result_buffer, sizeof(result_buffer), "%g", result);
+// Stores new_value into an identifier or member-access target and returns it.
+static Value assign_to_target(ASTNode *target_node, Value new_value, StackFrame *frame) {
+    if (target_node->type == AST_IDENTIFIER) {
+        Value *slot_value = frame_slot(frame, target_node->depth, target_node->slot);
+        if (slot_value) *slot_value = new_value;
+        else set_variable(frame, target_node->value, new_value);
+        return new_value;
+    } else if (target_node->type == AST_MEMBER_ACCESS) {
+        ASTNode *member_access = target_node;
+        ASTNode *object_node = member_access->left;
+        const char *prop_name = member_access->value;
+
+        Value target_ref = evaluate_expression(object_node, frame);
+        char target_buf[64];
+
+        if (IS_OBJECT(target_ref)) {
+            Object *obj_instance = find_object_by_id(target_ref.as.object_id);
+            if (obj_instance) {
+                set_object_property_at_site(obj_instance, prop_name, new_value, 0, member_access);
+                return new_value;
+            } else { fprintf(stderr, "Error (L%d:%d): Object obj:%d not found for assignment to '%s'.\n", member_access->line, member_access->col, target_ref.as.object_id, prop_name); }
+        } else if (IS_STRING(target_ref) && isupper((unsigned char)target_ref.as.string->chars[0])) { // Assume ClassName for static
+            Object* static_obj = find_static_class_object(target_ref.as.string->chars);
+            if (static_obj) {
+                 set_object_property_at_site(static_obj, prop_name, new_value, 1, member_access);
+                 return new_value;
+            } else { fprintf(stderr, "Error (L%d:%d): Class %s not found for static assignment to '%s'.\n", object_node->line, object_node->col, target_ref.as.string->chars, prop_name); }
+        } else { fprintf(stderr, "Error (L%d:%d): Invalid target for member assignment to '%s'. Target was '%s'\n", object_node->line, object_node->col, prop_name, value_to_cstring(target_ref, target_buf, sizeof(target_buf)));}
+        return value_undefined();
+    } else if (target_node->type == AST_INDEX_ACCESS) {
+        Value target_ref = evaluate_expression(target_node->left, frame);
+        gc_push_root(target_ref);
+        Value index_val = evaluate_expression(target_node->right, frame);
+        gc_pop_roots(1);
+        char index_buf[64];
+        if (IS_ARRAY(target_ref) && value_is_numeric(index_val)) {
+            OuroArray *array = target_ref.as.array;
+            int64_t index = value_as_int(index_val);
+            Value *element = value_array_at(array, index);
+            if (element) { *element = new_value; return new_value; }
+            if (index == array->count) { value_array_push(array, new_value); return new_value; } // a[a.length] = x appends
+            fprintf(stderr, "Error (L%d:%d): Index %lld out of bounds for assignment to array of length %lld.\n",
+                    target_node->line, target_node->col, (long long)index, (long long)array->count);
+        } else if (IS_OBJECT(target_ref)) { // obj["key"] = value sets a property
+            Object *obj_instance = find_object_by_id(target_ref.as.object_id);
+            if (obj_instance) {
+                set_object_property_with_access(obj_instance, value_to_cstring(index_val, index_buf, sizeof(index_buf)), new_value, ACCESS_MODIFIER_PUBLIC, 0);
+                return new_value;
             }
+            fprintf(stderr, "Error (L%d:%d): Object obj:%d not found for indexed assignment.\n", target_node->line, target_node->col, target_ref.as.object_id);
         } else {
-            // Treat as string concatenation otherwise (default behaviour in many scripting languages)
-            snprintf(result_buffer, sizeof(result_buffer), "%s%s", safe_left ? safe_left : "", safe_right ? safe_right : "");
-        }
-    }
-    else if (strcmp(op_str, "-") == 0) {
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            double result = left_num - right_num;
-            
-            if (result == (int)result) {
-                snprintf(result_buffer, sizeof(result_buffer), "%d", (int)result);
-            } else {
-                snprintf(result_buffer, sizeof(result_buffer), "%g", result);
-            }
+            fprintf(stderr, "Error (L%d:%d): Invalid target for indexed assignment (%s).\n", target_node->line, target_node->col, value_type_name(target_ref));
         }
+        return value_undefined();
     }
-    else if (strcmp(op_str, "*") == 0) {
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            double result = left_num * right_num;
-            
-            if (result == (int)result) {
-                snprintf(result_buffer, sizeof(result_buffer), "%d", (int)result);
-            } else {
-                snprintf(result_buffer, sizeof(result_buffer), "%g", result);
-            }
+    fprintf(stderr, "Error (L%d:%d): Invalid left-hand side in assignment.\n", target_node->line, target_node->col);
+    return value_undefined();
+}
+
+Value evaluate_binary_values(const char *op_str, Value left, Value right) {
+    char op = op_str[0];
+    char op2 = op_str[0] ? op_str[1] : '\0';
+
+    // Arithmetic operations
+    if (op2 == '\0' && (op == '+' || op == '-' || op == '*' || op == '/' || op == '%')) {
+        // '+' concatenates as soon as either side is a string (or neither side is numeric)
+        if (op == '+' && (IS_STRING(left) || IS_STRING(right) || !value_is_numeric(left) || !value_is_numeric(right))) {
+            return value_concat(left, right);
         }
-    }
-    else if (strcmp(op_str, "/") == 0) {
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            
-            if (right_num == 0) {
-                fprintf(stderr, "[RUNTIME] Error: Division by zero\n");
-                strcpy(result_buffer, "NaN");
-            } else {
-                double result = left_num / right_num;
-                
-                if (result == (int)result) {
-                    snprintf(result_buffer, sizeof(result_buffer), "%d", (int)result);
-                } else {
-                    snprintf(result_buffer, sizeof(result_buffer), "%g", result);
-                }
+        if (!value_is_numeric(left) || !value_is_numeric(right)) return value_undefined();
+
+        if (left.type != VAL_DOUBLE && right.type != VAL_DOUBLE) {
+            int64_t l = value_as_int(left), r = value_as_int(right);
+            switch (op) {
+                case '+': return value_int(l + r);
+                case '-': return value_int(l - r);
+                case '*': return value_int(l * r);
+                case '/':
+                    if (r == 0) { fprintf(stderr, "[RUNTIME] Error: Division by zero\n"); return value_double(NAN); }
+                    if (l % r == 0) return value_int(l / r);
+                    return value_double((double)l / (double)r);
+                case '%':
+                    if (r == 0) { fprintf(stderr, "[RUNTIME] Error: Modulus by zero\n"); return value_double(NAN); }
+                    return value_int(l % r);
             }
         }
-    }
-    else if (strcmp(op_str, "%") == 0) {
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            long left_num = atol(safe_left);
-            long right_num = atol(safe_right);
-            if (right_num == 0) {
-                fprintf(stderr, "[RUNTIME] Error: Modulus by zero\n");
-                strcpy(result_buffer, "NaN");
-            } else {
-                long result = left_num % right_num;
-                snprintf(result_buffer, sizeof(result_buffer), "%ld", result);
-            }
+        double l = value_as_number(left), r = value_as_number(right);
+        switch (op) {
+            case '+': return value_double(l + r);
+            case '-': return value_double(l - r);
+            case '*': return value_double(l * r);
+            case '/':
+                if (r == 0) { fprintf(stderr, "[RUNTIME] Error: Division by zero\n"); return value_double(NAN); }
+                return value_double(l / r);
+            case '%':
+                if (r == 0) { fprintf(stderr, "[RUNTIME] Error: Modulus by zero\n"); return value_double(NAN); }
+                return value_double(fmod(l, r));
         }
     }
     else if (strcmp(op_str, "<<") == 0 || strcmp(op_str, ">>") == 0 || strcmp(op_str, ">>>") == 0) {
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            long left_num = atol(safe_left);
-            int shift = atoi(safe_right);
-            long result;
-            if (strcmp(op_str, "<<") == 0) result = left_num << shift;
-            else result = left_num >> shift; // '>>>' treated same as '>>' in this simple impl
-            snprintf(result_buffer, sizeof(result_buffer), "%ld", result);
-        }
+        if (!value_is_numeric(left) || !value_is_numeric(right)) return value_undefined();
+        int64_t l = value_as_int(left);
+        int shift = (int)value_as_int(right);
+        if (op == '<') return value_int(l << shift);
+        if (op_str[2] == '>') return value_int((int64_t)((uint64_t)l >> shift));
+        return value_int(l >> shift);
     }
-    
+
     // Comparison operations
-    else if (strcmp(op_str, "==") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num == right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) == 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    else if (strcmp(op_str, "!=") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num != right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) != 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    else if (strcmp(op_str, "<") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num < right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) < 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    else if (strcmp(op_str, ">") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num > right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) > 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    else if (strcmp(op_str, "<=") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num <= right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) <= 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    else if (strcmp(op_str, ">=") == 0) {
-        int result;
-        if (is_numeric_string(safe_left) && is_numeric_string(safe_right)) {
-            double left_num = atof(safe_left);
-            double right_num = atof(safe_right);
-            result = (left_num >= right_num);
-        } else {
-            result = (strcmp(safe_left, safe_right) >= 0);
-        }
-        strcpy(result_buffer, result ? "true" : "false");
-    }
-    
+    else if (op == '=' && op2 == '=') return value_bool(value_equals(left, right));
+    else if (op == '!' && op2 == '=') return value_bool(!value_equals(left, right));
+    else if (op == '<' && op2 == '\0') return value_bool(value_compare(left, right) < 0);
+    else if (op == '>' && op2 == '\0') return value_bool(value_compare(left, right) > 0);
+    else if (op == '<' && op2 == '=') return value_bool(value_compare(left, right) <= 0);
+    else if (op == '>' && op2 == '=') return value_bool(value_compare(left, right) >= 0);
+
     // Logical operations
-    else if (strcmp(op_str, "&&") == 0) {
-        int left_bool = (strcmp(safe_left, "true") == 0);
-        int right_bool = (strcmp(safe_right, "true") == 0);
-        strcpy(result_buffer, (left_bool && right_bool) ? "true" : "false");
-    }
-    else if (strcmp(op_str, "||") == 0) {
-        int left_bool = (strcmp(safe_left, "true") == 0);
-        int right_bool = (strcmp(safe_right, "true") == 0);
-        strcpy(result_buffer, (left_bool || right_bool) ? "true" : "false");
-    }
-    
-    return result_buffer;
+    else if (op == '&' && op2 == '&') return value_bool(value_is_truthy(left) && value_is_truthy(right));
+    else if (op == '|' && op2 == '|') return value_bool(value_is_truthy(left) || value_is_truthy(right));
+
+    return value_undefined();
 }
@@ -3,13 +3,16 @@
 
 #include "stack.h"    // For StackFrame
 #include "ast_types.h" // For ASTNode
+#include "value.h"     // For Value
 
 // Main evaluation function for an expression AST node
-// Returns a C-string representing the evaluated value.
-// For complex types (objects, arrays), this might be a reference string (e.g., "obj:123").
-// The caller should be aware that some results might point to a static internal buffer
-// in eval.c and should be used or copied immediately.
-const char* evaluate_expression(ASTNode *expr_node, StackFrame *frame);
+// Returns a tagged Value. Strings point into the VM heap and stay valid until
+// vm_cleanup(); objects are returned as VAL_OBJECT references.
+Value evaluate_expression(ASTNode *expr_node, StackFrame *frame);
+
+// Applies a non-assigning, non-short-circuit binary operator ("+", "<", ">>", ...)
+// to two already evaluated operands. Shared with the bytecode interpreter.
+Value evaluate_binary_values(const char *op_str, Value left, Value right);
 
 // Helper to check if a string is numeric (used internally by eval.c, but could be util)
 int is_numeric_string(const char *s);
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "gc.h"
+#include "stack.h"
+#include "vm.h"
+#include "bytecode.h"
+
+#define GC_INITIAL_THRESHOLD (1024 * 1024) // First collection after 1 MiB
+#define GC_GROWTH_FACTOR 2                 // Next collection at live bytes * factor
+
+int gc_pending = 0;
+
+static GCStats stats = { 0, 0, 0, GC_INITIAL_THRESHOLD, 0, 0, 0, 0, 0, 0, 0 };
+
+// Temporary roots (gc_push_root)
+static Value *temp_roots = NULL;
+static int temp_root_count = 0;
+static int temp_root_capacity = 0;
+
+// Marked arrays and objects whose children are still to be scanned
+static Value *gray_stack = NULL;
+static int gray_count = 0;
+static int gray_capacity = 0;
+
+void gc_set_heap_limit(size_t bytes) {
+    stats.heap_limit = bytes;
+    if (bytes && stats.next_collection > bytes) stats.next_collection = bytes;
+}
+
+const GCStats* gc_stats(void) {
+    return &stats;
+}
+
+void gc_print_stats(void) {
+    printf("\n==== GC Statistics ====\n");
+    printf("Collections:      %llu\n", (unsigned long long)stats.collections);
+    printf("Allocations:      %llu (%llu bytes)\n", (unsigned long long)stats.allocations, (unsigned long long)stats.bytes_allocated);
+    printf("Freed:            %llu bytes (%llu strings, %llu arrays, %llu objects)\n",
+           (unsigned long long)stats.bytes_freed, (unsigned long long)stats.strings_freed,
+           (unsigned long long)stats.arrays_freed, (unsigned long long)stats.objects_freed);
+    printf("Live heap:        %zu bytes (peak %zu)\n", stats.heap_bytes, stats.peak_heap_bytes);
+    if (stats.heap_limit) printf("Heap limit:       %zu bytes\n", stats.heap_limit);
+}
+
+static void note_heap_growth(size_t bytes) {
+    stats.heap_bytes += bytes;
+    stats.bytes_allocated += bytes;
+    if (stats.heap_bytes > stats.peak_heap_bytes) stats.peak_heap_bytes = stats.heap_bytes;
+    if (stats.heap_bytes > stats.next_collection) gc_pending = 1;
+}
+
+void gc_track_alloc(size_t bytes) {
+    stats.allocations++;
+    note_heap_growth(bytes);
+}
+
+void gc_track_resize(size_t old_bytes, size_t new_bytes) {
+    if (new_bytes >= old_bytes) {
+        note_heap_growth(new_bytes - old_bytes);
+    } else {
+        stats.heap_bytes -= old_bytes - new_bytes;
+        stats.bytes_freed += old_bytes - new_bytes;
+    }
+}
+
+void gc_push_root(Value value) {
+    if (temp_root_count == temp_root_capacity) {
+        int new_capacity = temp_root_capacity ? temp_root_capacity * 2 : 64;
+        Value *grown = (Value*)realloc(temp_roots, (size_t)new_capacity * sizeof(Value));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for GC root stack\n");
+            exit(EXIT_FAILURE);
+        }
+        temp_roots = grown;
+        temp_root_capacity = new_capacity;
+    }
+    temp_roots[temp_root_count++] = value;
+}
+
+void gc_pop_roots(int count) {
+    temp_root_count -= count;
+    if (temp_root_count < 0) temp_root_count = 0;
+}
+
+static void push_gray(Value value) {
+    if (gray_count == gray_capacity) {
+        int new_capacity = gray_capacity ? gray_capacity * 2 : 256;
+        Value *grown = (Value*)realloc(gray_stack, (size_t)new_capacity * sizeof(Value));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for GC mark stack\n");
+            exit(EXIT_FAILURE);
+        }
+        gray_stack = grown;
+        gray_capacity = new_capacity;
+    }
+    gray_stack[gray_count++] = value;
+}
+
+void gc_mark_value(Value value) {
+    switch (value.type) {
+        case VAL_STRING:
+            value.as.string->marked = 1;
+            break;
+        case VAL_ARRAY:
+            if (!value.as.array->marked) {
+                value.as.array->marked = 1;
+                push_gray(value);
+            }
+            break;
+        case VAL_OBJECT: {
+            Object *obj = find_object_by_id(value.as.object_id);
+            if (obj && !obj->marked) {
+                obj->marked = 1;
+                push_gray(value);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void mark_frame(StackFrame *frame) {
+    for (int i = 0; i < frame->slot_count; i++) gc_mark_value(frame->slots[i]);
+    for (int i = 0; i < frame->dynamic_count; i++) gc_mark_value(frame->dynamic_vars[i].value);
+}
+
+// Scans the children of gray values until everything reachable is marked
+static void trace_references(void) {
+    while (gray_count > 0) {
+        Value value = gray_stack[--gray_count];
+        if (IS_ARRAY(value)) {
+            OuroArray *array = value.as.array;
+            for (int64_t i = 0; i < array->count; i++) gc_mark_value(array->items[i]);
+        } else {
+            Object *obj = find_object_by_id(value.as.object_id);
+            for (int i = 0; i < obj->shape->property_count; i++) gc_mark_value(obj->slots[i]);
+        }
+    }
+}
+
+size_t gc_collect(void) {
+    gc_pending = 0;
+    size_t freed_before = (size_t)stats.bytes_freed;
+
+    for (StackFrame *frame = stack_live_frames(); frame; frame = frame->live_next) mark_frame(frame);
+    for (int i = 0; i < temp_root_count; i++) gc_mark_value(temp_roots[i]);
+    vm_mark_roots();
+    bytecode_mark_roots();
+    trace_references();
+
+    value_heap_sweep(&stats);
+    vm_sweep_objects(&stats);
+    stats.collections++;
+
+    size_t next = stats.heap_bytes * GC_GROWTH_FACTOR;
+    if (next < GC_INITIAL_THRESHOLD) next = GC_INITIAL_THRESHOLD;
+    if (stats.heap_limit) {
+        if (stats.heap_bytes > stats.heap_limit) {
+            fprintf(stderr, "[RUNTIME] Fatal: heap limit of %zu bytes exceeded (%zu bytes live after collection)\n",
+                    stats.heap_limit, stats.heap_bytes);
+            exit(EXIT_FAILURE);
+        }
+        if (next > stats.heap_limit) next = stats.heap_limit;
+    }
+    stats.next_collection = next;
+
+    return (size_t)stats.bytes_freed - freed_before;
+}
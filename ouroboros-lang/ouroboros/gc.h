@@ -0,0 +1,61 @@
+#ifndef GC_H
+#define GC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "value.h"
+
+// Precise mark-sweep collector for the VM heap: strings, arrays and objects.
+//
+// Roots are the live stack frames, the pending return value, the classes'
+// static objects, the bytecode operand stack and the temporary root stack
+// below. Interned strings (literals, identifiers, bytecode constants) are
+// permanent and never collected.
+//
+// Allocation only schedules a collection (gc_pending); it runs at the next
+// safe point, which is a statement boundary, a bytecode loop back-edge or an
+// explicit gc_collect(). Native code therefore never sees a collection in the
+// middle of building a value.
+
+typedef struct GCStats {
+    size_t heap_bytes;          // Bytes currently held by strings, arrays and objects
+    size_t peak_heap_bytes;
+    size_t heap_limit;          // 0 = unlimited
+    size_t next_collection;     // heap_bytes that schedules the next collection
+    uint64_t bytes_allocated;   // Cumulative
+    uint64_t bytes_freed;       // Cumulative
+    uint64_t allocations;       // Strings, arrays and objects created
+    uint64_t collections;
+    uint64_t strings_freed;
+    uint64_t arrays_freed;
+    uint64_t objects_freed;
+} GCStats;
+
+extern int gc_pending;
+
+// Caps the live heap. A collection that cannot bring the heap under the limit
+// is a fatal out-of-memory error. 0 removes the limit.
+void gc_set_heap_limit(size_t bytes);
+const GCStats* gc_stats(void);
+void gc_print_stats(void);
+
+// Accounting hooks for the allocators (value.c, vm.c)
+void gc_track_alloc(size_t bytes);
+void gc_track_resize(size_t old_bytes, size_t new_bytes);
+
+// Runs a full collection now and returns the number of bytes freed.
+size_t gc_collect(void);
+static inline void gc_safepoint(void) {
+    if (gc_pending) gc_collect();
+}
+
+// Values held only in C locals while script code runs (an operand while the
+// other side is evaluated, a new object while its constructor runs, ...)
+// must stay pushed here for the duration.
+void gc_push_root(Value value);
+void gc_pop_roots(int count);
+
+// Marking, for root providers
+void gc_mark_value(Value value);
+
+#endif // GC_H
@@ -1,8 +0,0 @@
-#ifndef IR_H
-#define IR_H
-
-#include "parser.h"
-
-void generate_ir(ASTNode *root);
-
-#endif // IR_H
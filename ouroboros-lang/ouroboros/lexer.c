@@ -3,10 +3,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include "lexer.h"
+#include "ourolang/scan.h"
 
 // --- Globals for string lexing ---
 static const char* current_source_string = NULL;
-static int current_string_pos = 0;
+static size_t current_source_len = 0;
+static size_t current_string_pos = 0;
 static int current_line_lex = 1;
 static int current_col_lex = 1;
 // ---
@@ -28,43 +30,17 @@ static int string_peek_lex() {
     return current_source_string[current_string_pos];
 }
 
+// Whitespace and both comment styles are skipped by the vectorized scanner
+// in scan.h; only the line and column have to be caught up afterwards
 static void skip_whitespace_and_comments_string() {
-    int c;
-    while ((c = string_getc_lex()) != EOF) {
-        if (c == ' ' || c == '\t' || c == '\r') { // Added \r
-            current_col_lex++;
-        } else if (c == '\n') {
-            current_line_lex++;
-            current_col_lex = 1;
-        } else if (c == '/' && string_peek_lex() == '/') { // Single-line comment
-            current_col_lex += 2;
-            while ((c = string_getc_lex()) != '\n' && c != EOF) { current_col_lex++; }
-            if (c == '\n') { // Consumed the newline
-                current_line_lex++;
-                current_col_lex = 1;
-            }
-        } else if (c == '/' && string_peek_lex() == '*') { // Multi-line comment
-            string_getc_lex(); // consume '*'
-            current_col_lex += 2; 
-            while ((c = string_getc_lex()) != EOF) {
-                if (c == '*') {
-                    if (string_peek_lex() == '/') {
-                        string_getc_lex(); // consume '/'
-                        current_col_lex += 2;
-                        break; 
-                    } else { current_col_lex++; }
-                } else if (c == '\n') {
-                    current_line_lex++;
-                    current_col_lex = 1;
-                } else {
-                    current_col_lex++;
-                }
-            }
-             if (c == EOF) { /* Unterminated comment, error reported by parser usually */ }
-        } else {
-            string_ungetc_lex(); // Put back non-whitespace/comment char
-            break;
-        }
+    OuroScanLines lines = { 0, 0 };
+    size_t start = current_string_pos;
+    current_string_pos = ouro_skip_space_and_comments(current_source_string, start, current_source_len, &lines, 1);
+    if (lines.count > 0) {
+        current_line_lex += (int)lines.count;
+        current_col_lex = 1 + (int)(current_string_pos - (lines.last + 1));
+    } else {
+        current_col_lex += (int)(current_string_pos - start);
     }
 }
 
@@ -113,15 +89,14 @@ static Token get_next_token_from_string() {
     tok.col = current_col_lex;
 
     if (isalpha(c) || c == '_') { // Identifiers or Keywords
-        int i = 0;
-        tok.text[i++] = c;
-        current_col_lex++;
-        while ((c = string_getc_lex()) != EOF && (isalnum(c) || c == '_')) {
-            if (i < (int)sizeof(tok.text) - 1) tok.text[i++] = c;
-            current_col_lex++;
-        }
-        tok.text[i] = '\0';
-        if (c != EOF) string_ungetc_lex();
+        size_t start = current_string_pos - 1;
+        size_t end = ouro_scan_ident(current_source_string, current_string_pos, current_source_len);
+        size_t n = end - start;
+        if (n > sizeof(tok.text) - 1) n = sizeof(tok.text) - 1; // Longer names are truncated
+        memcpy(tok.text, current_source_string + start, n);
+        tok.text[n] = '\0';
+        current_col_lex += (int)(end - start);
+        current_string_pos = end;
         
         if (is_lexer_keyword(tok.text)) {
             tok.type = TOKEN_KEYWORD;
@@ -145,9 +120,12 @@ static Token get_next_token_from_string() {
         }
 
         while ((c = string_getc_lex()) != EOF) {
-            if (isdigit(c)) {
-                if (i < (int)sizeof(tok.text) - 1) tok.text[i++] = c;
-                current_col_lex++;
+            if (isdigit(c)) { // c and the rest of its run
+                size_t start = current_string_pos - 1;
+                size_t end = ouro_scan_digits(current_source_string, current_string_pos, current_source_len);
+                for (size_t k = start; k < end && i < (int)sizeof(tok.text) - 1; k++) tok.text[i++] = current_source_string[k];
+                current_col_lex += (int)(end - start);
+                current_string_pos = end;
             } else if (c == '.' && !has_decimal) { // Only one decimal point allowed
                 if (i < (int)sizeof(tok.text) - 1) tok.text[i++] = c;
                 has_decimal = 1;
@@ -181,7 +159,19 @@ static Token get_next_token_from_string() {
     } else if (c == '"') { // String literals
         int i = 0;
         current_col_lex++; // For opening quote
-        while ((c = string_getc_lex()) != EOF) {
+        for (;;) {
+            // Copy the plain run up to the closing quote or the next escape
+            size_t start = current_string_pos;
+            size_t end = ouro_find_either(current_source_string, start, current_source_len, '"', '\\');
+            size_t room = sizeof(tok.text) - 1 - (size_t)i;
+            if (end - start > room) end = start + room;
+            memcpy(tok.text + i, current_source_string + start, end - start);
+            i += (int)(end - start);
+            current_col_lex += (int)(end - start);
+            current_string_pos = end;
+            if (i >= (int)sizeof(tok.text) - 1) { /* String too long */ break; }
+
+            if ((c = string_getc_lex()) == EOF) break;
             current_col_lex++;
             if (c == '"') break; // End of string
             if (c == '\\') { // Escape sequence
@@ -196,8 +186,6 @@ static Token get_next_token_from_string() {
                     case '"': tok.text[i++] = '"'; break;
                     default: tok.text[i++] = next_char; break; // Store as is
                 }
-            } else {
-                if (i < (int)sizeof(tok.text) - 1) tok.text[i++] = c;
             }
             if (i >= (int)sizeof(tok.text) -1) { /* String too long */ break;}
         }
@@ -302,6 +290,7 @@ static Token get_next_token_from_string() {
 
 Token* lex(const char* source) {
     current_source_string = source;
+    current_source_len = strlen(source);
     current_string_pos = 0;
     current_line_lex = 1;
     current_col_lex = 1;
@@ -3,12 +3,14 @@
 #include <string.h> // For strcmp
 #include "lexer.h"
 #include "parser.h"
-#include "ast_types.h" // For ASTNode, print_ast, free_ast
+#include "ast_types.h" // For ASTNode, print_ast, the AST arena
 #include "semantic.h"  // For analyze_program
 #include "optimize.h"  // For optimize_ast
 #include "vm.h"        // For vm_init, run_vm, vm_cleanup
 #include "stdlib.h"    // For register_stdlib_functions
 #include "module.h"    // For module_manager_init/cleanup, if used directly
+#include "bytecode.h"  // For the -bytecode backend
+#include "gc.h"        // For -heap-limit and -gc-stats
 
 // Function to read file content into a string
 char* read_file_to_string(const char* filename) {
@@ -46,7 +48,8 @@ char* read_file_to_string(const char* filename) {
 int main(int argc, char *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <filename.ouro> [options...]\n", argv[0]);
-        // Example options: -print-tokens, -print-ast, -no-optimize, -no-run
+        // Example options: -print-tokens, -print-ast, -no-optimize, -no-run, -bytecode, -print-bytecode,
+        //                  -heap-limit <MB>, -gc-stats
         return 1;
     }
     
@@ -55,12 +58,21 @@ int main(int argc, char *argv[]) {
     int print_ast_flag = 0;
     int no_optimize_flag = 0;
     int no_run_flag = 0;
+    int bytecode_flag = 0;
+    int print_bytecode_flag = 0;
+    int gc_stats_flag = 0;
 
     for (int i = 2; i < argc; ++i) {
         if (strcmp(argv[i], "-print-tokens") == 0) print_tokens_flag = 1;
         else if (strcmp(argv[i], "-print-ast") == 0) print_ast_flag = 1;
         else if (strcmp(argv[i], "-no-optimize") == 0) no_optimize_flag = 1;
         else if (strcmp(argv[i], "-no-run") == 0) no_run_flag = 1;
+        else if (strcmp(argv[i], "-bytecode") == 0) bytecode_flag = 1;
+        else if (strcmp(argv[i], "-print-bytecode") == 0) bytecode_flag = print_bytecode_flag = 1;
+        else if (strcmp(argv[i], "-gc-stats") == 0) gc_stats_flag = 1;
+        else if (strcmp(argv[i], "-heap-limit") == 0 && i + 1 < argc) {
+            gc_set_heap_limit((size_t)strtoull(argv[++i], NULL, 10) * 1024 * 1024);
+        }
     }
 
     char* source_code = read_file_to_string(filename);
@@ -88,11 +100,14 @@ int main(int argc, char *argv[]) {
     }
 
     // --- Parsing ---
+    AstArena* ast_arena = ast_arena_create(); // Owns every node and string of the program's AST
+    ast_arena_activate(ast_arena);
     ASTNode* ast_root = parse(tokens); // parser.c sets its global `program` to ast_root
     free(tokens); // Tokens are copied into AST or no longer needed after parsing
     
     if (!ast_root) {
         fprintf(stderr, "Parsing failed.\n");
+        ast_arena_destroy(ast_arena);
         free(source_code);
         return 1;
     }
@@ -103,7 +118,9 @@ int main(int argc, char *argv[]) {
     }
 
     // --- Semantic Analysis ---
+    register_stdlib_functions(); // Natives first, so the semantic pass knows their names
     analyze_program(ast_root); // Populates symbol tables, does basic type checks, etc.
+    resolve_program(ast_root); // Assigns stack frame slots to parameters and locals
     // check_semantics(ast_root); // Optional second pass for more complex checks
 
     // --- Optimization ---
@@ -120,6 +137,12 @@ int main(int argc, char *argv[]) {
     } else {
         printf("\n==== Optimization Skipped ====\n");
     }
+
+    // --- Bytecode (optional backend) ---
+    if (bytecode_flag) {
+        bytecode_compile_program(ast_root);
+        if (print_bytecode_flag) bytecode_disassemble_program(ast_root);
+    }
     
     // --- Execution (VM) ---
     if (!no_run_flag) {
@@ -128,6 +151,7 @@ int main(int argc, char *argv[]) {
         
         vm_init();    // Initialize VM state
         run_vm(ast_root); // Execute the AST
+        if (gc_stats_flag) gc_print_stats();
         vm_cleanup(); // Clean up VM state
 
         module_manager_cleanup(); // Cleanup module system
@@ -136,7 +160,8 @@ int main(int argc, char *argv[]) {
     }
 
     // --- Cleanup ---
-    free_ast(ast_root);
+    bytecode_free_program(ast_root);
+    ast_arena_destroy(ast_arena);
     free(source_code);
 
     printf("\nCompilation and execution pipeline finished.\n");
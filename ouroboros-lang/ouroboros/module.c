@@ -8,7 +8,6 @@
 #include "parser.h"
 #include "ast_types.h"
 #include "semantic.h"
-#include "ir.h"
 #include "vm.h"
 
 // Global module manager
@@ -35,7 +34,7 @@ void module_manager_cleanup() {
         if (current->dependencies) {
             free(current->dependencies);
         }
-        // Note: AST cleanup should be handled elsewhere
+        ast_arena_destroy(current->arena); // Releases the module's whole AST
         free(current);
         current = next;
     }
@@ -202,7 +201,12 @@ Module* module_load(const char *module_name) {
     extern ASTNode *program;   // declared in parser.c
     ASTNode *prev_program = program;
 
+    // The module's nodes go into its own arena; the importer's stays intact
+    module->arena = ast_arena_create();
+    AstArena *prev_arena = ast_arena_activate(module->arena);
+
     module->ast = parse(tokens);
+    free(tokens);
 
     /* Restore previous global AST so that later compilation stages (e.g.
        field default-initialisation) can still see the main program's classes. */
@@ -210,6 +214,7 @@ Module* module_load(const char *module_name) {
         fprintf(stderr, "Error: Failed to parse module %s\n", module_name);
         free(source);
         program = prev_program; // make sure it's reset even on error
+        ast_arena_activate(prev_arena);
         return NULL;
     }
 
@@ -217,6 +222,7 @@ Module* module_load(const char *module_name) {
 
     // Analyze the module
     analyze_program(module->ast);
+    ast_arena_activate(prev_arena);
     
     free(source);
     
@@ -323,10 +329,8 @@ ASTNode* compile_multiple_files(char **filenames, int file_count) {
                 cloned->left = func->left;
                 cloned->right = func->right;
                 // Copy type information
-                strncpy(cloned->data_type, func->data_type, sizeof(cloned->data_type) - 1);
-                cloned->data_type[sizeof(cloned->data_type) - 1] = '\0';
-                strncpy(cloned->generic_type, func->generic_type, sizeof(cloned->generic_type) - 1);
-                cloned->generic_type[sizeof(cloned->generic_type) - 1] = '\0';
+                cloned->data_type = ast_intern(func->data_type);
+                cloned->generic_type = ast_intern(func->generic_type);
                 cloned->is_void = func->is_void;
                 cloned->is_array = func->is_array;
                 cloned->array_size = func->array_size;
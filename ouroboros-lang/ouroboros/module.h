@@ -8,6 +8,7 @@ typedef struct Module {
     char *name;                    // Module name (derived from filename)
     char *filename;                // Full path to the module file
     ASTNode *ast;                  // Parsed AST for this module
+    AstArena *arena;               // Owns the module's AST nodes and strings
     struct Module **dependencies;  // Array of module dependencies
     int dependency_count;          // Number of dependencies
     int is_loaded;                 // Flag to prevent circular loading
@@ -1,78 +1,651 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "optimize.h"
-// #include "parser.h" // No longer needed if ast_types.h is included by optimize.h
 #include "ast_types.h" // For node_type_to_string and ASTNode structure
+#include "eval.h"      // evaluate_binary_values: folding applies the runtime's own operator semantics
+#include "value.h"
 
+// The optimizer runs after resolve_program, so identifiers already carry their
+// frame slots. Every pass rewrites nodes in place (dropped subtrees go back
+// with the arena) and returns how many rewrites it made; optimize_ast repeats
+// the pipeline until a round changes nothing.
+
+#define MAX_OPTIMIZE_ROUNDS 8
+
+// What the optimizer can tell about an expression's runtime type
+typedef enum {
+    KIND_UNKNOWN,
+    KIND_INT,
+    KIND_FLOAT,
+    KIND_BOOL,
+    KIND_STRING,
+    KIND_NULL
+} ExprKind;
+
+// A literal operand. Strings stay as their text so folding never allocates on
+// the VM heap, which does not exist yet.
+typedef struct {
+    ExprKind kind;
+    Value value;      // Every kind but KIND_STRING
+    const char *text; // KIND_STRING
+} Constant;
+
+static int is_assignment_op(const char *op) {
+    return (op[0] == '=' && op[1] == '\0') ||
+           ((op[0] == '+' || op[0] == '-' || op[0] == '*' || op[0] == '/' || op[0] == '%') && op[1] == '=' && op[2] == '\0');
+}
+
+static int is_comparison_op(const char *op) {
+    return strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 || strcmp(op, "<") == 0 ||
+           strcmp(op, ">") == 0 || strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0;
+}
+
+static int is_function_node(const ASTNode *node) {
+    return node->type == AST_FUNCTION || node->type == AST_TYPED_FUNCTION || node->type == AST_CLASS_METHOD;
+}
+
+static int read_constant(const ASTNode *node, Constant *out) {
+    if (!node || node->type != AST_LITERAL) return 0;
+    const char *type = node->data_type;
+    if (strcmp(type, "string") == 0) {
+        out->kind = KIND_STRING;
+        out->text = node->value;
+        return 1;
+    }
+    if (strcmp(type, "int") != 0 && strcmp(type, "float") != 0 && strcmp(type, "bool") != 0 &&
+        strcmp(type, "null") != 0 && strcmp(node->value, "null") != 0) {
+        return 0;
+    }
+    out->value = value_from_literal(node->value, type);
+    switch (out->value.type) {
+        case VAL_INT: out->kind = KIND_INT; return 1;
+        case VAL_DOUBLE: out->kind = KIND_FLOAT; return 1;
+        case VAL_BOOL: out->kind = KIND_BOOL; return 1;
+        case VAL_NULL: out->kind = KIND_NULL; return 1;
+        default: return 0;
+    }
+}
+
+static int constant_truthy(const Constant *c) {
+    return c->kind == KIND_STRING ? c->text[0] != '\0' : value_is_truthy(c->value);
+}
+
+static const char* constant_text(const Constant *c, char *buf, size_t buf_size) {
+    return c->kind == KIND_STRING ? c->text : value_to_cstring(c->value, buf, buf_size);
+}
+
+// Conservative test for strings the runtime would treat as numbers
+static int text_may_be_numeric(const char *text) {
+    char *end = NULL;
+    strtod(text, &end);
+    return end != text;
+}
+
+static void set_literal(ASTNode *node, const char *text, const char *data_type) {
+    if (node->type == AST_TERNARY) node->next = NULL; // A ternary keeps its else-branch in next
+    node->type = AST_LITERAL;
+    node->value = text;
+    node->data_type = data_type;
+    node->left = NULL;
+    node->right = NULL;
+    node->slot = -1;
+    node->depth = 0;
+}
+
+// Shortest text that reads back as the same double and still parses as a float
+static int format_float(double number, char *buf, size_t buf_size) {
+    if (!isfinite(number)) return 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(buf, buf_size, "%.*g", precision, number);
+        if (strtod(buf, NULL) == number) break;
+    }
+    if (!strpbrk(buf, ".eE") && strlen(buf) + 3 <= buf_size) strcat(buf, ".0");
+    return 1;
+}
+
+static int set_constant(ASTNode *node, Value value) {
+    char text[64];
+    const char *data_type;
+    switch (value.type) {
+        case VAL_INT:
+            snprintf(text, sizeof(text), "%lld", (long long)value.as.integer);
+            data_type = "int";
+            break;
+        case VAL_DOUBLE:
+            if (!format_float(value.as.number, text, sizeof(text))) return 0;
+            data_type = "float";
+            break;
+        case VAL_BOOL:
+            strcpy(text, value.as.boolean ? "true" : "false");
+            data_type = "bool";
+            break;
+        case VAL_NULL:
+            strcpy(text, "null");
+            data_type = "null";
+            break;
+        default:
+            return 0; // undefined, or a heap value
+    }
+    set_literal(node, ast_intern(text), data_type);
+    return 1;
+}
+
+// Replaces `node` by a copy of `with`, keeping node's place in its list
+static int replace_node(ASTNode *node, const ASTNode *with) {
+    ASTNode *sibling = node->type == AST_TERNARY ? NULL : node->next;
+    if (with->type == AST_TERNARY && sibling) return 0;
+    *node = *with;
+    if (node->type != AST_TERNARY) node->next = sibling;
+    return 1;
+}
+
+static void make_block(ASTNode *node, ASTNode *body) {
+    node->type = AST_BLOCK;
+    node->value = ast_intern("block");
+    node->left = body;
+    node->right = NULL;
+}
+
+// Post-order walk applying `visit` to every node; returns the total rewrites
+static int walk_tree(ASTNode *node, int (*visit)(ASTNode*)) {
+    int rewrites = 0;
+    for (; node; node = node->next) {
+        rewrites += walk_tree(node->left, visit);
+        rewrites += walk_tree(node->right, visit);
+        if (node->type == AST_TERNARY) {
+            rewrites += walk_tree(node->next, visit); // The else-branch, not a sibling
+            return rewrites + visit(node);
+        }
+        rewrites += visit(node);
+    }
+    return rewrites;
+}
+
+// --- Constant folding ---
+
+static int fold_concat(ASTNode *node, const Constant *left, const Constant *right) {
+    char left_buf[64], right_buf[64];
+    const char *l = constant_text(left, left_buf, sizeof(left_buf));
+    const char *r = constant_text(right, right_buf, sizeof(right_buf));
+    size_t left_len = strlen(l), right_len = strlen(r);
+    char *joined = (char*)malloc(left_len + right_len + 1);
+    if (!joined) {
+        fprintf(stderr, "Error: Memory allocation failed while folding a string constant\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(joined, l, left_len);
+    memcpy(joined + left_len, r, right_len + 1);
+    set_literal(node, ast_intern(joined), "string");
+    free(joined);
+    return 1;
+}
+
+static int fold_binary(ASTNode *node) {
+    const char *op = node->value;
+    Constant left, right;
+    if (is_assignment_op(op) || !read_constant(node->left, &left)) return 0;
+
+    // The right side of && and || only matters when the left one does not decide
+    if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) {
+        int truthy = constant_truthy(&left);
+        if (op[0] == '&' && !truthy) return set_constant(node, value_bool(0));
+        if (op[0] == '|' && truthy) return set_constant(node, value_bool(1));
+        if (!read_constant(node->right, &right)) return 0;
+        return set_constant(node, value_bool(constant_truthy(&right)));
+    }
+    if (!read_constant(node->right, &right)) return 0;
+
+    if (strcmp(op, "+") == 0 &&
+        (left.kind == KIND_STRING || right.kind == KIND_STRING ||
+         !value_is_numeric(left.value) || !value_is_numeric(right.value))) {
+        return fold_concat(node, &left, &right);
+    }
+    if (left.kind == KIND_STRING || right.kind == KIND_STRING) {
+        // Only comparisons between two non-numeric strings are worth doing here
+        if (left.kind != right.kind || !is_comparison_op(op)) return 0;
+        if (text_may_be_numeric(left.text) || text_may_be_numeric(right.text)) return 0;
+        int order = strcmp(left.text, right.text);
+        if (strcmp(op, "==") == 0) return set_constant(node, value_bool(order == 0));
+        if (strcmp(op, "!=") == 0) return set_constant(node, value_bool(order != 0));
+        if (strcmp(op, "<") == 0) return set_constant(node, value_bool(order < 0));
+        if (strcmp(op, ">") == 0) return set_constant(node, value_bool(order > 0));
+        if (strcmp(op, "<=") == 0) return set_constant(node, value_bool(order <= 0));
+        return set_constant(node, value_bool(order >= 0));
+    }
+
+    // Division by zero and out-of-range shifts stay for the runtime to report
+    if ((strcmp(op, "/") == 0 || strcmp(op, "%") == 0) && value_as_number(right.value) == 0) return 0;
+    if (op[0] == op[1] && (op[0] == '<' || op[0] == '>')) {
+        int64_t shift = value_as_int(right.value);
+        if (shift < 0 || shift > 63) return 0;
+    }
+    return set_constant(node, evaluate_binary_values(op, left.value, right.value));
+}
+
+static int fold_unary(ASTNode *node) {
+    Constant operand;
+    if (!read_constant(node->left, &operand)) return 0;
+    if (strcmp(node->value, "!") == 0) return set_constant(node, value_bool(!constant_truthy(&operand)));
+    if (strcmp(node->value, "-") != 0 && strcmp(node->value, "+") != 0) return 0;
+
+    int negate = node->value[0] == '-';
+    switch (operand.kind) {
+        case KIND_INT:
+            return set_constant(node, value_int(negate ? -operand.value.as.integer : operand.value.as.integer));
+        case KIND_FLOAT: case KIND_BOOL: {
+            double number = value_as_number(operand.value);
+            return set_constant(node, value_double(negate ? -number : number));
+        }
+        default:
+            return 0; // Strings and null are left to the runtime (and its error message)
+    }
+}
+
+static int fold_ternary(ASTNode *node) {
+    Constant condition;
+    if (!read_constant(node->left, &condition)) return 0;
+    ASTNode *taken = constant_truthy(&condition) ? node->right : node->next;
+    if (!taken) {
+        set_literal(node, ast_intern("undefined"), "");
+        return 1;
+    }
+    return replace_node(node, taken);
+}
+
+static int fold_node(ASTNode *node) {
+    switch (node->type) {
+        case AST_BINARY_OP: return fold_binary(node);
+        case AST_UNARY_OP: return fold_unary(node);
+        case AST_TERNARY: return fold_ternary(node);
+        default: return 0;
+    }
+}
+
+// Folds every operator whose operands are literals into a literal of the
+// type the runtime would produce ("1.5 + 2" is the float 3.5, "a" + 1 is "a1").
 void constant_fold(ASTNode *node) {
-    if (!node) return;
-
-    // Fold children first, unless this node itself will become a literal
-    // (in which case its children will be detached and freed).
-    if (node->type != AST_BINARY_OP) { 
-      if (node->left) constant_fold(node->left);
-      if (node->right) constant_fold(node->right);
-    } else { 
-        if (node->left && node->left->type != AST_LITERAL) constant_fold(node->left);
-        if (node->right && node->right->type != AST_LITERAL) constant_fold(node->right);
-    }
-
-
-    if (node->type == AST_BINARY_OP) {
-        if (node->left && node->right &&
-            node->left->type == AST_LITERAL &&
-            node->right->type == AST_LITERAL) {
-
-            int l_val = atoi(node->left->value);
-            int r_val = atoi(node->right->value);
-            int result = 0;
-            int folded = 1; 
-
-            if (strcmp(node->value, "+") == 0) result = l_val + r_val;
-            else if (strcmp(node->value, "-") == 0) result = l_val - r_val;
-            else if (strcmp(node->value, "*") == 0) result = l_val * r_val;
-            else if (strcmp(node->value, "/") == 0) {
-                if (r_val != 0) result = l_val / r_val;
-                else {
-                    fprintf(stderr, "[OPT L%d:%d] Error: Division by zero during constant folding: %s / %s \n", node->line, node->col, node->left->value, node->right->value);
-                    folded = 0; 
+    walk_tree(node, fold_node);
+}
+
+static int fold_constants(ASTNode *program) {
+    return walk_tree(program, fold_node);
+}
+
+// --- Constant propagation ---
+//
+// A declaration whose initializer is a literal and whose slot is never
+// assigned afterwards is an immutable binding: later reads of the slot can use
+// the literal directly. Only declarations that are direct statements of their
+// function (or program) body qualify, so the binding has certainly run before
+// any read that comes after it in the same body. Reads from top-level functions
+// of a program-level binding additionally require `const`, because such a
+// function may be called before the declaration runs. The declaration itself
+// stays: code that looks the name up at runtime still finds the value.
+
+enum {
+    SLOT_REDECLARED = 1 << 0,
+    SLOT_WRITTEN    = 1 << 1,
+    SLOT_TOP_LEVEL  = 1 << 2,
+    SLOT_CONSTANT   = 1 << 3, // Decided after the scan
+    SLOT_DECLARED   = 1 << 4  // Rewrite walk has passed the declaration
+};
+
+typedef struct UnitSlots {
+    ASTNode *unit;           // AST_PROGRAM or a resolved function
+    ASTNode **decls;         // Per slot: its declaration, if any
+    unsigned char *flags;    // Per slot: SLOT_* bits
+    struct UnitSlots *enclosing;
+    struct UnitSlots *next;  // All units, for lookup and cleanup
+} UnitSlots;
+
+typedef struct {
+    UnitSlots *units;
+    const char **named_writes; // Names assigned without a resolved slot
+    int named_write_count;
+    int named_write_capacity;
+    int rewrites;
+} Propagator;
+
+static UnitSlots* add_unit(Propagator *p, ASTNode *unit, UnitSlots *enclosing) {
+    UnitSlots *slots = (UnitSlots*)calloc(1, sizeof(UnitSlots));
+    int count = unit->local_count > 0 ? unit->local_count : 0;
+    if (slots && count > 0) {
+        slots->decls = (ASTNode**)calloc((size_t)count, sizeof(ASTNode*));
+        slots->flags = (unsigned char*)calloc((size_t)count, 1);
+    }
+    if (!slots || (count > 0 && (!slots->decls || !slots->flags))) {
+        fprintf(stderr, "Error: Memory allocation failed for constant propagation\n");
+        exit(EXIT_FAILURE);
+    }
+    slots->unit = unit;
+    slots->enclosing = enclosing;
+    slots->next = p->units;
+    p->units = slots;
+    return slots;
+}
+
+static UnitSlots* find_unit(Propagator *p, const ASTNode *unit) {
+    for (UnitSlots *slots = p->units; slots; slots = slots->next) {
+        if (slots->unit == unit) return slots;
+    }
+    return NULL;
+}
+
+// The unit whose frame an identifier at `depth` refers to
+static UnitSlots* unit_at_depth(UnitSlots *slots, int depth) {
+    while (slots && depth-- > 0) slots = slots->enclosing;
+    return slots;
+}
+
+static int valid_slot(const UnitSlots *slots, int slot) {
+    return slots && slot >= 0 && slot < slots->unit->local_count;
+}
+
+static void note_named_write(Propagator *p, const char *name) {
+    if (p->named_write_count == p->named_write_capacity) {
+        int new_capacity = p->named_write_capacity ? p->named_write_capacity * 2 : 16;
+        const char **grown = (const char**)realloc((void*)p->named_writes, (size_t)new_capacity * sizeof(const char*));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for constant propagation\n");
+            exit(EXIT_FAILURE);
+        }
+        p->named_writes = grown;
+        p->named_write_capacity = new_capacity;
+    }
+    p->named_writes[p->named_write_count++] = name;
+}
+
+static int is_named_write(const Propagator *p, const char *name) {
+    for (int i = 0; i < p->named_write_count; i++) {
+        if (strcmp(p->named_writes[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static void note_write(Propagator *p, UnitSlots *slots, const ASTNode *target) {
+    if (!target || target->type != AST_IDENTIFIER) return;
+    if (target->slot < 0) {
+        note_named_write(p, target->value);
+        return;
+    }
+    UnitSlots *owner = unit_at_depth(slots, target->depth);
+    if (valid_slot(owner, target->slot)) owner->flags[target->slot] |= SLOT_WRITTEN;
+}
+
+static ASTNode* unit_body(ASTNode *unit) {
+    ASTNode *body = unit->type == AST_PROGRAM ? unit->left : unit->right;
+    if (body && body->type == AST_BLOCK && !body->next) body = body->left;
+    return body;
+}
+
+static void mark_top_level(UnitSlots *slots) {
+    for (ASTNode *stmt = unit_body(slots->unit); stmt; stmt = stmt->next) {
+        if ((stmt->type == AST_VAR_DECL || stmt->type == AST_TYPED_VAR_DECL) && valid_slot(slots, stmt->slot)) {
+            slots->flags[stmt->slot] |= SLOT_TOP_LEVEL;
+        }
+    }
+}
+
+static void scan_unit(Propagator *p, ASTNode *node, UnitSlots *slots) {
+    for (; node; node = node->next) {
+        if (is_function_node(node) && node->local_count >= 0) {
+            UnitSlots *inner = add_unit(p, node, slots);
+            mark_top_level(inner);
+            scan_unit(p, node->right, inner);
+            continue;
+        }
+        switch (node->type) {
+            case AST_VAR_DECL: case AST_TYPED_VAR_DECL:
+                if (!valid_slot(slots, node->slot)) {
+                    note_named_write(p, node->value);
+                } else if (slots->decls[node->slot]) {
+                    slots->flags[node->slot] |= SLOT_REDECLARED;
+                } else {
+                    slots->decls[node->slot] = node;
                 }
-            } else {
-                folded = 0; 
-            }
-
-            if (folded) {
-                free_ast(node->left); 
-                free_ast(node->right);
-
-                snprintf(node->value, sizeof(node->value), "%d", result); 
-                node->type = AST_LITERAL;
-                node->left = NULL; 
-                node->right = NULL;
-                
-                strncpy(node->data_type, "int", sizeof(node->data_type) - 1);
-                node->data_type[sizeof(node->data_type) - 1] = '\0';
-
-                printf("[OPT] Folded constant: %d at L%d:%d (New type: %s)\n", result, node->line, node->col, node->data_type);
-            }
+                break;
+            case AST_ASSIGN:
+                note_write(p, slots, node->left);
+                break;
+            case AST_BINARY_OP:
+                if (is_assignment_op(node->value)) note_write(p, slots, node->left);
+                break;
+            case AST_UNARY_OP:
+                if (strcmp(node->value, "++") == 0 || strcmp(node->value, "--") == 0) note_write(p, slots, node->left);
+                break;
+            default:
+                break;
         }
+        scan_unit(p, node->left, slots);
+        scan_unit(p, node->right, slots);
     }
 }
 
-void optimize_ast(ASTNode *root) {
-    if (!root) return;
-    
-    if (root->left) {
-        optimize_ast(root->left);
+static void decide_constants(Propagator *p) {
+    Constant literal;
+    for (UnitSlots *slots = p->units; slots; slots = slots->next) {
+        for (int slot = 0; slot < slots->unit->local_count; slot++) {
+            ASTNode *decl = slots->decls[slot];
+            unsigned char flags = slots->flags[slot];
+            if (!decl || !(flags & SLOT_TOP_LEVEL) || (flags & (SLOT_REDECLARED | SLOT_WRITTEN))) continue;
+            if (!read_constant(decl->right, &literal) || is_named_write(p, decl->value)) continue;
+            slots->flags[slot] |= SLOT_CONSTANT;
+        }
+    }
+}
+
+static void propagate_read(Propagator *p, ASTNode *node, UnitSlots *slots) {
+    if (node->slot < 0) return;
+    UnitSlots *owner = unit_at_depth(slots, node->depth);
+    if (!valid_slot(owner, node->slot)) return;
+    unsigned char flags = owner->flags[node->slot];
+    if (!(flags & SLOT_CONSTANT) || !(flags & SLOT_DECLARED)) return;
+    const ASTNode *decl = owner->decls[node->slot];
+    if (node->depth > 0 && strcmp(decl->access_modifier, "const") != 0) return;
+    set_literal(node, decl->right->value, decl->right->data_type);
+    p->rewrites++;
+}
+
+static void rewrite_unit(Propagator *p, ASTNode *node, UnitSlots *slots) {
+    for (; node; node = node->next) {
+        if (is_function_node(node) && node->local_count >= 0) {
+            rewrite_unit(p, node->right, find_unit(p, node));
+            continue;
+        }
+        switch (node->type) {
+            case AST_VAR_DECL: case AST_TYPED_VAR_DECL:
+                rewrite_unit(p, node->right, slots);
+                if (valid_slot(slots, node->slot)) slots->flags[node->slot] |= SLOT_DECLARED;
+                continue;
+            case AST_IDENTIFIER:
+                propagate_read(p, node, slots);
+                continue;
+            case AST_MAP:
+                // Identifier keys are property names, not reads
+                for (ASTNode *pair = node->left; pair; pair = pair->next) {
+                    if (pair->left && pair->left->type != AST_IDENTIFIER) rewrite_unit(p, pair->left, slots);
+                    rewrite_unit(p, pair->right, slots);
+                }
+                continue;
+            default:
+                break;
+        }
+        rewrite_unit(p, node->left, slots);
+        rewrite_unit(p, node->right, slots);
+    }
+}
+
+static int propagate_constants(ASTNode *program) {
+    if (program->type != AST_PROGRAM || program->local_count < 0) return 0;
+
+    Propagator p = { NULL, NULL, 0, 0, 0 };
+    UnitSlots *globals = add_unit(&p, program, NULL);
+    mark_top_level(globals);
+    scan_unit(&p, program->left, globals);
+    decide_constants(&p);
+    rewrite_unit(&p, program->left, globals);
+
+    while (p.units) {
+        UnitSlots *next = p.units->next;
+        free(p.units->decls);
+        free(p.units->flags);
+        free(p.units);
+        p.units = next;
+    }
+    free((void*)p.named_writes);
+    return p.rewrites;
+}
+
+// --- Dead-branch elimination ---
+
+static int eliminate_branch(ASTNode *node) {
+    Constant condition;
+    if (node->type == AST_IF && read_constant(node->left, &condition)) {
+        ASTNode *else_node = (node->next && node->next->type == AST_ELSE) ? node->next : NULL;
+        ASTNode *taken = constant_truthy(&condition) ? node->right : (else_node ? else_node->left : NULL);
+        make_block(node, taken);
+        if (else_node) make_block(else_node, NULL);
+        return 1;
     }
-    if (root->right) {
-        optimize_ast(root->right);
+    if (node->type == AST_WHILE && read_constant(node->left, &condition) && !constant_truthy(&condition)) {
+        make_block(node, NULL);
+        return 1;
     }
-    
-    constant_fold(root); 
+    return 0;
+}
+
+static int eliminate_dead_branches(ASTNode *program) {
+    return walk_tree(program, eliminate_branch);
+}
+
+// --- Algebraic simplification ---
+//
+// Identities only hold for operands of a known numeric or boolean type:
+// x + 0 concatenates when x is a string, x * 1 converts a string or bool.
+
+static ExprKind expression_kind(const ASTNode *node) {
+    Constant constant;
+    if (!node) return KIND_UNKNOWN;
+    switch (node->type) {
+        case AST_LITERAL:
+            return read_constant(node, &constant) ? constant.kind : KIND_UNKNOWN;
+        case AST_BINARY_OP: {
+            const char *op = node->value;
+            if (is_assignment_op(op)) return KIND_UNKNOWN;
+            if (is_comparison_op(op) || strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) return KIND_BOOL;
+            ExprKind left = expression_kind(node->left), right = expression_kind(node->right);
+            if (strcmp(op, "+") == 0 && (left == KIND_STRING || right == KIND_STRING)) return KIND_STRING;
+            int numeric = (left == KIND_INT || left == KIND_FLOAT || left == KIND_BOOL) &&
+                          (right == KIND_INT || right == KIND_FLOAT || right == KIND_BOOL);
+            if (!numeric) return KIND_UNKNOWN;
+            if (op[0] == op[1] && (op[0] == '<' || op[0] == '>')) return KIND_INT;
+            if (left == KIND_FLOAT || right == KIND_FLOAT) return KIND_FLOAT;
+            // int / int is a float unless it divides evenly; % by zero is NaN
+            if (strcmp(op, "+") == 0 || strcmp(op, "-") == 0 || strcmp(op, "*") == 0) return KIND_INT;
+            return KIND_UNKNOWN;
+        }
+        case AST_UNARY_OP: {
+            if (strcmp(node->value, "!") == 0) return KIND_BOOL;
+            if (strcmp(node->value, "-") != 0 && strcmp(node->value, "+") != 0) return KIND_UNKNOWN;
+            ExprKind operand = expression_kind(node->left);
+            if (operand == KIND_INT || operand == KIND_FLOAT) return operand;
+            return operand == KIND_BOOL ? KIND_FLOAT : KIND_UNKNOWN;
+        }
+        default:
+            return KIND_UNKNOWN;
+    }
+}
+
+// Whether `c` is the number `n` and x OP c == x for every x of kind `x_kind`
+static int is_numeric_identity(const Constant *c, double n, ExprKind x_kind) {
+    if (x_kind == KIND_INT) return c->kind == KIND_INT && c->value.as.integer == (int64_t)n;
+    if (x_kind == KIND_FLOAT) return (c->kind == KIND_INT || c->kind == KIND_FLOAT) && value_as_number(c->value) == n;
+    return 0;
+}
+
+static int is_bool_constant(const Constant *c, int truth) {
+    return c->kind == KIND_BOOL && c->value.as.boolean == truth;
+}
 
-    if (root->next) {
-        optimize_ast(root->next);
+static int simplify_binary(ASTNode *node) {
+    const char *op = node->value;
+    if (is_assignment_op(op)) return 0;
+    Constant constant, other;
+    ASTNode *operand;
+    int constant_on_right;
+    if (read_constant(node->right, &constant) && !read_constant(node->left, &other)) {
+        operand = node->left;
+        constant_on_right = 1;
+    } else if (read_constant(node->left, &constant) && !read_constant(node->right, &other)) {
+        operand = node->right;
+        constant_on_right = 0;
+    } else {
+        return 0; // Both literal is folding's job
+    }
+    ExprKind kind = expression_kind(operand);
+
+    int identity = 0;
+    if (strcmp(op, "+") == 0) identity = kind == KIND_INT && is_numeric_identity(&constant, 0, kind); // -0.0 + 0 is 0.0
+    else if (strcmp(op, "-") == 0) identity = constant_on_right && is_numeric_identity(&constant, 0, kind);
+    else if (strcmp(op, "*") == 0) identity = is_numeric_identity(&constant, 1, kind);
+    else if (strcmp(op, "/") == 0) identity = constant_on_right && is_numeric_identity(&constant, 1, kind);
+    else if (strcmp(op, "&&") == 0) identity = kind == KIND_BOOL && is_bool_constant(&constant, 1);
+    else if (strcmp(op, "||") == 0) identity = kind == KIND_BOOL && is_bool_constant(&constant, 0);
+    else if (strcmp(op, "==") == 0) identity = kind == KIND_BOOL && is_bool_constant(&constant, 1);
+    else if (strcmp(op, "!=") == 0) identity = kind == KIND_BOOL && is_bool_constant(&constant, 0);
+    return identity ? replace_node(node, operand) : 0;
+}
+
+static int simplify_unary(ASTNode *node) {
+    ASTNode *operand = node->left;
+    if (!operand) return 0;
+    const char *op = node->value;
+    if (strcmp(op, "+") == 0) {
+        ExprKind kind = expression_kind(operand);
+        if (kind == KIND_INT || kind == KIND_FLOAT) return replace_node(node, operand);
+        return 0;
+    }
+    // !!x and -(-x) cancel out for operands that are already of the result type
+    if (operand->type != AST_UNARY_OP || strcmp(operand->value, op) != 0 || !operand->left) return 0;
+    ExprKind kind = expression_kind(operand->left);
+    if (strcmp(op, "!") == 0 && kind == KIND_BOOL) return replace_node(node, operand->left);
+    if (strcmp(op, "-") == 0 && (kind == KIND_INT || kind == KIND_FLOAT)) return replace_node(node, operand->left);
+    return 0;
+}
+
+static int simplify_node(ASTNode *node) {
+    if (node->type == AST_BINARY_OP) return simplify_binary(node);
+    if (node->type == AST_UNARY_OP) return simplify_unary(node);
+    return 0;
+}
+
+static int simplify_algebra(ASTNode *program) {
+    return walk_tree(program, simplify_node);
+}
+
+// --- Pipeline ---
+
+typedef int (*OptimizerPass)(ASTNode *program); // Returns the number of rewrites
+
+static const OptimizerPass optimizer_passes[] = {
+    fold_constants,
+    propagate_constants,
+    eliminate_dead_branches,
+    simplify_algebra,
+};
+
+void optimize_ast(ASTNode *root) {
+    if (!root) return;
+
+    // Each pass can expose work for the others (a propagated constant makes a
+    // condition foldable, which makes a branch dead), so run until stable.
+    for (int round = 0; round < MAX_OPTIMIZE_ROUNDS; round++) {
+        int rewrites = 0;
+        for (size_t i = 0; i < sizeof(optimizer_passes) / sizeof(optimizer_passes[0]); i++) {
+            rewrites += optimizer_passes[i](root);
+        }
+        if (rewrites == 0) break;
     }
 }
@@ -3,7 +3,10 @@
 
 #include "ast_types.h" // Changed from parser.h to ast_types.h for ASTNode definition
 
+// Runs the AST pass pipeline (constant folding, constant propagation,
+// dead-branch elimination, algebraic simplification) until it reaches a fixed
+// point. Expects a tree that resolve_program has already placed in slots.
 void optimize_ast(ASTNode *root);
-void constant_fold(ASTNode *node); // Expose for potential direct use or testing
+void constant_fold(ASTNode *node); // Folding pass alone, for potential direct use or testing
 
 #endif // OPTIMIZE_H
@@ -67,6 +67,14 @@ static Token peek_token_n(int n) {
     return eof_token;
 }
 
+// "int" with two dimensions -> "int[][]", interned in the AST arena
+static const char* array_type_name(const char *element_type, int dims) {
+    char type_name[256];
+    snprintf(type_name, sizeof(type_name), "%s", element_type);
+    for (int i = 0; i < dims; i++) strncat(type_name, "[]", sizeof(type_name) - strlen(type_name) - 1);
+    return ast_intern(type_name);
+}
+
 // Utility to check if a string is a built-in type keyword
 int is_builtin_type_keyword(const char* s) { // Renamed to avoid conflict if parser.c included elsewhere
     return strcmp(s, "int") == 0 || strcmp(s, "float") == 0 ||
@@ -211,8 +219,11 @@ static ASTNode* parse_statement() {
         if (peek.type == TOKEN_IDENTIFIER) { // MyType myVar;
             stmt = parse_typed_variable_declaration();
         }
-        else if (peek.type == TOKEN_SYMBOL && strcmp(peek.text, "[") == 0) { // MyType[] ...
-            stmt = parse_typed_variable_declaration();
+        else if (peek.type == TOKEN_SYMBOL && strcmp(peek.text, "[") == 0) { // MyType[] ..., but not a[i] = ...
+            Token peek2 = peek_token_n(2);
+            if (peek2.type == TOKEN_SYMBOL && strcmp(peek2.text, "]") == 0) {
+                stmt = parse_typed_variable_declaration();
+            }
         }
         else if (peek.type == TOKEN_SYMBOL && strcmp(peek.text, ":") == 0) { // myVar: MyType
             stmt = parse_typed_variable_declaration();
@@ -223,13 +234,12 @@ static ASTNode* parse_statement() {
     if (stmt && modifiers[0] != '\0') {
         // HACK: The ASTNode only supports one modifier. Prioritize 'static'.
         if (strstr(modifiers, "static")) {
-            strncpy(stmt->access_modifier, "static", sizeof(stmt->access_modifier) - 1);
+            stmt->access_modifier = "static";
         } else if (strstr(modifiers, "private")) {
-            strncpy(stmt->access_modifier, "private", sizeof(stmt->access_modifier) - 1);
+            stmt->access_modifier = "private";
         } else {
-            strncpy(stmt->access_modifier, "public", sizeof(stmt->access_modifier) - 1);
+            stmt->access_modifier = "public";
         }
-        stmt->access_modifier[sizeof(stmt->access_modifier) - 1] = '\0';
         stmt->line = first_modifier_token.line;
         stmt->col = first_modifier_token.col;
     } else if (!stmt && modifiers[0] != '\0') {
@@ -301,9 +311,7 @@ static ASTNode* parse_typed_variable_declaration() {
         Token next = peek_token();
         if (next.type == TOKEN_SYMBOL && strcmp(next.text, ":") == 0) {
             // This is colon-style: name: type
-            char var_name_str[sizeof(((ASTNode*)0)->value)];
-            strncpy(var_name_str, name_token.text, sizeof(var_name_str) - 1);
-            var_name_str[sizeof(var_name_str) - 1] = '\0';
+            const char* var_name_str = ast_intern(name_token.text);
             advance(); // consume name
             advance(); // consume ':'
             
@@ -366,9 +374,7 @@ static ASTNode* parse_typed_variable_declaration() {
             }
             
             ASTNode* var_decl = create_node(AST_TYPED_VAR_DECL, var_name_str, start_token.line, start_token.col);
-            strncpy(var_decl->data_type, type_str, sizeof(var_decl->data_type) - 1);
-            var_decl->data_type[sizeof(var_decl->data_type) - 1] = '\0';
-            for(int i = 0; i < array_dims; i++) strcat(var_decl->data_type, "[]");
+            var_decl->data_type = array_type_name(type_str, array_dims);
             var_decl->is_array = array_dims > 0;
             free(type_str);
             
@@ -464,17 +470,13 @@ static ASTNode* parse_typed_variable_declaration() {
         free(type_str);
         return NULL;
     }
-    char var_name_str[sizeof(((ASTNode*)0)->value)]; // Ensure buffer is same size as ASTNode.value
-    strncpy(var_name_str, current_token.text, sizeof(var_name_str) - 1);
-    var_name_str[sizeof(var_name_str) - 1] = '\0';
+    const char* var_name_str = ast_intern(current_token.text);
     advance();
 
     // Do not modify type_str in-place; we'll build array suffix directly in var_decl below.
     // We'll set var_decl->is_array after we create the node below.
     ASTNode* var_decl = create_node(AST_TYPED_VAR_DECL, var_name_str, type_token.line, type_token.col);
-    strncpy(var_decl->data_type, type_str, sizeof(var_decl->data_type) - 1);
-    var_decl->data_type[sizeof(var_decl->data_type) - 1] = '\0';
-    for(int i=0;i<array_dims;i++) strcat(var_decl->data_type, "[]");
+    var_decl->data_type = array_type_name(type_str, array_dims);
     var_decl->is_array = array_dims > 0;
     free(type_str);
 
@@ -524,15 +526,11 @@ static ASTNode* parse_variable_declaration() {
             fprintf(stderr, "Error (L%d:%d): Expected identifier after var[] declaration\n", current_token.line, current_token.col);
             return NULL;
         }
-        char var_name_str[256];
-        strncpy(var_name_str, current_token.text, sizeof(var_name_str) - 1);
-        var_name_str[sizeof(var_name_str) - 1] = '\0';
+        const char* var_name_str = ast_intern(current_token.text);
         advance();
         // Create typed variable declaration node
         ASTNode* var_decl = create_node(AST_TYPED_VAR_DECL, var_name_str, keyword_token.line, keyword_token.col);
-        strncpy(var_decl->data_type, type_str, sizeof(var_decl->data_type) - 1);
-        var_decl->data_type[sizeof(var_decl->data_type) - 1] = '\0';
-        for (int i = 0; i < array_dims; i++) strcat(var_decl->data_type, "[]");
+        var_decl->data_type = array_type_name(type_str, array_dims);
         var_decl->is_array = array_dims > 0;
         var_decl->left = NULL;
         // Parse optional initializer
@@ -563,9 +561,7 @@ static ASTNode* parse_variable_declaration() {
         Token next = peek_token();
         if (next.type == TOKEN_SYMBOL && strcmp(next.text, ":") == 0) {
             // This is colon-style with let/var/const
-            char var_name_str[sizeof(((ASTNode*)0)->value)];
-            strncpy(var_name_str, name_token.text, sizeof(var_name_str) - 1);
-            var_name_str[sizeof(var_name_str) - 1] = '\0';
+            const char* var_name_str = ast_intern(name_token.text);
             advance(); // consume name
             advance(); // consume ':'
             
@@ -628,14 +624,12 @@ static ASTNode* parse_variable_declaration() {
             }
             
             ASTNode* var_decl = create_node(AST_TYPED_VAR_DECL, var_name_str, keyword_token.line, keyword_token.col);
-            strncpy(var_decl->data_type, type_str, sizeof(var_decl->data_type) - 1);
-            var_decl->data_type[sizeof(var_decl->data_type) - 1] = '\0';
-            for(int i = 0; i < array_dims; i++) strcat(var_decl->data_type, "[]");
+            var_decl->data_type = array_type_name(type_str, array_dims);
             var_decl->is_array = array_dims > 0;
             free(type_str);
             
             if (strcmp(keyword_token.text, "const") == 0) {
-                strncpy(var_decl->access_modifier, "const", sizeof(var_decl->access_modifier)-1);
+                var_decl->access_modifier = "const";
             }
             
             var_decl->left = NULL;
@@ -670,7 +664,7 @@ static ASTNode* parse_variable_declaration() {
 
     ASTNode* var_decl = create_node(AST_VAR_DECL, current_token.text, keyword_token.line, keyword_token.col);
     if (strcmp(keyword_token.text, "const") == 0) {
-        strncpy(var_decl->access_modifier, "const", sizeof(var_decl->access_modifier)-1);
+        var_decl->access_modifier = "const";
     }
     var_decl->left = NULL; // For untyped VarDecl, left is not used for name node. Name is in value.
     advance();
@@ -713,8 +707,7 @@ static ASTNode* parse_typed_function() {
         return NULL;
     }
     ASTNode* func = create_node(AST_TYPED_FUNCTION, current_token.text, type_token.line, type_token.col);
-    strncpy(func->data_type, type_str, sizeof(func->data_type) - 1);
-    func->data_type[sizeof(func->data_type) - 1] = '\0';
+    func->data_type = ast_intern(type_str);
     free(type_str);
     advance();
 
@@ -778,8 +771,7 @@ static ASTNode* parse_parameters() {
                 return NULL;
             }
             param_node = create_node(AST_PARAMETER, current_token.text, param_type_token.line, param_type_token.col);
-            strncpy(param_node->data_type, param_type_str, sizeof(param_node->data_type) - 1);
-            param_node->data_type[sizeof(param_node->data_type) - 1] = '\0';
+            param_node->data_type = ast_intern(param_type_str);
             free(param_type_str);
             advance();
         } else if (current_token.type == TOKEN_IDENTIFIER) {
@@ -797,8 +789,7 @@ static ASTNode* parse_parameters() {
                     free_ast(param_node); free_ast(head); return NULL;
                 }
                 
-                strncpy(param_node->data_type, current_token.text, sizeof(param_node->data_type) - 1);
-                param_node->data_type[sizeof(param_node->data_type) - 1] = '\0';
+                param_node->data_type = ast_intern(current_token.text);
                 advance(); // consume type
             } else if (next.type == TOKEN_IDENTIFIER) {
                 // Traditional style: type name
@@ -808,14 +799,12 @@ static ASTNode* parse_parameters() {
                 advance(); // consume type name
                 param_node = create_node(AST_PARAMETER, current_token.text, param_type_token.line, param_type_token.col);
                 // Set data_type to the user-defined type
-                strncpy(param_node->data_type, type_str, sizeof(param_node->data_type) - 1);
-                param_node->data_type[sizeof(param_node->data_type) - 1] = '\0';
+                param_node->data_type = ast_intern(type_str);
                 advance(); // consume parameter name
             } else {
                 // Untyped parameter: just a name; default type 'any'
                 param_node = create_node(AST_PARAMETER, current_token.text, param_type_token.line, param_type_token.col);
-                strncpy(param_node->data_type, inferred_type, sizeof(param_node->data_type) - 1);
-                param_node->data_type[sizeof(param_node->data_type) - 1] = '\0';
+                param_node->data_type = ast_intern(inferred_type);
                 advance();
             }
         } else {
@@ -830,7 +819,7 @@ static ASTNode* parse_parameters() {
             if (current_token.type == TOKEN_SYMBOL && strcmp(current_token.text, "]") == 0) {
                 advance();
                 param_node->is_array = 1;
-                strcat(param_node->data_type, "[]");
+                param_node->data_type = array_type_name(param_node->data_type, 1);
             }
             else {
                 fprintf(stderr, "Error (L%d:%d): Expected ']' for array parameter '%s'.\n", current_token.line, current_token.col, param_node->value);
@@ -1066,7 +1055,7 @@ static ASTNode* parse_binary_expression(ASTNode* left, int min_precedence) {
             }
             else { // Left-associative
                 if (next_prec <= prec) break;
-                right = parse_binary_expression(right, next_prec);
+                right = parse_binary_expression(right, prec); // Consumes every operator binding tighter than op_token
             }
 
             if (!right) { free_ast(left); return NULL; }
@@ -1116,13 +1105,12 @@ static ASTNode* parse_primary() {
         else if (current_token.type == TOKEN_KEYWORD &&
             (strcmp(current_token.text, "true") == 0 || strcmp(current_token.text, "false") == 0)) {
             node = create_node(AST_LITERAL, current_token.text, start_token.line, start_token.col);
-            strncpy(node->data_type, "bool", sizeof(node->data_type) - 1);
-            node->data_type[sizeof(node->data_type) - 1] = '\0';
+            node->data_type = "bool";
             advance();
         }
         else if (current_token.type == TOKEN_KEYWORD && strcmp(current_token.text, "null") == 0) {
-            strncpy(node->data_type, "null", sizeof(node->data_type) - 1);
-            node->data_type[sizeof(node->data_type) - 1] = '\0';
+            node = create_node(AST_LITERAL, current_token.text, start_token.line, start_token.col);
+            node->data_type = "null";
             advance();
         }
         else if (current_token.type == TOKEN_KEYWORD && strcmp(current_token.text, "this") == 0) {
@@ -1210,7 +1198,7 @@ static ASTNode* parse_primary() {
             call_node->left = args;
             if (node->type == AST_MEMBER_ACCESS) {
                 call_node->right = node->left; // The object/class expression
-                strncpy(call_node->value, node->value, sizeof(call_node->value) - 1); // The method name from member access
+                call_node->value = node->value; // The method name from member access
                 // The original 'node' (which was AST_MEMBER_ACCESS) is now replaced by 'call_node'.
                 // We need to free the old 'node' to avoid memory leak if it was heap allocated.
                 // However, 'node' is just a pointer. If parse_member_access returned a new node,
@@ -1316,15 +1304,14 @@ static ASTNode* parse_literal_or_identifier() {
     ASTNode* node = create_node(type, current_token.text, current_start_token.line, current_start_token.col);
     if (type == AST_LITERAL) { // Set data_type for literals
         if (current_token.type == TOKEN_NUMBER) {
-            strncpy(node->data_type, strchr(current_token.text, '.') ? "float" : "int", sizeof(node->data_type) - 1);
+            node->data_type = strchr(current_token.text, '.') ? "float" : "int";
         }
         else if (current_token.type == TOKEN_STRING) {
-            strncpy(node->data_type, "string", sizeof(node->data_type) - 1);
+            node->data_type = "string";
         }
         else if (current_token.type == TOKEN_BOOL) { // "true" or "false"
-            strncpy(node->data_type, "bool", sizeof(node->data_type) - 1);
+            node->data_type = "bool";
         }
-        node->data_type[sizeof(node->data_type) - 1] = '\0';
     }
     advance();
     return node;
@@ -1702,6 +1689,7 @@ static ASTNode* parse_array_literal() {
 
     ASTNode* head_element = NULL;
     ASTNode* tail_element = NULL;
+    int element_count = 0;
 
     if (!(current_token.type == TOKEN_SYMBOL && strcmp(current_token.text, "]") == 0)) {
         while (1) {
@@ -1712,6 +1700,7 @@ static ASTNode* parse_array_literal() {
             }
             if (!head_element) head_element = tail_element = elem_expr;
             else { tail_element->next = elem_expr; tail_element = elem_expr; }
+            element_count++;
 
             /* After each element we must find either a comma (continue with next element)
                or a closing bracket (array terminator). This explicit branching also
@@ -1739,8 +1728,8 @@ static ASTNode* parse_array_literal() {
 
     ASTNode* arr_node = create_node(AST_ARRAY, "array_literal", start_token.line, start_token.col);
     arr_node->left = head_element;
-    strncpy(arr_node->data_type, "array", sizeof(arr_node->data_type) - 1);
-    arr_node->data_type[sizeof(arr_node->data_type) - 1] = '\0';
+    arr_node->data_type = "array";
+    arr_node->array_size = element_count; // Lets the evaluator size the array up front
     return arr_node;
 }
 
@@ -1753,8 +1742,7 @@ static ASTNode* parse_new_expression() {
         return NULL;
     }
     ASTNode* node = create_node(AST_NEW, current_token.text, new_keyword_token.line, new_keyword_token.col);
-    strncpy(node->data_type, current_token.text, sizeof(node->data_type) - 1);
-    node->data_type[sizeof(node->data_type) - 1] = '\0';
+    node->data_type = ast_intern(current_token.text);
     Token class_name_token = current_token;
     advance();
 
@@ -10,6 +10,11 @@
 // --- Symbol Table Implementation ---
 SymbolTable* g_st = NULL; 
 
+// Names of registered natives, consulted when a call resolves to no symbol
+static const char **native_names = NULL;
+static int native_count = 0;
+static int native_capacity = 0;
+
 // --- Forward declarations for analysis functions ---
 static void analyze_node(ASTNode *node); 
 static void analyze_function_decl(ASTNode *func_node, ASTNode *parent_class_node_or_null);
@@ -241,11 +246,9 @@ static void analyze_function_decl(ASTNode *func_node, ASTNode *parent_class_node
             return;
         }
         ASTNode* this_param = create_node(AST_PARAMETER, "this", func_node->line, func_node->col);
-        strncpy(this_param->value, "this", sizeof(this_param->value) - 1);
         this_param->left = create_node(AST_TYPE, parent_class_node_or_null->value, func_node->line, func_node->col);
         // Set access modifier string to "public"
-        strncpy(this_param->access_modifier, "public", sizeof(this_param->access_modifier) - 1);
-        this_param->access_modifier[sizeof(this_param->access_modifier) - 1] = '\0';
+        this_param->access_modifier = "public";
 
         if (func_node->left) {
             ASTNode* current = func_node->left;
@@ -347,24 +350,24 @@ static void analyze_return_stmt(ASTNode *return_node) {
 static const char* analyze_member_access_expr(ASTNode *access_node) {
     if (!access_node || !access_node->left || !access_node->value[0]) {
         if (access_node) { // Corrected misleading indentation
-            strcpy(access_node->data_type, "error_type");
+            access_node->data_type = "error_type";
         }
         return "error_type";
     }
     // ... rest of function is unchanged
     const char* target_type_name = analyze_expression_node(access_node->left);
     if (strcmp(target_type_name, "error_type") == 0) {
-        strcpy(access_node->data_type, "error_type"); return "error_type";
+        access_node->data_type = "error_type"; return "error_type";
     }
     if (strcmp(target_type_name, "any") == 0) {
-         strcpy(access_node->data_type, "any"); return "any"; 
+         access_node->data_type = "any"; return "any"; 
     }
 
     Symbol* type_sym = symbol_table_lookup_all_scopes(g_st, target_type_name);
     if (type_sym && (type_sym->kind == SYMBOL_CLASS || type_sym->kind == SYMBOL_STRUCT)) {
         ASTNode* type_decl_node = type_sym->declaration_node;
         if (!type_decl_node) { // Should not happen if symbol table is consistent
-             strcpy(access_node->data_type, "error_type"); return "error_type";
+             access_node->data_type = "error_type"; return "error_type";
         }
         ASTNode* member_decl = type_decl_node->left; 
         int found = 0;
@@ -396,7 +399,7 @@ static const char* analyze_member_access_expr(ASTNode *access_node) {
                     if(strcmp(target_type_name, current_class_context_name) != 0) {
                         fprintf(stderr, "[SEMANTIC L%d:%d] Error: Member '%s' of type '%s' is private and cannot be accessed from context '%s'.\n", 
                                  access_node->line, access_node->col, access_node->value, target_type_name, current_class_context_name[0] ? current_class_context_name : "global");
-                        strcpy(access_node->data_type, "error_type"); return "error_type";
+                        access_node->data_type = "error_type"; return "error_type";
                     }
                 }
                 int is_static_access_attempt = (access_node->left->type == AST_IDENTIFIER && type_sym && strcmp(access_node->left->value, type_sym->name)==0);
@@ -405,13 +408,13 @@ static const char* analyze_member_access_expr(ASTNode *access_node) {
                 if(is_static_access_attempt && !member_is_static) {
                      fprintf(stderr, "[SEMANTIC L%d:%d] Error: Cannot access instance member '%s' of type '%s' statically.\n", 
                                  access_node->line, access_node->col, access_node->value, target_type_name);
-                     strcpy(access_node->data_type, "error_type"); return "error_type";
+                     access_node->data_type = "error_type"; return "error_type";
                 }
 
                 if(member_decl->data_type[0]) { 
-                    strncpy(access_node->data_type, member_decl->data_type, sizeof(access_node->data_type)-1);
+                    access_node->data_type = ast_intern(member_decl->data_type);
                 } else if (member_decl->type == AST_VAR_DECL || member_decl->type == AST_FUNCTION) { 
-                     strcpy(access_node->data_type, "any"); 
+                     access_node->data_type = "any"; 
                 }
                 found = 1;
                 break;
@@ -420,15 +423,15 @@ static const char* analyze_member_access_expr(ASTNode *access_node) {
         }
         if (!found) {
              /* Dynamic property: allow, assume type 'any' */
-             strcpy(access_node->data_type, "any");
+             access_node->data_type = "any";
         }
     } else if ( (strcmp(target_type_name, "string")==0 || strstr(target_type_name, "[]") || strcmp(target_type_name, "array")==0 ) &&
                 strcmp(access_node->value, "length")==0) {
-        strcpy(access_node->data_type, "int");
+        access_node->data_type = "int";
     } else {
         fprintf(stderr, "[SEMANTIC L%d:%d] Error: Cannot access member '%s' on primitive or unknown type '%s'.\n", 
                 access_node->line, access_node->col, access_node->value, target_type_name);
-        strcpy(access_node->data_type, "error_type");
+        access_node->data_type = "error_type";
     }
     return access_node->data_type[0] ? access_node->data_type : "error_type";
 }
@@ -438,12 +441,10 @@ static void analyze_new_expr(ASTNode *new_node) {
     if (!class_sym || (class_sym->kind != SYMBOL_CLASS && class_sym->kind != SYMBOL_STRUCT)) {
         fprintf(stderr, "[SEMANTIC L%d:%d] Error: Class or struct '%s' not found for 'new' expression.\n", 
                 new_node->line, new_node->col, new_node->value);
-        strncpy(new_node->data_type, "error_type", sizeof(new_node->data_type)-1);
-        new_node->data_type[sizeof(new_node->data_type)-1] = '\0';
+        new_node->data_type = "error_type";
         return;
     }
-    strncpy(new_node->data_type, new_node->value, sizeof(new_node->data_type)-1);
-    new_node->data_type[sizeof(new_node->data_type)-1] = '\0';
+    new_node->data_type = new_node->value;
 
     if (new_node->left) { 
         ASTNode *arg = new_node->left;
@@ -561,15 +562,15 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
     switch (expr_node->type) {
         case AST_LITERAL:
             if (expr_node->value[0] == '"') {
-                strcpy(expr_node->data_type, "string");
+                expr_node->data_type = "string";
             } else if (isdigit(expr_node->value[0]) || (expr_node->value[0] == '-' && isdigit(expr_node->value[1]))) {
                 if (strchr(expr_node->value, '.')) {
-                    strcpy(expr_node->data_type, "float");
+                    expr_node->data_type = "float";
                 } else {
-                    strcpy(expr_node->data_type, "int");
+                    expr_node->data_type = "int";
                 }
             } else if (strcmp(expr_node->value, "true") == 0 || strcmp(expr_node->value, "false") == 0) {
-                strcpy(expr_node->data_type, "bool");
+                expr_node->data_type = "bool";
             }
             return expr_node->data_type[0] ? expr_node->data_type : "any";
             
@@ -577,14 +578,14 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
             Symbol* sym = symbol_table_lookup_all_scopes(g_st, expr_node->value);
             if (sym) {
                 if (sym->type_name[0]) {
-                    strcpy(expr_node->data_type, sym->type_name);
+                    expr_node->data_type = ast_intern(sym->type_name);
                 } else {
-                    strcpy(expr_node->data_type, "any");
+                    expr_node->data_type = "any";
                 }
             } else {
                 // fprintf(stderr, "[SEMANTIC L%d:%d] Warning: Undefined variable '%s'.\n", 
                 //         expr_node->line, expr_node->col, expr_node->value);
-                strcpy(expr_node->data_type, "error_type");
+                expr_node->data_type = "error_type";
             }
             return expr_node->data_type[0] ? expr_node->data_type : "any";
         }
@@ -596,7 +597,7 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
                 const char* right_type = analyze_expression_node(expr_node->right);
                 
                 if (strcmp(left_type, "error_type") == 0 || strcmp(right_type, "error_type") == 0) {
-                    strcpy(expr_node->data_type, "error_type");
+                    expr_node->data_type = "error_type";
                     return "error_type";
                 }
                 
@@ -608,16 +609,16 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
                     strcmp(expr_node->value, "%") == 0) {
                     
                     if (strcmp(left_type, "string") == 0 && strcmp(expr_node->value, "+") == 0) {
-                        strcpy(expr_node->data_type, "string");
+                        expr_node->data_type = "string";
                     } else if ((strcmp(left_type, "int") == 0 || strcmp(left_type, "float") == 0) &&
                                (strcmp(right_type, "int") == 0 || strcmp(right_type, "float") == 0)) {
                         if (strcmp(left_type, "float") == 0 || strcmp(right_type, "float") == 0) {
-                            strcpy(expr_node->data_type, "float");
+                            expr_node->data_type = "float";
                         } else {
-                            strcpy(expr_node->data_type, "int");
+                            expr_node->data_type = "int";
                         }
                     } else {
-                        strcpy(expr_node->data_type, "error_type");
+                        expr_node->data_type = "error_type";
                     }
                 }
                 // Comparison operators
@@ -628,15 +629,15 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
                          strcmp(expr_node->value, "<=") == 0 ||
                          strcmp(expr_node->value, ">=") == 0) {
                     
-                    strcpy(expr_node->data_type, "bool");
+                    expr_node->data_type = "bool";
                 }
                 // Logical operators
                 else if (strcmp(expr_node->value, "&&") == 0 || 
                          strcmp(expr_node->value, "||") == 0) {
                     
-                    strcpy(expr_node->data_type, "bool");
+                    expr_node->data_type = "bool";
                 } else {
-                    strcpy(expr_node->data_type, "any");
+                    expr_node->data_type = "any";
                 }
                 
                 return expr_node->data_type[0] ? expr_node->data_type : "any";
@@ -647,15 +648,15 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
                 const char* operand_type = analyze_expression_node(expr_node->left);
                 
                 if (strcmp(expr_node->value, "!") == 0) {
-                    strcpy(expr_node->data_type, "bool");
+                    expr_node->data_type = "bool";
                 } else if (strcmp(expr_node->value, "-") == 0 || strcmp(expr_node->value, "+") == 0) {
                     if (strcmp(operand_type, "int") == 0 || strcmp(operand_type, "float") == 0) {
-                        strcpy(expr_node->data_type, operand_type);
+                        expr_node->data_type = ast_intern(operand_type);
                     } else {
-                        strcpy(expr_node->data_type, "error_type");
+                        expr_node->data_type = "error_type";
                     }
                 } else {
-                    strcpy(expr_node->data_type, "any");
+                    expr_node->data_type = "any";
                 }
                 
                 return expr_node->data_type[0] ? expr_node->data_type : "any";
@@ -664,7 +665,7 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
         case AST_CALL:
             {
                 // Simply mark as "any" type for now
-                strcpy(expr_node->data_type, "any");
+                expr_node->data_type = "any";
                 return "any";
             }
             
@@ -676,7 +677,7 @@ static const char* analyze_expression_node(ASTNode *expr_node) {
             return expr_node->data_type[0] ? expr_node->data_type : "any";
             
         default:
-            strcpy(expr_node->data_type, "any");
+            expr_node->data_type = "any";
             return "any";
     }
 }
@@ -831,25 +832,58 @@ static void analyze_for_stmt(ASTNode *for_node) {
     symbol_table_exit_scope(g_st);
 }
 
+void semantic_declare_native(const char *name) {
+    if (native_count == native_capacity) {
+        native_capacity = native_capacity ? native_capacity * 2 : 64;
+        native_names = realloc(native_names, native_capacity * sizeof(const char*));
+        if (!native_names) {
+            fprintf(stderr, "Fatal Error: Could not allocate native name table.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    native_names[native_count++] = name;
+}
+
+static int is_native(const char *name) {
+    for (int i = 0; i < native_count; i++) {
+        if (strcmp(native_names[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
 static void analyze_call_expr_or_stmt(ASTNode *call_node) {
     if (!call_node) return;
-    
+
     Symbol* func_sym = symbol_table_lookup_all_scopes(g_st, call_node->value);
+    if (!func_sym && call_node->right) {
+        // receiver.method(...) is dispatched on the receiver at runtime
+        // (e.g. arr.push(x) calls the array_push native)
+        analyze_expression_node(call_node->right);
+        for (ASTNode* arg = call_node->left; arg; arg = arg->next) analyze_expression_node(arg);
+        call_node->data_type = "any";
+        return;
+    }
+    if (!func_sym && is_native(call_node->value)) {
+        // Natives check their own arguments when called
+        for (ASTNode* arg = call_node->left; arg; arg = arg->next) analyze_expression_node(arg);
+        call_node->data_type = "any";
+        return;
+    }
     if (!func_sym) {
         fprintf(stderr, "[SEMANTIC L%d:%d] Error: Call to undefined function '%s'.\n",
                call_node->line, call_node->col, call_node->value);
-        strcpy(call_node->data_type, "error_type");
+        call_node->data_type = "error_type";
         return;
     }
     
     if (func_sym->kind != SYMBOL_FUNCTION) {
         fprintf(stderr, "[SEMANTIC L%d:%d] Error: '%s' is not a function.\n",
                call_node->line, call_node->col, call_node->value);
-        strcpy(call_node->data_type, "error_type");
+        call_node->data_type = "error_type";
         return;
     }
     
-    strcpy(call_node->data_type, func_sym->type_name);
+    call_node->data_type = ast_intern(func_sym->type_name);
     
     // For now, just analyze the arguments without parameter matching
     ASTNode* arg = call_node->left;
@@ -858,3 +892,277 @@ static void analyze_call_expr_or_stmt(ASTNode *call_node) {
         arg = arg->next;
     }
 }
+
+// --- Resolver: assigns frame slots to locals ---
+//
+// Every function (and the program itself, whose frame is the VM's global frame)
+// gets one slot per parameter and local. Blocks do not open frames at runtime,
+// so all declarations in a body share the function's slots. Identifiers record
+// (slot, depth): depth 0 is the current frame, depth 1 the global frame seen from
+// a top-level function or method. Function expressions nested inside another
+// function run with their caller as parent frame, so only their own locals are
+// resolved; everything else keeps slot -1 and is looked up by name.
+//
+// A local that shadows an outer name is only bound to its slot if every read
+// of it runs after its declaration. Otherwise (`print(t); let t = 1;`, or
+// `let t = t + i;` in a loop) the read must still see the outer variable until
+// the declaration has run, so the name stays unresolved and the frame creates
+// it on declaration, as the environments did before slots.
+
+typedef struct ResolverScope {
+    ASTNode *owner;               // Function node or the AST_PROGRAM root
+    const char **names;
+    int count;
+    int capacity;
+    const char **declared;        // Names declared on every path to the current node
+    int declared_count;
+    int declared_capacity;
+    const char **unresolved;      // Shadowing locals read before their declaration
+    int unresolved_count;
+    int unresolved_capacity;
+    struct ResolverScope *enclosing;
+} ResolverScope;
+
+static void resolve_node(ASTNode *node, ResolverScope *scope);
+static void resolve_function(ASTNode *func_node, ResolverScope *enclosing, int is_member);
+
+static int resolver_find(ResolverScope *scope, const char *name) {
+    for (int i = 0; i < scope->count; i++) {
+        if (scope->names[i] && strcmp(scope->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static int resolver_contains(const char **names, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static void resolver_push_name(ResolverScope *scope, const char ***names, int *count, int *capacity, const char *name) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 8;
+        const char **grown = (const char**)realloc((void*)*names, (size_t)new_capacity * sizeof(const char*));
+        if (!grown) {
+            fprintf(stderr, "Fatal Error: Could not allocate resolver scope for '%s'.\n", scope->owner->value);
+            exit(EXIT_FAILURE);
+        }
+        *names = grown;
+        *capacity = new_capacity;
+    }
+    (*names)[(*count)++] = name;
+}
+
+static int resolver_declare(ResolverScope *scope, const char *name) {
+    int slot = resolver_find(scope, name);
+    if (slot >= 0) return slot; // Redeclarations share the slot, like set_variable did
+    resolver_push_name(scope, &scope->names, &scope->count, &scope->capacity, name);
+    return scope->count - 1;
+}
+
+// Only the program and top-level functions/methods have a frame chain that
+// matches their lexical nesting.
+static int resolver_lookup(ResolverScope *scope, const char *name, int *depth_out) {
+    int depth = 0;
+    while (scope) {
+        int slot = resolver_find(scope, name);
+        if (slot >= 0) { *depth_out = depth; return slot; }
+        if (scope->owner->type == AST_PROGRAM || scope->owner->depth != 0) break;
+        scope = scope->enclosing;
+        depth++;
+    }
+    return -1;
+}
+
+static void resolve_reference(ASTNode *node, const char *name, ResolverScope *scope) {
+    int depth = 0;
+    int slot = resolver_lookup(scope, name, &depth);
+    node->slot = slot;
+    node->depth = slot >= 0 ? depth : 0;
+
+    // A local read where its declaration may not have run yet
+    if (slot >= 0 && depth == 0 && scope->owner->type != AST_PROGRAM &&
+        !resolver_contains(scope->declared, scope->declared_count, name) &&
+        !resolver_contains(scope->unresolved, scope->unresolved_count, name)) {
+        for (ResolverScope *outer = scope->enclosing; outer; outer = outer->enclosing) {
+            if (resolver_find(outer, name) >= 0) {
+                resolver_push_name(scope, &scope->unresolved, &scope->unresolved_count,
+                                   &scope->unresolved_capacity, name);
+                break;
+            }
+        }
+    }
+}
+
+static void resolver_declared(ResolverScope *scope, const char *name) {
+    resolver_push_name(scope, &scope->declared, &scope->declared_count, &scope->declared_capacity, name);
+}
+
+// Gives the slot's declarations and references back to name lookup.
+static void resolver_unbind(ASTNode *node, int slot) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_FUNCTION: case AST_TYPED_FUNCTION: case AST_CLASS_METHOD:
+            case AST_CLASS: case AST_STRUCT: case AST_IMPORT:
+                continue; // Own scopes
+            case AST_IDENTIFIER: case AST_VAR_DECL: case AST_TYPED_VAR_DECL:
+                if (node->slot == slot && node->depth == 0) node->slot = -1;
+                break;
+            default:
+                break;
+        }
+        resolver_unbind(node->left, slot);
+        resolver_unbind(node->right, slot);
+    }
+}
+
+// Hoists declarations so uses earlier in the body (e.g. in a loop) see the slot.
+static void resolver_collect_decls(ASTNode *node, ResolverScope *scope) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_FUNCTION: case AST_TYPED_FUNCTION: case AST_CLASS_METHOD:
+            case AST_CLASS: case AST_STRUCT: case AST_IMPORT:
+                continue; // Own scopes, or not executed in this frame
+            case AST_VAR_DECL: case AST_TYPED_VAR_DECL:
+                resolver_declare(scope, node->value);
+                break;
+            default:
+                break;
+        }
+        resolver_collect_decls(node->left, scope);
+        resolver_collect_decls(node->right, scope);
+    }
+}
+
+static void resolver_finish(ResolverScope *scope) {
+    // The slot names live as long as the tree, so they move into its arena
+    const char **names = NULL;
+    if (scope->count > 0) {
+        names = (const char**)ast_alloc((size_t)scope->count * sizeof(const char*));
+        memcpy((void*)names, (const void*)scope->names, (size_t)scope->count * sizeof(const char*));
+    }
+    free((void*)scope->names);
+    free((void*)scope->declared);
+    free((void*)scope->unresolved);
+    scope->owner->local_names = names;
+    scope->owner->local_count = scope->count;
+}
+
+static void resolve_assignment_target(ASTNode *target, ResolverScope *scope) {
+    if (target->type != AST_IDENTIFIER) {
+        resolve_node(target, scope);
+        return;
+    }
+    resolve_reference(target, target->value, scope);
+    if (target->slot < 0) {
+        // Assigning an unknown name creates a local, as set_variable does
+        target->slot = resolver_declare(scope, target->value);
+        target->depth = 0;
+    }
+}
+
+static void resolve_class_members(ASTNode *class_node, ResolverScope *program_scope) {
+    // Field initialisers run in whatever frame creates the instance, so they
+    // stay name-resolved; only method bodies get frames of their own.
+    for (ASTNode *member = class_node->left; member; member = member->next) {
+        if (member->type == AST_FUNCTION || member->type == AST_TYPED_FUNCTION || member->type == AST_CLASS_METHOD) {
+            resolve_function(member, program_scope, 1);
+        }
+    }
+}
+
+// Resolves a statement list. Declarations in it stay in scope->declared for
+// the statements after them; resolve_node drops them once the list ends.
+static void resolve_chain(ASTNode *node, ResolverScope *scope) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_FUNCTION: case AST_TYPED_FUNCTION: case AST_CLASS_METHOD:
+                resolve_function(node, scope, 0);
+                continue;
+            case AST_CLASS: case AST_STRUCT:
+                if (scope->owner->type == AST_PROGRAM) resolve_class_members(node, scope);
+                continue;
+            case AST_IMPORT:
+                continue;
+            case AST_VAR_DECL: case AST_TYPED_VAR_DECL:
+                resolve_node(node->right, scope);
+                node->slot = resolver_declare(scope, node->value);
+                node->depth = 0;
+                resolver_declared(scope, node->value);
+                continue;
+            case AST_IDENTIFIER:
+                resolve_reference(node, node->value, scope);
+                continue;
+            case AST_THIS: case AST_SUPER:
+                resolve_reference(node, "this", scope);
+                continue;
+            case AST_ASSIGN:
+                resolve_node(node->right, scope);
+                if (node->left) resolve_assignment_target(node->left, scope);
+                continue;
+            case AST_BINARY_OP:
+                if (node->left && (strcmp(node->value, "=") == 0 || strcmp(node->value, "+=") == 0 || strcmp(node->value, "-=") == 0 ||
+                                   strcmp(node->value, "*=") == 0 || strcmp(node->value, "/=") == 0 || strcmp(node->value, "%=") == 0)) {
+                    resolve_node(node->right, scope);
+                    resolve_assignment_target(node->left, scope);
+                    continue;
+                }
+                break;
+            case AST_FOR: {
+                // The initializer's declaration runs before the body
+                int declared_mark = scope->declared_count;
+                resolve_chain(node->left, scope);
+                resolve_node(node->right, scope);
+                scope->declared_count = declared_mark;
+                continue;
+            }
+            default:
+                break;
+        }
+        resolve_node(node->left, scope);
+        resolve_node(node->right, scope);
+    }
+}
+
+static void resolve_node(ASTNode *node, ResolverScope *scope) {
+    int declared_mark = scope->declared_count;
+    resolve_chain(node, scope);
+    scope->declared_count = declared_mark;
+}
+
+static void resolve_function(ASTNode *func_node, ResolverScope *enclosing, int is_member) {
+    ResolverScope scope = { func_node, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, enclosing };
+
+    // Nesting level: 0 for top-level functions, methods and function
+    // expressions in top-level code; execute_function_call picks the parent
+    // frame from it.
+    func_node->depth = (enclosing->owner->type == AST_PROGRAM) ? 0 : enclosing->owner->depth + 1;
+
+    for (ASTNode *param = func_node->left; param; param = param->next) {
+        if (param->type == AST_PARAMETER) {
+            param->slot = resolver_declare(&scope, param->value);
+            resolver_declared(&scope, param->value);
+        }
+    }
+    func_node->slot = is_member ? resolver_declare(&scope, "this") : -1;
+    if (is_member) resolver_declared(&scope, "this");
+
+    resolver_collect_decls(func_node->right, &scope);
+    resolve_node(func_node->right, &scope);
+    for (int i = 0; i < scope.unresolved_count; i++) {
+        int slot = resolver_find(&scope, scope.unresolved[i]);
+        resolver_unbind(func_node->right, slot);
+        scope.names[slot] = NULL; // Nor may name lookup find the unused slot
+    }
+    resolver_finish(&scope);
+}
+
+void resolve_program(ASTNode *program_ast_root) {
+    if (!program_ast_root || program_ast_root->type != AST_PROGRAM) return;
+
+    ResolverScope scope = { program_ast_root, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, NULL };
+    resolver_collect_decls(program_ast_root->left, &scope);
+    resolve_node(program_ast_root->left, &scope);
+    resolver_finish(&scope);
+}
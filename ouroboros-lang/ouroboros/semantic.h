@@ -58,5 +58,11 @@ Scope* symbol_table_get_current_scope(SymbolTable* st);
 // Analysis functions
 void analyze_program(ASTNode *ast); // Takes the root AST node
 void check_semantics(ASTNode *ast);  // Placeholder for more detailed checks
+void resolve_program(ASTNode *ast);  // Assigns frame slots to locals; run after analyze_program
+
+// Natives are registered by the runtime rather than declared in source. Each
+// registered name is passed here so calls to it are not reported as calls to
+// undefined functions. `name` must stay valid for the rest of the program.
+void semantic_declare_native(const char *name);
 
 #endif // SEMANTIC_H
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shape.h"
+
+static Shape **root_table = NULL; // Root shapes by class name, chained through next_root
+static int root_capacity = 0;
+static int root_count = 0;
+
+static uint32_t hash_name(const char *s) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *s; s++) {
+        hash ^= (uint8_t)*s;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char* copy_name(const char *name) {
+    size_t length = strlen(name);
+    char *copy = (char*)malloc(length + 1);
+    if (!copy) {
+        fprintf(stderr, "Error: Memory allocation failed for shape property '%s'\n", name);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, name, length + 1);
+    return copy;
+}
+
+static Shape* allocate_shape(Shape *parent, int property_count) {
+    Shape *shape = (Shape*)calloc(1, sizeof(Shape));
+    if (shape && property_count > 0) {
+        shape->properties = (ShapeProperty*)calloc((size_t)property_count, sizeof(ShapeProperty));
+    }
+    if (!shape || (property_count > 0 && !shape->properties)) {
+        fprintf(stderr, "Error: Memory allocation failed for object shape\n");
+        exit(EXIT_FAILURE);
+    }
+    shape->parent = parent;
+    shape->property_count = property_count;
+    if (parent) {
+        shape->class_name = parent->class_name;
+        shape->root = parent->root;
+    } else {
+        shape->root = shape;
+    }
+    return shape;
+}
+
+// Builds the name index once the properties are filled in. The table is kept
+// at most half full so probes stay short.
+static void build_index(Shape *shape) {
+    if (shape->property_count == 0) return;
+    int capacity = 8;
+    while (capacity < shape->property_count * 2) capacity *= 2;
+    shape->index = (int*)malloc((size_t)capacity * sizeof(int));
+    if (!shape->index) {
+        fprintf(stderr, "Error: Memory allocation failed for object shape index\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(shape->index, 0xFF, (size_t)capacity * sizeof(int));
+    shape->index_capacity = capacity;
+    for (int slot = 0; slot < shape->property_count; slot++) {
+        uint32_t bucket = shape->properties[slot].hash & (uint32_t)(capacity - 1);
+        while (shape->index[bucket] >= 0) bucket = (bucket + 1) & (uint32_t)(capacity - 1);
+        shape->index[bucket] = slot;
+    }
+}
+
+static void grow_root_table(void) {
+    int new_capacity = root_capacity ? root_capacity * 2 : 16;
+    Shape **grown = (Shape**)calloc((size_t)new_capacity, sizeof(Shape*));
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed for shape registry\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < root_capacity; i++) {
+        Shape *root = root_table[i];
+        while (root) {
+            Shape *next = root->next_root;
+            uint32_t bucket = hash_name(root->class_name) & (uint32_t)(new_capacity - 1);
+            root->next_root = grown[bucket];
+            grown[bucket] = root;
+            root = next;
+        }
+    }
+    free(root_table);
+    root_table = grown;
+    root_capacity = new_capacity;
+}
+
+Shape* shape_root(const char *class_name) {
+    if (!class_name) class_name = "";
+    if (root_capacity) {
+        uint32_t bucket = hash_name(class_name) & (uint32_t)(root_capacity - 1);
+        for (Shape *root = root_table[bucket]; root; root = root->next_root) {
+            if (strcmp(root->class_name, class_name) == 0) return root;
+        }
+    }
+    if (root_count + 1 > root_capacity / 2) grow_root_table();
+
+    Shape *root = allocate_shape(NULL, 0);
+    root->class_name = copy_name(class_name);
+    uint32_t bucket = hash_name(class_name) & (uint32_t)(root_capacity - 1);
+    root->next_root = root_table[bucket];
+    root_table[bucket] = root;
+    root_count++;
+    return root;
+}
+
+int shape_lookup(const Shape *shape, const char *name) {
+    if (!shape || !shape->index || !name) return -1;
+    uint32_t hash = hash_name(name);
+    uint32_t mask = (uint32_t)(shape->index_capacity - 1);
+    for (uint32_t bucket = hash & mask; shape->index[bucket] >= 0; bucket = (bucket + 1) & mask) {
+        const ShapeProperty *prop = &shape->properties[shape->index[bucket]];
+        if (prop->hash == hash && strcmp(prop->name, name) == 0) return shape->index[bucket];
+    }
+    return -1;
+}
+
+static void add_transition(Shape *shape, Shape *child) {
+    if (shape->transition_count == shape->transition_capacity) {
+        int new_capacity = shape->transition_capacity ? shape->transition_capacity * 2 : 2;
+        Shape **grown = (Shape**)realloc(shape->transitions, (size_t)new_capacity * sizeof(Shape*));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for shape transitions\n");
+            exit(EXIT_FAILURE);
+        }
+        shape->transitions = grown;
+        shape->transition_capacity = new_capacity;
+    }
+    shape->transitions[shape->transition_count++] = child;
+}
+
+Shape* shape_add_property(Shape *shape, const char *name, int access, int is_static) {
+    uint32_t hash = hash_name(name);
+    for (int i = 0; i < shape->transition_count; i++) {
+        Shape *child = shape->transitions[i];
+        const ShapeProperty *added = &child->properties[child->property_count - 1];
+        if (added->hash == hash && added->access == access && added->is_static == is_static &&
+            strcmp(added->name, name) == 0) {
+            return child;
+        }
+    }
+
+    Shape *child = allocate_shape(shape, shape->property_count + 1);
+    // Inherited names are shared with the parent; each shape owns only the one it adds
+    memcpy(child->properties, shape->properties, (size_t)shape->property_count * sizeof(ShapeProperty));
+    ShapeProperty *added = &child->properties[shape->property_count];
+    added->name = copy_name(name);
+    added->hash = hash;
+    added->access = access;
+    added->is_static = is_static;
+    build_index(child);
+    add_transition(shape, child);
+    return child;
+}
+
+Shape* shape_reconfigure(Shape *shape, int slot, int access, int is_static) {
+    // Replays the layout from the root so that objects reconfigured the same
+    // way end up sharing a shape; slot positions are unchanged.
+    Shape *result = shape->root;
+    for (int i = 0; i < shape->property_count; i++) {
+        const ShapeProperty *prop = &shape->properties[i];
+        result = shape_add_property(result, prop->name,
+                                    i == slot ? access : prop->access,
+                                    i == slot ? is_static : prop->is_static);
+    }
+    return result;
+}
+
+static void free_shape_tree(Shape *shape) {
+    for (int i = 0; i < shape->transition_count; i++) free_shape_tree(shape->transitions[i]);
+    if (shape->property_count > 0) free(shape->properties[shape->property_count - 1].name);
+    free(shape->properties);
+    free(shape->index);
+    free(shape->transitions);
+    free(shape);
+}
+
+void shape_cleanup(void) {
+    for (int i = 0; i < root_capacity; i++) {
+        Shape *root = root_table[i];
+        while (root) {
+            Shape *next = root->next_root;
+            char *class_name = (char*)root->class_name;
+            free_shape_tree(root);
+            free(class_name);
+            root = next;
+        }
+    }
+    free(root_table);
+    root_table = NULL;
+    root_capacity = 0;
+    root_count = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stdint.h>
+
+// Shapes (hidden classes) describe the property layout of VM objects. Every
+// object starts at its class's root shape; adding a property follows (or
+// creates) a transition to a child shape that appends one slot. Objects built
+// the same way therefore share shapes, and a (shape, slot) pair cached at an
+// access site stays valid for every object with that shape.
+
+struct Object;
+
+typedef struct ShapeProperty {
+    char *name;
+    uint32_t hash;
+    int access;                   // AccessModifierEnum (vm.h)
+    int is_static;
+} ShapeProperty;
+
+typedef struct Shape {
+    const char *class_name;       // Class the layout belongs to (owned by the root shape)
+    struct Shape *root;
+    struct Shape *parent;         // NULL for a root shape
+    ShapeProperty *properties;    // properties[i] lives in object slot i
+    int property_count;
+    int *index;                   // Open-addressed name -> slot table (-1 = empty)
+    int index_capacity;
+    struct Shape **transitions;   // Child shapes, each adding one property
+    int transition_count;
+    int transition_capacity;
+    struct Shape *next_root;      // Registry bucket chain (root shapes only)
+    struct Object *static_object; // The class's static companion object (root shapes only)
+} Shape;
+
+// Returns the root shape for class_name, creating it on first use.
+Shape* shape_root(const char *class_name);
+// Returns the slot of `name` in shape, or -1.
+int shape_lookup(const Shape *shape, const char *name);
+// Returns the shape reached by appending a property to shape.
+Shape* shape_add_property(Shape *shape, const char *name, int access, int is_static);
+// Returns the shape with the same slots as shape but with slot's attributes changed.
+Shape* shape_reconfigure(Shape *shape, int slot, int access, int is_static);
+// Frees every shape. Objects referring to them must already be gone.
+void shape_cleanup(void);
+
+#endif // SHAPE_H
@@ -3,79 +3,97 @@
 #include <string.h>
 #include "stack.h"
 
-StackFrame* create_stack_frame(const char* name, StackFrame* parent) {
-    StackFrame* frame = (StackFrame*)calloc(1, sizeof(StackFrame)); // Use calloc
+static StackFrame *live_frames = NULL;
+
+StackFrame* create_stack_frame(const char* name, StackFrame* parent, int slot_count, const char **slot_names) {
+    if (slot_count < 0) slot_count = 0;
+    // Slots are allocated inline; calloc leaves them all VAL_UNDEFINED
+    StackFrame* frame = (StackFrame*)calloc(1, sizeof(StackFrame) + (size_t)slot_count * sizeof(Value));
     if (!frame) {
         fprintf(stderr, "Error: Memory allocation failed for stack frame '%s'\n", name);
-        // In a real application, might try to recover or throw a more specific error.
         exit(EXIT_FAILURE); // For simplicity, exit on critical alloc failure
     }
-    
-    strncpy(frame->name, name, sizeof(frame->name) - 1);
-    frame->name[sizeof(frame->name) - 1] = '\0';
-    
-    // If 'name' is a function call, function_name can be the same.
-    // If it's a block, function_name might be inherited or set to the enclosing function.
-    // For now, simple copy.
-    strncpy(frame->function_name, name, sizeof(frame->function_name) - 1);
-    frame->function_name[sizeof(frame->function_name) - 1] = '\0';
-    
+
+    frame->name = name;
     frame->parent = parent;
-    // var_count is 0 due to calloc
-    
+    frame->slot_count = slot_count;
+    frame->slot_names = slot_names;
+
+    frame->live_next = live_frames;
+    if (live_frames) live_frames->live_prev = frame;
+    live_frames = frame;
+
     return frame;
 }
 
 void destroy_stack_frame(StackFrame* frame) {
     if (frame) {
-        // Variables are stack-allocated within the frame struct, so no individual free needed for them
-        // unless their `value` field becomes dynamically allocated.
+        if (frame->live_prev) frame->live_prev->live_next = frame->live_next;
+        else live_frames = frame->live_next;
+        if (frame->live_next) frame->live_next->live_prev = frame->live_prev;
+        // String values live on the VM heap; only the frame's own storage is freed.
+        free(frame->dynamic_vars);
         free(frame);
     }
 }
 
-void set_variable(StackFrame* frame, const char* name, const char* value) {
-    if (!frame || !name || !value) {
-        // fprintf(stderr, "Warning: Attempt to set variable with null frame, name, or value.\n");
+StackFrame* stack_live_frames(void) {
+    return live_frames;
+}
+
+// Finds `name` among the frame's slots and dynamic variables.
+static Value* find_in_frame(StackFrame* frame, const char* name) {
+    for (int i = 0; i < frame->slot_count; i++) {
+        if (frame->slot_names && frame->slot_names[i] && strcmp(frame->slot_names[i], name) == 0) {
+            return &frame->slots[i];
+        }
+    }
+    for (int i = 0; i < frame->dynamic_count; i++) {
+        if (strcmp(frame->dynamic_vars[i].name, name) == 0) {
+            return &frame->dynamic_vars[i].value;
+        }
+    }
+    return NULL;
+}
+
+void set_variable(StackFrame* frame, const char* name, Value value) {
+    if (!frame || !name) {
         return;
     }
-    
+
     // Try to update existing variable in the current frame only
-    for (int i = 0; i < frame->var_count; i++) {
-        if (strcmp(frame->variables[i].name, name) == 0) {
-            strncpy(frame->variables[i].value, value, sizeof(frame->variables[i].value) - 1);
-            frame->variables[i].value[sizeof(frame->variables[i].value) - 1] = '\0';
+    Value* existing = find_in_frame(frame, name);
+    if (existing) {
+        *existing = value;
+        return;
+    }
+
+    // If not found in current frame, add as a new dynamic variable in the current frame
+    if (frame->dynamic_count == frame->dynamic_capacity) {
+        int new_capacity = frame->dynamic_capacity ? frame->dynamic_capacity * 2 : 4;
+        Variable* grown = (Variable*)realloc(frame->dynamic_vars, (size_t)new_capacity * sizeof(Variable));
+        if (!grown) {
+            fprintf(stderr, "Error: Stack frame '%s' could not grow when setting '%s'.\n", frame->name, name);
             return;
         }
+        frame->dynamic_vars = grown;
+        frame->dynamic_capacity = new_capacity;
     }
-    
-    // If not found in current frame, add as a new variable in the current frame
-    if (frame->var_count < MAX_VARIABLES) {
-        strncpy(frame->variables[frame->var_count].name, name, sizeof(frame->variables[frame->var_count].name) - 1);
-        frame->variables[frame->var_count].name[sizeof(frame->variables[frame->var_count].name) - 1] = '\0';
-        
-        strncpy(frame->variables[frame->var_count].value, value, sizeof(frame->variables[frame->var_count].value) - 1);
-        frame->variables[frame->var_count].value[sizeof(frame->variables[frame->var_count].value) - 1] = '\0';
-        
-        frame->var_count++;
-    } else {
-        fprintf(stderr, "Error: Stack frame '%s' variable limit (%d) reached when setting '%s'.\n", frame->name, MAX_VARIABLES, name);
-        // This is a critical runtime error.
-    }
+    Variable* var = &frame->dynamic_vars[frame->dynamic_count++];
+    strncpy(var->name, name, sizeof(var->name) - 1);
+    var->name[sizeof(var->name) - 1] = '\0';
+    var->value = value;
 }
 
-const char* get_variable(StackFrame* frame, const char* name) {
-    if (!name) return NULL; // Or "undefined"
+Value* get_variable(StackFrame* frame, const char* name) {
+    if (!name) return NULL;
 
     StackFrame* current_frame_iter = frame;
     while (current_frame_iter) {
-        for (int i = 0; i < current_frame_iter->var_count; i++) {
-            if (strcmp(current_frame_iter->variables[i].name, name) == 0) {
-                return current_frame_iter->variables[i].value;
-            }
-        }
+        Value* found = find_in_frame(current_frame_iter, name);
+        if (found) return found;
         current_frame_iter = current_frame_iter->parent; // Go to parent frame
     }
-    
+
     return NULL; // Variable not found in this frame or any parent frames
 }
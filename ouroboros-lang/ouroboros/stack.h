@@ -1,32 +1,46 @@
 #ifndef STACK_H
 #define STACK_H
 
-// Maximum number of variables in a stack frame
-#define MAX_VARIABLES 64 // Consider making this dynamic or larger for complex functions
+#include "value.h"
 
-// Variable structure (within a stack frame)
+// Variable created at runtime under a name the resolver did not assign a slot
+// (unresolved modules, implicit globals, ...). Kept per frame, grown on demand.
 typedef struct Variable {
     char name[128];       // Variable name
-    char value[1024];     // Variable value (as string). Consider dynamic allocation for large strings/objects.
-    // char type_name[64]; // Optionally store type here too, though symbol table is primary
+    Value value;          // Tagged runtime value
 } Variable;
 
-// Stack frame structure
+// Stack frame structure. Locals resolved by resolve_program() live in slots[],
+// sized to the function's local count; anything else falls back to the
+// name-keyed dynamic_vars list.
 typedef struct StackFrame {
-    char name[128];           // Debug name for the frame (e.g., function name, "global", "block")
-    char function_name[128];  // Specifically for the function this frame belongs to (if applicable)
-    Variable variables[MAX_VARIABLES];
-    int var_count;
-    // char *return_value; // Return value is now managed globally by vm.c's set_return_value
-    struct StackFrame *parent; // Link to the parent (caller's) stack frame
+    const char *name;          // Debug name for the frame (function name, "global"); not owned
+    struct StackFrame *parent; // Enclosing frame: the global frame for top-level functions
+                               // and methods, the caller for unresolved/nested functions
+    Variable *dynamic_vars;
+    int dynamic_count;
+    int dynamic_capacity;
+    int slot_count;
+    const char **slot_names;   // Name of each slot (owned by the function's AST node)
+    struct StackFrame *live_prev; // Every frame not yet destroyed, for the GC's root scan
+    struct StackFrame *live_next;
+    Value slots[];
 } StackFrame;
 
 // Stack frame functions
-StackFrame* create_stack_frame(const char* name, StackFrame *parent);
+StackFrame* create_stack_frame(const char* name, StackFrame *parent, int slot_count, const char **slot_names);
 void destroy_stack_frame(StackFrame *frame);
+StackFrame* stack_live_frames(void); // Head of the live frame list (follow live_next)
 
-// Variable management within a frame
-void set_variable(StackFrame *frame, const char *name, const char *value);
-const char* get_variable(StackFrame *frame, const char *name); // Searches current and parent frames
+// Resolved access: walks `depth` frames outward and returns the slot, or NULL
+// if that frame has no such slot (code run in a frame it was not resolved for).
+static inline Value* frame_slot(StackFrame *frame, int depth, int slot) {
+    while (depth-- > 0 && frame) frame = frame->parent;
+    return (frame && slot >= 0 && slot < frame->slot_count) ? &frame->slots[slot] : NULL;
+}
+
+// Name-based variable management (slow path for unresolved identifiers)
+void set_variable(StackFrame *frame, const char *name, Value value); // Current frame only
+Value* get_variable(StackFrame *frame, const char *name); // Searches current and parent frames; NULL if not found
 
 #endif // STACK_H
@@ -1,8 +1,11 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include "stdlib.h"
 #include "vm.h"
+#include "gc.h"
+#include "semantic.h" // For semantic_declare_native
 
 // For minimal build, stub out the GUI and graphics dependencies
 #ifndef MINIMAL_BUILD
@@ -16,15 +19,36 @@
 #include "vulkan.h"
 #endif
 
-// Function registry
+// Function registry. The native set is small and fixed at startup, so a
+// fixed number of buckets is plenty.
+#define NATIVE_BUCKETS 256
+
 typedef struct NativeFunction {
     const char *name;
-    void (*func_ptr)(void);
+    TextNativeFunction func_ptr;
     int arg_count;
-    struct NativeFunction *next;
+    struct NativeFunction *next; // Bucket chain, newest first
 } NativeFunction;
 
-static NativeFunction *functions = NULL;
+static NativeFunction *functions[NATIVE_BUCKETS];
+
+typedef struct ValueNative {
+    const char *name;
+    ValueNativeFunction func_ptr;
+    int arg_count;
+    struct ValueNative *next; // Bucket chain, newest first
+} ValueNative;
+
+static ValueNative *value_functions[NATIVE_BUCKETS];
+
+static uint32_t native_bucket(const char *name) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *name; name++) {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }
+    return hash & (NATIVE_BUCKETS - 1);
+}
 
 // For storing function call arguments
 static const char **call_args = NULL;
@@ -298,11 +322,101 @@ void register_function(const char *name, void (*func_ptr)(void), int arg_count)
     strcpy((char*)fn->name, name);
     fn->func_ptr = func_ptr;
     fn->arg_count = arg_count;
-    fn->next = functions;
-    functions = fn;
+    uint32_t bucket = native_bucket(name);
+    fn->next = functions[bucket];
+    functions[bucket] = fn;
+    semantic_declare_native(fn->name);
+}
+
+TextNativeFunction find_builtin_function(const char *name) {
+    for (NativeFunction *fn = functions[native_bucket(name)]; fn; fn = fn->next) {
+        if (strcmp(fn->name, name) == 0) return fn->func_ptr;
+    }
+    return NULL;
+}
+
+void register_value_function(const char *name, ValueNativeFunction func_ptr, int arg_count) {
+    ValueNative *fn = malloc(sizeof(ValueNative));
+    fn->name = malloc(strlen(name) + 1);
+    strcpy((char*)fn->name, name);
+    fn->func_ptr = func_ptr;
+    fn->arg_count = arg_count;
+    uint32_t bucket = native_bucket(name);
+    fn->next = value_functions[bucket];
+    value_functions[bucket] = fn;
+    semantic_declare_native(fn->name);
+}
+
+ValueNativeFunction find_value_function(const char *name) {
+    for (ValueNative *fn = value_functions[native_bucket(name)]; fn; fn = fn->next) {
+        if (strcmp(fn->name, name) == 0) return fn->func_ptr;
+    }
+    return NULL;
+}
+
+// Array natives
+static OuroArray* array_argument(const Value *args, int arg_count, const char *native_name) {
+    if (arg_count < 1 || !IS_ARRAY(args[0])) {
+        fprintf(stderr, "[RUNTIME] Error: %s expects an array as its first argument\n", native_name);
+        return NULL;
+    }
+    return args[0].as.array;
+}
+
+static Value native_array_push(const Value *args, int arg_count) {
+    OuroArray *array = array_argument(args, arg_count, "array_push");
+    if (!array) return value_undefined();
+    for (int i = 1; i < arg_count; i++) value_array_push(array, args[i]);
+    return value_int(array->count);
+}
+
+static Value native_array_pop(const Value *args, int arg_count) {
+    OuroArray *array = array_argument(args, arg_count, "array_pop");
+    return array ? value_array_pop(array) : value_undefined();
+}
+
+static Value native_array_slice(const Value *args, int arg_count) {
+    OuroArray *array = array_argument(args, arg_count, "array_slice");
+    if (!array) return value_undefined();
+    int64_t start = arg_count > 1 ? value_as_int(args[1]) : 0;
+    int64_t end = arg_count > 2 ? value_as_int(args[2]) : array->count;
+    return value_array_slice(array, start, end);
+}
+
+static Value native_array_length(const Value *args, int arg_count) {
+    OuroArray *array = array_argument(args, arg_count, "array_length");
+    return array ? value_int(array->count) : value_undefined();
+}
+
+// Collector natives
+static Value native_gc_collect(const Value *args, int arg_count) {
+    (void)args; (void)arg_count;
+    return value_int((int64_t)gc_collect());
+}
+
+static Value native_gc_stats(const Value *args, int arg_count) {
+    (void)args; (void)arg_count;
+    const GCStats *stats = gc_stats();
+    Object *obj = create_object("Object");
+    if (!obj) return value_undefined();
+    set_object_property(obj, "collections", value_int((int64_t)stats->collections));
+    set_object_property(obj, "heap_bytes", value_int((int64_t)stats->heap_bytes));
+    set_object_property(obj, "peak_heap_bytes", value_int((int64_t)stats->peak_heap_bytes));
+    set_object_property(obj, "heap_limit", value_int((int64_t)stats->heap_limit));
+    set_object_property(obj, "bytes_allocated", value_int((int64_t)stats->bytes_allocated));
+    set_object_property(obj, "bytes_freed", value_int((int64_t)stats->bytes_freed));
+    set_object_property(obj, "allocations", value_int((int64_t)stats->allocations));
+    set_object_property(obj, "strings_freed", value_int((int64_t)stats->strings_freed));
+    set_object_property(obj, "arrays_freed", value_int((int64_t)stats->arrays_freed));
+    set_object_property(obj, "objects_freed", value_int((int64_t)stats->objects_freed));
+    return value_object(obj->id);
 }
 
 void register_stdlib_functions() {
+    static int registered = 0; // main registers before semantic analysis; later calls are no-ops
+    if (registered) return;
+    registered = 1;
+
     printf("\n===================================\n");
     printf("==== REGISTERING STD FUNCTIONS ====\n");
     printf("===================================\n\n");
@@ -314,6 +428,12 @@ void register_stdlib_functions() {
     register_function("to_string", wrapper_to_string, 1);
     register_function("string_concat", wrapper_string_concat, 2);
     register_function("string_length", wrapper_string_length, 1);
+    register_value_function("array_push", native_array_push, -1);
+    register_value_function("array_pop", native_array_pop, 1);
+    register_value_function("array_slice", native_array_slice, -1);
+    register_value_function("array_length", native_array_length, 1);
+    register_value_function("gc_collect", native_gc_collect, 0);
+    register_value_function("gc_stats", native_gc_stats, 0);
     
     // Register GUI and graphics functions (minimal build has stubs)
     register_function("init_gui", wrapper_init_gui, 0);
@@ -396,29 +516,16 @@ void register_stdlib_functions() {
     fflush(stdout);
 }
 
+void invoke_builtin_function(TextNativeFunction func_ptr, const char **args, int arg_count) {
+    set_call_args(args, arg_count); // Set args for the wrapper to use
+    func_ptr(); // Call the C wrapper
+}
+
 int call_builtin_function_impl(const char *name, const char **args, int arg_count) {
-    // printf("[STDLIB_IMPL] Looking for built-in function: %s with %d args\n", name, arg_count);
-    
-    NativeFunction *fn = functions; // Assuming 'functions' is the list of registered native functions
-    while (fn) {
-        // printf("[STDLIB_IMPL] Checking function: %s (expects %d args)\n", fn->name, fn->arg_count);
-        if (strcmp(fn->name, name) == 0) {
-            // Basic arity check (can be made more sophisticated)
-            // if (fn->arg_count != arg_count && fn->arg_count != -1) { // -1 for varargs
-            //     fprintf(stderr, "[STDLIB_IMPL] Error: Function '%s' called with %d args, but expects %d.\n", name, arg_count, fn->arg_count);
-            //     // set_return_value("undefined"); // Or some error indicator
-            //     return 0; // Indicate error or wrong function
-            // }
-            // printf("[STDLIB_IMPL] Found built-in function: %s\n", name);
-            set_call_args(args, arg_count); // Set args for the wrapper to use
-            fn->func_ptr(); // Call the C wrapper
-            return 1; // Success
-        }
-        fn = fn->next;
-    }
-    
-    // printf("[STDLIB_IMPL] Built-in function not found: %s\n", name);
-    return 0; // Function not found
+    TextNativeFunction func_ptr = find_builtin_function(name);
+    if (!func_ptr) return 0; // Function not found
+    invoke_builtin_function(func_ptr, args, arg_count);
+    return 1;
 }
 
 // Print function wrapper
@@ -1020,10 +1127,10 @@ void wrapper_loading_animation() {
 // === STRING UTILITY FUNCTIONS ===
 void wrapper_to_string() {
     if (call_arg_count >= 1 && call_args[0]) {
-        set_return_value(call_args[0]);
+        set_return_value(value_string(call_args[0]));
         return;
     }
-    set_return_value("");
+    set_return_value(value_intern(""));
 }
 
 void wrapper_string_concat() {
@@ -1034,22 +1141,20 @@ void wrapper_string_concat() {
         char *buf = (char*)malloc(len + 1);
         strcpy(buf, str1);
         strcat(buf, str2);
-        set_return_value(buf);
+        set_return_value(value_string(buf));
         free(buf);
         return;
     }
-    set_return_value("");
+    set_return_value(value_intern(""));
 }
 
 void wrapper_string_length() {
     if (call_arg_count >= 1) {
         const char *str = call_args[0] ? call_args[0] : "";
-        char buf[32];
-        sprintf(buf, "%zu", strlen(str));
-        set_return_value(buf);
+        set_return_value(value_int((int64_t)strlen(str)));
         return;
     }
-    set_return_value("0");
+    set_return_value(value_int(0));
 }
 
 // OpenGL wrapper implementations
@@ -1184,9 +1289,7 @@ void wrapper_opengl_swap_buffers() {
 void wrapper_opengl_is_context_valid() {
     int valid = opengl_is_context_valid();
     // For the VM's return value system, we need to use vm.h's set_return_value
-    char result[32];
-    sprintf(result, "%d", valid);
-    set_return_value(result);
+    set_return_value(value_int(valid));
 }
 
 // Vulkan wrapper implementations
@@ -1261,9 +1364,7 @@ void wrapper_vulkan_create_command_buffers() {
 void wrapper_vulkan_draw_frame() {
     int result = vulkan_draw_frame();
     // Return value for Ouroboros VM
-    char result_str[32];
-    sprintf(result_str, "%d", result);
-    set_return_value(result_str);
+    set_return_value(value_int(result));
 }
 
 void wrapper_vulkan_cleanup() {
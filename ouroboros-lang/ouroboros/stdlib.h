@@ -1,6 +1,8 @@
 #ifndef STDLIB_H
 #define STDLIB_H
 
+#include "value.h"
+
 // No direct ASTNode dependencies needed for the public API of stdlib itself.
 // The VM handles ASTNode evaluation before calling stdlib functions.
 
@@ -10,4 +12,17 @@ void register_stdlib_functions();
 int call_builtin_function_impl(const char *name, const char **args, int arg_count); 
 void set_call_args(const char **args, int count); // Used internally by stdlib.c wrappers
 
+// Text natives read their C-string arguments through set_call_args. Looking one
+// up once and invoking the pointer lets call sites skip the name lookup.
+typedef void (*TextNativeFunction)(void);
+TextNativeFunction find_builtin_function(const char *name); // NULL if not registered
+void invoke_builtin_function(TextNativeFunction func_ptr, const char **args, int arg_count);
+
+// Value natives take and return runtime values directly instead of text, so
+// arrays and objects reach them intact. Named "<type>_<method>" they are also
+// callable as methods on values of that type (arr.push(x) -> array_push(arr, x)).
+typedef Value (*ValueNativeFunction)(const Value *args, int arg_count);
+void register_value_function(const char *name, ValueNativeFunction func_ptr, int arg_count);
+ValueNativeFunction find_value_function(const char *name); // NULL if not registered
+
 #endif // STDLIB_H
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Runs every tests/*.ouro with the tree-walker and with -bytecode. Both must
+# print the same [OUTPUT] lines and exit the same way, and when a
+# <name>.expected file exists, print exactly what it lists.
+#
+# Usage: tests/run_tests.sh [path/to/ouroc]   (default: ./ouroc.exe)
+
+OUROC=${1:-./ouroc.exe}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/ouro_tests.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+failures=0
+for test in "$DIR"/*.ouro; do
+    name=$(basename "$test" .ouro)
+    "$OUROC" "$test" > "$TMP/tree.raw" 2>&1
+    tree_status=$?
+    "$OUROC" "$test" -bytecode > "$TMP/bytecode.raw" 2>&1
+    bytecode_status=$?
+    grep '^\[OUTPUT\]' "$TMP/tree.raw" > "$TMP/tree.out"
+    grep '^\[OUTPUT\]' "$TMP/bytecode.raw" > "$TMP/bytecode.out"
+
+    if [ $tree_status -ne $bytecode_status ]; then
+        echo "FAIL $name: tree-walker exited $tree_status, -bytecode exited $bytecode_status"
+        failures=$((failures + 1))
+    elif ! diff -u "$TMP/tree.out" "$TMP/bytecode.out" > "$TMP/diff"; then
+        echo "FAIL $name: -bytecode output differs from the tree-walker"
+        cat "$TMP/diff"
+        failures=$((failures + 1))
+    elif [ -f "$DIR/$name.expected" ] && ! diff -u "$DIR/$name.expected" "$TMP/tree.out" > "$TMP/diff"; then
+        echo "FAIL $name: output differs from $name.expected"
+        cat "$TMP/diff"
+        failures=$((failures + 1))
+    else
+        echo "ok   $name"
+    fi
+done
+
+[ $failures -eq 0 ] || { echo "$failures test(s) failed"; exit 1; }
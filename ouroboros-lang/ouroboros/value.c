@@ -0,0 +1,459 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "value.h"
+#include "gc.h"
+
+static OuroString *heap_strings = NULL;
+static OuroArray *heap_arrays = NULL;
+
+// Open-addressed intern table (power-of-two capacity)
+static OuroString **intern_table = NULL;
+static size_t intern_capacity = 0;
+static size_t intern_count = 0;
+
+static uint32_t hash_chars(const char *s, size_t length) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static OuroString* allocate_string(const char *s, size_t length, uint32_t hash) {
+    OuroString *str = (OuroString*)malloc(sizeof(OuroString) + length + 1);
+    if (!str) {
+        fprintf(stderr, "Error: Memory allocation failed for string of length %zu\n", length);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(str->chars, s, length);
+    str->chars[length] = '\0';
+    str->length = length;
+    str->hash = hash;
+    str->interned = 0;
+    str->marked = 0;
+    str->next = heap_strings;
+    heap_strings = str;
+    gc_track_alloc(sizeof(OuroString) + length + 1);
+    return str;
+}
+
+Value value_string_n(const char *s, size_t length) {
+    Value v;
+    v.type = VAL_STRING;
+    v.as.string = allocate_string(s ? s : "", s ? length : 0, hash_chars(s ? s : "", s ? length : 0));
+    return v;
+}
+
+Value value_string(const char *s) {
+    return value_string_n(s, s ? strlen(s) : 0);
+}
+
+static void intern_grow(void) {
+    size_t new_capacity = intern_capacity ? intern_capacity * 2 : 256;
+    OuroString **new_table = (OuroString**)calloc(new_capacity, sizeof(OuroString*));
+    if (!new_table) {
+        fprintf(stderr, "Error: Memory allocation failed for string intern table\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < intern_capacity; i++) {
+        OuroString *str = intern_table[i];
+        if (!str) continue;
+        size_t slot = str->hash & (new_capacity - 1);
+        while (new_table[slot]) slot = (slot + 1) & (new_capacity - 1);
+        new_table[slot] = str;
+    }
+    free(intern_table);
+    intern_table = new_table;
+    intern_capacity = new_capacity;
+}
+
+Value value_intern(const char *s) {
+    if (!s) s = "";
+    size_t length = strlen(s);
+    uint32_t hash = hash_chars(s, length);
+
+    if ((intern_count + 1) * 2 > intern_capacity) intern_grow();
+
+    size_t slot = hash & (intern_capacity - 1);
+    while (intern_table[slot]) {
+        OuroString *str = intern_table[slot];
+        if (str->hash == hash && str->length == length && memcmp(str->chars, s, length) == 0) {
+            Value v; v.type = VAL_STRING; v.as.string = str;
+            return v;
+        }
+        slot = (slot + 1) & (intern_capacity - 1);
+    }
+
+    OuroString *str = allocate_string(s, length, hash);
+    str->interned = 1;
+    intern_table[slot] = str;
+    intern_count++;
+
+    Value v; v.type = VAL_STRING; v.as.string = str;
+    return v;
+}
+
+Value value_concat(Value a, Value b) {
+    char left_buf[64], right_buf[64];
+    const char *left = value_to_cstring(a, left_buf, sizeof(left_buf));
+    const char *right = value_to_cstring(b, right_buf, sizeof(right_buf));
+    size_t left_len = IS_STRING(a) ? a.as.string->length : strlen(left);
+    size_t right_len = IS_STRING(b) ? b.as.string->length : strlen(right);
+
+    char stack_buf[256];
+    char *joined = stack_buf;
+    if (left_len + right_len + 1 > sizeof(stack_buf)) {
+        joined = (char*)malloc(left_len + right_len + 1);
+        if (!joined) {
+            fprintf(stderr, "Error: Memory allocation failed for string concatenation\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(joined, left, left_len);
+    memcpy(joined + left_len, right, right_len);
+    Value result = value_string_n(joined, left_len + right_len);
+    if (joined != stack_buf) free(joined);
+    return result;
+}
+
+Value value_array(int64_t capacity) {
+    OuroArray *array = (OuroArray*)calloc(1, sizeof(OuroArray));
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for array\n");
+        exit(EXIT_FAILURE);
+    }
+    if (capacity > 0) {
+        array->items = (Value*)malloc((size_t)capacity * sizeof(Value));
+        if (!array->items) {
+            fprintf(stderr, "Error: Memory allocation failed for array of %lld elements\n", (long long)capacity);
+            exit(EXIT_FAILURE);
+        }
+        array->capacity = capacity;
+    }
+    array->next = heap_arrays;
+    heap_arrays = array;
+    gc_track_alloc(sizeof(OuroArray) + (size_t)array->capacity * sizeof(Value));
+
+    Value v; v.type = VAL_ARRAY; v.as.array = array;
+    return v;
+}
+
+void value_array_push(OuroArray *array, Value item) {
+    if (array->count == array->capacity) {
+        int64_t new_capacity = array->capacity ? array->capacity * 2 : 8;
+        Value *grown = (Value*)realloc(array->items, (size_t)new_capacity * sizeof(Value));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed growing array to %lld elements\n", (long long)new_capacity);
+            exit(EXIT_FAILURE);
+        }
+        gc_track_resize((size_t)array->capacity * sizeof(Value), (size_t)new_capacity * sizeof(Value));
+        array->items = grown;
+        array->capacity = new_capacity;
+    }
+    array->items[array->count++] = item;
+}
+
+Value value_array_pop(OuroArray *array) {
+    if (array->count == 0) return value_undefined();
+    return array->items[--array->count];
+}
+
+Value value_array_slice(const OuroArray *array, int64_t start, int64_t end) {
+    if (start < 0) start += array->count;
+    if (end < 0) end += array->count;
+    if (start < 0) start = 0;
+    if (end > array->count) end = array->count;
+    int64_t count = end > start ? end - start : 0;
+
+    Value slice = value_array(count);
+    if (count > 0) memcpy(slice.as.array->items, array->items + start, (size_t)count * sizeof(Value));
+    slice.as.array->count = count;
+    return slice;
+}
+
+// Renders "[a,b,c]" onto the heap. Nesting is capped so that an array
+// containing itself still prints.
+static const char* array_to_cstring(const OuroArray *array) {
+    static int depth = 0;
+    if (depth > 32) return "[...]";
+    depth++;
+
+    size_t capacity = 64, length = 0;
+    char *text = (char*)malloc(capacity);
+    if (!text) {
+        fprintf(stderr, "Error: Memory allocation failed formatting array\n");
+        exit(EXIT_FAILURE);
+    }
+    text[length++] = '[';
+    for (int64_t i = 0; i < array->count; i++) {
+        char item_buf[64];
+        const char *item = value_to_cstring(array->items[i], item_buf, sizeof(item_buf));
+        size_t item_len = strlen(item);
+        if (length + item_len + 2 > capacity) {
+            while (length + item_len + 2 > capacity) capacity *= 2;
+            char *grown = (char*)realloc(text, capacity);
+            if (!grown) {
+                fprintf(stderr, "Error: Memory allocation failed formatting array\n");
+                exit(EXIT_FAILURE);
+            }
+            text = grown;
+        }
+        if (i > 0) text[length++] = ',';
+        memcpy(text + length, item, item_len);
+        length += item_len;
+    }
+    text[length++] = ']';
+    Value rendered = value_string_n(text, length);
+    free(text);
+
+    depth--;
+    return rendered.as.string->chars;
+}
+
+// Parses a decimal literal ("12", "-3.5", ".75", "1.2e4"). Returns 0 if text is not a number.
+static int parse_number(const char *text, Value *out) {
+    if (!text) return 0;
+    while (isspace((unsigned char)*text)) text++;
+    if (!*text) return 0;
+
+    char *end = NULL;
+    int is_float = strpbrk(text, ".eE") != NULL;
+    if (!is_float) {
+        long long i = strtoll(text, &end, 10);
+        if (end != text && *end == '\0') { *out = value_int((int64_t)i); return 1; }
+        return 0;
+    }
+    double d = strtod(text, &end);
+    if (end != text && *end == '\0') { *out = value_double(d); return 1; }
+    return 0;
+}
+
+// Recognises the text forms of non-string values.
+static int infer_scalar(const char *text, Value *out) {
+    if (strcmp(text, "true") == 0) { *out = value_bool(1); return 1; }
+    if (strcmp(text, "false") == 0) { *out = value_bool(0); return 1; }
+    if (strcmp(text, "null") == 0) { *out = value_null(); return 1; }
+    if (strcmp(text, "undefined") == 0) { *out = value_undefined(); return 1; }
+    if (strncmp(text, "obj:", 4) == 0 && isdigit((unsigned char)text[4])) { *out = value_object(atoi(text + 4)); return 1; }
+    return parse_number(text, out);
+}
+
+Value value_from_literal(const char *text, const char *data_type) {
+    Value v;
+    if (data_type && (strcmp(data_type, "int") == 0 || strcmp(data_type, "float") == 0)) {
+        if (parse_number(text, &v)) return v;
+    } else if (data_type && strcmp(data_type, "bool") == 0) {
+        return value_bool(text && strcmp(text, "true") == 0);
+    } else if (data_type && strcmp(data_type, "null") == 0) {
+        return value_null();
+    } else if (data_type && strcmp(data_type, "string") == 0) {
+        return value_intern(text);
+    }
+    // Untyped literal: infer from the token text
+    if (!text) return value_undefined();
+    if (infer_scalar(text, &v)) return v;
+    return value_intern(text);
+}
+
+Value value_parse(const char *text) {
+    Value v;
+    if (!text) return value_undefined();
+    if (infer_scalar(text, &v)) return v;
+    return value_string(text);
+}
+
+int value_is_truthy(Value v) {
+    switch (v.type) {
+        case VAL_UNDEFINED: case VAL_NULL: return 0;
+        case VAL_BOOL: return v.as.boolean;
+        case VAL_INT: return v.as.integer != 0;
+        case VAL_DOUBLE: return v.as.number != 0.0;
+        case VAL_STRING: return v.as.string->length > 0;
+        case VAL_OBJECT: case VAL_ARRAY: return 1;
+    }
+    return 0;
+}
+
+int value_is_numeric(Value v) {
+    Value parsed;
+    switch (v.type) {
+        case VAL_INT: case VAL_DOUBLE: case VAL_BOOL: return 1;
+        case VAL_STRING: return parse_number(v.as.string->chars, &parsed);
+        default: return 0;
+    }
+}
+
+double value_as_number(Value v) {
+    Value parsed;
+    switch (v.type) {
+        case VAL_INT: return (double)v.as.integer;
+        case VAL_DOUBLE: return v.as.number;
+        case VAL_BOOL: return v.as.boolean;
+        case VAL_STRING:
+            if (parse_number(v.as.string->chars, &parsed)) return value_as_number(parsed);
+            return 0.0;
+        default: return 0.0;
+    }
+}
+
+int64_t value_as_int(Value v) {
+    Value parsed;
+    switch (v.type) {
+        case VAL_INT: return v.as.integer;
+        case VAL_DOUBLE: return (int64_t)v.as.number;
+        case VAL_BOOL: return v.as.boolean;
+        case VAL_STRING:
+            if (parse_number(v.as.string->chars, &parsed)) return value_as_int(parsed);
+            return 0;
+        default: return 0;
+    }
+}
+
+const char* value_to_cstring(Value v, char *buf, size_t buf_size) {
+    switch (v.type) {
+        case VAL_UNDEFINED: return "undefined";
+        case VAL_NULL: return "null";
+        case VAL_BOOL: return v.as.boolean ? "true" : "false";
+        case VAL_INT:
+            snprintf(buf, buf_size, "%lld", (long long)v.as.integer);
+            return buf;
+        case VAL_DOUBLE:
+            if (isnan(v.as.number)) return "NaN";
+            snprintf(buf, buf_size, "%g", v.as.number);
+            return buf;
+        case VAL_STRING: return v.as.string->chars;
+        case VAL_OBJECT:
+            snprintf(buf, buf_size, "obj:%d", v.as.object_id);
+            return buf;
+        case VAL_ARRAY: return array_to_cstring(v.as.array);
+    }
+    return "undefined";
+}
+
+Value value_to_string_value(Value v) {
+    if (IS_STRING(v)) return v;
+    char buf[64];
+    return value_string(value_to_cstring(v, buf, sizeof(buf)));
+}
+
+const char* value_type_name(Value v) {
+    switch (v.type) {
+        case VAL_UNDEFINED: return "undefined";
+        case VAL_NULL: return "null";
+        case VAL_BOOL: return "bool";
+        case VAL_INT: return "int";
+        case VAL_DOUBLE: return "float";
+        case VAL_STRING: return "string";
+        case VAL_OBJECT: return "object";
+        case VAL_ARRAY: return "array";
+    }
+    return "unknown";
+}
+
+int value_equals(Value a, Value b) {
+    if (IS_NUMBER(a) && IS_NUMBER(b)) {
+        if (a.type == VAL_INT && b.type == VAL_INT) return a.as.integer == b.as.integer;
+        return value_as_number(a) == value_as_number(b);
+    }
+    if (a.type == b.type) {
+        switch (a.type) {
+            case VAL_UNDEFINED: case VAL_NULL: return 1;
+            case VAL_BOOL: return a.as.boolean == b.as.boolean;
+            case VAL_OBJECT: return a.as.object_id == b.as.object_id;
+            case VAL_ARRAY: return a.as.array == b.as.array;
+            case VAL_STRING:
+                return a.as.string == b.as.string ||
+                       (a.as.string->length == b.as.string->length &&
+                        memcmp(a.as.string->chars, b.as.string->chars, a.as.string->length) == 0);
+            default: break;
+        }
+    }
+    // Mixed kinds ("1" == 1, "true" == true): compare numerically when both
+    // sides are numbers, otherwise by their text form.
+    if (value_is_numeric(a) && value_is_numeric(b) && a.type != VAL_BOOL && b.type != VAL_BOOL) {
+        return value_as_number(a) == value_as_number(b);
+    }
+    char left_buf[64], right_buf[64];
+    return strcmp(value_to_cstring(a, left_buf, sizeof(left_buf)),
+                  value_to_cstring(b, right_buf, sizeof(right_buf))) == 0;
+}
+
+int value_compare(Value a, Value b) {
+    if (IS_NUMBER(a) && IS_NUMBER(b)) {
+        if (a.type == VAL_INT && b.type == VAL_INT) {
+            return (a.as.integer > b.as.integer) - (a.as.integer < b.as.integer);
+        }
+        double l = value_as_number(a), r = value_as_number(b);
+        return (l > r) - (l < r);
+    }
+    if (value_is_numeric(a) && value_is_numeric(b)) {
+        double l = value_as_number(a), r = value_as_number(b);
+        return (l > r) - (l < r);
+    }
+    char left_buf[64], right_buf[64];
+    return strcmp(value_to_cstring(a, left_buf, sizeof(left_buf)),
+                  value_to_cstring(b, right_buf, sizeof(right_buf)));
+}
+
+void value_heap_sweep(GCStats *stats) {
+    OuroString **str_link = &heap_strings;
+    while (*str_link) {
+        OuroString *str = *str_link;
+        if (str->marked || str->interned) {
+            str->marked = 0;
+            str_link = &str->next;
+            continue;
+        }
+        *str_link = str->next;
+        size_t bytes = sizeof(OuroString) + str->length + 1;
+        stats->heap_bytes -= bytes;
+        stats->bytes_freed += bytes;
+        stats->strings_freed++;
+        free(str);
+    }
+
+    OuroArray **array_link = &heap_arrays;
+    while (*array_link) {
+        OuroArray *array = *array_link;
+        if (array->marked) {
+            array->marked = 0;
+            array_link = &array->next;
+            continue;
+        }
+        *array_link = array->next;
+        size_t bytes = sizeof(OuroArray) + (size_t)array->capacity * sizeof(Value);
+        stats->heap_bytes -= bytes;
+        stats->bytes_freed += bytes;
+        stats->arrays_freed++;
+        free(array->items);
+        free(array);
+    }
+}
+
+void value_heap_cleanup(void) {
+    OuroString *str = heap_strings;
+    while (str) {
+        OuroString *next = str->next;
+        free(str);
+        str = next;
+    }
+    heap_strings = NULL;
+
+    OuroArray *array = heap_arrays;
+    while (array) {
+        OuroArray *next = array->next;
+        free(array->items);
+        free(array);
+        array = next;
+    }
+    heap_arrays = NULL;
+
+    free(intern_table);
+    intern_table = NULL;
+    intern_capacity = 0;
+    intern_count = 0;
+}
@@ -0,0 +1,113 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Runtime value tags. A zero-initialised Value is VAL_UNDEFINED.
+typedef enum {
+    VAL_UNDEFINED = 0,
+    VAL_NULL,
+    VAL_BOOL,
+    VAL_INT,
+    VAL_DOUBLE,
+    VAL_STRING,
+    VAL_OBJECT,
+    VAL_ARRAY
+} ValueType;
+
+// Immutable heap string. Strings are never modified after creation, so any
+// number of Values may share one.
+typedef struct OuroString {
+    struct OuroString *next; // VM heap list, released by value_heap_cleanup()
+    size_t length;
+    uint32_t hash;
+    uint8_t interned;        // Interned strings are permanent
+    uint8_t marked;          // GC mark bit
+    char chars[];
+} OuroString;
+
+// Growable array of values. Arrays are mutable and shared by reference, so
+// every Value holding the same OuroArray sees pushes and element stores.
+typedef struct OuroArray {
+    struct OuroArray *next; // VM heap list, released by value_heap_cleanup()
+    int64_t count;
+    int64_t capacity;
+    struct Value *items;
+    int marked;             // GC mark bit
+} OuroArray;
+
+// Tagged runtime value. Scalars are stored inline; strings point into the VM
+// heap and objects are referenced by their id (see find_object_by_id in vm.h).
+typedef struct Value {
+    ValueType type;
+    union {
+        int boolean;
+        int64_t integer;
+        double number;
+        OuroString *string;
+        OuroArray *array;
+        int object_id;
+    } as;
+} Value;
+
+#define IS_NUMBER(v) ((v).type == VAL_INT || (v).type == VAL_DOUBLE)
+#define IS_STRING(v) ((v).type == VAL_STRING)
+#define IS_OBJECT(v) ((v).type == VAL_OBJECT)
+#define IS_ARRAY(v) ((v).type == VAL_ARRAY)
+#define IS_NULLISH(v) ((v).type == VAL_UNDEFINED || (v).type == VAL_NULL)
+
+static inline Value value_undefined(void) { Value v; v.type = VAL_UNDEFINED; v.as.integer = 0; return v; }
+static inline Value value_null(void) { Value v; v.type = VAL_NULL; v.as.integer = 0; return v; }
+static inline Value value_bool(int b) { Value v; v.type = VAL_BOOL; v.as.integer = 0; v.as.boolean = b ? 1 : 0; return v; }
+static inline Value value_int(int64_t i) { Value v; v.type = VAL_INT; v.as.integer = i; return v; }
+static inline Value value_double(double d) { Value v; v.type = VAL_DOUBLE; v.as.number = d; return v; }
+static inline Value value_object(int id) { Value v; v.type = VAL_OBJECT; v.as.integer = 0; v.as.object_id = id; return v; }
+
+// String construction. value_string copies its argument onto the VM heap;
+// value_intern returns a shared, deduplicated string (used for literals and
+// identifiers, which are evaluated repeatedly).
+Value value_string(const char *s);
+Value value_string_n(const char *s, size_t length);
+Value value_intern(const char *s);
+Value value_concat(Value a, Value b);
+
+// Arrays. value_array_slice takes Python-style bounds: negative indices count
+// from the end and out-of-range bounds are clamped.
+Value value_array(int64_t capacity);
+void value_array_push(OuroArray *array, Value item);
+Value value_array_pop(OuroArray *array); // undefined when empty
+Value value_array_slice(const OuroArray *array, int64_t start, int64_t end);
+static inline Value* value_array_at(OuroArray *array, int64_t index) {
+    return (index >= 0 && index < array->count) ? &array->items[index] : NULL;
+}
+
+// Builds the runtime value for a parser literal (text + data_type from the AST).
+Value value_from_literal(const char *text, const char *data_type);
+// Parses the text form of a value ("42", "true", "obj:3", ...); anything else
+// becomes a string. Used where values arrive as text (pseudo-arrays, native input).
+Value value_parse(const char *text);
+
+// Conversions
+int value_is_truthy(Value v);
+int value_is_numeric(Value v);       // number, bool, or a string holding a number
+double value_as_number(Value v);
+int64_t value_as_int(Value v);
+// Formats v as text. Returns v's own characters for strings, otherwise writes
+// into buf (arrays are rendered onto the heap, as "[a,b,c]"). Only use this
+// at print/stdlib boundaries.
+const char* value_to_cstring(Value v, char *buf, size_t buf_size);
+Value value_to_string_value(Value v);
+const char* value_type_name(Value v);
+
+// Comparison
+int value_equals(Value a, Value b);
+int value_compare(Value a, Value b); // <0, 0, >0
+
+// Frees every heap string and array. Called from vm_cleanup().
+void value_heap_cleanup(void);
+// Frees unmarked strings and arrays and clears the marks (gc.c)
+struct GCStats;
+void value_heap_sweep(struct GCStats *stats);
+
+#endif // VALUE_H
@@ -8,6 +8,8 @@
 #include "eval.h"    // For evaluate_expression
 #include "stdlib.h"  // For actual call_builtin_function, register_stdlib_functions
 #include "module.h"  // For Module types, if used for imports
+#include "gc.h"
+#include "bytecode.h" // For bytecode_execute
 
 // Using AccessModifierEnum from vm.h; remove string macro definition
 
@@ -15,54 +17,75 @@ extern ASTNode *program; // Global AST root from parser
 
 typedef struct FunctionEntry {
     ASTNode *func;
-    struct FunctionEntry *next;
+    uint32_t hash;              // function_key_hash(name, parent class)
+    struct FunctionEntry *next; // Bucket chain, newest first so later registrations win
 } FunctionEntry;
 
 typedef struct ClassEntry {
     char name[128];
     char parent_name[128];
     ASTNode *class_node; 
-    struct ClassEntry *next;
+    uint32_t hash;
+    ASTNode **methods;          // Own methods by name (open addressing), first declaration wins
+    int method_capacity;
+    struct ClassEntry *bucket_next;
+    struct ClassEntry *next;    // Registration order
 } ClassEntry;
 
 static StackFrame *global_frame = NULL;
-static char *return_value = NULL;
-static FunctionEntry *registered_functions = NULL;
+static Value return_value;
+static FunctionEntry **function_table = NULL; // Buckets by function_key_hash
+static int function_table_capacity = 0;
+static int function_count = 0;
+static ClassEntry **class_table = NULL;       // Buckets by class name hash
+static int class_table_capacity = 0;
+static int class_count = 0;
 static ClassEntry *registered_classes = NULL;
 static ClassEntry *registered_classes_tail = NULL;
+// Bumped whenever a function or class is (un)registered; call-site caches
+// resolved under an older epoch are re-resolved.
+static unsigned registry_epoch = 1;
+
+// Polymorphic part of a method call site's cache. Keys identify the receiver's
+// class: its root shape for instance calls, the interned class name string for
+// Class.method() calls.
+#define CALL_CACHE_WAYS 4
+typedef struct CallCache {
+    const void *keys[CALL_CACHE_WAYS];
+    ASTNode *targets[CALL_CACHE_WAYS]; // NULL = no class method, take the generic path
+    int count;
+    struct CallCache *next;            // All caches, released with the registries
+} CallCache;
+static CallCache *call_caches = NULL;
 
 char current_class[128] = {0}; // Global current class context for resolution
 char g_super_target_class[128] = {0};
-Object *objects = NULL;
+static Object **object_table = NULL; // Indexed by object id; slot 0 is never used
+static int object_table_capacity = 0;
 static int next_object_id = 1;
+static int *free_object_ids = NULL;   // Ids of collected objects, reused before next_object_id
+static int free_object_id_count = 0;
+static int free_object_id_capacity = 0;
 
 static int g_break_flag = 0;
 static int g_continue_flag = 0;
+static int g_return_flag = 0; // Set by 'return'; unwinds statement lists up to execute_function_call
 
 static int is_class_registered(const char *name);
+static Value invoke_with_ast_args(ASTNode *func_node, Value this_binding, const char *class_context, ASTNode *args_ast_list, StackFrame *caller_frame);
+static Value call_value_native(ValueNativeFunction native, const Value *receiver, ASTNode *args_ast_list, StackFrame *frame);
+static Value call_text_native(TextNativeFunction native, const char *func_name_to_call, ASTNode *args_ast_list, StackFrame *frame_for_evaluating_args);
 static ClassEntry* find_class_entry(const char *name);
 static void initialize_default_instance_fields(const char *class_name, Object *instance, StackFrame* frame_for_eval);
 const char* get_parent_class_name(const char *class_name);
 ASTNode* find_class_method(const char *class_name, const char *method_name);
 
-const char* get_return_value() {
-    return return_value ? return_value : "0"; 
+Value get_return_value() {
+    return return_value;
 }
 
-void set_return_value(const char* value) {
-    if (return_value) {
-        free(return_value);
-        return_value = NULL;
-    }
-    if (value) {
-        return_value = strdup(value);
-        if (!return_value) {
-            fprintf(stderr, "Error: Memory allocation failed for return value. Defaulting to \"0\".\n");
-            return_value = strdup("0"); 
-        }
-    } else {
-        return_value = strdup("0"); 
-    }
+void set_return_value(Value value) {
+    return_value = value;
 }
 
 Object* create_object(const char *class_name) {
@@ -71,135 +94,135 @@ Object* create_object(const char *class_name) {
         fprintf(stderr, "Error: Failed to allocate memory for object of class '%s'\n", class_name);
         return NULL;
     }
-    snprintf(obj->class_name, sizeof(obj->class_name), "%s#%d", class_name, next_object_id++);
-    obj->next = objects;
-    objects = obj;
-    // printf("[OBJECT] Created new object: %s (class: %s)\n", obj->class_name, class_name);
+    if (free_object_id_count == 0 && next_object_id >= object_table_capacity) {
+        int new_capacity = object_table_capacity ? object_table_capacity * 2 : 64;
+        Object **grown = (Object**)realloc(object_table, (size_t)new_capacity * sizeof(Object*));
+        if (!grown) {
+            fprintf(stderr, "Error: Failed to grow object table for object of class '%s'\n", class_name);
+            free(obj);
+            return NULL;
+        }
+        memset(grown + object_table_capacity, 0, (size_t)(new_capacity - object_table_capacity) * sizeof(Object*));
+        object_table = grown;
+        object_table_capacity = new_capacity;
+    }
+    obj->id = free_object_id_count > 0 ? free_object_ids[--free_object_id_count] : next_object_id++;
+    strncpy(obj->class_name, class_name, sizeof(obj->class_name) - 1);
+    obj->class_name[sizeof(obj->class_name) - 1] = '\0';
+    obj->shape = shape_root(obj->class_name);
+    object_table[obj->id] = obj;
+    gc_track_alloc(sizeof(Object));
+    // printf("[OBJECT] Created new object: %s#%d\n", obj->class_name, obj->id);
+    // Field initialisers may run script code, so keep the new object rooted
+    gc_push_root(value_object(obj->id));
     initialize_default_instance_fields(class_name, obj, global_frame); 
+    gc_pop_roots(1);
     return obj;
 }
 
-void set_object_property_with_access(Object *obj, const char *name, const char *value, AccessModifierEnum access, int is_static) {
+void set_object_property_with_access(Object *obj, const char *name, Value value, AccessModifierEnum access, int is_static) {
     if (!obj) { fprintf(stderr, "Error: Cannot set property '%s' on null object\n", name); return; }
-    if (!name || !value) { fprintf(stderr, "Error: Invalid parameters for setting object property (name or value is null)\n"); return; }
+    if (!name) { fprintf(stderr, "Error: Invalid parameters for setting object property (name is null)\n"); return; }
     
-    ObjectProperty *prop = obj->properties;
-    while (prop) {
-        if (strcmp(prop->name, name) == 0) {
-            strncpy(prop->value, value, sizeof(prop->value) - 1);
-            prop->value[sizeof(prop->value) - 1] = '\0';
-            prop->access = access;
-            prop->is_static = is_static;
-            return;
+    int slot = shape_lookup(obj->shape, name);
+    if (slot >= 0) {
+        const ShapeProperty *prop = &obj->shape->properties[slot];
+        if (prop->access != (int)access || prop->is_static != is_static) {
+            obj->shape = shape_reconfigure(obj->shape, slot, access, is_static);
         }
-        prop = prop->next;
+        obj->slots[slot] = value;
+        return;
     }
     
-    ObjectProperty *new_prop = (ObjectProperty*)calloc(1, sizeof(ObjectProperty)); // Use calloc
-    if (!new_prop) { fprintf(stderr, "Error: Failed to allocate memory for object property '%s'\n", name); return; }
-    
-    strncpy(new_prop->name, name, sizeof(new_prop->name) - 1);
-    new_prop->name[sizeof(new_prop->name) - 1] = '\0';
-    strncpy(new_prop->value, value, sizeof(new_prop->value) - 1);
-    new_prop->value[sizeof(new_prop->value) - 1] = '\0';
-    new_prop->access = access;
-    new_prop->is_static = is_static;
-    new_prop->next = obj->properties;
-    obj->properties = new_prop;
+    slot = obj->shape->property_count;
+    if (slot == obj->slot_capacity) {
+        int new_capacity = obj->slot_capacity ? obj->slot_capacity * 2 : 4;
+        Value *grown = (Value*)realloc(obj->slots, (size_t)new_capacity * sizeof(Value));
+        if (!grown) { fprintf(stderr, "Error: Failed to allocate memory for object property '%s'\n", name); return; }
+        gc_track_resize((size_t)obj->slot_capacity * sizeof(Value), (size_t)new_capacity * sizeof(Value));
+        obj->slots = grown;
+        obj->slot_capacity = new_capacity;
+    }
+    obj->shape = shape_add_property(obj->shape, name, access, is_static);
+    obj->slots[slot] = value;
 }
 
-const char* get_object_property(Object *obj, const char *name) {
+Value* get_object_property(Object *obj, const char *name) {
     return get_object_property_with_access_check(obj, name, NULL); 
 }
 
-const char* get_object_property_with_access_check(Object *obj, const char *name, const char *accessing_class_context) {
+Value* get_object_property_with_access_check(Object *obj, const char *name, const char *accessing_class_context) {
     if (!obj || !name) return NULL;
     
-    char obj_base_class_name[128] = {0};
-    char *hash_pos = strchr(obj->class_name, '#');
-    if (hash_pos) {
-        size_t len = hash_pos - obj->class_name;
-        if (len < sizeof(obj_base_class_name)) {
-            strncpy(obj_base_class_name, obj->class_name, len);
-            obj_base_class_name[len] = '\0';
-        } else {
-            strncpy(obj_base_class_name, obj->class_name, sizeof(obj_base_class_name) -1);
-            obj_base_class_name[sizeof(obj_base_class_name)-1] = '\0';
-        }
-    } else { 
-        strncpy(obj_base_class_name, obj->class_name, sizeof(obj_base_class_name) - 1);
-        obj_base_class_name[sizeof(obj_base_class_name)-1] = '\0';
-        if(strstr(obj_base_class_name, "_static")) { // "ClassName_static"
-             char * p = strstr(obj_base_class_name, "_static");
-             if(p) *p = '\0';
-        }
-    }
-    
-    ObjectProperty *prop = obj->properties;
-    while (prop) {
-        if (strcmp(prop->name, name) == 0) {
-            if (prop->access == ACCESS_MODIFIER_PUBLIC) return prop->value;
-            if (prop->access == ACCESS_MODIFIER_PRIVATE) {
-                if (accessing_class_context && strcmp(accessing_class_context, obj_base_class_name) == 0) {
-                    return prop->value;
-                } else {
-                    // fprintf(stderr, "Access Denied: Cannot access private property '%s.%s' from context '%s'.\n", 
-                    //         obj_base_class_name, name, accessing_class_context ? accessing_class_context : "global/unknown");
-                    return NULL; 
-                }
-            }
-            return prop->value; 
-        }
-        prop = prop->next;
+    int slot = shape_lookup(obj->shape, name);
+    if (slot < 0) return NULL;
+    if (obj->shape->properties[slot].access == ACCESS_MODIFIER_PRIVATE &&
+        !(accessing_class_context && strcmp(accessing_class_context, obj->class_name) == 0)) {
+        // fprintf(stderr, "Access Denied: Cannot access private property '%s.%s' from context '%s'.\n", 
+        //         obj->class_name, name, accessing_class_context ? accessing_class_context : "global/unknown");
+        return NULL;
     }
-    return NULL; 
+    return &obj->slots[slot];
 }
 
-const char* get_object_property_with_access(Object *obj, const char *property_name, const char *current_class_context_for_access_check) {
-    if (!obj) return "undefined";
-    const char* instance_prop_val = get_object_property_with_access_check(obj, property_name, current_class_context_for_access_check);
-    if (instance_prop_val) return instance_prop_val;
+Value get_object_property_with_access(Object *obj, const char *property_name, const char *current_class_context_for_access_check) {
+    if (!obj) return value_undefined();
+    Value* instance_prop_val = get_object_property_with_access_check(obj, property_name, current_class_context_for_access_check);
+    if (instance_prop_val) return *instance_prop_val;
 
     char obj_base_class_name[128] = {0};
-    char *hash_pos = strchr(obj->class_name, '#');
-    if (hash_pos) {
-        size_t len = hash_pos - obj->class_name;
-         if (len < sizeof(obj_base_class_name)) {
-            strncpy(obj_base_class_name, obj->class_name, len);
-            obj_base_class_name[len] = '\0';
-        } else {
-            strncpy(obj_base_class_name, obj->class_name, sizeof(obj_base_class_name)-1);
-            obj_base_class_name[sizeof(obj_base_class_name)-1] = '\0';
-        }
-        if(strstr(obj_base_class_name, "_static")) { // if "ClassName_static"
-             char * p = strstr(obj_base_class_name, "_static");
-             if(p) *p = '\0'; // Get "ClassName"
+    strncpy(obj_base_class_name, obj->class_name, sizeof(obj_base_class_name) - 1);
+    char *static_suffix = strstr(obj_base_class_name, "_static");
+    if (static_suffix) *static_suffix = '\0'; // "ClassName_static" -> "ClassName"
+
+    Object *static_class_obj = find_static_class_object(obj_base_class_name);
+    if (static_class_obj) {
+        int slot = shape_lookup(static_class_obj->shape, property_name);
+        if (slot >= 0 && static_class_obj->shape->properties[slot].is_static) {
+            const ShapeProperty *static_prop = &static_class_obj->shape->properties[slot];
+            if (static_prop->access == ACCESS_MODIFIER_PUBLIC) return static_class_obj->slots[slot];
+            if (static_prop->access == ACCESS_MODIFIER_PRIVATE && 
+                current_class_context_for_access_check && 
+                strcmp(current_class_context_for_access_check, obj_base_class_name) == 0) {
+                return static_class_obj->slots[slot];
+            }
+            // fprintf(stderr, "Access Denied: Cannot access private static property '%s.%s' from context '%s'.\n",
+            //          obj_base_class_name, property_name, current_class_context_for_access_check ? current_class_context_for_access_check : "global/unknown");
+            return value_undefined(); 
         }
+    }
+    return value_undefined();
+}
 
+Value get_object_property_at_site(Object *obj, const char *name, ASTNode *site) {
+    if (obj->shape == site->cached_shape) return obj->slots[site->cached_slot];
+    int slot = shape_lookup(obj->shape, name);
+    // Private properties depend on the accessing class, so only the others are cached
+    if (slot >= 0 && obj->shape->properties[slot].access != ACCESS_MODIFIER_PRIVATE) {
+        site->cached_shape = obj->shape;
+        site->cached_slot = slot;
+        return obj->slots[slot];
+    }
+    return get_object_property_with_access(obj, name, current_class);
+}
 
-        Object *static_class_obj = find_static_class_object(obj_base_class_name);
-        if (static_class_obj) {
-            ObjectProperty *static_prop = static_class_obj->properties;
-            while(static_prop) {
-                if (strcmp(static_prop->name, property_name) == 0 && static_prop->is_static) {
-                    if (static_prop->access == ACCESS_MODIFIER_PUBLIC) return static_prop->value;
-                    if (static_prop->access == ACCESS_MODIFIER_PRIVATE && 
-                        current_class_context_for_access_check && 
-                        strcmp(current_class_context_for_access_check, obj_base_class_name) == 0) {
-                        return static_prop->value;
-                    }
-                    // fprintf(stderr, "Access Denied: Cannot access private static property '%s.%s' from context '%s'.\n",
-                    //          obj_base_class_name, property_name, current_class_context_for_access_check ? current_class_context_for_access_check : "global/unknown");
-                    return "undefined"; 
-                }
-                static_prop = static_prop->next;
-            }
+void set_object_property_at_site(Object *obj, const char *name, Value value, int is_static, ASTNode *site) {
+    if (obj->shape == site->cached_shape) {
+        const ShapeProperty *prop = &obj->shape->properties[site->cached_slot];
+        if (prop->access == ACCESS_MODIFIER_PUBLIC && prop->is_static == is_static) {
+            obj->slots[site->cached_slot] = value;
+            return;
         }
     }
-    return "undefined";
+    set_object_property_with_access(obj, name, value, ACCESS_MODIFIER_PUBLIC, is_static);
+    int slot = shape_lookup(obj->shape, name);
+    if (slot >= 0) {
+        site->cached_shape = obj->shape;
+        site->cached_slot = slot;
+    }
 }
 
-const char* get_static_property(const char *class_name, const char *prop_name) {
+Value* get_static_property(const char *class_name, const char *prop_name) {
     if (!class_name || !prop_name) return NULL;
     Object *static_obj = find_static_class_object(class_name);
     if (static_obj) {
@@ -208,6 +231,139 @@ const char* get_static_property(const char *class_name, const char *prop_name) {
     return NULL;
 }
 
+static uint32_t hash_name(const char *s) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *s; s++) {
+        hash ^= (uint8_t)*s;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Functions are keyed by name and, for methods, the class they belong to
+static uint32_t function_key_hash(const char *name, const char *class_name) {
+    uint32_t hash = hash_name(name);
+    return class_name ? (hash ^ hash_name(class_name)) * 16777619u : hash;
+}
+
+static void grow_function_table(void) {
+    int new_capacity = function_table_capacity ? function_table_capacity * 2 : 64;
+    FunctionEntry **grown = (FunctionEntry**)calloc((size_t)new_capacity, sizeof(FunctionEntry*));
+    if (!grown) {
+        fprintf(stderr, "Error: Failed to allocate memory for the function registry\n");
+        exit(EXIT_FAILURE);
+    }
+    // Walk each chain oldest-first so newer entries stay in front
+    for (int i = 0; i < function_table_capacity; i++) {
+        FunctionEntry *reversed = NULL;
+        for (FunctionEntry *entry = function_table[i], *next; entry; entry = next) {
+            next = entry->next;
+            entry->next = reversed;
+            reversed = entry;
+        }
+        for (FunctionEntry *entry = reversed, *next; entry; entry = next) {
+            next = entry->next;
+            uint32_t bucket = entry->hash & (uint32_t)(new_capacity - 1);
+            entry->next = grown[bucket];
+            grown[bucket] = entry;
+        }
+    }
+    free(function_table);
+    function_table = grown;
+    function_table_capacity = new_capacity;
+}
+
+static void grow_class_table(void) {
+    int new_capacity = class_table_capacity ? class_table_capacity * 2 : 16;
+    ClassEntry **grown = (ClassEntry**)calloc((size_t)new_capacity, sizeof(ClassEntry*));
+    if (!grown) {
+        fprintf(stderr, "Error: Failed to allocate memory for the class registry\n");
+        exit(EXIT_FAILURE);
+    }
+    // Names are unique, so chain order does not matter here
+    for (int i = 0; i < class_table_capacity; i++) {
+        for (ClassEntry *entry = class_table[i], *next; entry; entry = next) {
+            next = entry->bucket_next;
+            uint32_t bucket = entry->hash & (uint32_t)(new_capacity - 1);
+            entry->bucket_next = grown[bucket];
+            grown[bucket] = entry;
+        }
+    }
+    free(class_table);
+    class_table = grown;
+    class_table_capacity = new_capacity;
+}
+
+static int is_method_member(const ASTNode *member) {
+    return member->type == AST_CLASS_METHOD || member->type == AST_FUNCTION || member->type == AST_TYPED_FUNCTION;
+}
+
+static void build_method_table(ClassEntry *entry) {
+    int method_count = 0;
+    for (ASTNode *member = entry->class_node->left; member; member = member->next) {
+        if (is_method_member(member)) method_count++;
+    }
+    if (method_count == 0) return;
+    int capacity = 8;
+    while (capacity < method_count * 2) capacity *= 2;
+    entry->methods = (ASTNode**)calloc((size_t)capacity, sizeof(ASTNode*));
+    if (!entry->methods) {
+        fprintf(stderr, "Error: Failed to allocate memory for methods of class '%s'\n", entry->name);
+        exit(EXIT_FAILURE);
+    }
+    entry->method_capacity = capacity;
+    for (ASTNode *member = entry->class_node->left; member; member = member->next) {
+        if (!is_method_member(member)) continue;
+        uint32_t bucket = hash_name(member->value) & (uint32_t)(capacity - 1);
+        while (entry->methods[bucket] && strcmp(entry->methods[bucket]->value, member->value) != 0) {
+            bucket = (bucket + 1) & (uint32_t)(capacity - 1);
+        }
+        if (!entry->methods[bucket]) entry->methods[bucket] = member;
+    }
+}
+
+static ASTNode* find_own_method(const ClassEntry *entry, const char *method_name) {
+    if (!entry->methods) return NULL;
+    uint32_t mask = (uint32_t)(entry->method_capacity - 1);
+    for (uint32_t bucket = hash_name(method_name) & mask; entry->methods[bucket]; bucket = (bucket + 1) & mask) {
+        if (strcmp(entry->methods[bucket]->value, method_name) == 0) return entry->methods[bucket];
+    }
+    return NULL;
+}
+
+static void free_registries(void) {
+    for (int i = 0; i < function_table_capacity; i++) {
+        for (FunctionEntry *entry = function_table[i], *next; entry; entry = next) {
+            next = entry->next;
+            free(entry);
+        }
+    }
+    free(function_table);
+    function_table = NULL;
+    function_table_capacity = function_count = 0;
+
+    ClassEntry *class_entry = registered_classes;
+    while (class_entry) {
+        ClassEntry *next_entry = class_entry->next;
+        free(class_entry->methods);
+        free(class_entry);
+        class_entry = next_entry;
+    }
+    registered_classes = NULL;
+    registered_classes_tail = NULL;
+    free(class_table);
+    class_table = NULL;
+    class_table_capacity = class_count = 0;
+
+    // Sites still pointing at these see a stale epoch and never touch them
+    while (call_caches) {
+        CallCache *next = call_caches->next;
+        free(call_caches);
+        call_caches = next;
+    }
+    registry_epoch++;
+}
+
 static void vm_register_class(ASTNode *class_node) { 
     if (!class_node || (class_node->type != AST_CLASS && class_node->type != AST_STRUCT) || !class_node->value[0]) return;
     const char *name = class_node->value;
@@ -229,17 +385,25 @@ static void vm_register_class(ASTNode *class_node) {
     } else { entry->parent_name[0] = '\0'; }
 
     entry->class_node = class_node; 
+    build_method_table(entry);
     if (!registered_classes) registered_classes = registered_classes_tail = entry;
     else { registered_classes_tail->next = entry; registered_classes_tail = entry; }
+
+    if (class_count + 1 > class_table_capacity) grow_class_table();
+    entry->hash = hash_name(entry->name);
+    uint32_t bucket = entry->hash & (uint32_t)(class_table_capacity - 1);
+    entry->bucket_next = class_table[bucket];
+    class_table[bucket] = entry;
+    class_count++;
+    registry_epoch++;
     // printf("[VM] Registered class: %s (from L%d:%d)\n", name, class_node->line, class_node->col);
 }
 
 static ClassEntry* find_class_entry(const char *name) {
-    if (!name) return NULL;
-    ClassEntry *entry = registered_classes;
-    while (entry) {
-        if (strcmp(entry->name, name) == 0) return entry;
-        entry = entry->next;
+    if (!name || !class_table_capacity) return NULL;
+    uint32_t hash = hash_name(name);
+    for (ClassEntry *entry = class_table[hash & (uint32_t)(class_table_capacity - 1)]; entry; entry = entry->bucket_next) {
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) return entry;
     }
     return NULL;
 }
@@ -250,55 +414,81 @@ static int is_class_registered(const char *name) {
 
 void free_object(Object *obj) {
     if (!obj) return;
-    ObjectProperty *prop = obj->properties;
-    while (prop) {
-        ObjectProperty *next_prop = prop->next;
-        free(prop);
-        prop = next_prop;
-    }
+    if (obj->shape->root->static_object == obj) obj->shape->root->static_object = NULL;
+    if (obj->id > 0 && obj->id < object_table_capacity && object_table[obj->id] == obj) object_table[obj->id] = NULL;
+    free(obj->slots);
     free(obj);
 }
 
+static void free_all_objects(void) {
+    for (int id = 1; id < next_object_id && id < object_table_capacity; id++) {
+        if (object_table[id]) free_object(object_table[id]);
+    }
+    free(object_table);
+    object_table = NULL;
+    object_table_capacity = 0;
+    next_object_id = 1;
+    free(free_object_ids);
+    free_object_ids = NULL;
+    free_object_id_count = free_object_id_capacity = 0;
+}
+
+void vm_mark_roots(void) {
+    gc_mark_value(return_value);
+    // Static class objects are reachable through their class name
+    for (int id = 1; id < next_object_id; id++) {
+        Object *obj = object_table[id];
+        if (obj && obj->shape->root->static_object == obj) gc_mark_value(value_object(id));
+    }
+}
+
+void vm_sweep_objects(GCStats *stats) {
+    for (int id = 1; id < next_object_id; id++) {
+        Object *obj = object_table[id];
+        if (!obj) continue;
+        if (obj->marked) { obj->marked = 0; continue; }
+
+        size_t bytes = sizeof(Object) + (size_t)obj->slot_capacity * sizeof(Value);
+        stats->heap_bytes -= bytes;
+        stats->bytes_freed += bytes;
+        stats->objects_freed++;
+        free_object(obj);
+
+        if (free_object_id_count == free_object_id_capacity) {
+            int new_capacity = free_object_id_capacity ? free_object_id_capacity * 2 : 64;
+            int *grown = (int*)realloc(free_object_ids, (size_t)new_capacity * sizeof(int));
+            if (!grown) continue; // The id is simply not reused
+            free_object_ids = grown;
+            free_object_id_capacity = new_capacity;
+        }
+        free_object_ids[free_object_id_count++] = id;
+    }
+}
+
 void vm_init() {
     if (global_frame) destroy_stack_frame(global_frame);
-    global_frame = create_stack_frame("global", NULL);
+    global_frame = create_stack_frame("global", NULL, 0, NULL);
     
-    if (return_value) free(return_value);
-    return_value = strdup("0"); 
+    return_value = value_undefined();
+    g_break_flag = g_continue_flag = g_return_flag = 0;
     
-    Object *obj = objects;
-    while (obj) { Object *next = obj->next; free_object(obj); obj = next; }
-    objects = NULL;
-    next_object_id = 1;
-
-    FunctionEntry *fn_entry = registered_functions;
-    while(fn_entry) { FunctionEntry* next = fn_entry->next; free(fn_entry); fn_entry = next; }
-    registered_functions = NULL;
+    free_all_objects();
 
-    ClassEntry *cls_entry = registered_classes;
-    while(cls_entry) { ClassEntry* next = cls_entry->next; free(cls_entry); cls_entry = next; }
-    registered_classes = NULL;
-    registered_classes_tail = NULL;
+    free_registries();
 
     current_class[0] = '\0';
 }
 
 void vm_cleanup() {
-    if (return_value) { free(return_value); return_value = NULL; }
+    return_value = value_undefined();
     if (global_frame) { destroy_stack_frame(global_frame); global_frame = NULL; }
     
-    FunctionEntry *entry = registered_functions;
-    while (entry) { FunctionEntry *next = entry->next; free(entry); entry = next; }
-    registered_functions = NULL;
+    free_registries();
     
-    ClassEntry *class_entry = registered_classes;
-    while (class_entry) { ClassEntry *next_entry = class_entry->next; free(class_entry); class_entry = next_entry; }
-    registered_classes = NULL;
-    registered_classes_tail = NULL;
-    
-    Object *obj = objects;
-    while (obj) { Object *next_obj = obj->next; free_object(obj); obj = next_obj; }
-    objects = NULL;
+    free_all_objects();
+    shape_cleanup();
+
+    value_heap_cleanup();
     // printf("[VM] Cleanup complete.\n");
 }
 
@@ -313,57 +503,54 @@ void register_user_function(ASTNode *func_node) {
         return;
     }
     entry->func = func_node;
-    entry->next = registered_functions;
-    registered_functions = entry;
+    entry->hash = function_key_hash(func_node->value, func_node->parent_class_name);
+    if (function_count + 1 > function_table_capacity) grow_function_table();
+    uint32_t bucket = entry->hash & (uint32_t)(function_table_capacity - 1);
+    entry->next = function_table[bucket];
+    function_table[bucket] = entry;
+    function_count++;
+    registry_epoch++;
 }
 
-ASTNode* find_user_function(const char *name, const char* class_context_name) {
-    FunctionEntry *entry = registered_functions;
-    while (entry) {
-        if (entry->func && entry->func->value && strcmp(entry->func->value, name) == 0) {
-            if (class_context_name) { 
-                if (entry->func->parent_class_name && strcmp(entry->func->parent_class_name, class_context_name) == 0) {
-                    return entry->func;
-                }
-            } else { 
-                if (entry->func->parent_class_name == NULL) {
-                    return entry->func;
-                }
-            }
+// Exact (name, class) match; class_name NULL selects free functions
+static ASTNode* lookup_function(const char *name, const char *class_name) {
+    if (!function_table_capacity) return NULL;
+    uint32_t hash = function_key_hash(name, class_name);
+    for (FunctionEntry *entry = function_table[hash & (uint32_t)(function_table_capacity - 1)]; entry; entry = entry->next) {
+        const ASTNode *func = entry->func;
+        if (entry->hash != hash || strcmp(func->value, name) != 0) continue;
+        if (class_name ? (func->parent_class_name && strcmp(func->parent_class_name, class_name) == 0)
+                       : func->parent_class_name == NULL) {
+            return entry->func;
         }
-        entry = entry->next;
     }
+    return NULL;
+}
+
+ASTNode* find_user_function(const char *name, const char* class_context_name) {
+    ASTNode *func = lookup_function(name, class_context_name);
     /* Inheritance lookup */
-    if (class_context_name) {
-        const char *parent = get_parent_class_name(class_context_name);
-        while (parent) {
-            entry = registered_functions;
-            while (entry) {
-                if (entry->func && strcmp(entry->func->value, name) == 0) {
-                    if (entry->func->parent_class_name && strcmp(entry->func->parent_class_name, parent) == 0) {
-                        return entry->func;
-                    }
-                }
-                entry = entry->next;
-            }
-            parent = get_parent_class_name(parent);
-        }
+    for (const char *parent = class_context_name ? get_parent_class_name(class_context_name) : NULL;
+         !func && parent; parent = get_parent_class_name(parent)) {
+        func = lookup_function(name, parent);
     }
-    return NULL;
+    return func;
 }
 
-const char* execute_function_call(const char* qualified_name, ASTNode* args_ast_list, StackFrame *caller_frame) {
-    // Parse qualified name: obj:123.method or class.method
+Value execute_function_call(const char* qualified_name, Value this_value, ASTNode* args_ast_list, StackFrame *caller_frame) {
+    // Parse qualified name: Class.method or target.method
     char obj_name[128] = "";
     char method_name[128] = "";
     int is_class_method = 0;
     
     // Check if it's a class method call (e.g., "class.method")
-    char* dot_pos = strchr(qualified_name, '.');
+    const char* dot_pos = strchr(qualified_name, '.');
     if (dot_pos) {
-        strncpy(obj_name, qualified_name, dot_pos - qualified_name);
-        obj_name[dot_pos - qualified_name] = '\0';
-        strcpy(method_name, dot_pos + 1);
+        size_t obj_len = (size_t)(dot_pos - qualified_name);
+        if (obj_len >= sizeof(obj_name)) obj_len = sizeof(obj_name) - 1;
+        strncpy(obj_name, qualified_name, obj_len);
+        obj_name[obj_len] = '\0';
+        strncpy(method_name, dot_pos + 1, sizeof(method_name) - 1);
         
         // Check if it's a class method (starts with class name)
         ClassEntry* class_entry = find_class_entry(obj_name);
@@ -379,12 +566,12 @@ const char* execute_function_call(const char* qualified_name, ASTNode* args_ast_
     } else {
         func_node = find_user_function(qualified_name, NULL);
         // Check for object property holding a function
-        if (!func_node && strncmp(obj_name, "obj:", 4) == 0) {
-            Object* inst = find_object_by_id(atoi(obj_name + 4));
+        if (!func_node && dot_pos && IS_OBJECT(this_value)) {
+            Object* inst = find_object_by_id(this_value.as.object_id);
             if (inst) {
-                const char* fn = get_object_property(inst, method_name);
-                if (fn && strcmp(fn, "undefined") != 0) {
-                    func_node = find_user_function(fn, NULL);
+                Value* fn = get_object_property(inst, method_name);
+                if (fn && IS_STRING(*fn)) {
+                    func_node = find_user_function(fn->as.string->chars, NULL);
                 }
             }
         }
@@ -392,85 +579,228 @@ const char* execute_function_call(const char* qualified_name, ASTNode* args_ast_
     
     if (!func_node) {
         // Attempt to call built-in function
-        const char* builtin_res = call_built_in_function(qualified_name, args_ast_list, caller_frame);
-        if (builtin_res && strcmp(builtin_res, "undefined") != 0) {
+        Value builtin_res;
+        if (call_built_in_function(qualified_name, args_ast_list, caller_frame, &builtin_res)) {
             return builtin_res;
         }
         fprintf(stderr, "Error: Function '%s' not found\n", qualified_name);
-        return "undefined";
+        return value_undefined();
     }
-    
-    // Create new stack frame for function execution
-    StackFrame* new_frame = create_stack_frame(qualified_name, caller_frame);
-    
+
+    // Bind 'this' to the receiver, or to the static class object for Class.method calls
+    Value this_binding = value_undefined();
+    if (IS_OBJECT(this_value)) {
+        this_binding = this_value;
+    } else if (is_class_method) {
+        Object* instance = find_static_class_object(obj_name);
+        if (instance) this_binding = value_object(instance->id);
+    }
+    return invoke_with_ast_args(func_node, this_binding, is_class_method ? obj_name : NULL, args_ast_list, caller_frame);
+}
+
+// Evaluates the arguments in the caller's frame and class context, then runs
+// func_node with current_class set to class_context (NULL keeps the caller's).
+static Value invoke_with_ast_args(ASTNode *func_node, Value this_binding, const char *class_context, ASTNode *args_ast_list, StackFrame *caller_frame) {
+    int argc = 0;
+    for (ASTNode *arg = args_ast_list; arg; arg = arg->next) argc++;
+    Value stack_args[8];
+    Value *args = argc <= 8 ? stack_args : (Value*)malloc((size_t)argc * sizeof(Value));
+    if (!args) {
+        fprintf(stderr, "Error: Memory allocation failed for arguments of '%s'\n", func_node->value);
+        return value_undefined();
+    }
+    int arg_index = 0;
+    for (ASTNode *arg = args_ast_list; arg; arg = arg->next) {
+        args[arg_index] = evaluate_expression(arg, caller_frame);
+        gc_push_root(args[arg_index++]); // Later arguments may run script code
+    }
+
     // Optionally update global current class context for methods
-    char prev_class[128]; strncpy(prev_class, current_class, sizeof(prev_class)-1);
-    if (is_class_method) {
-        strncpy(current_class, obj_name, sizeof(current_class) - 1);
+    char prev_class[128]; strncpy(prev_class, current_class, sizeof(prev_class)-1); prev_class[sizeof(prev_class)-1] = '\0';
+    if (class_context) {
+        strncpy(current_class, class_context, sizeof(current_class) - 1);
     }
 
-    // Evaluate and set parameters as local variables
-    ASTNode* param = func_node->left;
-    ASTNode* arg = args_ast_list;
-    
-    while (param && arg) {
-        const char* arg_value = evaluate_expression(arg, caller_frame);
-        if (arg_value) {
-            set_variable(new_frame, param->value, arg_value);
-            // Do not free arg_value, as it may not be heap allocated
+    Value result = vm_invoke_function(func_node, this_binding, args, argc, caller_frame);
+    gc_pop_roots(argc);
+
+    // Restore previous context
+    if (class_context) {
+        strncpy(current_class, prev_class, sizeof(current_class)-1);
+    }
+    if (args != stack_args) free(args);
+    return result;
+}
+
+enum { CALL_TARGET_NONE, CALL_TARGET_USER, CALL_TARGET_VALUE_NATIVE, CALL_TARGET_TEXT_NATIVE };
+
+Value execute_call_at_site(ASTNode *call_node, StackFrame *caller_frame) {
+    const char *name = call_node->value;
+    if (call_node->cached_epoch != registry_epoch) {
+        // Same precedence as execute_function_call: user functions, then value
+        // natives, then text natives. Dotted names take the uncached path.
+        ValueNativeFunction value_native = NULL;
+        TextNativeFunction text_native = NULL;
+        call_node->cached_callee = strchr(name, '.') ? NULL : find_user_function(name, NULL);
+        call_node->cached_native = NULL;
+        if (strchr(name, '.')) {
+            call_node->cached_call_kind = CALL_TARGET_NONE;
+        } else if (call_node->cached_callee) {
+            call_node->cached_call_kind = CALL_TARGET_USER;
+        } else if ((value_native = find_value_function(name)) != NULL) {
+            call_node->cached_call_kind = CALL_TARGET_VALUE_NATIVE;
+            call_node->cached_native = (void (*)(void))value_native;
+        } else if ((text_native = find_builtin_function(name)) != NULL) {
+            call_node->cached_call_kind = CALL_TARGET_TEXT_NATIVE;
+            call_node->cached_native = text_native;
+        } else {
+            call_node->cached_call_kind = CALL_TARGET_NONE;
         }
-        param = param->next;
-        arg = arg->next;
+        call_node->cached_epoch = registry_epoch;
     }
-    
-    // If it's a class method, set 'this' parameter to instance or static class object
-    if (func_node->type == AST_CLASS_METHOD) {
-        Object* instance = is_class_method ? find_static_class_object(obj_name)
-                                            : find_object_by_id(atoi(obj_name));
-        if (instance) {
-            set_variable(new_frame, "this", instance->class_name);
+
+    switch (call_node->cached_call_kind) {
+        case CALL_TARGET_USER:
+            return invoke_with_ast_args(call_node->cached_callee, value_undefined(), NULL, call_node->left, caller_frame);
+        case CALL_TARGET_VALUE_NATIVE:
+            return call_value_native((ValueNativeFunction)call_node->cached_native, NULL, call_node->left, caller_frame);
+        case CALL_TARGET_TEXT_NATIVE:
+            return call_text_native(call_node->cached_native, name, call_node->left, caller_frame);
+        default:
+            return execute_function_call(name, value_undefined(), call_node->left, caller_frame);
+    }
+}
+
+// Finds the method cached for receiver class `key` at a call site. The first
+// class is held inline; up to CALL_CACHE_WAYS more go to the site's CallCache.
+static int method_cache_lookup(ASTNode *site, const void *key, ASTNode **method) {
+    if (site->cached_epoch != registry_epoch) {
+        site->cached_receiver = NULL;
+        site->call_cache = NULL;
+        site->cached_epoch = registry_epoch;
+        return 0;
+    }
+    if (site->cached_receiver == key) {
+        *method = site->cached_callee;
+        return 1;
+    }
+    CallCache *cache = site->call_cache;
+    for (int i = 0; cache && i < cache->count; i++) {
+        if (cache->keys[i] == key) {
+            *method = cache->targets[i];
+            return 1;
         }
     }
-    
+    return 0;
+}
+
+static void method_cache_insert(ASTNode *site, const void *key, ASTNode *method) {
+    if (!site->cached_receiver) {
+        site->cached_receiver = key;
+        site->cached_callee = method;
+        return;
+    }
+    if (!site->call_cache) {
+        CallCache *cache = (CallCache*)calloc(1, sizeof(CallCache));
+        if (!cache) return; // Uncached calls still work
+        cache->next = call_caches;
+        call_caches = cache;
+        site->call_cache = cache;
+    }
+    CallCache *cache = site->call_cache;
+    if (cache->count == CALL_CACHE_WAYS) return; // Megamorphic: every call resolves through the registry
+    cache->keys[cache->count] = key;
+    cache->targets[cache->count] = method;
+    cache->count++;
+}
+
+static ASTNode* resolve_class_method(const char *class_name, const char *method_name) {
+    return find_class_entry(class_name) ? find_class_method(class_name, method_name) : NULL;
+}
+
+Value execute_method_call_at_site(ASTNode *call_node, Object *receiver, StackFrame *caller_frame) {
+    // Every object of a class shares its root shape, so that is the cache key
+    Shape *root = receiver->shape->root;
+    ASTNode *method;
+    if (!method_cache_lookup(call_node, root, &method)) {
+        method = resolve_class_method(receiver->class_name, call_node->value);
+        method_cache_insert(call_node, root, method);
+    }
+    if (method) {
+        return invoke_with_ast_args(method, value_object(receiver->id), receiver->class_name, call_node->left, caller_frame);
+    }
+    // Functions stored in properties, builtins and error reporting
+    char qualified_name[512];
+    snprintf(qualified_name, sizeof(qualified_name), "%s.%s", receiver->class_name, call_node->value);
+    return execute_function_call(qualified_name, value_object(receiver->id), call_node->left, caller_frame);
+}
+
+Value execute_static_call_at_site(ASTNode *call_node, const OuroString *class_name, StackFrame *caller_frame) {
+    // Interned strings are never freed, so the pointer identifies the class
+    ASTNode *method;
+    if (!method_cache_lookup(call_node, class_name, &method)) {
+        method = resolve_class_method(class_name->chars, call_node->value);
+        method_cache_insert(call_node, class_name, method);
+    }
+    if (method) {
+        Object *static_obj = find_static_class_object(class_name->chars);
+        Value this_binding = static_obj ? value_object(static_obj->id) : value_undefined();
+        return invoke_with_ast_args(method, this_binding, class_name->chars, call_node->left, caller_frame);
+    }
+    char qualified_name[512];
+    snprintf(qualified_name, sizeof(qualified_name), "%s.%s", class_name->chars, call_node->value);
+    return execute_function_call(qualified_name, value_undefined(), call_node->left, caller_frame);
+}
+
+Value vm_invoke_function(ASTNode *func_node, Value this_binding, const Value *args, int argc, StackFrame *caller_frame) {
+    // Create a frame sized to the function's resolved locals. Top-level functions
+    // and methods see the global frame as parent; nested function expressions
+    // and unresolved (imported) functions keep the caller's frame.
+    StackFrame* parent_frame = (func_node->local_count >= 0 && func_node->depth == 0) ? global_frame : caller_frame;
+    StackFrame* new_frame = create_stack_frame(func_node->value, parent_frame, func_node->local_count, func_node->local_names);
+
+    // Bind parameters positionally; missing arguments stay undefined
+    int arg_index = 0;
+    for (ASTNode *param = func_node->left; param && arg_index < argc; param = param->next) {
+        Value *slot_value = frame_slot(new_frame, 0, param->slot);
+        if (slot_value) *slot_value = args[arg_index];
+        else set_variable(new_frame, param->value, args[arg_index]);
+        arg_index++;
+    }
+
+    if (this_binding.type != VAL_UNDEFINED) {
+        Value *this_slot = frame_slot(new_frame, 0, func_node->slot);
+        if (this_slot) *this_slot = this_binding;
+        else set_variable(new_frame, "this", this_binding);
+    }
+
     // Evaluate function body
-    run_vm_node(func_node->right, new_frame);
-    // Restore previous context
-    if (is_class_method) {
-        strncpy(current_class, prev_class, sizeof(current_class)-1);
+    Value result;
+    if (func_node->bytecode) {
+        result = bytecode_execute(func_node->bytecode, new_frame);
+    } else {
+        set_return_value(value_undefined());
+        run_vm_node(func_node->right, new_frame);
+        g_return_flag = 0;
+        result = get_return_value();
     }
-    // Destroy frame
     destroy_stack_frame(new_frame);
-    return get_return_value();
+    return result;
 }
 
 ASTNode* find_class_method(const char *class_name, const char *method_name) {
-    ClassEntry* entry = find_class_entry(class_name);
-    if (!entry) return NULL;
-    
-    ASTNode* class_node = entry->class_node;
-    if (!class_node || !class_node->left) return NULL;
-    
-    ASTNode* member = class_node->left;
-    while (member) {
-        // Treat function declarations inside classes as class methods
-        if ((member->type == AST_CLASS_METHOD || member->type == AST_FUNCTION || member->type == AST_TYPED_FUNCTION)
-            && strcmp(member->value, method_name) == 0) {
-            return member;
-        }
-        member = member->next;
+    // Own methods first, then up the parent chain
+    for (ClassEntry *entry = find_class_entry(class_name); entry; entry = find_class_entry(entry->parent_name)) {
+        ASTNode *method = find_own_method(entry, method_name);
+        if (method) return method;
+        if (!entry->parent_name[0]) break;
     }
-    
-    // Check parent class
-    const char* parent_name = get_parent_class_name(class_name);
-    if (parent_name && strlen(parent_name) > 0) {
-        return find_class_method(parent_name, method_name);
-    }
-    
     return NULL;
 }
 
 void run_vm_node(ASTNode *node, StackFrame *frame) {
     if (!node) return;
+    gc_safepoint();
     
     // This current_class update is simplistic. execute_function_call is better placed to manage it.
     // if (frame && frame->function_name) {
@@ -491,41 +821,45 @@ void run_vm_node(ASTNode *node, StackFrame *frame) {
     switch (node->type) {
         case AST_PROGRAM: {
             ASTNode *stmt = node->left;
-            while (stmt) { run_vm_node(stmt, frame); stmt = stmt->next; }
+            while (stmt && !g_return_flag) { run_vm_node(stmt, frame); stmt = stmt->next; }
             break;
         }
         case AST_FUNCTION: case AST_TYPED_FUNCTION: break; 
         case AST_BLOCK: {
             ASTNode *stmt = node->left;
-            while (stmt) { run_vm_node(stmt, frame); stmt = stmt->next; }
+            while (stmt && !g_return_flag && !g_break_flag && !g_continue_flag) { run_vm_node(stmt, frame); stmt = stmt->next; }
             break;
         }
         case AST_PRINT: {
-            const char *value_to_print = evaluate_expression(node->left, frame);
-            printf("[OUTPUT] %s\n", value_to_print ? value_to_print : "undefined");
+            char print_buf[64];
+            printf("[OUTPUT] %s\n", value_to_cstring(evaluate_expression(node->left, frame), print_buf, sizeof(print_buf)));
             fflush(stdout);
             break;
         }
         case AST_VAR_DECL: 
         case AST_TYPED_VAR_DECL: { 
             const char *var_name = node->value; 
-            const char *initial_value_str = "undefined"; 
+            Value initial_value = value_undefined(); 
             if (node->right) { 
-                initial_value_str = evaluate_expression(node->right, frame);
+                initial_value = evaluate_expression(node->right, frame);
             } else if (node->type == AST_TYPED_VAR_DECL) { // Default init for typed vars if no explicit init
-                if(strcmp(node->data_type, "int")==0 || strcmp(node->data_type, "long")==0) initial_value_str = "0";
-                else if(strcmp(node->data_type, "float")==0 || strcmp(node->data_type, "double")==0) initial_value_str = "0.0";
-                else if(strcmp(node->data_type, "bool")==0) initial_value_str = "false";
-                else if(strcmp(node->data_type, "string")==0) initial_value_str = "";
+                if(strcmp(node->data_type, "int")==0 || strcmp(node->data_type, "long")==0) initial_value = value_int(0);
+                else if(strcmp(node->data_type, "float")==0 || strcmp(node->data_type, "double")==0) initial_value = value_double(0.0);
+                else if(strcmp(node->data_type, "bool")==0) initial_value = value_bool(0);
+                else if(strcmp(node->data_type, "string")==0) initial_value = value_intern("");
                 // Object types default to null/undefined implicitly
             }
-            set_variable(frame, var_name, initial_value_str);
+            Value *slot_value = frame_slot(frame, 0, node->slot);
+            if (slot_value) *slot_value = initial_value;
+            else set_variable(frame, var_name, initial_value);
             break;
         }
         case AST_ASSIGN: { 
-            const char *value_to_assign = evaluate_expression(node->right, frame);
+            Value value_to_assign = evaluate_expression(node->right, frame);
             if (node->left->type == AST_IDENTIFIER) {
-                set_variable(frame, node->left->value, value_to_assign);
+                Value *slot_value = frame_slot(frame, node->left->depth, node->left->slot);
+                if (slot_value) *slot_value = value_to_assign;
+                else set_variable(frame, node->left->value, value_to_assign);
             } else if (node->left->type == AST_MEMBER_ACCESS) {
                 // This case should ideally be fully handled by AST_BINARY_OP with "="
                 // Forcing it here means re-evaluating parts of member access.
@@ -536,7 +870,7 @@ void run_vm_node(ASTNode *node, StackFrame *frame) {
                 // Quick attempt to make it work similarly to BINARY_OP's assignment logic
                 ASTNode temp_binary_op_assign_node; // Stack allocate a temporary node
                 temp_binary_op_assign_node.type = AST_BINARY_OP;
-                strcpy(temp_binary_op_assign_node.value, "="); // Operator is "="
+                temp_binary_op_assign_node.value = "="; // Operator is "="
                 temp_binary_op_assign_node.left = node->left;   // Original LHS (e.g. member access node)
                 temp_binary_op_assign_node.right = node->right; // Original RHS (expression node for value)
                 temp_binary_op_assign_node.line = node->line;
@@ -548,26 +882,21 @@ void run_vm_node(ASTNode *node, StackFrame *frame) {
             break;
         }
         case AST_RETURN: {
-            const char *ret_val_str = node->left ? evaluate_expression(node->left, frame) : "0"; 
-            set_return_value(ret_val_str);
+            set_return_value(node->left ? evaluate_expression(node->left, frame) : value_undefined());
+            g_return_flag = 1;
             break;
         }
         case AST_IF: {
-            const char *cond_val_str = evaluate_expression(node->left, frame); 
-            int truthy = cond_val_str && strcmp(cond_val_str, "0") != 0 && strcmp(cond_val_str, "false") != 0 && strcmp(cond_val_str, "") != 0;
-            if (truthy) run_vm_node(node->right, frame); 
+            if (value_is_truthy(evaluate_expression(node->left, frame))) run_vm_node(node->right, frame); 
             else if (node->next && node->next->type == AST_ELSE) run_vm_node(node->next->left, frame); 
             break;
         }
         case AST_WHILE: {
-            while(1) {
-                const char *cond_val_str = evaluate_expression(node->left, frame); 
-                int truthy = cond_val_str && strcmp(cond_val_str, "0") != 0 && strcmp(cond_val_str, "false") != 0 && strcmp(cond_val_str, "") != 0;
-                if (!truthy) break;
-                g_continue_flag = 0; // reset at start of iteration
+            while (!g_return_flag) {
+                if (!value_is_truthy(evaluate_expression(node->left, frame))) break;
                 run_vm_node(node->right, frame);
+                g_continue_flag = 0;
                 if (g_break_flag) { g_break_flag = 0; break; }
-                if (g_continue_flag) { g_continue_flag = 0; continue; }
             }
             break;
         }
@@ -582,34 +911,17 @@ void run_vm_node(ASTNode *node, StackFrame *frame) {
                 if(init_expr->type == AST_VAR_DECL || init_expr->type == AST_TYPED_VAR_DECL) run_vm_node(init_expr, frame);
                 else evaluate_expression(init_expr, frame); 
             }
-            while (1) {
-                int truthy = 1; 
-                if (cond_expr) {
-                    const char *cond_val_str = evaluate_expression(cond_expr, frame);
-                    truthy = cond_val_str && strcmp(cond_val_str, "0") != 0 && strcmp(cond_val_str, "false") != 0 && strcmp(cond_val_str, "") != 0;
-                }
-                if (!truthy) break; 
+            while (!g_return_flag) {
+                if (cond_expr && !value_is_truthy(evaluate_expression(cond_expr, frame))) break; 
                 run_vm_node(node->right, frame); 
-                g_continue_flag = 0; // reset for each iteration
+                g_continue_flag = 0; // 'continue' only skips the rest of the body
                 if (g_break_flag) { g_break_flag = 0; break; }
-                if (g_continue_flag) { g_continue_flag = 0; if (incr_expr) evaluate_expression(incr_expr, frame); continue; }
+                if (g_return_flag) break;
                 if (incr_expr) evaluate_expression(incr_expr, frame); 
             }
             break;
         }
-        case AST_CALL: {
-            // Reconstruct qualified name if method call stored as target->right, value->method_name
-            char qualified_name_buffer[512];
-            if (node->right) { // Method call (target in right, method name in value)
-                const char* target_eval_str = evaluate_expression(node->right, frame);
-                snprintf(qualified_name_buffer, sizeof(qualified_name_buffer), "%s.%s", target_eval_str ? target_eval_str : "undefined_target", node->value);
-            } else { // Plain function call
-                strncpy(qualified_name_buffer, node->value, sizeof(qualified_name_buffer)-1);
-                qualified_name_buffer[sizeof(qualified_name_buffer)-1] = '\0';
-            }
-            execute_function_call(qualified_name_buffer, node->left, frame);
-            break;
-        }
+        case AST_CALL: // Method and function calls share the expression path (receiver binding, builtins)
         case AST_BINARY_OP: case AST_UNARY_OP: case AST_LITERAL: 
         case AST_IDENTIFIER: case AST_MEMBER_ACCESS: case AST_NEW:
             evaluate_expression(node, frame);
@@ -631,6 +943,11 @@ void run_vm_node(ASTNode *node, StackFrame *frame) {
 void run_vm(ASTNode *root_ast_node) {
     if (!root_ast_node) { fprintf(stderr, "[VM] Error: Cannot run VM on NULL AST.\n"); return; }
     vm_init(); 
+    if (root_ast_node->local_count > 0) {
+        // Top-level locals were resolved into slots of the global frame
+        destroy_stack_frame(global_frame);
+        global_frame = create_stack_frame("global", NULL, root_ast_node->local_count, root_ast_node->local_names);
+    }
     
     // printf("\n==== Program Output (VM Run) ====\n");
     
@@ -644,8 +961,7 @@ void run_vm(ASTNode *root_ast_node) {
                 ASTNode *class_member = node->left; 
                 while (class_member) {
                     if (class_member->type == AST_FUNCTION || class_member->type == AST_TYPED_FUNCTION || class_member->type == AST_CLASS_METHOD) {
-                        if (class_member->parent_class_name) free(class_member->parent_class_name);
-                        class_member->parent_class_name = strdup(node->value); 
+                        class_member->parent_class_name = node->value;
                         register_user_function(class_member);
                     }
                     class_member = class_member->next;
@@ -664,8 +980,7 @@ void run_vm(ASTNode *root_ast_node) {
                                 ASTNode *cm = imp_node->left;
                                 while (cm) {
                                     if (cm->type == AST_FUNCTION || cm->type == AST_TYPED_FUNCTION || cm->type == AST_CLASS_METHOD) {
-                                        if (cm->parent_class_name) free(cm->parent_class_name);
-                                        cm->parent_class_name = strdup(imp_node->value);
+                                        cm->parent_class_name = imp_node->value;
                                         register_user_function(cm);
                                     }
                                     cm = cm->next;
@@ -694,8 +1009,7 @@ void run_vm(ASTNode *root_ast_node) {
         find_static_class_object(cls_iter->name); 
         Object *instance_obj = create_object(cls_iter->name); 
         if (instance_obj) {
-            int obj_id_val = 0;
-            sscanf(instance_obj->class_name, "%*[^#]#%d", &obj_id_val); 
+            int obj_id_val = instance_obj->id;
             LifecycleInstance *inst_entry = (LifecycleInstance*)calloc(1, sizeof(LifecycleInstance)); // Use calloc
             if (!inst_entry) { fprintf(stderr, "Mem alloc failed for lifecycle entry\n"); break;}
             snprintf(inst_entry->obj_ref_str, sizeof(inst_entry->obj_ref_str), "obj:%d", obj_id_val);
@@ -718,7 +1032,7 @@ void run_vm(ASTNode *root_ast_node) {
                     }
                 }
                 if (has_static_singleton_field) {
-                    set_object_property_with_access(static_obj_for_class, "singleton", inst_entry->obj_ref_str, ACCESS_MODIFIER_PUBLIC, 1);
+                    set_object_property_with_access(static_obj_for_class, "singleton", value_object(obj_id_val), ACCESS_MODIFIER_PUBLIC, 1);
                 }
             }
         }
@@ -769,7 +1083,9 @@ void run_vm(ASTNode *root_ast_node) {
 #endif  // end disable lifecycle loops
 
     // Fallback: execute top-level statements for scripts without main
-    run_vm_node(root_ast_node, global_frame);
+    if (root_ast_node->bytecode) bytecode_execute(root_ast_node->bytecode, global_frame);
+    else run_vm_node(root_ast_node, global_frame);
+    g_return_flag = 0;
 
     // Call main() if it exists
     ASTNode* main_func = find_user_function("main", NULL);
@@ -778,7 +1094,7 @@ void run_vm(ASTNode *root_ast_node) {
         printf("==== EXECUTING MAIN() ====\n");
         printf("=========================\n\n");
         fflush(stdout);
-        execute_function_call(main_func->value, main_func->left, global_frame);
+        execute_function_call(main_func->value, value_undefined(), NULL, global_frame);
         printf("\n\n===========================\n");
         printf("==== EXECUTION COMPLETE ====\n");
         printf("===========================\n\n");
@@ -793,34 +1109,40 @@ void run_vm(ASTNode *root_ast_node) {
     // vm_cleanup called by main
 }
 
-void set_object_property(Object *obj, const char *name, const char *value) {
+void set_object_property(Object *obj, const char *name, Value value) {
     set_object_property_with_access(obj, name, value, ACCESS_MODIFIER_PUBLIC, 0); 
 }
 
-const char* evaluate_member_access(ASTNode *member_access_expr_node, StackFrame *frame) {
+Value evaluate_member_access(ASTNode *member_access_expr_node, StackFrame *frame) {
     if (!member_access_expr_node || member_access_expr_node->type != AST_MEMBER_ACCESS || 
         !member_access_expr_node->left || !member_access_expr_node->value[0]) {
         // fprintf(stderr, "Error (L%d:%d): Invalid member access expression.\n", member_access_expr_node ? member_access_expr_node->line: 0, member_access_expr_node ? member_access_expr_node->col : 0);
-        return "undefined";
+        return value_undefined();
     }
     
-    const char *object_or_class_ref_str;
+    Value target;
     ASTNode *target_expr_node = member_access_expr_node->left; 
     const char *property_name_str = member_access_expr_node->value; 
 
     if (target_expr_node->type == AST_THIS) {
-        object_or_class_ref_str = get_variable(frame, "this");
-        if (!object_or_class_ref_str) {
+        Value *this_ref = get_variable(frame, "this");
+        if (!this_ref) {
             fprintf(stderr, "Error (L%d:%d): 'this' is undefined in current context for member access '%s'.\n", target_expr_node->line, target_expr_node->col, property_name_str);
-            return "undefined";
+            return value_undefined();
         }
+        target = *this_ref;
     } else {
-        object_or_class_ref_str = evaluate_expression(target_expr_node, frame);
+        target = evaluate_expression(target_expr_node, frame);
     }
     
+    if (IS_ARRAY(target) && strcmp(property_name_str, "length") == 0) {
+        return value_int(target.as.array->count);
+    }
+
     // Early universal .length support for plain strings and pseudo array literals
-    if (object_or_class_ref_str && strcmp(property_name_str, "length") == 0) {
-        if (object_or_class_ref_str[0] == '[') {
+    if (IS_STRING(target) && strcmp(property_name_str, "length") == 0) {
+        const OuroString *str = target.as.string;
+        if (str->chars[0] == '[') {
             /* Count only top-level elements: keep track of nested bracket depth so that
                commas inside sub-arrays are ignored.  This prevents exaggerated length
                values for multidimensional literals like [[1,2],[3,4]]. */
@@ -828,7 +1150,7 @@ const char* evaluate_member_access(ASTNode *member_access_expr_node, StackFrame
             int elem_count = 0;
             int in_elem = 0;
 
-            for (const char *p = object_or_class_ref_str + 1; *p && !(depth == 0 && *p == ']'); ++p) {
+            for (const char *p = str->chars + 1; *p && !(depth == 0 && *p == ']'); ++p) {
                 char ch = *p;
                 if (ch == '[') {
                     depth++;
@@ -848,127 +1170,163 @@ const char* evaluate_member_access(ASTNode *member_access_expr_node, StackFrame
                 }
             }
             if (in_elem) elem_count++; /* account for final element if any */
-
-            static char len_buf[32];
-            snprintf(len_buf, sizeof(len_buf), "%d", elem_count);
-            return len_buf;
-        } else {
-            static char len_buf[32];
-            snprintf(len_buf, sizeof(len_buf), "%zu", strlen(object_or_class_ref_str));
-            return len_buf;
+            return value_int(elem_count);
         }
+        return value_int((int64_t)str->length);
     }
     
-    if (!object_or_class_ref_str || strcmp(object_or_class_ref_str, "undefined") == 0) {
+    if (IS_NULLISH(target)) {
         // Semantic analysis should catch most of these if target_expr_node->value is an undeclared identifier
         // This error might still occur if evaluate_expression for target_expr_node results in "undefined" at runtime
         // printf("[VM EVAL_MEMBER_ACCESS] Error: Cannot access property '%s' of undefined or unresolved target '%s' (L%d).\n", 
         //        property_name_str, target_expr_node->value, member_access_expr_node->line);
-        return "undefined";
+        return value_undefined();
     }
 
-    if (strncmp(object_or_class_ref_str, "obj:", 4) == 0) { 
-        int obj_id = atoi(object_or_class_ref_str + 4);
-        Object *target_obj = find_object_by_id(obj_id);
+    if (IS_OBJECT(target)) { 
+        Object *target_obj = find_object_by_id(target.as.object_id);
         if (target_obj) {
-            return get_object_property_with_access(target_obj, property_name_str, current_class);
+            return get_object_property_at_site(target_obj, property_name_str, member_access_expr_node);
         } else {
-            fprintf(stderr, "Error (L%d:%d): Object %s not found for property access '%s'.\n", member_access_expr_node->line, member_access_expr_node->col, object_or_class_ref_str, property_name_str);
-            return "undefined";
+            fprintf(stderr, "Error (L%d:%d): Object obj:%d not found for property access '%s'.\n", member_access_expr_node->line, member_access_expr_node->col, target.as.object_id, property_name_str);
+            return value_undefined();
         }
     } else { 
-        const char* class_name_str = object_or_class_ref_str;
-        ClassEntry* ce = find_class_entry(class_name_str); // Check if it's a known class
-        if (!ce) { // If not a registered class, it might be some other non-object string
+        char target_buf[64];
+        const char* class_name_str = value_to_cstring(target, target_buf, sizeof(target_buf));
+        ClassEntry* ce = IS_STRING(target) ? find_class_entry(class_name_str) : NULL; // Check if it's a known class
+        if (!ce) { // If not a registered class, it might be some other non-object value
              fprintf(stderr, "Error (L%d:%d): Target '%s' for member access '%s' is not a known class or object instance.\n", 
                 target_expr_node->line, target_expr_node->col, class_name_str, property_name_str);
-            return "undefined";
+            return value_undefined();
         }
         Object *static_obj = find_static_class_object(class_name_str); 
         if (static_obj) {
-            return get_object_property_with_access(static_obj, property_name_str, current_class);
+            return get_object_property_at_site(static_obj, property_name_str, member_access_expr_node);
         } else {
              fprintf(stderr, "Error (L%d:%d): Could not find/create static object for class '%s' to access '%s'.\n", 
                 target_expr_node->line, target_expr_node->col, class_name_str, property_name_str);
-            return "undefined";
+            return value_undefined();
         }
     }
 }
 
 Object* find_object_by_id(int id) {
-    Object *obj_iter = objects;
-    while (obj_iter) {
-        int current_obj_id = 0;
-        char *hash_pos = strchr(obj_iter->class_name, '#');
-        if (hash_pos) {
-            current_obj_id = atoi(hash_pos + 1);
-            if (current_obj_id == id) return obj_iter;
-        }
-        obj_iter = obj_iter->next;
-    }
-    return NULL;
+    return (id > 0 && id < object_table_capacity) ? object_table[id] : NULL;
 }
 
 Object* find_static_class_object(const char *class_name) {
-    char static_obj_prefix[128 + 8]; 
-    snprintf(static_obj_prefix, sizeof(static_obj_prefix), "%s_static", class_name); 
-
-    Object *obj_iter = objects;
-    while (obj_iter) {
-        if (strncmp(obj_iter->class_name, static_obj_prefix, strlen(static_obj_prefix)) == 0) {
-             char char_after_prefix = obj_iter->class_name[strlen(static_obj_prefix)];
-             if (char_after_prefix == '#' || char_after_prefix == '\0') return obj_iter;
-        }
-        obj_iter = obj_iter->next;
-    }
-    return create_object(static_obj_prefix); 
+    char static_obj_name[128 + 8]; 
+    snprintf(static_obj_name, sizeof(static_obj_name), "%s_static", class_name); 
+
+    // The static object hangs off the root shape of its "ClassName_static" layout
+    Shape *static_root = shape_root(static_obj_name);
+    if (!static_root->static_object) static_root->static_object = create_object(static_obj_name);
+    return static_root->static_object;
 }
 
 void initialize_test_class(Object *obj) {
     if (!obj || strstr(obj->class_name, "TestClass") == NULL) return; 
     if (strstr(obj->class_name, "_static") != NULL) { 
-        set_object_property_with_access(obj, "static_prop", "Static Property Value", ACCESS_MODIFIER_PUBLIC, 1);
+        set_object_property_with_access(obj, "static_prop", value_intern("Static Property Value"), ACCESS_MODIFIER_PUBLIC, 1);
     } else { 
-        set_object_property_with_access(obj, "public_prop", "Public Property Value", ACCESS_MODIFIER_PUBLIC, 0);
-        set_object_property_with_access(obj, "private_prop", "Private Property Value", ACCESS_MODIFIER_PRIVATE, 0);
+        set_object_property_with_access(obj, "public_prop", value_intern("Public Property Value"), ACCESS_MODIFIER_PUBLIC, 0);
+        set_object_property_with_access(obj, "private_prop", value_intern("Private Property Value"), ACCESS_MODIFIER_PRIVATE, 0);
         Object* static_companion = find_static_class_object("TestClass");
         if(static_companion && get_object_property_with_access_check(static_companion, "static_prop", "TestClass") == NULL) {
-             set_object_property_with_access(static_companion, "static_prop", "Static Property Value", ACCESS_MODIFIER_PUBLIC, 1);
+             set_object_property_with_access(static_companion, "static_prop", value_intern("Static Property Value"), ACCESS_MODIFIER_PUBLIC, 1);
         }
     }
 }
 
-/// Bridge to stdlib.c's call_builtin_function
-const char* call_built_in_function(const char* func_name_to_call, ASTNode* args_ast_list, StackFrame* frame_for_evaluating_args) {
-    if (!func_name_to_call) return "undefined";
+// Evaluates the arguments (after an optional receiver) and calls a value native.
+static Value call_value_native(ValueNativeFunction native, const Value *receiver, ASTNode *args_ast_list, StackFrame *frame) {
+    int argc = receiver ? 1 : 0;
+    for (ASTNode *arg = args_ast_list; arg; arg = arg->next) argc++;
+    Value stack_args[8];
+    Value *args = argc <= 8 ? stack_args : (Value*)malloc((size_t)argc * sizeof(Value));
+    if (!args) {
+        fprintf(stderr, "VM Error: Out of memory marshalling %d native arguments.\n", argc);
+        return value_undefined();
+    }
+    int arg_index = 0;
+    if (receiver) args[arg_index++] = *receiver;
+    for (ASTNode *arg = args_ast_list; arg; arg = arg->next) {
+        args[arg_index] = evaluate_expression(arg, frame);
+        gc_push_root(args[arg_index++]);
+    }
+    Value result = native(args, argc);
+    gc_pop_roots(argc - (receiver ? 1 : 0));
+    if (args != stack_args) free(args);
+    return result;
+}
+
+int call_built_in_method(const char *method_name, Value receiver, ASTNode *args_ast_list, StackFrame *frame, Value *result) {
+    char native_name[160];
+    snprintf(native_name, sizeof(native_name), "%s_%s", value_type_name(receiver), method_name);
+    ValueNativeFunction native = find_value_function(native_name);
+    if (!native) return 0;
+    Value native_result = call_value_native(native, &receiver, args_ast_list, frame);
+    if (result) *result = native_result;
+    return 1;
+}
 
+/// Bridge to stdlib.c's call_builtin_function.
+/// Text natives take C-string arguments, so this is where values are converted
+/// to text; value natives (stdlib.h) receive the values themselves.
+int call_built_in_function(const char* func_name_to_call, ASTNode* args_ast_list, StackFrame* frame_for_evaluating_args, Value *result) {
+    if (!func_name_to_call) return 0;
+
+    ValueNativeFunction value_native = find_value_function(func_name_to_call);
+    if (value_native) {
+        Value native_result = call_value_native(value_native, NULL, args_ast_list, frame_for_evaluating_args);
+        if (result) *result = native_result;
+        return 1;
+    }
+    TextNativeFunction text_native = find_builtin_function(func_name_to_call);
+    if (!text_native) return 0;
+    Value native_result = call_text_native(text_native, func_name_to_call, args_ast_list, frame_for_evaluating_args);
+    if (result) *result = native_result;
+    return 1;
+}
+
+static Value call_text_native(TextNativeFunction native, const char *func_name_to_call, ASTNode *args_ast_list, StackFrame *frame_for_evaluating_args) {
     int arg_count = 0;
     ASTNode *iter = args_ast_list;
     while (iter) { arg_count++; iter = iter->next; }
 
+    typedef char ArgText[64];
     const char **arg_values_evaluated = NULL; // Array of C-string pointers
+    ArgText *arg_text_buffers = NULL;         // Backing storage for formatted scalars
     if (arg_count > 0) {
         arg_values_evaluated = (const char**)calloc(arg_count, sizeof(char*)); // Use calloc
-        if (!arg_values_evaluated) {
+        arg_text_buffers = (ArgText*)calloc(arg_count, sizeof(ArgText));
+        if (!arg_values_evaluated || !arg_text_buffers) {
             fprintf(stderr, "VM Error (L%d): Out of memory marshalling args for builtin '%s'.\n", args_ast_list ? args_ast_list->line : 0, func_name_to_call);
-            return "undefined";
+            free((void*)arg_values_evaluated);
+            free(arg_text_buffers);
+            return value_undefined();
         }
         iter = args_ast_list;
         for (int i = 0; i < arg_count; ++i) {
-            arg_values_evaluated[i] = evaluate_expression(iter, frame_for_evaluating_args);
+            Value arg_value = evaluate_expression(iter, frame_for_evaluating_args);
+            gc_push_root(arg_value); // Its text is passed to the native below
+            arg_values_evaluated[i] = value_to_cstring(arg_value, arg_text_buffers[i], sizeof(ArgText));
             iter = iter->next;
         }
     }
     
-    // Corrected function call
-    int was_found_and_called = call_builtin_function_impl(func_name_to_call, arg_values_evaluated, arg_count);
+    Value saved_return_value = get_return_value();
+    set_return_value(value_undefined());
+    invoke_builtin_function(native, arg_values_evaluated, arg_count);
+    Value result = get_return_value();
+    set_return_value(saved_return_value);
+    gc_pop_roots(arg_count);
 
-    if (arg_values_evaluated) free((void*)arg_values_evaluated);
+    free((void*)arg_values_evaluated);
+    free(arg_text_buffers);
 
-    if (was_found_and_called) {
-        return get_return_value(); 
-    }
-    return "undefined"; 
+    return result;
 }
 
 static void initialize_default_instance_fields(const char *class_name_param, Object *instance_obj, StackFrame *frame_for_eval) {
@@ -982,14 +1340,14 @@ static void initialize_default_instance_fields(const char *class_name_param, Obj
                 if (member->type == AST_CLASS_FIELD) {
                     // Initialize field with default value or expression
                     if (member->left) {
-                        // Prepare buffer for field value
-                        char value[256] = "";
-                        const char* result = evaluate_expression(member->left, frame_for_eval);
-                        if (result) {
-                            strncpy(value, result, sizeof(value) - 1);
-                        }
-                        set_object_property_with_access(instance_obj, member->value, value, ACCESS_MODIFIER_PUBLIC, 0);
+                        set_object_property_with_access(instance_obj, member->value, evaluate_expression(member->left, frame_for_eval), ACCESS_MODIFIER_PUBLIC, 0);
                     }
+                } else if ((member->type == AST_VAR_DECL || member->type == AST_TYPED_VAR_DECL) &&
+                           strcmp(member->access_modifier, "static") != 0) {
+                    // 'let x = ...;' inside a class body declares an instance field
+                    AccessModifierEnum access = strcmp(member->access_modifier, "private") == 0 ? ACCESS_MODIFIER_PRIVATE : ACCESS_MODIFIER_PUBLIC;
+                    Value initial_value = member->right ? evaluate_expression(member->right, frame_for_eval) : value_undefined();
+                    set_object_property_with_access(instance_obj, member->value, initial_value, access, 0);
                 }
                 member = member->next;
             }
@@ -3,6 +3,8 @@
 
 #include "ast_types.h"
 #include "stack.h" // For StackFrame
+#include "value.h" // For Value
+#include "shape.h" // For Shape
 
 // Property access modifiers (can be used by AST or VM internals if needed)
 typedef enum {
@@ -11,28 +13,24 @@ typedef enum {
     ACCESS_MODIFIER_PROTECTED
 } AccessModifierEnum;
 
-// Object property structure
-typedef struct ObjectProperty {
-    char name[128];
-    char value[1024]; // Consider dynamic allocation for larger values
-    AccessModifierEnum access; // e.g. ACCESS_PUBLIC, ACCESS_PRIVATE
-    int is_static;          // 0 for instance, 1 for static
-    struct ObjectProperty *next;
-} ObjectProperty;
-
-// Object structure
+// Object structure. Objects live in a table indexed by id (VAL_OBJECT(id)).
+// Property names and attributes are described by the shared shape; the
+// object only stores the values, slots[i] holding shape->properties[i].
 typedef struct Object {
-    char class_name[128]; // Format: "ClassName#InstanceID" or "ClassName_static#ID"
-    ObjectProperty *properties;
-    struct Object *next; // For linked list of all objects
+    int id;
+    char class_name[128]; // "ClassName", or "ClassName_static" for a class's static object
+    Shape *shape;
+    Value *slots;
+    int slot_capacity;
+    int marked;           // Set during a collection's mark phase
 } Object;
 
 // C function pointer type for native functions (if used)
 typedef void (*CFunction)();
 
 // External globals (if needed by other modules, e.g., for debugging)
-extern Object *objects;
 extern char current_class[128]; // Current class context for access checks
+extern char g_super_target_class[128]; // Parent class targeted by the last 'super' evaluation
 
 // VM initialization and cleanup
 void vm_init();
@@ -44,33 +42,60 @@ ASTNode* find_user_function(const char *name, const char* class_context_name); /
 
 // Object operations
 Object* create_object(const char* class_name); // class_name is base name e.g. "MyClass"
-void set_object_property(Object *obj, const char *name, const char *value); // Basic public setter
-void set_object_property_with_access(Object *obj, const char *name, const char *value, AccessModifierEnum access, int is_static);
-const char* get_object_property(Object *obj, const char *name); // Basic public getter
-const char* get_object_property_with_access_check(Object *obj, const char *name, const char *accessing_class_context);
-const char* get_static_property(const char *class_name, const char *prop_name); // Gets from ClassName_static object
+void set_object_property(Object *obj, const char *name, Value value); // Basic public setter
+void set_object_property_with_access(Object *obj, const char *name, Value value, AccessModifierEnum access, int is_static);
+Value* get_object_property(Object *obj, const char *name); // Basic public getter; NULL if missing
+Value* get_object_property_with_access_check(Object *obj, const char *name, const char *accessing_class_context);
+Value* get_static_property(const char *class_name, const char *prop_name); // Gets from ClassName_static object
 void free_object(Object *obj);
 Object* find_object_by_id(int id);
 Object* find_static_class_object(const char *class_name); // Finds/creates ClassName_static object
+// Collector hooks (gc.c): marks the pending return value and static objects,
+// then frees the objects left unmarked
+void vm_mark_roots(void);
+struct GCStats;
+void vm_sweep_objects(struct GCStats *stats);
 void initialize_test_class(Object *obj); // Specific initializer, maybe remove/generalize
-const char* get_object_property_with_access(Object *obj, const char *property_name, const char *current_class_context_for_access_check);
+// Instance lookup with static fallback; VAL_UNDEFINED if missing or not accessible
+Value get_object_property_with_access(Object *obj, const char *property_name, const char *current_class_context_for_access_check);
+Value evaluate_member_access(ASTNode *member_access_expr_node, StackFrame *frame);
+// Inline-cached forms for AST access sites: `site` remembers the last shape and
+// slot it saw, so repeated accesses on same-shaped objects skip the lookup.
+Value get_object_property_at_site(Object *obj, const char *name, ASTNode *site);
+void set_object_property_at_site(Object *obj, const char *name, Value value, int is_static, ASTNode *site);
 
 
 // VM execution
-const char* execute_function_call(const char* qualified_name, ASTNode* args_ast_list, StackFrame* caller_frame);
+// this_value is the receiver for method calls (VAL_UNDEFINED for plain calls;
+// static methods then bind 'this' to the class's static object).
+Value execute_function_call(const char* qualified_name, Value this_value, ASTNode* args_ast_list, StackFrame* caller_frame);
+// Call-site cached forms for AST_CALL nodes: the target is resolved once and
+// reused until the function/class registry changes. Method sites cache per
+// receiver class, up to a few classes per site.
+Value execute_call_at_site(ASTNode *call_node, StackFrame *caller_frame);
+Value execute_method_call_at_site(ASTNode *call_node, Object *receiver, StackFrame *caller_frame);
+Value execute_static_call_at_site(ASTNode *call_node, const OuroString *class_name, StackFrame *caller_frame); // class_name interned
+// Calls an already resolved function with evaluated arguments. Runs its bytecode
+// when compiled, otherwise walks the body. this_binding may be VAL_UNDEFINED.
+Value vm_invoke_function(ASTNode *func_node, Value this_binding, const Value *args, int argc, StackFrame *caller_frame);
 void run_vm_node(ASTNode *node, StackFrame *frame);
 void run_vm(ASTNode *root_ast_node);
 
 // Return value handling
-const char* get_return_value();
-void set_return_value(const char* value);
+Value get_return_value();
+void set_return_value(Value value);
 
 // Class method resolution
 ASTNode* find_class_method(const char *class_name, const char *method_name);
 
 // Bridge to stdlib built-in functions (defined in stdlib.c)
 // Arguments: func_name, list of ASTNodes for args, frame to evaluate args in.
-const char* call_built_in_function(const char* func_name_to_call, ASTNode* args_ast_list, StackFrame* frame_for_evaluating_args);
+// Returns 1 and stores the builtin's return value in *result if func_name names a builtin.
+int call_built_in_function(const char* func_name_to_call, ASTNode* args_ast_list, StackFrame* frame_for_evaluating_args, Value *result);
+// Method-call form for built-in value types: receiver.name(args) calls the value
+// native "<type>_<name>" (e.g. array_push) with the receiver as first argument.
+// Returns 0 if there is no such native.
+int call_built_in_method(const char *method_name, Value receiver, ASTNode *args_ast_list, StackFrame *frame, Value *result);
 
 // Add prototype for get_parent_class_name
 const char* get_parent_class_name(const char *class_name);
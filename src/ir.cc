@@ -1,3 +0,0 @@
-export module ir;
-
-export void build_ir();
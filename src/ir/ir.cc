@@ -0,0 +1,605 @@
+#include "ir.h"
+#include <algorithm>
+#include <charconv>
+#include <functional>
+
+namespace ouro::ir {
+
+std::vector<Block*> Block::succs() const {
+    auto* t = terminator();
+    if (!t) return {};
+    return t->blocks;
+}
+
+void Function::replace_uses(const Instr* from, Instr* to) {
+    for (auto& b : blocks) {
+        for (auto& i : b->instrs) {
+            std::replace(i->operands.begin(), i->operands.end(), const_cast<Instr*>(from), to);
+        }
+    }
+}
+
+void Function::remove_unreachable() {
+    std::set<const Block*> reached;
+    std::vector<Block*> work{entry()};
+    while (!work.empty()) {
+        auto* b = work.back();
+        work.pop_back();
+        if (!reached.insert(b).second) continue;
+        for (auto* s : b->succs()) work.push_back(s);
+    }
+    for (auto& b : blocks) {
+        if (!reached.contains(b.get())) continue;
+        // Drop the edges from dead blocks, and the phi operands that came along them
+        for (std::size_t k = b->preds.size(); k-- > 0;) {
+            if (reached.contains(b->preds[k])) continue;
+            auto* dead = b->preds[k];
+            b->preds.erase(b->preds.begin() + static_cast<std::ptrdiff_t>(k));
+            for (auto& i : b->instrs) {
+                if (i->op != Op::Phi) break;
+                auto at = std::find(i->blocks.begin(), i->blocks.end(), dead) - i->blocks.begin();
+                i->blocks.erase(i->blocks.begin() + at);
+                i->operands.erase(i->operands.begin() + at);
+            }
+        }
+    }
+    std::erase_if(blocks, [&](const auto& b) { return !reached.contains(b.get()); });
+}
+
+Function* Module::find(std::string_view name) const {
+    for (const auto& f : functions) {
+        if (f->name == name) return f.get();
+    }
+    return nullptr;
+}
+
+// --- Builder -------------------------------------------------------------------
+
+Block* Builder::create_block(std::string name) {
+    auto b = std::make_unique<Block>();
+    b->name = std::move(name);
+    b->id = fn.next_block++;
+    b->parent = &fn;
+    return fn.blocks.emplace_back(std::move(b)).get();
+}
+
+// Not yet placed: insert() gives it its block
+std::unique_ptr<Instr> Builder::make(Op op, Type type) {
+    return std::make_unique<Instr>(Instr{op, type, {}, {}, {}, {}, 0, fn.next_instr++, nullptr});
+}
+
+Instr* Builder::insert(Block* b, std::size_t at, std::unique_ptr<Instr> instr) {
+    instr->parent = b;
+    return b->instrs.insert(b->instrs.begin() + static_cast<std::ptrdiff_t>(at), std::move(instr))->get();
+}
+
+Instr* Builder::constant(Type type, Constant value) {
+    auto i = make(Op::Const, type);
+    i->constant = std::move(value);
+    return append(std::move(i));
+}
+
+// After the parameters at the top of the entry block
+static std::size_t after_params(const Block* entry) {
+    std::size_t at = 0;
+    while (at < entry->instrs.size() && entry->instrs[at]->op == Op::Param) ++at;
+    return at;
+}
+
+Instr* Builder::undef(Type type) {
+    auto* entry = fn.entry();
+    return insert(entry, after_params(entry), make(Op::Undef, type));
+}
+
+Instr* Builder::param(int index) {
+    auto i = make(Op::Param, fn.params.at(static_cast<std::size_t>(index)));
+    i->index = index;
+    auto* entry = fn.entry();
+    return insert(entry, after_params(entry), std::move(i));
+}
+
+Instr* Builder::binary(Op op, Instr* left, Instr* right) {
+    bool compare = op >= Op::Eq && op <= Op::Ge;
+    auto i = make(op, compare ? Type::Bool : left->type);
+    i->operands = {left, right};
+    return append(std::move(i));
+}
+
+Instr* Builder::unary(Op op, Instr* operand) {
+    auto i = make(op, op == Op::Not ? Type::Bool : operand->type);
+    i->operands = {operand};
+    return append(std::move(i));
+}
+
+Instr* Builder::convert(Instr* value, Type to) {
+    if (value->type == to) return value;
+    auto i = make(Op::Convert, to);
+    i->operands = {value};
+    return append(std::move(i));
+}
+
+Instr* Builder::load_global(int slot, std::string name, Type type) {
+    auto i = make(Op::LoadGlobal, type);
+    i->index = slot;
+    i->name = std::move(name);
+    return append(std::move(i));
+}
+
+void Builder::store_global(int slot, std::string name, Instr* value) {
+    auto i = make(Op::StoreGlobal, Type::Void);
+    i->index = slot;
+    i->name = std::move(name);
+    i->operands = {value};
+    append(std::move(i));
+}
+
+Instr* Builder::call(std::string callee, std::vector<Instr*> args, Type result) {
+    auto i = make(Op::Call, result);
+    i->name = std::move(callee);
+    i->operands = std::move(args);
+    return append(std::move(i));
+}
+
+Instr* Builder::phi(Type type, Block* at) {
+    std::size_t index = 0;
+    while (index < at->instrs.size() && at->instrs[index]->op == Op::Phi) ++index;
+    return insert(at, index, make(Op::Phi, type));
+}
+
+void Builder::add_incoming(Instr* phi, Instr* value, Block* from) {
+    phi->operands.push_back(value);
+    phi->blocks.push_back(from);
+}
+
+void Builder::br(Block* target) {
+    auto i = make(Op::Br, Type::Void);
+    i->blocks = {target};
+    append(std::move(i));
+    edge(block, target);
+}
+
+void Builder::cond_br(Instr* condition, Block* then_block, Block* else_block) {
+    auto i = make(Op::CondBr, Type::Void);
+    i->operands = {condition};
+    i->blocks = {then_block, else_block};
+    append(std::move(i));
+    edge(block, then_block);
+    edge(block, else_block);
+}
+
+void Builder::ret(Instr* value) {
+    auto i = make(Op::Ret, Type::Void);
+    if (value) i->operands = {value};
+    append(std::move(i));
+}
+
+// --- Variables -----------------------------------------------------------------
+
+Instr* Variables::read(int var, Block* block) {
+    auto& local = defs[block];
+    if (auto it = local.find(var); it != local.end()) return it->second;
+    return read_recursive(var, block);
+}
+
+Instr* Variables::read_recursive(int var, Block* block) {
+    Instr* value;
+    if (!sealed.contains(block)) {
+        value = builder.phi(types.at(var), block);
+        incomplete[block].emplace_back(var, value);
+    } else if (block->preds.empty()) {
+        value = builder.undef(types.at(var));
+    } else if (block->preds.size() == 1) {
+        value = read(var, block->preds.front());
+    } else {
+        value = builder.phi(types.at(var), block);
+        write(var, block, value); // Ends the search of a loop that reaches this block again
+        value = add_operands(var, value);
+    }
+    write(var, block, value);
+    return value;
+}
+
+Instr* Variables::add_operands(int var, Instr* phi) {
+    for (auto* pred : phi->parent->preds) Builder::add_incoming(phi, read(var, pred), pred);
+    return remove_trivial(phi);
+}
+
+Instr* Variables::remove_trivial(Instr* phi) {
+    Instr* same = nullptr;
+    for (auto* op : phi->operands) {
+        if (op == same || op == phi) continue;
+        if (same) return phi; // Merges two values: not trivial
+        same = op;
+    }
+    if (!same) same = builder.undef(phi->type); // Reached only from itself, or from nowhere
+    auto& fn = builder.function();
+    std::vector<Instr*> users;
+    for (auto& b : fn.blocks) {
+        for (auto& i : b->instrs) {
+            if (i.get() != phi && i->op == Op::Phi && std::ranges::find(i->operands, phi) != i->operands.end()) {
+                users.push_back(i.get());
+            }
+        }
+    }
+    fn.replace_uses(phi, same);
+    for (auto& [block, vars] : defs) {
+        for (auto& [v, value] : vars) {
+            if (value == phi) value = same;
+        }
+    }
+    phi->operands.clear();
+    phi->blocks.clear();
+    removed.push_back(phi);
+    // Phis that used this one may have become trivial in turn
+    for (auto* user : users) {
+        if (std::ranges::find(removed, user) == removed.end()) remove_trivial(user);
+    }
+    return same;
+}
+
+void Variables::seal(Block* block) {
+    for (auto [var, phi] : incomplete[block]) add_operands(var, phi);
+    incomplete.erase(block);
+    sealed.insert(block);
+}
+
+void Variables::finish() {
+    for (auto* phi : removed) {
+        auto& instrs = phi->parent->instrs;
+        std::erase_if(instrs, [&](const auto& i) { return i.get() == phi; });
+    }
+    removed.clear();
+}
+
+// --- Dominators ----------------------------------------------------------------
+
+Dominators::Dominators(const Function& fn) {
+    // Reverse postorder of the blocks the entry reaches
+    std::vector<const Block*> order;
+    std::set<const Block*> seen;
+    std::function<void(const Block*)> visit = [&](const Block* b) {
+        if (!seen.insert(b).second) return;
+        for (auto* s : b->succs()) visit(s);
+        order.push_back(b);
+    };
+    visit(fn.entry());
+    std::reverse(order.begin(), order.end());
+    std::map<const Block*, std::size_t> position;
+    for (std::size_t k = 0; k < order.size(); ++k) position[order[k]] = k;
+
+    idom[fn.entry()] = fn.entry();
+    auto intersect = [&](const Block* a, const Block* b) {
+        while (a != b) {
+            while (position[a] > position[b]) a = idom[a];
+            while (position[b] > position[a]) b = idom[b];
+        }
+        return a;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t k = 1; k < order.size(); ++k) {
+            const Block* b = order[k];
+            const Block* dom = nullptr;
+            for (auto* p : b->preds) {
+                if (!idom.contains(p)) continue; // Not processed yet, or unreachable
+                dom = dom ? intersect(p, dom) : p;
+            }
+            if (dom && idom[b] != dom) {
+                idom[b] = dom;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool Dominators::dominates(const Block* a, const Block* b) const {
+    for (;;) {
+        if (a == b) return true;
+        auto* up = idom.at(b);
+        if (up == b) return false; // Reached the entry
+        b = up;
+    }
+}
+
+// --- Printing ------------------------------------------------------------------
+
+const char* name(Type type) {
+    switch (type) {
+        case Type::Void: return "void";
+        case Type::Bool: return "bool";
+        case Type::Int: return "int";
+        case Type::Float: return "float";
+        case Type::String: return "string";
+        case Type::Any: return "any";
+    }
+    return "?";
+}
+
+const char* name(Op op) {
+    switch (op) {
+        case Op::Const: return "const";
+        case Op::Undef: return "undef";
+        case Op::Param: return "param";
+        case Op::Add: return "add";
+        case Op::Sub: return "sub";
+        case Op::Mul: return "mul";
+        case Op::Div: return "div";
+        case Op::Mod: return "mod";
+        case Op::Neg: return "neg";
+        case Op::Not: return "not";
+        case Op::Eq: return "eq";
+        case Op::Ne: return "ne";
+        case Op::Lt: return "lt";
+        case Op::Le: return "le";
+        case Op::Gt: return "gt";
+        case Op::Ge: return "ge";
+        case Op::Convert: return "convert";
+        case Op::LoadGlobal: return "load";
+        case Op::StoreGlobal: return "store";
+        case Op::Call: return "call";
+        case Op::Phi: return "phi";
+        case Op::Br: return "br";
+        case Op::CondBr: return "condbr";
+        case Op::Ret: return "ret";
+    }
+    return "?";
+}
+
+static std::string ref(const Instr* i) { return "%" + std::to_string(i->id); }
+static std::string ref(const Block* b) { return "b" + std::to_string(b->id); }
+
+static std::string literal(const Constant& c) {
+    if (std::holds_alternative<bool>(c)) return std::get<bool>(c) ? "true" : "false";
+    if (std::holds_alternative<std::int64_t>(c)) return std::to_string(std::get<std::int64_t>(c));
+    if (std::holds_alternative<double>(c)) {
+        char buf[32]; // Shortest text that reads back as the same double
+        auto end = std::to_chars(buf, buf + sizeof(buf), std::get<double>(c)).ptr;
+        return std::string(buf, end);
+    }
+    if (std::holds_alternative<std::string>(c)) {
+        std::string out = "\"";
+        for (char ch : std::get<std::string>(c)) {
+            if (ch == '"' || ch == '\\') out += '\\';
+            if (ch == '\n') out += "\\n";
+            else out += ch;
+        }
+        return out + '"';
+    }
+    return "null";
+}
+
+static std::string dump(const Instr& i) {
+    std::string out = i.type == Type::Void ? "" : ref(&i) + " = ";
+    out += name(i.op);
+    auto operands = [&](std::size_t from) {
+        for (std::size_t k = from; k < i.operands.size(); ++k) out += (k > from ? ", " : "") + ref(i.operands[k]);
+    };
+    switch (i.op) {
+        case Op::Const: out += std::string(" ") + name(i.type) + " " + literal(i.constant); break;
+        case Op::Param: out += std::string(" ") + name(i.type) + " " + std::to_string(i.index); break;
+        case Op::LoadGlobal: out += std::string(" ") + name(i.type) + " @" + i.name + "[" + std::to_string(i.index) + "]"; break;
+        case Op::StoreGlobal: out += " @" + i.name + "[" + std::to_string(i.index) + "], " + ref(i.operands[0]); break;
+        case Op::Call:
+            out += std::string(" ") + name(i.type) + " " + i.name + "(";
+            operands(0);
+            out += ")";
+            break;
+        case Op::Phi:
+            out += std::string(" ") + name(i.type);
+            for (std::size_t k = 0; k < i.operands.size(); ++k) {
+                out += (k ? ", [" : " [") + ref(i.operands[k]) + ", " + ref(i.blocks[k]) + "]";
+            }
+            break;
+        case Op::Br: out += " " + ref(i.blocks[0]); break;
+        case Op::CondBr: out += " " + ref(i.operands[0]) + ", " + ref(i.blocks[0]) + ", " + ref(i.blocks[1]); break;
+        case Op::Ret:
+            if (!i.operands.empty()) out += " ";
+            operands(0);
+            break;
+        default:
+            out += std::string(" ") + name(i.type) + (i.operands.empty() ? "" : " ");
+            operands(0);
+            break;
+    }
+    return out;
+}
+
+std::string dump(const Function& fn) {
+    std::string out = "fn " + fn.name + "(";
+    for (std::size_t k = 0; k < fn.params.size(); ++k) out += (k ? ", " : "") + std::string(name(fn.params[k]));
+    out += ")";
+    if (fn.result != Type::Void) out += std::string(" -> ") + name(fn.result);
+    out += " {\n";
+    for (const auto& b : fn.blocks) {
+        out += ref(b.get()) + (b->name.empty() ? "" : " " + b->name) + ":\n";
+        for (const auto& i : b->instrs) out += "  " + dump(*i) + "\n";
+    }
+    return out + "}\n";
+}
+
+std::string dump(const Module& module) {
+    std::string out;
+    for (const auto& f : module.functions) out += (out.empty() ? "" : "\n") + dump(*f);
+    for (const auto& s : module.skipped) out += "; skipped " + s + "\n";
+    return out;
+}
+
+// --- Verifier ------------------------------------------------------------------
+
+namespace {
+
+class Verifier {
+    const Function& fn;
+    std::vector<std::string> problems;
+    std::set<const Instr*> defined;
+    std::set<const Block*> owned;
+
+public:
+    explicit Verifier(const Function& f) : fn(f) {}
+
+    std::vector<std::string> run() {
+        if (fn.blocks.empty()) {
+            fail("has no blocks");
+            return problems;
+        }
+        std::set<unsigned> instr_ids, block_ids;
+        for (const auto& b : fn.blocks) {
+            owned.insert(b.get());
+            if (!block_ids.insert(b->id).second) fail(ref(b.get()) + " reuses its id");
+            for (const auto& i : b->instrs) {
+                defined.insert(i.get());
+                if (!instr_ids.insert(i->id).second) fail(ref(i.get()) + " reuses its id");
+            }
+        }
+        if (!fn.entry()->preds.empty()) fail("the entry block " + ref(fn.entry()) + " has predecessors");
+        for (const auto& b : fn.blocks) check_block(*b);
+        if (problems.empty()) check_dominance(); // Needs well-formed edges
+        return problems;
+    }
+
+private:
+    void fail(const std::string& what) { problems.push_back("fn " + fn.name + ": " + what); }
+
+    void check_block(const Block& b) {
+        if (b.parent != &fn) fail(ref(&b) + " belongs to another function");
+        if (!b.terminator()) fail(ref(&b) + " does not end in a terminator");
+        bool phis = true;
+        for (const auto& i : b.instrs) {
+            if (i->parent != &b) fail(ref(i.get()) + " does not know its block");
+            if (i->op != Op::Phi) phis = false;
+            else if (!phis) fail(ref(i.get()) + " is a phi after other instructions");
+            if (i->is_terminator() && i.get() != b.instrs.back().get()) fail(ref(i.get()) + " ends " + ref(&b) + " early");
+            for (auto* op : i->operands) {
+                if (!defined.contains(op)) fail(ref(i.get()) + " uses a value from outside the function");
+            }
+            for (auto* t : i->blocks) {
+                if (!owned.contains(t)) fail(ref(i.get()) + " names a block outside the function");
+            }
+            check_types(*i);
+        }
+        // Each predecessor listed once per edge into this block
+        std::vector<const Block*> edges;
+        for (const auto& p : fn.blocks) {
+            for (auto* s : p->succs()) {
+                if (s == &b) edges.push_back(p.get());
+            }
+        }
+        auto listed = std::vector<const Block*>(b.preds.begin(), b.preds.end());
+        auto by_id = [](const Block* x, const Block* y) { return x->id < y->id; };
+        std::sort(edges.begin(), edges.end(), by_id);
+        std::sort(listed.begin(), listed.end(), by_id);
+        if (edges != listed) fail(ref(&b) + "'s predecessors do not match the branches into it");
+        for (const auto& i : b.instrs) {
+            if (i->op != Op::Phi) break;
+            auto incoming = std::vector<const Block*>(i->blocks.begin(), i->blocks.end());
+            std::sort(incoming.begin(), incoming.end(), by_id);
+            if (incoming != listed) fail(ref(i.get()) + " does not have one value per predecessor of " + ref(&b));
+        }
+    }
+
+    void expect(const Instr& i, bool ok, const char* what) {
+        if (!ok) fail(ref(&i) + " (" + name(i.op) + ") " + what);
+    }
+
+    void check_types(const Instr& i) {
+        auto operands = [&](std::size_t n) { return i.operands.size() == n; };
+        auto all = [&](Type t) {
+            return std::ranges::all_of(i.operands, [&](const Instr* o) { return o->type == t; });
+        };
+        bool arithmetic = i.type == Type::Int || i.type == Type::Float || i.type == Type::Any;
+        switch (i.op) {
+            case Op::Const: {
+                const auto& c = i.constant;
+                bool ok = i.type == Type::Any || (i.type == Type::Bool && std::holds_alternative<bool>(c)) ||
+                          (i.type == Type::Int && std::holds_alternative<std::int64_t>(c)) ||
+                          (i.type == Type::Float && std::holds_alternative<double>(c)) ||
+                          (i.type == Type::String && std::holds_alternative<std::string>(c));
+                expect(i, ok, "holds a constant of another type");
+                break;
+            }
+            case Op::Undef: expect(i, i.type != Type::Void, "must have a value type"); break;
+            case Op::Param:
+                expect(i, i.index >= 0 && static_cast<std::size_t>(i.index) < fn.params.size() &&
+                              fn.params[static_cast<std::size_t>(i.index)] == i.type,
+                       "does not match the function's parameters");
+                expect(i, i.parent == fn.entry(), "must be in the entry block");
+                break;
+            case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Mod:
+                expect(i, operands(2) && arithmetic && all(i.type), "needs two operands of its int, float or any type");
+                break;
+            case Op::Neg:
+                expect(i, operands(1) && arithmetic && all(i.type), "needs an operand of its int, float or any type");
+                break;
+            case Op::Not: expect(i, operands(1) && i.type == Type::Bool && all(Type::Bool), "needs a bool operand"); break;
+            case Op::Eq: case Op::Ne: case Op::Lt: case Op::Le: case Op::Gt: case Op::Ge:
+                expect(i, operands(2) && i.type == Type::Bool && i.operands[0]->type == i.operands[1]->type &&
+                              i.operands[0]->type != Type::Void,
+                       "needs two operands of one type and a bool result");
+                break;
+            case Op::Convert:
+                expect(i, operands(1) && i.type != Type::Void && i.operands[0]->type != Type::Void, "needs a value to convert");
+                break;
+            case Op::LoadGlobal: expect(i, operands(0) && i.type != Type::Void, "must load a value"); break;
+            case Op::StoreGlobal:
+                expect(i, operands(1) && i.type == Type::Void && i.operands[0]->type != Type::Void, "needs a value to store");
+                break;
+            case Op::Call:
+                expect(i, !i.name.empty() && std::ranges::none_of(i.operands, [](const Instr* o) { return o->type == Type::Void; }),
+                       "needs a callee and value arguments");
+                break;
+            case Op::Phi:
+                expect(i, i.type != Type::Void && all(i.type) && i.operands.size() == i.blocks.size(),
+                       "needs one value of its type per incoming block");
+                break;
+            case Op::Br: expect(i, operands(0) && i.blocks.size() == 1, "needs one target"); break;
+            case Op::CondBr:
+                expect(i, operands(1) && all(Type::Bool) && i.blocks.size() == 2, "needs a bool condition and two targets");
+                break;
+            case Op::Ret:
+                expect(i, fn.result == Type::Void ? operands(0) : operands(1) && all(fn.result),
+                       "does not return the function's result type");
+                break;
+        }
+    }
+
+    void check_dominance() {
+        Dominators dom(fn);
+        for (const auto& b : fn.blocks) {
+            if (!dom.reachable(b.get())) continue; // Nothing there runs
+            for (std::size_t k = 0; k < b->instrs.size(); ++k) {
+                const auto& i = *b->instrs[k];
+                for (std::size_t n = 0; n < i.operands.size(); ++n) {
+                    const auto* def = i.operands[n];
+                    // A phi's operand is used at the end of the block it comes from
+                    const Block* at = i.op == Op::Phi ? i.blocks[n] : b.get();
+                    if (!dom.reachable(at)) continue;
+                    bool ok;
+                    if (def->parent != at) {
+                        ok = dom.reachable(def->parent) && dom.dominates(def->parent, at);
+                    } else if (i.op == Op::Phi) {
+                        ok = true;
+                    } else {
+                        auto pos = std::find_if(b->instrs.begin(), b->instrs.end(), [&](const auto& x) { return x.get() == def; });
+                        ok = pos < b->instrs.begin() + static_cast<std::ptrdiff_t>(k);
+                    }
+                    if (!ok) fail(ref(&i) + " uses " + ref(def) + " where its definition does not dominate");
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::vector<std::string> verify(const Function& fn) { return Verifier(fn).run(); }
+
+std::vector<std::string> verify(const Module& module) {
+    std::vector<std::string> problems;
+    for (const auto& f : module.functions) {
+        auto more = verify(*f);
+        problems.insert(problems.end(), more.begin(), more.end());
+    }
+    return problems;
+}
+
+} // namespace ouro::ir
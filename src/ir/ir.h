@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace ouro::ir {
+
+// A typed SSA form shared by both front ends, so an optimization written
+// against it serves the ouro:: interpreter's language and ouroboros-lang
+// alike. A Module holds Functions; a Function holds Blocks, the first its
+// entry; a Block holds Instrs, its phis first and exactly one terminator
+// last. Every Instr defines one value, of its Type (Void if it produces
+// none), and each operand is an Instr whose definition dominates the use.
+//
+// Functions own their blocks and blocks their instructions; Instr* and
+// Block* stay valid until the function is destroyed or they are erased.
+
+enum class Type : std::uint8_t {
+    Void,
+    Bool,
+    Int,    // 64-bit two's complement
+    Float,  // IEEE double
+    String,
+    Any,    // Whatever a value of the front end's runtime can hold, checked when used
+};
+
+enum class Op : std::uint8_t {
+    Const,       // `constant`
+    Undef,       // A variable read before it was written on some path
+    Param,       // Argument `index`
+    Add, Sub, Mul, Div, Mod, // Operands of the result's type
+    Neg,         // Operand of the result's type
+    Not,         // Bool operand
+    Eq, Ne, Lt, Le, Gt, Ge,  // Operands of one type; Bool result
+    Convert,     // To the result's type. To Bool it tests truth as the front end's `if` does
+    LoadGlobal,  // Slot `index` of the program's frame, called `name`
+    StoreGlobal, // Operand 0 into slot `index`
+    Call,        // `name`(operands...)
+    Phi,         // operands[i] when control arrives from blocks[i]
+    Br,          // To blocks[0]
+    CondBr,      // To blocks[0] if the Bool operand is true, else blocks[1]
+    Ret,         // With operand 0, or nothing from a Void function
+};
+
+using Constant = std::variant<std::monostate, bool, std::int64_t, double, std::string>; // monostate: null
+
+struct Block;
+struct Function;
+
+struct Instr {
+    Op op;
+    Type type;
+    std::vector<Instr*> operands;
+    std::vector<Block*> blocks; // Br and CondBr: targets. Phi: where each operand comes from
+    Constant constant;
+    std::string name;
+    int index = 0;
+    unsigned id = 0;            // Printed as %id; unique in the function
+    Block* parent = nullptr;
+
+    bool is_terminator() const { return op == Op::Br || op == Op::CondBr || op == Op::Ret; }
+    // Stores, calls and terminators: kept even when nothing uses their value
+    bool has_effects() const { return op == Op::StoreGlobal || op == Op::Call || is_terminator(); }
+};
+
+struct Block {
+    std::string name;
+    unsigned id = 0;            // Printed as bN; unique in the function
+    Function* parent = nullptr;
+    std::vector<std::unique_ptr<Instr>> instrs;
+    std::vector<Block*> preds;  // One entry per edge, so a block both targets of a CondBr lists twice
+
+    Instr* terminator() const {
+        return !instrs.empty() && instrs.back()->is_terminator() ? instrs.back().get() : nullptr;
+    }
+    std::vector<Block*> succs() const;
+};
+
+struct Function {
+    std::string name;
+    std::vector<Type> params;
+    Type result = Type::Void;
+    std::vector<std::unique_ptr<Block>> blocks;
+    unsigned next_instr = 0, next_block = 0;
+
+    Block* entry() const { return blocks.front().get(); }
+    // Points every operand that is `from` at `to`
+    void replace_uses(const Instr* from, Instr* to);
+    // Drops blocks no path from the entry reaches, and their edges into the rest
+    void remove_unreachable();
+};
+
+struct Module {
+    std::vector<std::unique_ptr<Function>> functions;
+    // Functions the front end could not express in the IR, each with why
+    std::vector<std::string> skipped;
+
+    Function* find(std::string_view name) const;
+};
+
+// Appends instructions at the end of the current block. Types are checked by
+// verify(), not here: front ends insert the Converts their semantics need.
+class Builder {
+    Function& fn;
+    Block* block = nullptr;
+
+public:
+    explicit Builder(Function& f) : fn(f) {}
+
+    Function& function() const { return fn; }
+    Block* create_block(std::string name);
+    void set_block(Block* b) { block = b; }
+    Block* current() const { return block; }
+    bool terminated() const { return block->terminator() != nullptr; }
+
+    Instr* constant(Type type, Constant value);
+    Instr* undef(Type type);  // Placed in the entry block, so it dominates every use
+    Instr* param(int index);  // Likewise
+    Instr* binary(Op op, Instr* left, Instr* right); // Arithmetic or comparison
+    Instr* unary(Op op, Instr* operand);
+    Instr* convert(Instr* value, Type to); // `value` itself when it already has that type
+    Instr* load_global(int slot, std::string name, Type type);
+    void store_global(int slot, std::string name, Instr* value);
+    Instr* call(std::string callee, std::vector<Instr*> args, Type result);
+    Instr* phi(Type type, Block* at); // After `at`'s other phis, with no incoming values yet
+    static void add_incoming(Instr* phi, Instr* value, Block* from);
+    void br(Block* target);
+    void cond_br(Instr* condition, Block* then_block, Block* else_block);
+    void ret(Instr* value = nullptr);
+
+private:
+    std::unique_ptr<Instr> make(Op op, Type type);
+    Instr* insert(Block* b, std::size_t at, std::unique_ptr<Instr> instr);
+    Instr* append(std::unique_ptr<Instr> instr) { return insert(block, block->instrs.size(), std::move(instr)); }
+    void edge(Block* from, Block* to) { to->preds.push_back(from); }
+};
+
+// Builds SSA form straight from a front end's variables, as in Braun et al.,
+// "Simple and Efficient Construction of Static Single Assignment Form"
+// (CC 2013). A front end writes each variable's new value in the block that
+// assigns it and reads it back anywhere; a read in a block without its own
+// definition looks through the predecessors, placing phis where they meet,
+// and phis that turn out to merge one value are removed again. A block is
+// sealed once all its predecessors are known: reads in a loop header before
+// then leave phis whose operands are filled in by seal().
+class Variables {
+    Builder& builder;
+    std::map<int, Type> types;
+    std::map<const Block*, std::map<int, Instr*>> defs;
+    std::map<const Block*, std::vector<std::pair<int, Instr*>>> incomplete;
+    std::set<const Block*> sealed;
+    std::vector<Instr*> removed; // Trivial phis, no longer used but not yet erased
+
+public:
+    explicit Variables(Builder& b) : builder(b) {}
+
+    void declare(int var, Type type) { types[var] = type; }
+    Type type(int var) const { return types.at(var); }
+    void write(int var, Block* block, Instr* value) { defs[block][var] = value; }
+    Instr* read(int var, Block* block);
+    void seal(Block* block);
+    // Erases the phis found trivial. Call once the function is complete
+    void finish();
+
+private:
+    Instr* read_recursive(int var, Block* block);
+    Instr* add_operands(int var, Instr* phi);
+    Instr* remove_trivial(Instr* phi);
+};
+
+// Dominator tree: the immediate dominator of every block reachable from the
+// entry (the entry's is itself), by Cooper, Harvey and Kennedy's iteration.
+class Dominators {
+    std::map<const Block*, const Block*> idom;
+
+public:
+    explicit Dominators(const Function& fn);
+    bool reachable(const Block* b) const { return idom.contains(b); }
+    const Block* immediate(const Block* b) const { return idom.at(b); }
+    bool dominates(const Block* a, const Block* b) const;
+};
+
+const char* name(Type type);
+const char* name(Op op);
+
+// The textual form, one function after another:
+//
+//   fn add(float, float) -> float {
+//   b0 entry:
+//     %0 = param float 0
+//     %1 = param float 1
+//     %2 = add float %0, %1
+//     ret %2
+//   }
+std::string dump(const Function& fn);
+std::string dump(const Module& module);
+
+// What is wrong with the function or module, one problem per string; empty
+// when it is well formed
+std::vector<std::string> verify(const Function& fn);
+std::vector<std::string> verify(const Module& module);
+
+} // namespace ouro::ir
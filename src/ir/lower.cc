@@ -0,0 +1,715 @@
+#include "lower.h"
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+extern "C" {
+#include "../../ouroboros-lang/ouroboros/ast_types.h"
+}
+
+namespace ouro::ir {
+namespace {
+
+// Something the IR cannot express: the function containing it is skipped
+struct Unsupported : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Slot types of one frame. A slot the source gave a type keeps it, and what
+// is written there is converted; any other takes the type of its first write.
+struct Slots {
+    std::map<int, Type> types;
+    std::set<int> declared;
+};
+
+// The types of a program's variables, kept across attempts at lowering it:
+// when a write disagrees with an undeclared slot's type the slot becomes Any,
+// and the program is lowered again so no earlier read keeps the old type.
+struct Typing {
+    std::map<const void*, Slots> locals; // By the function's AST node
+    Slots globals;
+    bool widened = false;
+
+    void declare(Slots& s, int slot, Type type) {
+        auto [it, fresh] = s.types.emplace(slot, type);
+        if (!fresh && it->second != type) it->second = Type::Any; // Declared twice, differently
+        s.declared.insert(slot);
+    }
+    Type read(Slots& s, int slot) { return s.types.emplace(slot, Type::Any).first->second; } // Unwritten yet: anything
+    Type write(Slots& s, int slot, Type value) {
+        auto [it, fresh] = s.types.emplace(slot, value);
+        if (fresh || it->second == value || it->second == Type::Any || s.declared.contains(slot)) return it->second;
+        widened = true;
+        return it->second = Type::Any;
+    }
+};
+
+// Lowers one function: control flow into blocks, variables through Variables.
+// Code after a return, break or continue is not lowered, and a block nothing
+// branches to is left as it is and removed at the end.
+class Lowering {
+protected:
+    Typing& typing;
+    Slots& locals;
+    Function& fn;
+    Builder b;
+    Variables vars{b};
+    int next_temporary = -1; // Variables the source does not name count down from -1
+
+    Lowering(Typing& t, const void* key, Function& f) : typing(t), locals(t.locals[key]), fn(f), b(f) {
+        b.set_block(b.create_block("entry"));
+        vars.seal(b.current());
+    }
+
+    // Nothing can reach the current block, or it has already branched away
+    bool dead() const {
+        return b.terminated() || (b.current() != fn.entry() && b.current()->preds.empty());
+    }
+    void jump(Block* to) {
+        if (!dead()) b.br(to);
+    }
+    void enter(Block* block) {
+        vars.seal(block);
+        b.set_block(block);
+    }
+
+    int temporary(Type type) {
+        vars.declare(next_temporary, type);
+        return next_temporary--;
+    }
+    Instr* read_local(int slot) {
+        vars.declare(slot, typing.read(locals, slot));
+        return vars.read(slot, b.current());
+    }
+    Instr* write_local(int slot, Instr* value) {
+        auto type = typing.write(locals, slot, value->type);
+        vars.declare(slot, type);
+        value = b.convert(value, type);
+        vars.write(slot, b.current(), value);
+        return value;
+    }
+    Instr* read_global(int slot, std::string name) {
+        return b.load_global(slot, std::move(name), typing.read(typing.globals, slot));
+    }
+    Instr* write_global(int slot, std::string name, Instr* value) {
+        value = b.convert(value, typing.write(typing.globals, slot, value->type));
+        b.store_global(slot, std::move(name), value);
+        return value;
+    }
+
+    void finish() {
+        vars.finish();
+        fn.remove_unreachable();
+    }
+};
+
+// Lowers every function, then tries again while a slot's type is widened
+template <typename Attempt>
+Module until_stable(Attempt attempt) {
+    Typing typing;
+    for (;;) {
+        Module module;
+        typing.widened = false;
+        attempt(module, typing);
+        if (!typing.widened) return module;
+    }
+}
+
+// --- ouro:: ----------------------------------------------------------------------
+
+Type ouro_type(std::string_view name) {
+    if (name == "int" || name == "float") return Type::Float;
+    if (name == "string") return Type::String;
+    return Type::Any;
+}
+
+struct OuroFunction {
+    const FnDeclStmt* decl;
+    int nesting; // Functions around it; 1 for one declared at the top level
+};
+
+void collect(const StmtList& stmts, int nesting, std::vector<OuroFunction>& out) {
+    for (const auto* s : stmts) {
+        if (std::holds_alternative<FnDeclStmt>(s->value)) {
+            const auto& fn = std::get<FnDeclStmt>(s->value);
+            out.push_back({&fn, nesting + 1});
+            collect(fn.body, nesting + 1, out);
+        } else if (std::holds_alternative<IfStmt>(s->value)) {
+            collect(std::get<IfStmt>(s->value).then_branch, nesting, out);
+            collect(std::get<IfStmt>(s->value).else_branch, nesting, out);
+        } else if (std::holds_alternative<ForStmt>(s->value)) {
+            collect(std::get<ForStmt>(s->value).body, nesting, out);
+        }
+    }
+}
+
+class OuroLowering : Lowering {
+    const std::map<std::string_view, const FnDeclStmt*>& functions;
+    int nesting;     // 0 for the top-level code, whose variables are globals
+    int result = 0;  // The variable `return` sets, in a function
+
+public:
+    OuroLowering(Typing& t, Function& f, const void* key, int n, const std::map<std::string_view, const FnDeclStmt*>& fns)
+        : Lowering(t, key, f), functions(fns), nesting(n) {}
+
+    void program(const StmtList& stmts) {
+        statements(stmts);
+        b.ret();
+        finish();
+    }
+
+    void function(const FnDeclStmt& decl) {
+        if (decl.is_async) throw Unsupported("async functions are not lowered");
+        for (std::size_t k = 0; k < decl.params.size(); ++k) {
+            int slot = static_cast<int>(k); // Parameters take the first slots
+            typing.declare(locals, slot, fn.params[k]);
+            write_local(slot, b.param(slot));
+        }
+        result = temporary(fn.result);
+        statements(decl.body);
+        b.ret(vars.read(result, b.current())); // Undef if nothing returned, where the interpreter has a stale value
+        finish();
+    }
+
+private:
+    void statements(const StmtList& stmts) {
+        for (const auto* s : stmts) statement(*s);
+    }
+
+    void assign(int slot, std::string_view name, Instr* value) {
+        if (nesting == 0) write_global(slot, std::string(name), value);
+        else write_local(slot, value);
+    }
+
+    void statement(const Stmt& stmt) {
+        if (std::holds_alternative<VarDeclStmt>(stmt.value)) {
+            const auto& v = std::get<VarDeclStmt>(stmt.value);
+            assign(v.slot, v.name, expr(*v.value));
+        } else if (std::holds_alternative<IfStmt>(stmt.value)) {
+            const auto& i = std::get<IfStmt>(stmt.value);
+            auto* cond = b.convert(expr(*i.condition), Type::Bool);
+            auto* then_block = b.create_block("then");
+            auto* else_block = i.else_branch.empty() ? nullptr : b.create_block("else");
+            auto* join = b.create_block("endif");
+            b.cond_br(cond, then_block, else_block ? else_block : join);
+            enter(then_block);
+            statements(i.then_branch);
+            jump(join);
+            if (else_block) {
+                enter(else_block);
+                statements(i.else_branch);
+                jump(join);
+            }
+            enter(join);
+        } else if (std::holds_alternative<ForStmt>(stmt.value)) {
+            // The bounds are evaluated once and truncated to integers, the
+            // counter is an int, and the loop variable its value as a double
+            const auto& f = std::get<ForStmt>(stmt.value);
+            auto bound = [&](const Expr& e) { return b.convert(b.convert(expr(e), Type::Float), Type::Int); };
+            auto* start = bound(*f.start);
+            auto* end = bound(*f.end);
+            int counter = temporary(Type::Int);
+            vars.write(counter, b.current(), start);
+            auto* header = b.create_block("for");
+            auto* body = b.create_block("body");
+            auto* exit = b.create_block("endfor");
+            b.br(header);
+            b.set_block(header); // Sealed once the body has branched back
+            auto* i = vars.read(counter, header);
+            b.cond_br(b.binary(Op::Lt, i, end), body, exit);
+            enter(body);
+            assign(f.slot, f.var, b.convert(i, Type::Float));
+            statements(f.body);
+            auto* next = b.binary(Op::Add, vars.read(counter, b.current()), b.constant(Type::Int, std::int64_t{1}));
+            vars.write(counter, b.current(), next);
+            b.br(header);
+            vars.seal(header);
+            enter(exit);
+        } else if (std::holds_alternative<ReturnStmt>(stmt.value)) {
+            const auto& r = std::get<ReturnStmt>(stmt.value);
+            auto* value = r.value ? expr(*r.value) : b.constant(Type::Any, {});
+            if (nesting > 0) vars.write(result, b.current(), b.convert(value, fn.result));
+        }
+        // A FnDeclStmt is lowered as a function of its own
+    }
+
+    Instr* expr(const Expr& expr) {
+        if (std::holds_alternative<NumberExpr>(expr.value)) {
+            return b.constant(Type::Float, std::get<NumberExpr>(expr.value).value);
+        } else if (std::holds_alternative<StringExpr>(expr.value)) {
+            return b.constant(Type::String, std::string(std::get<StringExpr>(expr.value).value));
+        } else if (std::holds_alternative<IdentExpr>(expr.value)) {
+            const auto& id = std::get<IdentExpr>(expr.value);
+            if (id.slot < 0) throw Unsupported("reads undefined variable " + std::string(id.name));
+            if (id.shadowed) throw Unsupported("may read " + std::string(id.name) + " before its declaration");
+            if (id.depth == nesting) return read_global(id.slot, std::string(id.name));
+            if (id.depth == 0) return read_local(id.slot);
+            throw Unsupported("captures " + std::string(id.name) + " from an enclosing function");
+        } else if (std::holds_alternative<BinaryExpr>(expr.value)) {
+            // Operands are numbers; `>` gives 1 or 0
+            const auto& e = std::get<BinaryExpr>(expr.value);
+            auto* left = b.convert(this->expr(*e.left), Type::Float);
+            auto* right = b.convert(this->expr(*e.right), Type::Float);
+            switch (e.op) {
+                case TokenType::PLUS: return b.binary(Op::Add, left, right);
+                case TokenType::MINUS: return b.binary(Op::Sub, left, right);
+                case TokenType::MUL: return b.binary(Op::Mul, left, right);
+                case TokenType::DIV: return b.binary(Op::Div, left, right);
+                case TokenType::GT: return b.convert(b.binary(Op::Gt, left, right), Type::Float);
+                default: throw Unsupported("has an unknown operator");
+            }
+        } else if (std::holds_alternative<CallExpr>(expr.value)) {
+            const auto& c = std::get<CallExpr>(expr.value);
+            std::vector<Instr*> args;
+            for (const auto* a : c.args) args.push_back(this->expr(*a));
+            auto it = functions.find(c.name);
+            if (it == functions.end()) return b.call(std::string(c.name), std::move(args), Type::Any); // A native
+            if (it->second->is_async) throw Unsupported("calls async function " + std::string(c.name));
+            auto* value = b.call(std::string(c.name), std::move(args), ouro_type(it->second->return_type));
+            // The callee's return is the caller's until the caller returns itself
+            if (nesting > 0) vars.write(result, b.current(), b.convert(value, fn.result));
+            return value;
+        }
+        throw Unsupported("awaits");
+    }
+};
+
+// --- ouroboros-lang --------------------------------------------------------------
+
+// nullopt for no type at all, which leaves the slot's type to its values
+std::optional<Type> ouroboros_type(const char* name) {
+    std::string_view t = name;
+    if (t.empty()) return std::nullopt;
+    if (t == "int" || t == "long") return Type::Int;
+    if (t == "float" || t == "double") return Type::Float;
+    if (t == "bool") return Type::Bool;
+    if (t == "string") return Type::String;
+    if (t == "void") return Type::Void;
+    return Type::Any;
+}
+
+bool is_function(const ASTNode* n) { return n->type == AST_FUNCTION || n->type == AST_TYPED_FUNCTION; }
+
+Type result_type(const ASTNode* fn) {
+    if (fn->type != AST_TYPED_FUNCTION) return Type::Any;
+    return ouroboros_type(fn->data_type).value_or(Type::Any);
+}
+
+std::vector<Type> param_types(const ASTNode* fn) {
+    std::vector<Type> types;
+    for (const ASTNode* p = fn->left; p; p = p->next) {
+        if (p->type != AST_PARAMETER) continue;
+        auto t = ouroboros_type(p->data_type).value_or(Type::Any);
+        types.push_back(t == Type::Void ? Type::Any : t);
+    }
+    return types;
+}
+
+std::string where(const ASTNode* n) { return " at line " + std::to_string(n->line); }
+
+class OuroborosLowering : Lowering {
+    const std::map<std::string_view, const ASTNode*>& functions;
+    Module& module;
+    bool program;  // Top-level code: its frame is the global one
+    struct Loop {
+        Block* exit;
+        Block* next; // Where `continue` goes
+    };
+    std::vector<Loop> loops;
+
+public:
+    OuroborosLowering(Typing& t, Function& f, const ASTNode* key, bool top, Module& m,
+                      const std::map<std::string_view, const ASTNode*>& fns)
+        : Lowering(t, key, f), functions(fns), module(m), program(top) {
+        declare(key->type == AST_PROGRAM ? key->left : key->right, program ? typing.globals : locals);
+    }
+
+    void lower_program(const ASTNode* root) {
+        statements(root->left);
+        if (!dead()) b.ret();
+        finish();
+    }
+
+    void lower_function(const ASTNode* node) {
+        int k = 0;
+        for (const ASTNode* p = node->left; p; p = p->next) {
+            if (p->type != AST_PARAMETER) continue;
+            typing.declare(locals, p->slot, fn.params[static_cast<std::size_t>(k)]);
+            write_local(p->slot, b.param(k++));
+        }
+        statement(node->right);
+        if (!dead()) b.ret(fn.result == Type::Void ? nullptr : b.undef(fn.result));
+        finish();
+    }
+
+private:
+    // Gives the slots of typed declarations their types before any code reads them
+    void declare(const ASTNode* node, Slots& slots) {
+        for (; node; node = node->next) {
+            if (is_function(node) || node->type == AST_CLASS || node->type == AST_STRUCT) continue;
+            if (node->type == AST_TYPED_VAR_DECL && node->slot >= 0) {
+                auto t = ouroboros_type(node->data_type);
+                if (t && *t != Type::Void) typing.declare(slots, node->slot, *t);
+            }
+            declare(node->left, slots);
+            declare(node->right, slots);
+        }
+    }
+
+    void statements(const ASTNode* node) {
+        for (; node && !dead(); node = node->next) {
+            if (node->type != AST_ELSE) statement(node); // Taken by the if before it
+        }
+    }
+
+    void statement(const ASTNode* node) {
+        if (!node) return; // An empty body
+        switch (node->type) {
+            case AST_BLOCK: statements(node->left); return;
+            case AST_VAR_DECL:
+            case AST_TYPED_VAR_DECL: {
+                Instr* value;
+                if (node->right) value = expr(node->right);
+                else value = initial(node->type == AST_TYPED_VAR_DECL ? ouroboros_type(node->data_type) : std::nullopt);
+                assign(node, value);
+                return;
+            }
+            case AST_ASSIGN:
+                assign(node->left, expr(node->right));
+                return;
+            case AST_PRINT:
+                b.call("print", {expr(node->left)}, Type::Void);
+                return;
+            case AST_RETURN: {
+                auto* value = node->left ? expr(node->left) : nullptr;
+                if (fn.result == Type::Void) b.ret();
+                else b.ret(b.convert(value ? value : b.undef(Type::Any), fn.result));
+                return;
+            }
+            case AST_IF: {
+                auto* cond = truth(expr(node->left));
+                const ASTNode* otherwise = node->next && node->next->type == AST_ELSE ? node->next->left : nullptr;
+                auto* then_block = b.create_block("then");
+                auto* else_block = otherwise ? b.create_block("else") : nullptr;
+                auto* join = b.create_block("endif");
+                b.cond_br(cond, then_block, else_block ? else_block : join);
+                enter(then_block);
+                statement(node->right);
+                jump(join);
+                if (else_block) {
+                    enter(else_block);
+                    statement(otherwise);
+                    jump(join);
+                }
+                enter(join);
+                return;
+            }
+            case AST_WHILE: {
+                auto* header = b.create_block("while");
+                auto* body = b.create_block("body");
+                auto* exit = b.create_block("endwhile");
+                b.br(header);
+                b.set_block(header); // Sealed once every continue has branched back
+                b.cond_br(truth(expr(node->left)), body, exit);
+                loop(body, {exit, header}, node->right);
+                vars.seal(header);
+                enter(exit);
+                return;
+            }
+            case AST_FOR: {
+                // Parts are taken in order, as the VM does
+                const ASTNode* init = node->left;
+                const ASTNode* cond = init ? init->next : nullptr;
+                const ASTNode* step = cond ? cond->next : nullptr;
+                if (init) {
+                    if (init->type == AST_VAR_DECL || init->type == AST_TYPED_VAR_DECL) statement(init);
+                    else expr(init);
+                }
+                auto* header = b.create_block("for");
+                auto* body = b.create_block("body");
+                auto* next = b.create_block("step");
+                auto* exit = b.create_block("endfor");
+                b.br(header);
+                b.set_block(header);
+                if (cond) b.cond_br(truth(expr(cond)), body, exit);
+                else b.br(body);
+                loop(body, {exit, next}, node->right);
+                enter(next);
+                if (!dead()) {
+                    if (step) expr(step);
+                    b.br(header);
+                }
+                vars.seal(header);
+                enter(exit);
+                return;
+            }
+            case AST_BREAK:
+            case AST_CONTINUE:
+                if (loops.empty()) throw Unsupported("has a break or continue outside a loop" + where(node));
+                b.br(node->type == AST_BREAK ? loops.back().exit : loops.back().next);
+                return;
+            case AST_FUNCTION:
+            case AST_TYPED_FUNCTION:
+                // Top-level functions are lowered on their own; others can see their caller's frame
+                if (!program) module.skipped.push_back(std::string(node->value) + ": nested functions are not lowered");
+                return;
+            case AST_CLASS:
+            case AST_STRUCT:
+                if (program) return; // Declarations: skipped by lower()
+                break;
+            case AST_CALL:
+            case AST_BINARY_OP:
+            case AST_UNARY_OP:
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                expr(node);
+                return;
+            default:
+                break;
+        }
+        throw Unsupported("has a statement the IR cannot express" + where(node));
+    }
+
+    void loop(Block* body, Loop targets, const ASTNode* stmt) {
+        enter(body);
+        loops.push_back(targets);
+        statement(stmt);
+        loops.pop_back();
+        jump(targets.next);
+    }
+
+    // What a declaration without an initializer holds: typed ones start at zero
+    Instr* initial(std::optional<Type> type) {
+        switch (type.value_or(Type::Any)) {
+            case Type::Int: return b.constant(Type::Int, std::int64_t{0});
+            case Type::Float: return b.constant(Type::Float, 0.0);
+            case Type::Bool: return b.constant(Type::Bool, false);
+            case Type::String: return b.constant(Type::String, std::string());
+            default: return b.undef(Type::Any);
+        }
+    }
+
+    Instr* truth(Instr* value) { return b.convert(value, Type::Bool); }
+
+    // The frame a resolved identifier's slot is in
+    bool global(const ASTNode* id) const { return program ? id->depth == 0 : id->depth == 1; }
+
+    Instr* read(const ASTNode* id) {
+        if (id->slot < 0) throw Unsupported("looks up " + std::string(id->value) + " by name" + where(id));
+        if (global(id)) return read_global(id->slot, id->value);
+        if (id->depth == 0) return read_local(id->slot);
+        throw Unsupported("reads " + std::string(id->value) + " from an enclosing function" + where(id));
+    }
+
+    Instr* assign(const ASTNode* target, Instr* value) {
+        if (target->type != AST_IDENTIFIER && target->type != AST_VAR_DECL && target->type != AST_TYPED_VAR_DECL) {
+            throw Unsupported("assigns to something other than a variable" + where(target));
+        }
+        if (target->slot < 0) throw Unsupported("assigns " + std::string(target->value) + " by name" + where(target));
+        if (global(target)) return write_global(target->slot, target->value, value);
+        if (target->depth == 0) return write_local(target->slot, value);
+        throw Unsupported("assigns " + std::string(target->value) + " in an enclosing function" + where(target));
+    }
+
+    // An operation on two values: ints stay ints, ints and floats meet as
+    // floats, and anything else (or an int division, which can give either)
+    // is left to the runtime
+    Instr* arithmetic(Op op, Instr* left, Instr* right) {
+        auto numeric = [](const Instr* v) { return v->type == Type::Int || v->type == Type::Float; };
+        Type type = Type::Any;
+        if (left->type == Type::Int && right->type == Type::Int) type = op == Op::Div ? Type::Any : Type::Int;
+        else if (numeric(left) && numeric(right)) type = Type::Float;
+        return b.binary(op, b.convert(left, type), b.convert(right, type));
+    }
+
+    Instr* compare(Op op, Instr* left, Instr* right) {
+        auto numeric = [](const Instr* v) { return v->type == Type::Int || v->type == Type::Float; };
+        Type type = Type::Any;
+        if (left->type == right->type) type = left->type;
+        else if (numeric(left) && numeric(right)) type = Type::Float;
+        return b.binary(op, b.convert(left, type), b.convert(right, type));
+    }
+
+    // `a && b` and `a || b`: true or false, the right side run only when needed
+    Instr* logical(bool is_or, const ASTNode* node) {
+        auto* left = truth(expr(node->left));
+        auto* decided = b.constant(Type::Bool, is_or);
+        auto* from = b.current();
+        auto* rhs = b.create_block(is_or ? "or" : "and");
+        auto* join = b.create_block(is_or ? "endor" : "endand");
+        if (is_or) b.cond_br(left, join, rhs);
+        else b.cond_br(left, rhs, join);
+        enter(rhs);
+        auto* right = truth(expr(node->right));
+        auto* rhs_end = b.current();
+        b.br(join);
+        enter(join);
+        auto* phi = b.phi(Type::Bool, join);
+        Builder::add_incoming(phi, decided, from);
+        Builder::add_incoming(phi, right, rhs_end);
+        return phi;
+    }
+
+    static std::optional<Op> binary_op(std::string_view op) {
+        if (op == "+") return Op::Add;
+        if (op == "-") return Op::Sub;
+        if (op == "*") return Op::Mul;
+        if (op == "/") return Op::Div;
+        if (op == "%") return Op::Mod;
+        return std::nullopt;
+    }
+
+    static std::optional<Op> comparison(std::string_view op) {
+        if (op == "==") return Op::Eq;
+        if (op == "!=") return Op::Ne;
+        if (op == "<") return Op::Lt;
+        if (op == "<=") return Op::Le;
+        if (op == ">") return Op::Gt;
+        if (op == ">=") return Op::Ge;
+        return std::nullopt;
+    }
+
+    Instr* literal(const ASTNode* node) {
+        std::string_view t = node->data_type;
+        if (t == "int") return b.constant(Type::Int, static_cast<std::int64_t>(std::strtoll(node->value, nullptr, 10)));
+        if (t == "float") return b.constant(Type::Float, std::strtod(node->value, nullptr));
+        if (t == "bool") return b.constant(Type::Bool, std::strcmp(node->value, "true") == 0);
+        if (t == "string") return b.constant(Type::String, std::string(node->value));
+        if (t == "null") return b.constant(Type::Any, {});
+        throw Unsupported("has a literal of unknown type" + where(node));
+    }
+
+    Instr* expr(const ASTNode* node) {
+        switch (node->type) {
+            case AST_LITERAL: return literal(node);
+            case AST_IDENTIFIER: return read(node);
+            case AST_ASSIGN: return assign(node->left, expr(node->right));
+            case AST_BINARY_OP: {
+                std::string_view op = node->value;
+                if (op == "&&" || op == "||") return logical(op == "||", node);
+                if (op == "=") return assign(node->left, expr(node->right));
+                if (op.size() == 2 && op[1] == '=' && binary_op(op.substr(0, 1))) {
+                    auto* right = expr(node->right); // The right side runs first
+                    return assign(node->left, arithmetic(*binary_op(op.substr(0, 1)), read(node->left), right));
+                }
+                if (auto arith = binary_op(op)) {
+                    auto* left = expr(node->left);
+                    return arithmetic(*arith, left, expr(node->right));
+                }
+                if (auto cmp = comparison(op)) {
+                    auto* left = expr(node->left);
+                    return compare(*cmp, left, expr(node->right));
+                }
+                break;
+            }
+            case AST_UNARY_OP: {
+                std::string_view op = node->value;
+                if (op == "!") return b.unary(Op::Not, truth(expr(node->left)));
+                if (op == "-" || op == "+") {
+                    auto* value = expr(node->left);
+                    if (value->type != Type::Int && value->type != Type::Float) value = b.convert(value, Type::Any);
+                    return op == "-" ? b.unary(Op::Neg, value) : value;
+                }
+                if (op == "++" || op == "--") {
+                    // Both forms give the new value
+                    auto* value = read(node->left);
+                    Instr* one;
+                    if (value->type == Type::Float) one = b.constant(Type::Float, 1.0);
+                    else if (value->type == Type::Int) one = b.constant(Type::Int, std::int64_t{1});
+                    else one = b.constant(Type::Any, std::int64_t{1});
+                    return assign(node->left, b.binary(op == "++" ? Op::Add : Op::Sub, value, one));
+                }
+                break;
+            }
+            case AST_CALL: {
+                if (node->right) throw Unsupported("calls a method" + where(node));
+                std::vector<Instr*> args;
+                for (const ASTNode* a = node->left; a; a = a->next) args.push_back(expr(a));
+                Type type = Type::Any;
+                if (auto it = functions.find(node->value); it != functions.end()) {
+                    type = result_type(it->second);
+                    auto params = param_types(it->second);
+                    if (params.size() == args.size()) {
+                        for (std::size_t k = 0; k < args.size(); ++k) args[k] = b.convert(args[k], params[k]);
+                    }
+                }
+                auto* value = b.call(node->value, std::move(args), type);
+                return type == Type::Void ? b.undef(Type::Any) : value;
+            }
+            default:
+                break;
+        }
+        throw Unsupported("has an expression the IR cannot express" + where(node));
+    }
+};
+
+} // namespace
+
+Module lower(const StmtList& program) {
+    std::vector<OuroFunction> decls;
+    collect(program, 0, decls);
+    std::map<std::string_view, const FnDeclStmt*> functions;
+    for (const auto& d : decls) functions[d.decl->name] = d.decl;
+
+    return until_stable([&](Module& module, Typing& typing) {
+        // The top-level code first: it settles the globals' types before the functions read them
+        auto top = std::make_unique<Function>();
+        top->name = PROGRAM;
+        try {
+            OuroLowering(typing, *top, &program, 0, functions).program(program);
+            module.functions.push_back(std::move(top));
+        } catch (const Unsupported& e) {
+            module.skipped.push_back(std::string(PROGRAM) + ": " + e.what());
+        }
+        for (const auto& d : decls) {
+            auto fn = std::make_unique<Function>();
+            fn->name = d.decl->name;
+            for (const auto& p : d.decl->params) fn->params.push_back(ouro_type(p.second));
+            fn->result = ouro_type(d.decl->return_type);
+            try {
+                OuroLowering(typing, *fn, d.decl, d.nesting, functions).function(*d.decl);
+                module.functions.push_back(std::move(fn));
+            } catch (const Unsupported& e) {
+                module.skipped.push_back(fn->name + ": " + e.what());
+            }
+        }
+    });
+}
+
+Module lower(const ASTNode* program) {
+    std::map<std::string_view, const ASTNode*> functions;
+    for (const ASTNode* n = program->left; n; n = n->next) {
+        if (is_function(n)) functions[n->value] = n;
+    }
+
+    return until_stable([&](Module& module, Typing& typing) {
+        auto top = std::make_unique<Function>();
+        top->name = PROGRAM;
+        try {
+            OuroborosLowering(typing, *top, program, true, module, functions).lower_program(program);
+            module.functions.push_back(std::move(top));
+        } catch (const Unsupported& e) {
+            module.skipped.push_back(std::string(PROGRAM) + ": " + e.what());
+        }
+        for (const ASTNode* n = program->left; n; n = n->next) {
+            if (n->type == AST_CLASS || n->type == AST_STRUCT) {
+                module.skipped.push_back(std::string(n->value) + ": classes and structs are not lowered");
+                continue;
+            }
+            if (!is_function(n)) continue;
+            auto fn = std::make_unique<Function>();
+            fn->name = n->value;
+            fn->params = param_types(n);
+            fn->result = result_type(n);
+            try {
+                OuroborosLowering(typing, *fn, n, false, module, functions).lower_function(n);
+                module.functions.push_back(std::move(fn));
+            } catch (const Unsupported& e) {
+                module.skipped.push_back(fn->name + ": " + e.what());
+            }
+        }
+    });
+}
+
+} // namespace ouro::ir
@@ -0,0 +1,30 @@
+#pragma once
+#include "ir.h"
+#include "ourolang/ast.h"
+
+struct ASTNode; // ouroboros-lang/ouroboros/ast_types.h
+
+namespace ouro::ir {
+
+// Each front end's program becomes one function per declared function, plus
+// one named PROGRAM for its top-level code, whose variables live in memory
+// (LoadGlobal/StoreGlobal) because every function can see them. A function
+// the IR cannot express yet (an async one, one that captures an enclosing
+// function's locals, one using classes, arrays or other dynamic features) is
+// left out and listed in Module::skipped instead.
+//
+// Variables declared without a type take the type of the values written to
+// them, or Any when those disagree.
+inline constexpr std::string_view PROGRAM = "<program>";
+
+// From the ouro:: front end, after TypeChecker and Resolver. Numbers are
+// doubles there whatever they are declared, so int and float both lower to
+// Float; `return` sets the value a function ends with rather than leaving it,
+// as the interpreter's does.
+Module lower(const StmtList& program);
+
+// From ouroboros-lang, after analyze_program and resolve_program. Declared
+// types are trusted: arguments and assignments are converted to them.
+Module lower(const ASTNode* program);
+
+} // namespace ouro::ir
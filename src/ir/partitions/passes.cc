@@ -1,3 +0,0 @@
-export module ir:passes;
-
-export void run_passes();
@@ -1,3 +0,0 @@
-export module ir:transforms;
-
-export void apply_transforms();
@@ -0,0 +1,900 @@
+#include "passes.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+
+namespace ouro::ir {
+namespace {
+
+// --- Editing helpers -----------------------------------------------------------
+
+std::unique_ptr<Instr> make(Function& fn, Op op, Type type) {
+    auto i = std::make_unique<Instr>();
+    i->op = op;
+    i->type = type;
+    i->id = fn.next_instr++;
+    return i;
+}
+
+Instr* insert(Block* b, std::size_t at, std::unique_ptr<Instr> instr) {
+    instr->parent = b;
+    return b->instrs.insert(b->instrs.begin() + static_cast<std::ptrdiff_t>(at), std::move(instr))->get();
+}
+
+// Before the block's terminator
+Instr* insert_at_end(Block* b, std::unique_ptr<Instr> instr) { return insert(b, b->instrs.size() - 1, std::move(instr)); }
+
+std::size_t position(const Instr* i) {
+    const auto& instrs = i->parent->instrs;
+    return static_cast<std::size_t>(std::find_if(instrs.begin(), instrs.end(), [&](const auto& x) { return x.get() == i; }) -
+                                    instrs.begin());
+}
+
+std::unique_ptr<Instr> take(Instr* i) {
+    auto& instrs = i->parent->instrs;
+    auto at = instrs.begin() + static_cast<std::ptrdiff_t>(position(i));
+    auto owned = std::move(*at);
+    instrs.erase(at);
+    return owned;
+}
+
+void erase(Instr* i) { take(i); }
+
+std::unique_ptr<Instr> constant(Function& fn, Type type, Constant value) {
+    auto i = make(fn, Op::Const, type);
+    i->constant = std::move(value);
+    return i;
+}
+
+// Edges from `old` into `b` now come from `now`
+void rename_pred(Block* b, Block* old, Block* now) {
+    std::replace(b->preds.begin(), b->preds.end(), old, now);
+    for (auto& i : b->instrs) {
+        if (i->op != Op::Phi) break;
+        std::replace(i->blocks.begin(), i->blocks.end(), old, now);
+    }
+}
+
+// Forgets one edge from `from` into `to`, and the phi operands that came along it
+void remove_edge(Block* from, Block* to) {
+    auto pred = std::find(to->preds.begin(), to->preds.end(), from);
+    if (pred == to->preds.end()) return;
+    to->preds.erase(pred);
+    for (auto& i : to->instrs) {
+        if (i->op != Op::Phi) break;
+        auto at = std::find(i->blocks.begin(), i->blocks.end(), from) - i->blocks.begin();
+        i->blocks.erase(i->blocks.begin() + at);
+        i->operands.erase(i->operands.begin() + at);
+    }
+}
+
+std::optional<std::int64_t> int_constant(const Instr* i) {
+    if (i->op != Op::Const || i->type != Type::Int) return std::nullopt;
+    return std::get<std::int64_t>(i->constant);
+}
+
+std::optional<double> float_constant(const Instr* i) {
+    if (i->op != Op::Const || i->type != Type::Float) return std::nullopt;
+    return std::get<double>(i->constant);
+}
+
+// Ints wrap around rather than overflow
+std::int64_t wrap(std::uint64_t v) { return static_cast<std::int64_t>(v); }
+
+bool pure(const Instr* i) {
+    switch (i->op) {
+        case Op::Const: case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Mod:
+        case Op::Neg: case Op::Not: case Op::Eq: case Op::Ne: case Op::Lt: case Op::Le: case Op::Gt: case Op::Ge:
+        case Op::Convert: case Op::Phi:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool numeric(Type t) { return t == Type::Int || t == Type::Float; }
+
+// Whether running the instruction where it did not run before is safe
+bool cannot_fail(const Instr* i) {
+    switch (i->op) {
+        case Op::Const: case Op::Not: case Op::Eq: case Op::Ne:
+            return true;
+        case Op::Lt: case Op::Le: case Op::Gt: case Op::Ge:
+            return i->operands[0]->type != Type::Any;
+        case Op::Add: case Op::Sub: case Op::Mul: case Op::Neg:
+            return numeric(i->type);
+        case Op::Div: case Op::Mod: {
+            if (i->type == Type::Float) return true;
+            auto divisor = int_constant(i->operands[1]);
+            return i->type == Type::Int && divisor && *divisor != 0 && *divisor != -1;
+        }
+        case Op::Convert: {
+            auto from = i->operands[0]->type;
+            return i->type == Type::Bool || i->type == Type::Any || from == Type::Bool || numeric(from);
+        }
+        case Op::LoadGlobal:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Blocks the entry reaches, each before those it dominates
+std::vector<Block*> reverse_postorder(Function& fn) {
+    std::vector<Block*> order;
+    std::set<const Block*> seen;
+    std::function<void(Block*)> visit = [&](Block* b) {
+        if (!seen.insert(b).second) return;
+        for (auto* s : b->succs()) visit(s);
+        order.push_back(b);
+    };
+    visit(fn.entry());
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// --- Loops ---------------------------------------------------------------------
+
+// A natural loop: the header and every block that reaches a branch back to
+// it without passing through it
+struct Loop {
+    Block* header;
+    std::set<Block*> body;
+
+    std::vector<Block*> latches() const {
+        std::vector<Block*> out;
+        for (auto* p : header->preds) {
+            if (body.contains(p) && std::ranges::find(out, p) == out.end()) out.push_back(p);
+        }
+        return out;
+    }
+    // The block outside that alone branches to the header, and only there
+    Block* preheader() const {
+        Block* outside = nullptr;
+        for (auto* p : header->preds) {
+            if (body.contains(p)) continue;
+            if (outside) return nullptr;
+            outside = p;
+        }
+        return outside && outside->terminator()->op == Op::Br ? outside : nullptr;
+    }
+};
+
+// Innermost first
+std::vector<Loop> find_loops(Function& fn, const Dominators& dom) {
+    std::map<Block*, std::set<Block*>> bodies;
+    for (auto& b : fn.blocks) {
+        if (!dom.reachable(b.get())) continue;
+        for (auto* header : b->succs()) {
+            if (!dom.dominates(header, b.get())) continue;
+            auto& body = bodies[header];
+            body.insert(header);
+            std::vector<Block*> work{b.get()};
+            while (!work.empty()) {
+                auto* x = work.back();
+                work.pop_back();
+                if (!body.insert(x).second) continue;
+                for (auto* p : x->preds) {
+                    if (dom.reachable(p)) work.push_back(p);
+                }
+            }
+        }
+    }
+    std::vector<Loop> loops;
+    for (auto& b : fn.blocks) { // In the function's order, not the pointers'
+        if (auto it = bodies.find(b.get()); it != bodies.end()) loops.push_back({b.get(), std::move(it->second)});
+    }
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) { return a.body.size() < b.body.size(); });
+    return loops;
+}
+
+// Routes the edges entering the loop from outside through a new block, whose
+// phis merge what the header's did from those edges
+void add_preheader(Function& fn, const Loop& loop) {
+    Block* header = loop.header;
+    Builder b(fn);
+    Block* pre = b.create_block(header->name + ".pre");
+    std::vector<Block*> outside;
+    for (auto* p : header->preds) {
+        if (!loop.body.contains(p)) outside.push_back(p);
+    }
+    for (auto* p : outside) {
+        for (auto*& t : p->terminator()->blocks) {
+            if (t == header) t = pre;
+        }
+    }
+    b.set_block(pre);
+    for (auto& i : header->instrs) {
+        if (i->op != Op::Phi) break;
+        std::vector<std::pair<Instr*, Block*>> incoming;
+        for (std::size_t k = i->operands.size(); k-- > 0;) {
+            if (loop.body.contains(i->blocks[k])) continue;
+            incoming.emplace_back(i->operands[k], i->blocks[k]);
+            i->operands.erase(i->operands.begin() + static_cast<std::ptrdiff_t>(k));
+            i->blocks.erase(i->blocks.begin() + static_cast<std::ptrdiff_t>(k));
+        }
+        Instr* value = incoming.front().first;
+        bool same = std::ranges::all_of(incoming, [&](const auto& in) { return in.first == value; });
+        if (!same) {
+            value = b.phi(i->type, pre);
+            for (auto it = incoming.rbegin(); it != incoming.rend(); ++it) Builder::add_incoming(value, it->first, it->second);
+        }
+        Builder::add_incoming(i.get(), value, pre);
+    }
+    std::erase_if(header->preds, [&](Block* p) { return !loop.body.contains(p); });
+    pre->preds = outside;
+    b.br(header);
+
+    // Listed just before the header, as if the front end had made it
+    auto at = [&](const Block* x) {
+        return std::find_if(fn.blocks.begin(), fn.blocks.end(), [&](const auto& y) { return y.get() == x; });
+    };
+    auto owned = std::move(*at(pre));
+    fn.blocks.erase(at(pre));
+    fn.blocks.insert(at(header), std::move(owned));
+}
+
+// --- Constant folding ----------------------------------------------------------
+
+template <class T>
+std::optional<Constant> compare(Op op, const T& x, const T& y) {
+    switch (op) {
+        case Op::Eq: return x == y;
+        case Op::Ne: return x != y;
+        case Op::Lt: return x < y;
+        case Op::Le: return x <= y;
+        case Op::Gt: return x > y;
+        case Op::Ge: return x >= y;
+        default: return std::nullopt;
+    }
+}
+
+std::optional<Constant> evaluate(const Instr& i) {
+    if (i.operands.empty() || !pure(&i) || i.op == Op::Phi) return std::nullopt;
+    for (auto* o : i.operands) {
+        if (o->op != Op::Const || o->type == Type::Any) return std::nullopt;
+    }
+    const Constant& a = i.operands[0]->constant;
+    switch (i.op) {
+        case Op::Neg:
+            if (i.type == Type::Int) return wrap(0 - static_cast<std::uint64_t>(std::get<std::int64_t>(a)));
+            if (i.type == Type::Float) return -std::get<double>(a);
+            return std::nullopt;
+        case Op::Not: return !std::get<bool>(a);
+        case Op::Convert:
+            if (i.type == Type::Float && i.operands[0]->type == Type::Int) return static_cast<double>(std::get<std::int64_t>(a));
+            return std::nullopt;
+        default: break;
+    }
+    const Constant& c = i.operands[1]->constant;
+    if (i.op >= Op::Eq && i.op <= Op::Ge) {
+        switch (i.operands[0]->type) {
+            case Type::Int: return compare(i.op, std::get<std::int64_t>(a), std::get<std::int64_t>(c));
+            case Type::Float: return compare(i.op, std::get<double>(a), std::get<double>(c));
+            case Type::String: return compare(i.op, std::get<std::string>(a), std::get<std::string>(c));
+            case Type::Bool:
+                if (i.op == Op::Eq || i.op == Op::Ne) return compare(i.op, std::get<bool>(a), std::get<bool>(c));
+                return std::nullopt;
+            default: return std::nullopt;
+        }
+    }
+    if (i.type == Type::Int) {
+        auto x = std::get<std::int64_t>(a), y = std::get<std::int64_t>(c);
+        auto ux = static_cast<std::uint64_t>(x), uy = static_cast<std::uint64_t>(y);
+        switch (i.op) {
+            case Op::Add: return wrap(ux + uy);
+            case Op::Sub: return wrap(ux - uy);
+            case Op::Mul: return wrap(ux * uy);
+            case Op::Div: case Op::Mod:
+                if (y == 0 || (y == -1 && x == INT64_MIN)) return std::nullopt; // Left to fail when run
+                return i.op == Op::Div ? x / y : x % y;
+            default: return std::nullopt;
+        }
+    }
+    if (i.type == Type::Float) {
+        auto x = std::get<double>(a), y = std::get<double>(c);
+        switch (i.op) {
+            case Op::Add: return x + y;
+            case Op::Sub: return x - y;
+            case Op::Mul: return x * y;
+            case Op::Div: return x / y;
+            default: return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+// The one value a phi merges besides itself, if it merges one
+Instr* trivial(const Instr* phi) {
+    Instr* same = nullptr;
+    for (auto* o : phi->operands) {
+        if (o == same || o == phi) continue;
+        if (same) return nullptr;
+        same = o;
+    }
+    return same;
+}
+
+// --- Common subexpressions -----------------------------------------------------
+
+// Doubles by their bits, so 0.0 and -0.0 stay apart and NaN orders
+using KeyConstant = std::variant<std::monostate, bool, std::int64_t, std::uint64_t, std::string>;
+using Key = std::tuple<Op, Type, std::vector<unsigned>, std::vector<unsigned>, KeyConstant, std::string, int>;
+
+Key key(const Instr& i) {
+    std::vector<unsigned> operands, blocks;
+    for (auto* o : i.operands) operands.push_back(o->id);
+    if (i.op == Op::Phi) {
+        std::vector<std::pair<unsigned, unsigned>> incoming;
+        for (std::size_t k = 0; k < i.operands.size(); ++k) incoming.emplace_back(i.blocks[k]->id, i.operands[k]->id);
+        std::sort(incoming.begin(), incoming.end());
+        operands.clear();
+        for (auto [block, value] : incoming) {
+            blocks.push_back(block);
+            operands.push_back(value);
+        }
+    }
+    bool commutes = ((i.op == Op::Add || i.op == Op::Mul) && numeric(i.type)) || i.op == Op::Eq || i.op == Op::Ne;
+    if (commutes) std::sort(operands.begin(), operands.end());
+    KeyConstant c;
+    std::visit(
+        [&](const auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, double>) c = std::bit_cast<std::uint64_t>(v);
+            else c = v;
+        },
+        i.constant);
+    return {i.op, i.type, std::move(operands), std::move(blocks), std::move(c), i.name, i.index};
+}
+
+class CommonValues {
+    Function& fn;
+    std::map<const Block*, std::vector<Block*>> children;
+    std::map<Key, Instr*> available;
+    bool changed = false;
+
+public:
+    explicit CommonValues(Function& f) : fn(f) {
+        Dominators dom(fn);
+        for (auto& b : fn.blocks) {
+            if (b.get() != fn.entry() && dom.reachable(b.get())) children[dom.immediate(b.get())].push_back(b.get());
+        }
+    }
+
+    bool run() {
+        visit(fn.entry());
+        return changed;
+    }
+
+private:
+    void replace(Instr* i, Instr* with) {
+        fn.replace_uses(i, with);
+        erase(i);
+        changed = true;
+    }
+
+    // What is available in a block stays so in the blocks it dominates
+    void visit(Block* b) {
+        std::vector<Key> added;
+        std::map<int, Instr*> globals; // The value each slot is known to hold here
+        for (std::size_t k = 0; k < b->instrs.size();) {
+            Instr* i = b->instrs[k].get();
+            if (i->op == Op::LoadGlobal) {
+                auto known = globals.find(i->index);
+                if (known != globals.end() && known->second->type == i->type) {
+                    replace(i, known->second);
+                    continue;
+                }
+                globals[i->index] = i;
+            } else if (i->op == Op::StoreGlobal) {
+                globals[i->index] = i->operands[0];
+            } else if (i->op == Op::Call) {
+                globals.clear();
+            } else if (pure(i)) {
+                auto [it, fresh] = available.emplace(key(*i), i);
+                if (!fresh) {
+                    replace(i, it->second);
+                    continue;
+                }
+                added.push_back(it->first);
+            }
+            ++k;
+        }
+        for (auto* child : children[b]) visit(child);
+        for (const auto& k : added) available.erase(k);
+    }
+};
+
+// --- Strength reduction --------------------------------------------------------
+
+// x * 2 ** n for a double the reciprocal of which is exact
+bool exact_reciprocal(double d) {
+    int exponent;
+    return std::frexp(d, &exponent) == 0.5 && std::isnormal(1 / d);
+}
+
+// One instruction rewritten in place, or replaced by an operand
+bool simplify(Function& fn, Instr* i) {
+    if (i->operands.size() != 2 || !numeric(i->type)) return false;
+    Instr* x = i->operands[0];
+    Instr* y = i->operands[1];
+    auto becomes_constant = [&](Constant c) {
+        i->op = Op::Const;
+        i->operands.clear();
+        i->constant = std::move(c);
+        return true;
+    };
+    auto becomes = [&](Op op, std::vector<Instr*> operands) {
+        i->op = op;
+        i->operands = std::move(operands);
+        return true;
+    };
+    auto replaced_by = [&](Instr* v) {
+        fn.replace_uses(i, v);
+        erase(i);
+        return true;
+    };
+    if (i->type == Type::Int) {
+        if (i->op == Op::Mul) {
+            if (int_constant(x)) std::swap(x, y);
+            auto k = int_constant(y);
+            if (!k) return false;
+            if (*k == 0) return becomes_constant(std::int64_t{0});
+            if (*k == 1) return replaced_by(x);
+            if (*k == -1) return becomes(Op::Neg, {x});
+            if (*k == 2) return becomes(Op::Add, {x, x});
+            return false;
+        }
+        auto k = int_constant(y);
+        switch (i->op) {
+            case Op::Add:
+                if (int_constant(x) == 0) return replaced_by(y);
+                if (k == 0) return replaced_by(x);
+                return false;
+            case Op::Sub:
+                if (x == y) return becomes_constant(std::int64_t{0});
+                if (k == 0) return replaced_by(x);
+                return false;
+            case Op::Div: return k == 1 ? replaced_by(x) : false;
+            case Op::Mod: return k == 1 || k == -1 ? becomes_constant(std::int64_t{0}) : false;
+            default: return false;
+        }
+    }
+    switch (i->op) {
+        case Op::Mul: {
+            if (float_constant(x)) std::swap(x, y);
+            auto k = float_constant(y);
+            if (k == 1.0) return replaced_by(x);
+            if (k == -1.0) return becomes(Op::Neg, {x});
+            if (k == 2.0) return becomes(Op::Add, {x, x});
+            return false;
+        }
+        case Op::Sub: return float_constant(y) == 0.0 && !std::signbit(*float_constant(y)) ? replaced_by(x) : false;
+        case Op::Div: {
+            auto k = float_constant(y);
+            if (k == 1.0) return replaced_by(x);
+            if (!k || !exact_reciprocal(*k)) return false;
+            auto* inverse = insert(i->parent, position(i), constant(fn, Type::Float, 1 / *k));
+            return becomes(Op::Mul, {x, inverse});
+        }
+        default: return false;
+    }
+}
+
+// A header phi counting by a constant step, and values of it times a constant
+// within the loop: each product becomes a phi of its own, stepping by the
+// product of the two constants.
+bool reduce_induction(Function& fn, const Loop& loop) {
+    Block* pre = loop.preheader();
+    auto latches = loop.latches();
+    if (!pre || latches.size() != 1) return false;
+    Block* latch = latches.front();
+    bool changed = false;
+    std::vector<Instr*> counters;
+    for (auto& i : loop.header->instrs) {
+        if (i->op != Op::Phi) break;
+        if (i->type == Type::Int && i->operands.size() == 2) counters.push_back(i.get());
+    }
+    for (auto* counter : counters) {
+        auto from = [&](Block* b) { return counter->operands[counter->blocks[0] == b ? 0 : 1]; };
+        Instr* start = from(pre);
+        Instr* next = from(latch);
+        if (next->op != Op::Add || next->type != Type::Int) continue;
+        Instr* other = next->operands[0] == counter ? next->operands[1] : next->operands[0];
+        auto step = int_constant(other);
+        if (!step || (next->operands[0] != counter && next->operands[1] != counter)) continue;
+
+        std::vector<std::pair<Instr*, std::int64_t>> products;
+        for (auto* b : loop.body) {
+            for (auto& i : b->instrs) {
+                if (i->op != Op::Mul || i->type != Type::Int) continue;
+                auto* factor = i->operands[0] == counter ? i->operands[1] : i->operands[1] == counter ? i->operands[0] : nullptr;
+                auto k = factor ? int_constant(factor) : std::nullopt;
+                if (k) products.emplace_back(i.get(), *k);
+            }
+        }
+        std::sort(products.begin(), products.end(), [](const auto& x, const auto& y) { return x.first->id < y.first->id; });
+        for (auto [product, k] : products) {
+            auto* factor = insert_at_end(pre, constant(fn, Type::Int, k));
+            auto first = make(fn, Op::Mul, Type::Int);
+            first->operands = {start, factor};
+            auto* initial = insert_at_end(pre, std::move(first));
+            auto* stride = insert_at_end(pre, constant(fn, Type::Int, wrap(static_cast<std::uint64_t>(*step) * static_cast<std::uint64_t>(k))));
+            Builder b(fn);
+            auto* phi = b.phi(Type::Int, loop.header);
+            auto advance = make(fn, Op::Add, Type::Int);
+            advance->operands = {phi, stride};
+            auto* advanced = insert_at_end(latch, std::move(advance));
+            for (std::size_t n = 0; n < counter->blocks.size(); ++n) {
+                Builder::add_incoming(phi, counter->blocks[n] == pre ? initial : advanced, counter->blocks[n]);
+            }
+            fn.replace_uses(product, phi);
+            erase(product);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// --- Inlining ------------------------------------------------------------------
+
+std::size_t size(const Function& fn) {
+    std::size_t n = 0;
+    for (const auto& b : fn.blocks) {
+        n += static_cast<std::size_t>(std::ranges::count_if(b->instrs, [](const auto& i) { return i->op != Op::Param; }));
+    }
+    return n;
+}
+
+// Splits the call's block after it, and branches from there through a copy of
+// the callee, its returns leading to the rest of the block
+void inline_call(Function& fn, Instr* call, const Function& callee) {
+    Block* b = call->parent;
+    Builder builder(fn);
+    std::map<const Block*, Block*> blocks;
+    std::map<const Instr*, Instr*> values;
+    for (const auto& cb : callee.blocks) blocks[cb.get()] = builder.create_block(callee.name + "." + cb->name);
+    Block* after = builder.create_block(b->name + ".after");
+
+    auto at = position(call);
+    for (std::size_t k = at + 1; k < b->instrs.size(); ++k) {
+        b->instrs[k]->parent = after;
+        after->instrs.push_back(std::move(b->instrs[k]));
+    }
+    b->instrs.resize(at + 1);
+    for (auto* s : after->succs()) rename_pred(s, b, after);
+
+    for (const auto& cb : callee.blocks) {
+        for (const auto& ci : cb->instrs) {
+            if (ci->op == Op::Param) {
+                values[ci.get()] = call->operands[static_cast<std::size_t>(ci->index)];
+                continue;
+            }
+            auto copy = make(fn, ci->op, ci->type);
+            copy->constant = ci->constant;
+            copy->name = ci->name;
+            copy->index = ci->index;
+            values[ci.get()] = insert(blocks[cb.get()], blocks[cb.get()]->instrs.size(), std::move(copy));
+        }
+    }
+    std::vector<std::pair<Instr*, Block*>> returns;
+    for (const auto& cb : callee.blocks) {
+        Block* copy = blocks[cb.get()];
+        for (auto* p : cb->preds) copy->preds.push_back(blocks[p]);
+        for (const auto& ci : cb->instrs) {
+            if (ci->op == Op::Param) continue;
+            Instr* i = values[ci.get()];
+            for (auto* o : ci->operands) i->operands.push_back(values[o]);
+            for (auto* t : ci->blocks) i->blocks.push_back(blocks[t]);
+            if (i->op == Op::Ret) {
+                returns.emplace_back(i->operands.empty() ? nullptr : i->operands[0], copy);
+                i->op = Op::Br;
+                i->operands.clear();
+                i->blocks = {after};
+                after->preds.push_back(copy);
+            }
+        }
+    }
+
+    if (call->type != Type::Void) {
+        Instr* result;
+        if (returns.empty()) {
+            result = builder.undef(call->type); // The callee never returns
+        } else if (returns.size() == 1) {
+            result = returns.front().first;
+        } else {
+            result = builder.phi(call->type, after);
+            for (auto [value, from] : returns) Builder::add_incoming(result, value, from);
+        }
+        fn.replace_uses(call, result);
+    }
+    erase(call);
+    builder.set_block(b);
+    builder.br(blocks[callee.entry()]);
+
+    // Listed after the call's block, in the callee's order
+    auto first = fn.blocks.end() - static_cast<std::ptrdiff_t>(callee.blocks.size() + 1);
+    auto where = std::find_if(fn.blocks.begin(), fn.blocks.end(), [&](const auto& x) { return x.get() == b; }) + 1;
+    std::rotate(where, first, fn.blocks.end());
+}
+
+} // namespace
+
+// --- Passes --------------------------------------------------------------------
+
+bool inline_calls(Module& module, std::size_t budget) {
+    std::map<const Function*, std::set<const Function*>> callees;
+    for (const auto& f : module.functions) {
+        for (const auto& b : f->blocks) {
+            for (const auto& i : b->instrs) {
+                if (i->op != Op::Call) continue;
+                if (auto* g = module.find(i->name)) callees[f.get()].insert(g);
+            }
+        }
+    }
+    // Functions that can reach themselves through the calls they make
+    std::set<const Function*> recursive;
+    for (const auto& f : module.functions) {
+        std::set<const Function*> seen;
+        std::vector<const Function*> work(callees[f.get()].begin(), callees[f.get()].end());
+        while (!work.empty()) {
+            auto* g = work.back();
+            work.pop_back();
+            if (g == f.get()) {
+                recursive.insert(g);
+                break;
+            }
+            if (!seen.insert(g).second) continue;
+            work.insert(work.end(), callees[g].begin(), callees[g].end());
+        }
+    }
+
+    auto inlinable = [&](const Function& caller, const Instr& call) -> const Function* {
+        auto* g = module.find(call.name);
+        if (!g || g == &caller || recursive.contains(g) || size(*g) > budget) return nullptr;
+        if (call.type != g->result || call.operands.size() != g->params.size()) return nullptr;
+        for (std::size_t k = 0; k < g->params.size(); ++k) {
+            if (call.operands[k]->type != g->params[k]) return nullptr;
+        }
+        return g;
+    };
+    bool changed = false;
+    for (auto& f : module.functions) {
+        // Callees are not recursive, so copying their calls in ends
+        for (bool again = true; again;) {
+            again = false;
+            for (std::size_t n = 0; n < f->blocks.size() && !again; ++n) {
+                for (const auto& i : f->blocks[n]->instrs) {
+                    if (i->op != Op::Call) continue;
+                    if (auto* g = inlinable(*f, *i)) {
+                        inline_call(*f, i.get(), *g);
+                        again = changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+bool fold_constants(Function& fn) {
+    bool changed = false, branches = false;
+    for (bool again = true; again;) {
+        again = false;
+        for (auto& b : fn.blocks) {
+            for (std::size_t k = 0; k < b->instrs.size();) {
+                Instr* i = b->instrs[k].get();
+                if (i->op == Op::Phi) {
+                    if (auto* same = trivial(i)) {
+                        fn.replace_uses(i, same);
+                        erase(i);
+                        again = true;
+                        continue;
+                    }
+                } else if (auto value = evaluate(*i)) {
+                    i->op = Op::Const;
+                    i->operands.clear();
+                    i->constant = std::move(*value);
+                    again = true;
+                } else if (i->op == Op::CondBr && i->operands[0]->op == Op::Const && i->operands[0]->type == Type::Bool) {
+                    bool taken = std::get<bool>(i->operands[0]->constant);
+                    Block* dropped = i->blocks[taken ? 1 : 0];
+                    i->op = Op::Br;
+                    i->operands.clear();
+                    i->blocks = {i->blocks[taken ? 0 : 1]};
+                    remove_edge(b.get(), dropped);
+                    again = branches = true;
+                }
+                ++k;
+            }
+        }
+        changed |= again;
+    }
+    if (branches) fn.remove_unreachable();
+    return changed;
+}
+
+bool simplify_cfg(Function& fn) {
+    auto before = fn.blocks.size();
+    fn.remove_unreachable();
+    bool changed = fn.blocks.size() != before;
+    for (bool again = true; again;) {
+        again = false;
+        for (auto& owner : fn.blocks) {
+            Block* b = owner.get();
+            auto* t = b->terminator();
+            if (t->op != Op::Br) continue;
+            Block* next = t->blocks[0];
+            if (next == b || next == fn.entry() || next->preds.size() != 1) continue;
+            while (!next->instrs.empty() && next->instrs.front()->op == Op::Phi) {
+                fn.replace_uses(next->instrs.front().get(), next->instrs.front()->operands[0]);
+                next->instrs.erase(next->instrs.begin());
+            }
+            b->instrs.pop_back();
+            for (auto& i : next->instrs) {
+                i->parent = b;
+                b->instrs.push_back(std::move(i));
+            }
+            for (auto* s : b->succs()) rename_pred(s, next, b);
+            std::erase_if(fn.blocks, [&](const auto& x) { return x.get() == next; });
+            again = changed = true;
+            break;
+        }
+    }
+    return changed;
+}
+
+bool eliminate_common(Function& fn) { return CommonValues(fn).run(); }
+
+bool hoist_invariants(Function& fn) {
+    bool changed = false;
+    {
+        Dominators dom(fn);
+        for (const auto& loop : find_loops(fn, dom)) {
+            if (loop.preheader()) continue;
+            add_preheader(fn, loop);
+            changed = true;
+        }
+    }
+    Dominators dom(fn);
+    auto order = reverse_postorder(fn);
+    for (const auto& loop : find_loops(fn, dom)) {
+        Block* pre = loop.preheader();
+        bool calls = false;
+        std::set<int> stored;
+        for (auto* b : loop.body) {
+            for (const auto& i : b->instrs) {
+                if (i->op == Op::Call) calls = true;
+                if (i->op == Op::StoreGlobal) stored.insert(i->index);
+            }
+        }
+        for (auto* b : order) {
+            if (!loop.body.contains(b)) continue;
+            for (std::size_t k = 0; k < b->instrs.size();) {
+                Instr* i = b->instrs[k].get();
+                bool invariant = std::ranges::none_of(i->operands, [&](const Instr* o) { return loop.body.contains(o->parent); });
+                bool movable = i->op == Op::LoadGlobal ? !calls && !stored.contains(i->index) : pure(i) && i->op != Op::Phi;
+                // The header runs whenever the preheader does; other blocks may not
+                bool safe = b == loop.header || cannot_fail(i);
+                if (invariant && movable && safe) {
+                    insert_at_end(pre, take(i));
+                    changed = true;
+                    continue;
+                }
+                ++k;
+            }
+        }
+    }
+    return changed;
+}
+
+bool reduce_strength(Function& fn) {
+    bool changed = false;
+    for (auto& b : fn.blocks) {
+        // simplify() erases only the instruction it is given
+        std::vector<Instr*> instrs;
+        for (auto& i : b->instrs) instrs.push_back(i.get());
+        for (auto* i : instrs) changed |= simplify(fn, i);
+    }
+    Dominators dom(fn);
+    for (const auto& loop : find_loops(fn, dom)) changed |= reduce_induction(fn, loop);
+    return changed;
+}
+
+bool eliminate_dead(Function& fn) {
+    std::set<const Instr*> live;
+    std::vector<const Instr*> work;
+    for (const auto& b : fn.blocks) {
+        for (const auto& i : b->instrs) {
+            if (i->has_effects()) work.push_back(i.get());
+        }
+    }
+    while (!work.empty()) {
+        auto* i = work.back();
+        work.pop_back();
+        if (!live.insert(i).second) continue;
+        work.insert(work.end(), i->operands.begin(), i->operands.end());
+    }
+    bool changed = false;
+    for (auto& b : fn.blocks) {
+        changed |= std::erase_if(b->instrs, [&](const auto& i) { return !live.contains(i.get()); }) > 0;
+    }
+    return changed;
+}
+
+// --- PassManager ---------------------------------------------------------------
+
+void PassManager::add(std::string name, Pass pass) {
+    passes.push_back(std::move(pass));
+    times.push_back(Timing{std::move(name)});
+}
+
+void PassManager::add(std::string name, bool (*pass)(Function&)) {
+    add(std::move(name), [pass](Module& module) {
+        bool changed = false;
+        for (auto& f : module.functions) changed |= pass(*f);
+        return changed;
+    });
+}
+
+bool PassManager::run(Module& module, int rounds) {
+    bool any = false;
+    for (int round = 0; round < rounds; ++round) {
+        bool changed = false;
+        for (std::size_t k = 0; k < passes.size(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            bool did = passes[k](module);
+            times[k].time += std::chrono::steady_clock::now() - start;
+            ++times[k].runs;
+            times[k].changed += did;
+            changed |= did;
+            if (!verifying) continue;
+            auto problems = verify(module);
+            if (!problems.empty()) throw std::logic_error("after " + times[k].pass + ": " + problems.front());
+        }
+        any |= changed;
+        if (!changed) break;
+    }
+    return any;
+}
+
+std::string PassManager::report() const {
+    std::string out;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-16s %6s %8s %12s\n", "pass", "runs", "changed", "time (ms)");
+    out += line;
+    std::chrono::nanoseconds total{};
+    for (const auto& t : times) {
+        std::snprintf(line, sizeof(line), "%-16s %6u %8u %12.3f\n", t.pass.c_str(), t.runs, t.changed,
+                      std::chrono::duration<double, std::milli>(t.time).count());
+        out += line;
+        total += t.time;
+    }
+    std::snprintf(line, sizeof(line), "%-16s %6s %8s %12.3f\n", "total", "", "", std::chrono::duration<double, std::milli>(total).count());
+    return out + line;
+}
+
+Pipeline pipeline(Level level) {
+    Pipeline p;
+    if (level == Level::O0) return p;
+    bool o2 = level == Level::O2;
+    if (o2) p.passes.add("inline", [](Module& m) { return inline_calls(m, INLINE_BUDGET); });
+    p.passes.add("fold", fold_constants);
+    p.passes.add("simplify-cfg", simplify_cfg);
+    p.passes.add("cse", eliminate_common);
+    if (o2) {
+        p.passes.add("licm", hoist_invariants);
+        p.passes.add("strength", reduce_strength);
+    }
+    p.passes.add("dce", eliminate_dead);
+    p.rounds = o2 ? 4 : 2;
+    return p;
+}
+
+} // namespace ouro::ir
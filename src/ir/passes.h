@@ -0,0 +1,90 @@
+#pragma once
+#include "ir.h"
+#include <chrono>
+#include <functional>
+
+namespace ouro::ir {
+
+// Optimizations over the IR. Each pass rewrites a module or function in
+// place, leaves it passing verify(), and returns whether it changed
+// anything. Following the IR's contract, an instruction without effects
+// whose value nothing uses may be dropped, even one that could fail; code is
+// only moved onto a path that did not run it before when it cannot fail.
+
+// Replaces calls to functions of the module no bigger than `budget`
+// instructions with copies of their bodies. Recursive functions, directly or
+// through others, stay calls.
+bool inline_calls(Module& module, std::size_t budget);
+
+// Evaluates operations on constants, phis merging a single value, and
+// branches on a constant, dropping the blocks that no longer run
+bool fold_constants(Function& fn);
+
+// Merges a block into its only predecessor when that branches nowhere else
+bool simplify_cfg(Function& fn);
+
+// Reuses the value of an identical pure operation that dominates this one,
+// and, within a block, a global loaded or stored earlier with no call between
+bool eliminate_common(Function& fn);
+
+// Moves what does not change inside a loop to a block run once before it,
+// giving the loop one if it has none
+bool hoist_invariants(Function& fn);
+
+// Rewrites operations into cheaper ones that give the same result: algebraic
+// identities, x * 2 as x + x, division by a power of two as a multiplication,
+// and a loop counter times a constant as a second counter stepping by the
+// product
+bool reduce_strength(Function& fn);
+
+// Drops instructions nothing uses that have no effects
+bool eliminate_dead(Function& fn);
+
+enum class Level { O0, O1, O2 };
+
+// Runs passes in order and times each. The sequence repeats while it keeps
+// changing the module, up to a number of rounds.
+class PassManager {
+public:
+    using Pass = std::function<bool(Module&)>;
+
+    struct Timing {
+        std::string pass;
+        unsigned runs = 0;
+        unsigned changed = 0; // Runs that changed the module
+        std::chrono::nanoseconds time{};
+    };
+
+    void add(std::string name, Pass pass);
+    // A function pass, run on every function of the module
+    void add(std::string name, bool (*pass)(Function&));
+    // Checks the module after every pass, throwing std::logic_error naming the
+    // pass that broke it
+    void verify_each(bool on) { verifying = on; }
+    bool run(Module& module, int rounds = 1);
+
+    const std::vector<Timing>& timings() const { return times; }
+    // One line per pass: its runs, how many changed something, and its time
+    std::string report() const;
+
+private:
+    std::vector<Pass> passes;
+    std::vector<Timing> times; // One per pass, in the same order
+    bool verifying = false;
+};
+
+// The passes of an optimization level. O0 runs none; O1 folds, simplifies the
+// control flow and removes common and dead code; O2 inlines calls, hoists
+// loop invariants and reduces strength as well.
+struct Pipeline {
+    PassManager passes;
+    int rounds = 1;
+
+    bool run(Module& module) { return passes.run(module, rounds); }
+};
+Pipeline pipeline(Level level);
+
+// Functions of up to this many instructions are inlined at O2
+inline constexpr std::size_t INLINE_BUDGET = 40;
+
+} // namespace ouro::ir
@@ -1,6 +1,11 @@
 #include "ourolang/repl.h"
+#include <string_view>
 
-int main() {
-  ouro::repl();
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string_view(argv[1]) == "--vm") {
+    ouro::repl<ouro::VM>();
+  } else {
+    ouro::repl();
+  }
   return 0;
 }
@@ -0,0 +1,19 @@
+#include "ourolang/interpreter.h"
+#include <cassert>
+#include <sstream>
+
+int main() {
+    using namespace ouro;
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+
+    // Async calls run concurrently: the second task's shorter sleep ends first
+    {
+        Interpreter interp;
+        interp.run("async fn late(n: num) -> num { let s = sleep(n); let p = print(n); return n + n; }\n"
+                   "let a = late(40);\nlet b = late(5);\nlet c = await a;\nlet d = print(c);");
+    }
+    std::cout.rdbuf(saved);
+    assert(out.str() == "5\n40\n80\n");
+    return 0;
+}
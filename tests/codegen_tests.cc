@@ -1,5 +1,194 @@
+#include "../src/ir/lower.h"
+#include "../src/ir/passes.h"
+#include "ourolang/arena.h"
+#include "ourolang/parser.h"
+#include "ourolang/resolver.h"
+#include "ourolang/type_checker.h"
 #include <cassert>
+#include <cstdlib>
+#include <string>
+
+extern "C" {
+#include "../ouroboros-lang/ouroboros/parser.h"
+#include "../ouroboros-lang/ouroboros/semantic.h"
+}
+
+static bool contains(const std::string& text, const std::string& part) { return text.find(part) != std::string::npos; }
+
 int main() {
-  assert(true);
+  namespace ir = ouro::ir;
+
+  // Built by hand: a loop counter merges its start and its increment in a phi
+  {
+    ir::Function fn;
+    fn.name = "count";
+    fn.params = {ir::Type::Int};
+    fn.result = ir::Type::Int;
+    ir::Builder b(fn);
+    ir::Variables vars(b);
+    auto* entry = b.create_block("entry");
+    auto* header = b.create_block("loop");
+    auto* body = b.create_block("body");
+    auto* exit = b.create_block("exit");
+    b.set_block(entry);
+    vars.seal(entry);
+    vars.declare(0, ir::Type::Int);
+    auto* n = b.param(0);
+    vars.write(0, entry, b.constant(ir::Type::Int, std::int64_t{0}));
+    b.br(header);
+    b.set_block(header);
+    auto* i = vars.read(0, header);
+    b.cond_br(b.binary(ir::Op::Lt, i, n), body, exit);
+    vars.seal(body);
+    b.set_block(body);
+    vars.write(0, body, b.binary(ir::Op::Add, vars.read(0, body), b.constant(ir::Type::Int, std::int64_t{1})));
+    b.br(header);
+    vars.seal(header);
+    vars.seal(exit);
+    b.set_block(exit);
+    b.ret(vars.read(0, exit));
+    vars.finish();
+    assert(ir::verify(fn).empty());
+    assert(ir::dump(fn) == "fn count(int) -> int {\n"
+                           "b0 entry:\n"
+                           "  %0 = param int 0\n"
+                           "  %1 = const int 0\n"
+                           "  br b1\n"
+                           "b1 loop:\n"
+                           "  %3 = phi int [%1, b0], [%7, b2]\n"
+                           "  %4 = lt bool %3, %0\n"
+                           "  condbr %4, b2, b3\n"
+                           "b2 body:\n"
+                           "  %6 = const int 1\n"
+                           "  %7 = add int %3, %6\n"
+                           "  br b1\n"
+                           "b3 exit:\n"
+                           "  ret %3\n"
+                           "}\n");
+
+    // The verifier catches a use its definition does not dominate
+    body->instrs.back()->blocks[0] = exit;
+    assert(!ir::verify(fn).empty());
+  }
+
+  // From the ouro:: front end
+  {
+    const char* source = "fn sum(n: int) -> int {\n"
+                         "    let total = 0;\n"
+                         "    for i in 0..n { let total = total + i; }\n"
+                         "    return total;\n"
+                         "}\n"
+                         "let s = sum(10);\n"
+                         "let p = print(s);\n";
+    ouro::Arena arena;
+    auto tokens = ouro::Lexer(source, arena.get_resource()).tokenize();
+    auto program = ouro::Parser(tokens, arena.get_resource()).parse();
+    ouro::TypeChecker checker;
+    checker.declare_function("print", "");
+    checker.check(program);
+    ouro::Resolver().resolve(program);
+    auto module = ir::lower(program);
+    assert(module.skipped.empty());
+    assert(ir::verify(module).empty());
+    auto* sum = module.find("sum");
+    assert(sum && sum->params == std::vector{ir::Type::Float} && sum->result == ir::Type::Float);
+    auto text = ir::dump(*sum);
+    assert(contains(text, "phi float")); // total, around the loop
+    assert(contains(text, "phi int"));   // The counter
+    assert(contains(ir::dump(*module.find(ir::PROGRAM)), "call float sum("));
+  }
+
+  // From ouroboros-lang, through its own lexer, parser and resolver
+  {
+    const char* source = "function fib(int n) {\n"
+                         "    if (n < 2) { return n; }\n"
+                         "    return fib(n - 1) + fib(n - 2);\n"
+                         "}\n"
+                         "int collatz(int n) {\n"
+                         "    var steps = 0;\n"
+                         "    while (n != 1) {\n"
+                         "        steps++;\n"
+                         "        if (steps > 1000) { break; }\n"
+                         "        if (n % 2 == 0 && n > 0) { n = n / 2; } else { n = 3 * n + 1; }\n"
+                         "    }\n"
+                         "    return steps;\n"
+                         "}\n"
+                         "var total = 0;\n"
+                         "for (var i = 0; i < 10; i++) { total += fib(i); }\n"
+                         "print(total);\n"
+                         "class Point { }\n";
+    AstArena* arena = ast_arena_create();
+    AstArena* previous = ast_arena_activate(arena);
+    Token* tokens = lex(source);
+    ASTNode* root = parse(tokens);
+    std::free(tokens);
+    assert(root);
+    analyze_program(root);
+    resolve_program(root);
+    auto module = ir::lower(root);
+    assert(ir::verify(module).empty());
+    assert(module.skipped.size() == 1 && contains(module.skipped[0], "Point"));
+    auto* fib = module.find("fib");
+    assert(fib && fib->params == std::vector{ir::Type::Int} && fib->result == ir::Type::Any);
+    auto* collatz = module.find("collatz");
+    assert(collatz && collatz->result == ir::Type::Int);
+    auto text = ir::dump(*collatz);
+    assert(contains(text, "phi int")); // n and steps stay ints around the loop
+    assert(contains(text, "phi bool")); // &&
+    assert(contains(text, "div any"));  // n / 2 is an int only when it divides evenly
+    auto top = ir::dump(*module.find(ir::PROGRAM));
+    assert(contains(top, "store @total[0]"));
+    assert(contains(top, "call void print("));
+    ast_arena_activate(previous);
+    ast_arena_destroy(arena);
+  }
+
+  // Optimized: a helper inlined into a loop, an invariant hoisted out of it,
+  // a common product computed once and a counter's multiple stepped instead
+  {
+    const char* source = "int square(int x) { return x * x; }\n"
+                         "int run(int n) {\n"
+                         "    var total = 0;\n"
+                         "    for (var i = 0; i < n; i++) { total = total + square(i) + i * 8 + n * 3 + n * 3; }\n"
+                         "    return total;\n"
+                         "}\n"
+                         "float half(float x) { return x / 2.0; }\n"
+                         "print(run(2 + 3));\n";
+    AstArena* arena = ast_arena_create();
+    AstArena* previous = ast_arena_activate(arena);
+    Token* tokens = lex(source);
+    ASTNode* root = parse(tokens);
+    std::free(tokens);
+    assert(root);
+    analyze_program(root);
+    resolve_program(root);
+    auto module = ir::lower(root);
+    auto before = ir::dump(module);
+    auto none = ir::pipeline(ir::Level::O0);
+    assert(!none.run(module) && ir::dump(module) == before);
+
+    auto o2 = ir::pipeline(ir::Level::O2);
+    o2.passes.verify_each(true);
+    assert(o2.run(module));
+    auto* run = module.find("run");
+    auto text = ir::dump(*run);
+    assert(!contains(text, "call"));
+    std::size_t products = 0;
+    for (const auto& b : run->blocks) {
+      for (const auto& i : b->instrs) {
+        if (i->op != ir::Op::Mul) continue;
+        ++products; // i * i in the loop, n * 3 before it
+        if (i->operands[1]->op == ir::Op::Const) assert(i->parent == run->entry());
+      }
+    }
+    assert(products == 2);
+    assert(contains(ir::dump(*module.find("half")), "const float 0.5"));
+    auto top = ir::dump(*module.find(ir::PROGRAM));
+    assert(contains(top, "const int 5") && contains(top, "const int 15")); // Folded, then propagated through run
+    auto report = o2.passes.report();
+    for (const char* pass : {"inline", "fold", "simplify-cfg", "cse", "licm", "strength", "dce"}) assert(contains(report, pass));
+    ast_arena_activate(previous);
+    ast_arena_destroy(arena);
+  }
   return 0;
 }
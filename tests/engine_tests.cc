@@ -0,0 +1,83 @@
+#include "ourolang/interpreter.h"
+#include "ourolang/vm.h"
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// What the engine prints for `lines`, fed one at a time like REPL input, and
+// the message of each error it reports
+template <typename Engine>
+static std::string feed(const std::vector<std::string>& lines) {
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+    Engine engine;
+    for (const auto& line : lines) {
+        try {
+            engine.feed(line);
+        } catch (const std::runtime_error& e) {
+            out << "error: " << e.what() << "\n";
+        }
+    }
+    std::cout.rdbuf(saved);
+    return out.str();
+}
+
+// The VM must print what the interpreter prints
+static void check(const std::vector<std::string>& lines, const std::string& expected) {
+    assert(feed<ouro::Interpreter>(lines) == expected);
+    assert(feed<ouro::VM>(lines) == expected);
+}
+
+// And turn down what it would run in a different order, before any of it runs
+static void rejected(const std::string& source) {
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+    bool thrown = false;
+    try {
+        ouro::VM().run(source);
+    } catch (const ouro::Unsupported&) {
+        thrown = true;
+    }
+    std::cout.rdbuf(saved);
+    assert(thrown && out.str().empty());
+}
+
+int main() {
+    // Arithmetic, strings and precedence
+    check({"let a = 1 + 2 * 3;", "let s = \"a is \";", "let p = print(s, a, \" \", a / 2 - 1);"}, "a is 7 2.5\n");
+
+    // Recursion, and a function that reads a global's latest value
+    check({"let k = 1;", "fn tri(n: float) -> float { let r = n; for i in 1..n { let r = n + tri(n - 1); } return r; }",
+           "fn scaled() -> float { return k * 2; }", "let k = 21;", "let p = print(tri(6), \" \", scaled());"},
+          "21 42\n");
+
+    // Loops: reassigning the loop variable does not change the iteration
+    check({"let t = 0;", "for i in 0..4 { let t = t + i; let i = 10; }", "let p = print(t, \" \", i);"}, "6 10\n");
+
+    // Nested functions see the locals of the call that declared them
+    check({"fn outer(x: float) -> float { let y = x * 2; fn inner() -> float { return x + y; } return inner(); }",
+           "let p = print(outer(3), \" \", outer(5));"},
+          "9 15\n");
+
+    // return records the value and the body goes on
+    check({"fn f() -> num { return 1; let p = print(\"after\"); }", "let p = print(f());"}, "after\n1\n");
+
+    // What print and a bare return give back is 0, as on the tree walker
+    check({"let x = print(1);", "fn f() -> num { return; }", "let p = print(x, \" \", f() + 1);"}, "1\n0 1\n");
+
+    // A statement spread over several lines runs once it is complete
+    check({"fn add(a: num, b: num) -> num {", "return a + b;", "}", "let p = print(add(2, 3));"}, "5\n");
+
+    // Errors leave earlier globals in place
+    check({"let a = 1;", "let b = missing(a);", "let p = print(a, \" \", b);"},
+          "error: Undefined function: missing\nerror: Undefined variable: b\n");
+
+    // Async and gpu functions and parallel for are the interpreter's
+    rejected("let p = print(1);\n"
+             "async fn late(n: num) -> num { let s = sleep(n); let p = print(n); return n + n; }\n"
+             "let a = late(40);\nlet b = late(5);\nlet c = await a;\nlet d = print(c);");
+    rejected("let p = print(1);\ngpu fn sq(n: float) -> float { return n * n; }\nlet d = print(sq(3));");
+    rejected("let p = print(1);\nlet t = 0;\nparallel for i in 0..10 { let t = t + i; }\nlet d = print(t);");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "ourolang/interpreter.h"
+#include <cassert>
+#include <sstream>
+
+int main() {
+    using namespace ouro;
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+
+    // A gpu fn's sum is the same on one thread and on several, and exact here
+    // for both it and the interpreter
+    const std::string squares = " squares(n: float) -> float {\n"
+                                "    let s = 0;\n"
+                                "    for i in 0..n { let sq = i * i; let s = s + sq; }\n"
+                                "    return s - 333328333350000;\n"
+                                "}\n"
+                                "let d = print(squares(100000));\n";
+    for (unsigned threads : {1u, 3u}) Interpreter(threads).run("gpu fn" + squares);
+    Interpreter().run("fn" + squares);
+    std::cout.rdbuf(saved);
+    assert(out.str() == "0\n0\n0\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#if !defined(OURO_JIT)
+#error "jit_tests.cc tests the tiered interpreter and is built with -DOURO_JIT"
+#endif
+#include "ourolang/interpreter.h"
+#include <cassert>
+#include <sstream>
+
+int main() {
+    using namespace ouro;
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+
+    // fib gets hot and moves to native code partway through, with the same result
+    Interpreter().run("fn fib(n: int, one: int) -> int {\n"
+                      "    if n - one { if n { return fib(n - one, one) + fib(n - one - one, one); } else { return n; } }\n"
+                      "    else { return one; }\n"
+                      "}\n"
+                      "let one = fib(1, 1);\n"
+                      "let p = print(fib(20, one));\n");
+    std::cout.rdbuf(saved);
+    assert(out.str() == "6765\n");
+    return 0;
+}
@@ -13,5 +13,38 @@ int main() {
     assert(tokens[3].type == TokenType::NUMBER && tokens[3].value == "42");
     assert(tokens[4].type == TokenType::SEMICOLON);
     assert(tokens[5].type == TokenType::EOF_TOKEN);
+
+    // Lexing into an Arena takes the source copy, the tokens and their text
+    // from one chunk instead of the heap
+    Arena arena;
+    Lexer arena_lex("let a_rather_long_identifier = 42;", arena.get_resource());
+    auto arena_tokens = arena_lex.tokenize();
+    assert(arena_tokens.size() == 6);
+    assert(arena_tokens[1].value == "a_rather_long_identifier");
+    assert(arena.stats().allocations > 0);
+    assert(arena.stats().chunks == 1);
+
+    // Borrowing lexes the caller's buffer in place: token text points into it
+    std::string buffer = "for i in 0..10 {}";
+    auto borrowed = Lexer::borrowing(buffer).tokenize();
+    assert(borrowed.size() == 9);
+    assert(borrowed[1].value.data() == buffer.data() + 4);
+    assert(borrowed[3].type == TokenType::NUMBER && borrowed[3].value == "0");
+    assert(borrowed[4].type == TokenType::DOTDOT);
+    assert(borrowed[5].type == TokenType::NUMBER && borrowed[5].value == "10");
+
+    // Comments run to the end of the line; runs longer than one vector step
+    // still end in the right place
+    std::string long_name(70, 'n');
+    Lexer commented("// header\nlet " + long_name + " = 1234567890123456789012345; // done\n\n\n"
+                    "print(\"a string well past thirty-two bytes long\") //");
+    auto ctokens = commented.tokenize();
+    assert(ctokens.size() == 10);
+    assert(ctokens[0].type == TokenType::LET && ctokens[0].line == 2);
+    assert(ctokens[1].value == long_name);
+    assert(ctokens[3].value == "1234567890123456789012345");
+    assert(ctokens[5].type == TokenType::IDENTIFIER && ctokens[5].line == 5);
+    assert(ctokens[7].value == "a string well past thirty-two bytes long");
+    assert(ctokens[9].type == TokenType::EOF_TOKEN);
     return 0;
 }
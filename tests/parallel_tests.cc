@@ -0,0 +1,32 @@
+#include "ourolang/interpreter.h"
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+int main() {
+    using namespace ouro;
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+
+    // A parallel for gives the same reductions and final values on any
+    // number of threads
+    const std::string triangle = "let t = 0;\n"
+                                 "let d = 0;\n"
+                                 "parallel for i in 0..5000 { let sq = i * i; let t = t + i; let d = d - sq; }\n"
+                                 "let p = print(t, \" \", d, \" \", sq, \" \", i);\n";
+    auto precision = std::cout.precision(12);
+    for (unsigned threads : {1u, 3u}) Interpreter(threads).run(triangle);
+    std::cout.precision(precision);
+    std::cout.rdbuf(saved);
+    assert(out.str() == "12497500 -41654167500 24990001 4999\n12497500 -41654167500 24990001 4999\n");
+
+    // One that carries a value between iterations does not type-check
+    bool rejected = false;
+    try {
+        Interpreter().run("let a = 0;\nparallel for i in 0..10 { let b = a; let a = i; }\n");
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    return 0;
+}
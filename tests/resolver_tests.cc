@@ -0,0 +1,60 @@
+#include "ourolang/interpreter.h"
+#include "ourolang/vm.h"
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+// What `source` prints on the engine, or the message of the error it stops at
+template <typename Engine>
+static std::string run(const std::string& source) {
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+    try {
+        Engine().run(source);
+    } catch (const std::runtime_error& e) {
+        out << "error: " << e.what() << "\n";
+    }
+    std::cout.rdbuf(saved);
+    return out.str();
+}
+
+static void check(const std::string& source, const std::string& expected) {
+    assert(run<ouro::Interpreter>(source) == expected);
+    assert(run<ouro::VM>(source) == expected);
+}
+
+int main() {
+    // A `let` in a loop reads the global it shadows until it has run once
+    check("let t = 0;\n"
+          "fn f() -> num { for i in 0..3 { let t = t + i; } return t; }\n"
+          "let p = print(f(), \" \", t);\n",
+          "3 0\n");
+
+    // So does a read before the declaration
+    check("let t = 10;\n"
+          "fn f() -> num { let a = print(t); let t = 1; return t; }\n"
+          "let p = print(f());\n",
+          "10\n1\n");
+
+    // And one after a branch that may not have declared it
+    check("let t = 10;\n"
+          "fn f(c: int) -> num { if c { let t = c; } return t; }\n"
+          "let p = print(f(0), \" \", f(5));\n",
+          "10 5\n");
+
+    // Once declared, the local hides the global for the rest of the call
+    check("let t = 10;\n"
+          "fn f() -> num { let t = 1; for i in 0..3 { let t = t + i; } return t; }\n"
+          "let p = print(f(), \" \", t);\n",
+          "4 10\n");
+
+    // A function declared before the local it reads falls back the same way
+    check("let t = 10;\n"
+          "fn outer() -> num { fn inner() -> num { return t; } let a = print(inner()); let t = 2; return inner(); }\n"
+          "let p = print(outer());\n",
+          "10\n2\n");
+
+    // With nothing to fall back to, reading it first is still an error
+    check("fn f() -> num { let a = u; let u = 1; return u; }\nlet p = f();\n", "error: Undefined variable: u\n");
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "ourolang/session.h"
+#include <cassert>
+
+int main() {
+    using namespace ouro;
+
+    // A session lexes an edit's statement again and leaves the others alone
+    Session session;
+    session.append("let a = 1;\nlet b = 2;\nlet c = ");
+    assert(session.statements().size() == 2 && session.pending());
+    StmtPtr second = session.statements()[1].stmt;
+    auto update = session.edit(8, 9, "10");
+    assert(update.stmts.size() == 1 && session.statements()[1].stmt == second);
+    update = session.append("b;\n");
+    assert(update.stmts.size() == 1 && !session.pending());
+    assert(session.statements()[2].tokens.front().line == 3);
+
+    // An edit inside the unfinished tail only lexes the tail again
+    update = session.append("let d = ");
+    assert(update.stmts.empty() && session.pending());
+    update = session.append("c;\n");
+    assert(update.stmts.size() == 1 && session.statements().size() == 4);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// `gpu fn` benchmark: runs the same numeric kernel as a plain `fn` on the
+// interpreter and as a `gpu fn` on the CPU backend with one thread and with
+// several, and checks that the thread count does not change the result.
+//
+//   gpu_bench [iterations] [threads]
+//
+// Threads default to one per hardware thread.
+#include "ourolang/interpreter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string program(const char* keyword, long iterations) {
+    return std::string(keyword) + R"( energy(n: float, scale: float) -> float {
+    let total = 0;
+    for i in 0..n {
+        let x = i * scale;
+        let y = x * x - 3 * x + 2;
+        let d = x + 1;
+        let total = total + y / d;
+    }
+    return total;
+}
+let result = energy()" + std::to_string(iterations) + R"(, 0.001);
+let p = print(result);
+)";
+}
+
+struct Run {
+    double seconds;
+    std::string output;
+};
+
+Run run(const std::string& source, unsigned threads) {
+    std::ostringstream out;
+    out.precision(17);
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+    auto start = std::chrono::steady_clock::now();
+    {
+        ouro::Interpreter interp(threads);
+        interp.run(source);
+    }
+    std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+    std::cout.rdbuf(saved);
+    return {took.count(), out.str()};
+}
+
+void report(const char* name, long iterations, const Run& r, double baseline) {
+    std::string result = r.output.substr(0, r.output.find('\n'));
+    std::printf("  %-22s %9.2f ms  %8.1f M iter/s  %6.1fx  %s\n", name, r.seconds * 1e3,
+                static_cast<double>(iterations) / r.seconds / 1e6, baseline / r.seconds, result.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 2000000;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : std::thread::hardware_concurrency();
+    if (threads < 2) threads = 2;
+#if defined(__AVX__)
+    std::printf("kernel.h: AVX\n");
+#elif defined(__SSE2__)
+    std::printf("kernel.h: SSE2\n");
+#else
+    std::printf("kernel.h: scalar\n");
+#endif
+    std::printf("%ld iterations\n", iterations);
+
+    std::cout.precision(17); // print() writes through std::cout's settings
+    Run scalar = run(program("fn", iterations), 1);
+    Run one = run(program("gpu fn", iterations), 1);
+    Run many = run(program("gpu fn", iterations), threads);
+    report("interpreter", iterations, scalar, scalar.seconds);
+    report("gpu fn, 1 thread", iterations, one, scalar.seconds);
+    std::string label = "gpu fn, " + std::to_string(threads) + " threads";
+    report(label.c_str(), iterations, many, scalar.seconds);
+
+    if (one.output != many.output) {
+        std::printf("results differ between 1 and %u threads\n", threads);
+        return 1;
+    }
+    return 0;
+}
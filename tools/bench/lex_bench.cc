@@ -0,0 +1,108 @@
+// Lexer throughput benchmark: times ouro::Lexer and the ouroboros-lang C
+// lexer over the same input and reports MB/s for each.
+//
+//   lex_bench [file.ouro ...]
+//
+// Without arguments it lexes a generated ~4MB program.
+#include "ourolang/lexer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include "../../ouroboros-lang/ouroboros/lexer.h"
+}
+
+namespace {
+
+constexpr int RUNS = 5;
+
+// Code both lexers accept: declarations, calls, loops, strings and comments
+std::string generate(std::size_t bytes) {
+    std::string out;
+    out.reserve(bytes + 256);
+    for (int i = 0; out.size() < bytes; ++i) {
+        std::string n = std::to_string(i);
+        out += "// helper number " + n + ", generated for the lexer benchmark\n";
+        out += "fn compute_value_" + n + "(first_argument, second_argument) {\n";
+        out += "    let accumulated_total = first_argument * 31 + second_argument / 7;\n";
+        out += "    for index in 0..1024 {\n";
+        out += "        accumulated_total = accumulated_total + index * 2.5;\n";
+        out += "    }\n";
+        out += "    print(\"result of compute_value_" + n + " is \", accumulated_total);\n";
+        out += "    return accumulated_total;\n";
+        out += "}\n\n";
+    }
+    return out;
+}
+
+std::string read_file(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        std::exit(1);
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Best of RUNS, in seconds; `lex_once` returns the token count
+template <typename F>
+double best_time(F lex_once, std::size_t& tokens) {
+    double best = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        tokens = lex_once();
+        std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        if (took.count() < best) best = took.count();
+    }
+    return best;
+}
+
+void report(const char* name, std::size_t bytes, std::size_t tokens, double seconds) {
+    std::printf("  %-18s %9zu tokens  %8.2f ms  %8.1f MB/s\n", name, tokens, seconds * 1e3,
+                static_cast<double>(bytes) / seconds / 1e6);
+}
+
+void bench(const char* label, const std::string& source) {
+    std::printf("%s: %zu bytes, best of %d\n", label, source.size(), RUNS);
+
+    std::size_t tokens = 0;
+    double seconds = best_time([&] {
+        ouro::Arena arena(ouro::Arena::size_for_source(source.size()));
+        return ouro::Lexer::borrowing(source, arena.get_resource()).tokenize().size();
+    }, tokens);
+    report("ouro::Lexer", source.size(), tokens, seconds);
+
+    seconds = best_time([&] {
+        Token* list = lex(source.c_str());
+        std::size_t count = 0;
+        while (list[count].type != TOKEN_EOF) count++;
+        std::free(list);
+        return count + 1;
+    }, tokens);
+    report("ouroboros lex()", source.size(), tokens, seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+#if defined(__AVX2__)
+    std::printf("scan.h: AVX2, %d bytes per step\n", OURO_SCAN_WIDTH);
+#elif defined(__SSE2__)
+    std::printf("scan.h: SSE2, %d bytes per step\n", OURO_SCAN_WIDTH);
+#else
+    std::printf("scan.h: scalar\n");
+#endif
+    if (argc < 2) {
+        bench("generated", generate(4 << 20));
+    }
+    for (int i = 1; i < argc; ++i) {
+        bench(argv[i], read_file(argv[i]));
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Lowers a program to the IR, optimizes it and prints the result.
+//
+//   ouro_opt [-O0|-O1|-O2] [-time-passes] [-ouro] file.ouro
+//
+// The file is ouroboros-lang source, or ouro:: source with -ouro. The level
+// defaults to -O2; -time-passes reports what each pass took on stderr.
+#include "../../src/ir/lower.h"
+#include "../../src/ir/passes.h"
+#include "ourolang/arena.h"
+#include "ourolang/parser.h"
+#include "ourolang/resolver.h"
+#include "ourolang/type_checker.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+extern "C" {
+#include "../../ouroboros-lang/ouroboros/parser.h"
+#include "../../ouroboros-lang/ouroboros/semantic.h"
+}
+
+namespace {
+
+std::string read_file(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        std::exit(1);
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+ouro::ir::Module lower_ouro(const std::string& source) {
+    ouro::Arena arena;
+    auto tokens = ouro::Lexer(source, arena.get_resource()).tokenize();
+    auto program = ouro::Parser(tokens, arena.get_resource()).parse();
+    ouro::TypeChecker checker;
+    checker.declare_function("print", "");
+    checker.declare_function("sleep", "");
+    checker.check(program);
+    ouro::Resolver().resolve(program);
+    return ouro::ir::lower(program);
+}
+
+ouro::ir::Module lower_ouroboros(const std::string& source) {
+    AstArena* arena = ast_arena_create();
+    AstArena* previous = ast_arena_activate(arena);
+    Token* tokens = lex(source.c_str());
+    ASTNode* root = parse(tokens);
+    std::free(tokens);
+    if (!root) {
+        std::fprintf(stderr, "parse failed\n");
+        std::exit(1);
+    }
+    analyze_program(root);
+    resolve_program(root);
+    auto module = ouro::ir::lower(root);
+    ast_arena_activate(previous);
+    ast_arena_destroy(arena);
+    return module;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto level = ouro::ir::Level::O2;
+    bool time_passes = false, ouro_syntax = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-O0") level = ouro::ir::Level::O0;
+        else if (arg == "-O1") level = ouro::ir::Level::O1;
+        else if (arg == "-O2") level = ouro::ir::Level::O2;
+        else if (arg == "-time-passes") time_passes = true;
+        else if (arg == "-ouro") ouro_syntax = true;
+        else if (!path && !arg.starts_with("-")) path = argv[i];
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "Usage: %s [-O0|-O1|-O2] [-time-passes] [-ouro] file.ouro\n", argv[0]);
+        return 1;
+    }
+    auto source = read_file(path);
+    auto module = ouro_syntax ? lower_ouro(source) : lower_ouroboros(source);
+    auto pipeline = ouro::ir::pipeline(level);
+    pipeline.run(module);
+    std::fputs(ouro::ir::dump(module).c_str(), stdout);
+    if (time_passes) std::fputs(pipeline.passes.report().c_str(), stderr);
+    for (const auto& problem : ouro::ir::verify(module)) std::fprintf(stderr, "%s\n", problem.c_str());
+    return 0;
+}